@@ -26,6 +26,95 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <errno.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+
+/** @brief Opens a file in relative to a directory descriptor.
+ *
+ *  This function opens a file in the filesystem in relative to
+ *  the directory associated with the specified descriptor.
+ *
+ *  @param[in] dir_fd - the descriptor of the directory of the file
+ *                      (or AT_FDCWD for the current directory)
+ *
+ *  @param[in] file_name - the name of the file to open
+ *
+ *  @param[in] flags - the access mode the file when opened
+ *
+ *  @param[out] fsal_handle - the handle of the opened file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+static int FSAL_OpenFileAtFd( int dir_fd, char * file_name, int flags, FSAL_File_t * fsal_handle )
+{
+	int fd;
+	int open_flags = 0;
+
+	/* sanity checks */
+	if ( file_name == NULL ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	if (flags & FSAL_FLAGS_CREATE )
+		open_flags |= O_CREAT;
+
+	if (flags & FSAL_FLAGS_READ_ONLY )
+		open_flags |= O_RDONLY;
+	else if (flags & FSAL_FLAGS_WRITE_ONLY )
+		open_flags |= O_WRONLY;
+	else
+		open_flags |= O_RDWR;
+
+	/* open the specified file */
+	fd = openat( dir_fd, file_name, open_flags, 0777 );
+	if ( fd == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* copy the handle to the output parameter */
+	*fsal_handle = (FSAL_File_t) fd;
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Opens a file of a directory.
+ *
+ *  This function opens a file in the directory associated with the
+ *  specified directory handle.
+ *
+ *  @param[in] fsal_dir - the handle of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to open
+ *
+ *  @param[in] flags - the access mode the file when opened
+ *
+ *  @param[out] fsal_handle - the handle of the opened file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_OpenDirFile( FSAL_Dir_t fsal_dir, char * file_name, int flags, FSAL_File_t * fsal_handle )
+{
+	int fd = (int) fsal_dir;
+
+	/* sanity checks */
+	if ( fd == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* open the specified file in relative to the directory */
+	return FSAL_OpenFileAtFd( fd, file_name, flags, fsal_handle );
+}
 
 /** @brief Initializes the filesystem for use
  *
@@ -194,6 +283,74 @@ int FSAL_ListDirectory( char * dir_name )
 	return FSAL_STATUS_OK;
 }
 
+/** @brief Opens a directory.
+ *
+ *  This function opens a directory of the filesystem in relative to
+ *  the current directory so that files within it can be accessed
+ *  later on without changing the current directory.
+ *
+ *  @param[in] dir_name - the name of the directory to open
+ *
+ *  @param[out] fsal_dir - the handle of the opened directory
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_OpenDirectory( char * dir_name, FSAL_Dir_t * fsal_dir )
+{
+	int fd;
+
+	/* sanity checks */
+	if ( (dir_name == NULL) || (fsal_dir == NULL) ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* open the specified directory */
+	fd = open( dir_name, O_RDONLY | O_DIRECTORY );
+	if ( fd == -1 ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* copy the handle to the output parameter */
+	*fsal_dir = (FSAL_Dir_t) fd;
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Closes a directory.
+ *
+ *  This function closes a directory as specified by a specific
+ *  directory handle.
+ *
+ *  @param[in] fsal_dir - the handle associated to the directory
+ *                        to close
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_CloseDirectory( FSAL_Dir_t fsal_dir )
+{
+	int fd = (int) fsal_dir;
+
+	/* sanity check */
+	if ( fd == -1 ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* close the directory */
+	close( fd );
+
+	return FSAL_STATUS_OK;
+}
+
 /** @brief Lists a file and retrieves its size.
  *
  *  This function lists a file in the current directory and
@@ -244,6 +401,121 @@ int FSAL_ListFile( char * file_name, size_t * file_size )
 	return FSAL_STATUS_OK;
 }
 
+/** @brief Locks a directory.
+ *
+ *  This function places a shared or an exclusive lock on the
+ *  directory associated with the specified directory handle without
+ *  waiting for it. Any number of shared locks may be held on the
+ *  same directory at the same time while an exclusive lock can only
+ *  be held if no other lock is held on the directory.
+ *
+ *  @param[in] fsal_dir - the handle associated to the directory
+ *                        to lock
+ *
+ *  @param[in] lock_type - the type of lock to place:
+ *
+ *                         FSAL_LOCK_SHARED
+ *                         FSAL_LOCK_EXCLUSIVE
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *                FSAL_ERROR_DIR_LOCKED
+ *
+ */
+int FSAL_LockDirectory( FSAL_Dir_t fsal_dir, int lock_type )
+{
+	int fd = (int) fsal_dir;
+	int operation = (lock_type == FSAL_LOCK_EXCLUSIVE) ? LOCK_EX : LOCK_SH;
+
+	/* sanity check */
+	if ( fd == -1 ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* place the advisory lock without blocking (the lock is released
+	 * as well once the directory is closed or the process terminates) */
+	if ( flock( fd, operation | LOCK_NB ) == -1 ) {
+		return (errno == EWOULDBLOCK) ? FSAL_ERROR_DIR_LOCKED : FSAL_ERROR_DIR_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Unlocks a directory.
+ *
+ *  This function releases the lock previously placed on the
+ *  directory associated with the specified directory handle.
+ *
+ *  @param[in] fsal_dir - the handle associated to the directory
+ *                        to unlock
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_UnlockDirectory( FSAL_Dir_t fsal_dir )
+{
+	int fd = (int) fsal_dir;
+
+	/* sanity check */
+	if ( fd == -1 ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* release the advisory lock */
+	if ( flock( fd, LOCK_UN ) == -1 ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Lists a file of a directory and retrieves its size.
+ *
+ *  This function lists a file in the directory associated with the
+ *  specified directory handle and retrieves the file size.
+ *
+ *  @param[in] fsal_dir - the handle of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to list
+ *
+ *  @param[out] file_size - the current size of the file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_ListDirFile( FSAL_Dir_t fsal_dir, char * file_name, size_t * file_size )
+{
+	int fd = (int) fsal_dir;
+	struct stat st;
+
+	/* sanity checks */
+	if ( (fd == -1) || (file_name == NULL) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* retrieve the file status without opening the file */
+	if ( (fstatat( fd, file_name, &st, 0 ) == -1) ||
+		 (!S_ISREG(st.st_mode)) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* copy the file size */
+	*file_size = st.st_size;
+
+	return FSAL_STATUS_OK;
+}
+
 /** @brief Opens a file.
  *
  *  This function opens a file in the filesystem in relative to
@@ -264,43 +536,87 @@ int FSAL_ListFile( char * file_name, size_t * file_size )
  */
 int FSAL_OpenFile( char * file_name, int flags, FSAL_File_t * fsal_handle )
 {
-	int fd;
-	int open_flags = 0;
+	/* open the specified file in relative to the current directory */
+	return FSAL_OpenFileAtFd( AT_FDCWD, file_name, flags, fsal_handle );
+}
 
-	/* sanity checks */
-	if ( file_name == NULL ) {
+/** @brief Closes a file.
+ *
+ *  This function closes a file as specified by a specific file
+ *  handle.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to close
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_CloseFile( FSAL_File_t fsal_handle )
+{
+	int fd = (int) fsal_handle;
+
+	/* sanity check */
+	if ( fd == -1 ) {
 		return FSAL_ERROR_FILE_ACCESS;
 	}
 
-	if (flags & FSAL_FLAGS_CREATE )
-		open_flags |= O_CREAT;
+	/* close the file */
+	close( fd );
 
-	if (flags & FSAL_FLAGS_READ_ONLY )
-		open_flags |= O_RDONLY;
-	else if (flags & FSAL_FLAGS_WRITE_ONLY )
-		open_flags |= O_WRONLY;
-	else
-		open_flags |= O_RDWR;
+	return FSAL_STATUS_OK;
+}
 
-	/* open the specified file */
-	fd = open( file_name, open_flags, 0777 );
+/** @brief Synchronizes a file with the storage media.
+ *
+ *  This function writes back whatever the filesystem still buffers
+ *  of the file as specified by a specific file handle, so that the
+ *  data written so far survives a power loss.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to synchronize
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_SyncFile( FSAL_File_t fsal_handle )
+{
+	int fd = (int) fsal_handle;
+
+	/* sanity check */
 	if ( fd == -1 ) {
 		return FSAL_ERROR_FILE_ACCESS;
 	}
 
-	/* copy the handle to the output parameter */
-	*fsal_handle = (FSAL_File_t) fd;
+	/* flush the data (and the metadata needed to retrieve it) to the media */
+	if ( fdatasync( fd ) == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
 
 	return FSAL_STATUS_OK;
 }
 
-/** @brief Closes a file.
+/** @brief Allocates the storage of a file up front.
  *
- *  This function closes a file as specified by a specific file
- *  handle.
+ *  This function extends the file as specified by a specific file
+ *  handle to (at least) the specified length and reserves the storage
+ *  media for it, so that writing the file within that length later on
+ *  never has to allocate any more (and, where the filesystem allows
+ *  it, lands on contiguous clusters). What the file holds past its
+ *  previous end is left unspecified. A file already that long is left
+ *  as it is.
  *
  *  @param[in] fsal_handle - the handle associated to the file
- *                           to close
+ *                           to allocate
+ *
+ *  @param[in] length - the number of bytes to allocate the file for
  *
  *  @return int - the status or error code of the operation after
  *                the call:
@@ -309,7 +625,7 @@ int FSAL_OpenFile( char * file_name, int flags, FSAL_File_t * fsal_handle )
  *                FSAL_ERROR_FILE_ACCESS
  *
  */
-int FSAL_CloseFile( FSAL_File_t fsal_handle )
+int FSAL_AllocateFile( FSAL_File_t fsal_handle, size_t length )
 {
 	int fd = (int) fsal_handle;
 
@@ -318,8 +634,10 @@ int FSAL_CloseFile( FSAL_File_t fsal_handle )
 		return FSAL_ERROR_FILE_ACCESS;
 	}
 
-	/* close the file */
-	close( fd );
+	/* reserve the blocks of the file (which reads as zeroes past its previous end) */
+	if ( (length != 0) && (posix_fallocate( fd, 0, (off_t) length ) != 0) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
 
 	return FSAL_STATUS_OK;
 }
@@ -363,6 +681,49 @@ ssize_t FSAL_ReadFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length
 	return actual_length;
 }
 
+/** @brief Reads from a file at a specific position.
+ *
+ *  This function reads data from a file as specified by a specific
+ *  file handle, starting at the specified byte offset from the
+ *  beginning of the file.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to read
+ *
+ *  @param[in] offset - the byte offset in the file where the data
+ *                      is to be read from
+ *
+ *  @param[in] buffer - the location reference where the contents
+ *                      of the file will be stored
+ *
+ *  @param[in] length - the maximum bytes the location reference
+                        can store
+ *
+ *  @return int - the number of bytes actually read or a negative
+ *                error code if the operation failed
+ *
+ */
+ssize_t FSAL_ReadFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length )
+{
+	int fd = (int) fsal_handle;
+	ssize_t actual_length = 0;
+
+	/* sanity checks */
+	if ( (fd == -1) || (buffer == NULL) ) {
+		return -FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* proceed operation with nonzero length */
+	if ( length ) {
+		actual_length = pread( fd, buffer, length, (off_t) offset );
+		if ( actual_length == -1 ) {
+			return -FSAL_ERROR_FILE_ACCESS;
+		}
+	}
+
+	return actual_length;
+}
+
 /** @brief Writes to a file.
  *
  *  This function writes data to a file as specified by a specific
@@ -401,6 +762,235 @@ ssize_t FSAL_WriteFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length
 	return actual_length;
 }
 
+/** @brief Writes to a file at a specific position.
+ *
+ *  This function writes data to a file as specified by a specific
+ *  file handle, starting at the specified byte offset from the
+ *  beginning of the file. Bytes outside of the written range are
+ *  left untouched.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to write
+ *
+ *  @param[in] offset - the byte offset in the file where the data
+ *                      is to be written
+ *
+ *  @param[in] buffer - the location reference of the data to be
+ *                      written to the file
+ *
+ *  @param[in] length - the number of bytes to write to the file
+ *
+ *  @return int - the number of bytes actually written or a negative
+ *                error code if the operation failed
+ *
+ */
+ssize_t FSAL_WriteFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length )
+{
+	int fd = (int) fsal_handle;
+	ssize_t actual_length = 0;
+
+	/* sanity checks */
+	if ( (fd == -1) || (buffer == NULL) ) {
+		return -FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* proceed operation with nonzero length */
+	if ( length ) {
+		actual_length = pwrite( fd, buffer, length, (off_t) offset );
+		if ( actual_length == -1 ) {
+			return -FSAL_ERROR_FILE_ACCESS;
+		}
+	}
+
+	return actual_length;
+}
+
+/** @brief Maps a part of a file into memory.
+ *
+ *  This function maps the specified range of a file as specified
+ *  by a specific file handle into memory for read-only access. The
+ *  mapping stays valid after the file is closed, until it is
+ *  unmapped.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to map
+ *
+ *  @param[in] offset - the byte offset in the file where the range
+ *                      to map starts
+ *
+ *  @param[in] length - the number of bytes to map
+ *
+ *  @param[out] data - the reference where the location of the
+ *                     mapped range is set
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_MapFile( FSAL_File_t fsal_handle, size_t offset, size_t length, const uint8_t ** data )
+{
+	int fd = (int) fsal_handle;
+	size_t page_offset;
+	void * mapping;
+
+	/* sanity checks */
+	if ( (fd == -1) || (data == NULL) || (length == 0) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* a mapping must start at a page boundary */
+	page_offset = offset % (size_t) sysconf( _SC_PAGESIZE );
+
+	mapping = mmap( NULL, length + page_offset, PROT_READ, MAP_SHARED, fd, (off_t)(offset - page_offset) );
+	if ( mapping == MAP_FAILED ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	*data = (const uint8_t *) mapping + page_offset;
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Unmaps a part of a file from memory.
+ *
+ *  This function releases a range of a file previously mapped into
+ *  memory.
+ *
+ *  @param[in] data - the location of the mapped range
+ *
+ *  @param[in] offset - the byte offset in the file where the mapped
+ *                      range starts
+ *
+ *  @param[in] length - the number of bytes mapped
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_UnmapFile( const uint8_t * data, size_t offset, size_t length )
+{
+	size_t page_offset;
+
+	/* sanity checks */
+	if ( data == NULL ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* the mapping started at the page boundary */
+	page_offset = offset % (size_t) sysconf( _SC_PAGESIZE );
+
+	if ( munmap( (void *)(data - page_offset), length + page_offset ) == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Maps a part of a file into memory for writing.
+ *
+ *  This function maps the specified range of a file as specified
+ *  by a specific file handle into memory for read and write access.
+ *  Stores into the mapped range are shared with the file, which is
+ *  updated by the filesystem on its own or when the mapped range is
+ *  synchronized. The mapping stays valid after the file is closed,
+ *  until it is unmapped.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to map (opened for read and write)
+ *
+ *  @param[in] offset - the byte offset in the file where the range
+ *                      to map starts
+ *
+ *  @param[in] length - the number of bytes to map
+ *
+ *  @param[out] data - the reference where the location of the
+ *                     mapped range is set
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_MapFileWritable( FSAL_File_t fsal_handle, size_t offset, size_t length, uint8_t ** data )
+{
+	int fd = (int) fsal_handle;
+	size_t page_offset;
+	void * mapping;
+
+	/* sanity checks */
+	if ( (fd == -1) || (data == NULL) || (length == 0) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* a mapping must start at a page boundary */
+	page_offset = offset % (size_t) sysconf( _SC_PAGESIZE );
+
+	mapping = mmap( NULL, length + page_offset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t)(offset - page_offset) );
+	if ( mapping == MAP_FAILED ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	*data = (uint8_t *) mapping + page_offset;
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Synchronizes a part of a file mapped into memory.
+ *
+ *  This function writes the stores into a range of a file mapped
+ *  for writing back to the file, either by scheduling the write
+ *  or by waiting for the write to complete.
+ *
+ *  @param[in] data - the location of the mapped range
+ *
+ *  @param[in] offset - the byte offset in the file where the mapped
+ *                      range starts
+ *
+ *  @param[in] length - the number of bytes mapped
+ *
+ *  @param[in] sync_type - the type of synchronization to perform:
+ *
+ *                         FSAL_SYNC_ASYNC
+ *                         FSAL_SYNC_WAIT
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_SyncMappedFile( const uint8_t * data, size_t offset, size_t length, int sync_type )
+{
+	size_t page_offset;
+
+	/* sanity checks */
+	if ( data == NULL ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* the mapping started at the page boundary */
+	page_offset = offset % (size_t) sysconf( _SC_PAGESIZE );
+
+	if ( msync( (void *)(data - page_offset), length + page_offset, (sync_type == FSAL_SYNC_WAIT) ? MS_SYNC : MS_ASYNC ) == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
 /** @brief Deletes a file.
  *
  *  This function deletes a file from the filesystem in
@@ -430,5 +1020,105 @@ int FSAL_DeleteFile( char * file_name )
 	return FSAL_STATUS_OK;
 }
 
+/** @brief Deletes a file of a directory.
+ *
+ *  This function deletes a file from the directory associated with
+ *  the specified directory handle.
+ *
+ *  @param[in] fsal_dir - the handle of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to remove
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_DeleteDirFile( FSAL_Dir_t fsal_dir, char * file_name )
+{
+	int fd = (int) fsal_dir;
+
+	/* sanity checks */
+	if ( (fd == -1) || (file_name == NULL) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* delete the specified file */
+	if ( unlinkat(fd, file_name, 0) == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Defers the writes of the calling task.
+ *
+ *  This function sets whether the writes, closes and deletes of
+ *  files requested by the calling task (or thread) may be deferred,
+ *  which this filesystem never does.
+ *
+ *  @param[in] defer - non-zero to defer the requests, zero otherwise
+ *
+ *  @return none
+ */
+void FSAL_DeferWrites( int defer )
+{
+	/* every request completes before its call returns */
+	(void) defer;
+}
+
+/** @brief Retrieves the ticket of the last deferred write.
+ *
+ *  This function retrieves the ticket of the last request deferred
+ *  so far, always zero as this filesystem never defers any request.
+ *
+ *  @param none
+ *
+ *  @return uint32_t - the ticket of the last deferred request
+ */
+uint32_t FSAL_GetWriteTicket( void )
+{
+	return 0;
+}
+
+/** @brief Polls the deferred writes for completion.
+ *
+ *  This function retrieves the ticket up to which all deferred
+ *  requests completed and the ticket of the oldest one which failed,
+ *  both always zero as this filesystem never defers any request.
+ *
+ *  @param[in] sync_type - the type of synchronization to perform:
+ *
+ *                         FSAL_SYNC_ASYNC
+ *                         FSAL_SYNC_WAIT
+ *
+ *  @param[out] completed - the ticket up to which all requests
+ *                          completed
+ *
+ *  @param[out] failed - the ticket of the oldest failed request
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_PollWrites( int sync_type, uint32_t * completed, uint32_t * failed )
+{
+	/* sanity checks */
+	if ( (completed == NULL) || (failed == NULL) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* nothing is ever in flight */
+	*completed = 0;
+	*failed = 0;
+
+	return FSAL_STATUS_OK;
+}
+
 
 #endif /* FSAL_LINUX_EXT4 */
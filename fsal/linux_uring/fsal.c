@@ -0,0 +1,1622 @@
+/**********************************************************************
+* Filename:     fsal.c
+*
+* Copyright 2018, Swift Labs / TR
+*
+* Author:       Ronald Miranda / Emil Ekmecic
+*
+* Created:      October 14, 2026
+*
+* Description:  This is the Filesystem Abstraction Layer or FSAL specific
+*               to the Linux EXT4 filesystem accessed through an io_uring
+*               instance. This file implements all required FSAL functions
+*               which are referenced by the data queue application API.
+*               The writes, closes and deletes of files requested by a
+*               task deferring its requests are queued into the io_uring
+*               instance and submitted in batches, so that many of them
+*               (of many data queues) take a single system call, while
+*               any other request waits for those deferred to complete.
+*
+* History
+* 14-Oct-2026   RMM      Initial code based on the Linux EXT4 FSAL.
+**********************************************************************/
+
+#ifdef FSAL_LINUX_URING
+
+#include "../../inc/fsal.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+/**
+ * Data structure used to keep a deferred request: the copy of the
+ * data written (or of the name of the file deleted), the result
+ * expected, the descriptor of the file closed (if it closes one),
+ * whether it completed and its result
+ */
+typedef struct FSAL_Uring_Slot {
+	size_t length;
+	int close_fd;
+	int done;
+	int result;
+	uint8_t buffer[ FSAL_URING_BUFFER_SIZE ];
+} FSAL_Uring_Slot_t;
+
+/**
+ * The io_uring instance (its descriptor is -1 if the kernel does
+ * not provide one supporting the requests deferred, in which case
+ * no request is deferred) along with its submission and completion
+ * queues mapped into memory
+ */
+static int uring_fd = -1;
+static unsigned * uring_sq_tail;
+static unsigned uring_sq_mask;
+static struct io_uring_sqe * uring_sqes;
+static unsigned * uring_cq_head;
+static unsigned * uring_cq_tail;
+static unsigned uring_cq_mask;
+static struct io_uring_cqe * uring_cqes;
+
+/**
+ * Deferred requests (indexed by their ticket) along with the ticket
+ * of the last one deferred, submitted and completed (in order) and
+ * the ticket of the oldest one failed since the completions were
+ * last polled, all serialized by a mutex
+ */
+static FSAL_Uring_Slot_t uring_slots[ FSAL_URING_DEPTH ];
+static uint32_t uring_queued = 0;
+static uint32_t uring_submitted = 0;
+static uint32_t uring_completed = 0;
+static uint32_t uring_failed = 0;
+static PSL_Mutex_t uring_mutex;
+
+/**
+ * Whether the requests of the calling task (or thread) are deferred
+ */
+static PSL_THREAD_LOCAL int uring_defer = 0;
+
+/**
+ * File position of each opened file (indexed by its descriptor),
+ * so that both the requests deferred and those that are not write
+ * at the position expected
+ */
+static size_t uring_position[ FSAL_URING_FILE_MAX ];
+
+/** @brief Sets up the io_uring instance.
+ *
+ *  This function creates the io_uring instance, checks that the
+ *  kernel supports the requests deferred and maps its submission and
+ *  completion queues into memory.
+ *
+ *  @param none
+ *
+ *  @return int - the descriptor of the io_uring instance or -1 if
+ *                none could be set up
+ */
+static int FSAL_UringSetup( void )
+{
+	static uint8_t probe_buffer[ sizeof(struct io_uring_probe) + (IORING_OP_LAST * sizeof(struct io_uring_probe_op)) ];
+	struct io_uring_probe * probe = (struct io_uring_probe *) probe_buffer;
+	static const uint8_t opcodes[] = { IORING_OP_WRITE, IORING_OP_CLOSE, IORING_OP_UNLINKAT };
+	struct io_uring_params params;
+	uint8_t * sq_ring;
+	uint8_t * cq_ring;
+	size_t sq_size;
+	size_t cq_size;
+	unsigned index;
+	int fd;
+
+	memset( &params, 0, sizeof(params) );
+	fd = (int) syscall( __NR_io_uring_setup, FSAL_URING_DEPTH, &params );
+	if ( fd < 0 ) {
+		return -1;
+	}
+
+	/* check that all requests deferred are supported */
+	memset( probe_buffer, 0, sizeof(probe_buffer) );
+	if ( syscall( __NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST ) < 0 ) {
+		close( fd );
+		return -1;
+	}
+	for ( index = 0; index < sizeof(opcodes); index++ ) {
+		if ( (opcodes[index] > probe->last_op) || !(probe->ops[ opcodes[index] ].flags & IO_URING_OP_SUPPORTED) ) {
+			close( fd );
+			return -1;
+		}
+	}
+
+	/* map the submission and completion queues (as one if supported) */
+	sq_size = params.sq_off.array + (params.sq_entries * sizeof(unsigned));
+	cq_size = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+	if ( params.features & IORING_FEAT_SINGLE_MMAP ) {
+		sq_size = (cq_size > sq_size) ? cq_size : sq_size;
+	}
+	sq_ring = mmap( NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+	if ( sq_ring == MAP_FAILED ) {
+		close( fd );
+		return -1;
+	}
+	cq_ring = sq_ring;
+	if ( !(params.features & IORING_FEAT_SINGLE_MMAP) ) {
+		cq_ring = mmap( NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+		if ( cq_ring == MAP_FAILED ) {
+			close( fd );
+			return -1;
+		}
+	}
+	uring_sqes = mmap( NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+	if ( uring_sqes == MAP_FAILED ) {
+		close( fd );
+		return -1;
+	}
+
+	uring_sq_tail = (unsigned *) (sq_ring + params.sq_off.tail);
+	uring_sq_mask = *(unsigned *) (sq_ring + params.sq_off.ring_mask);
+	uring_cq_head = (unsigned *) (cq_ring + params.cq_off.head);
+	uring_cq_tail = (unsigned *) (cq_ring + params.cq_off.tail);
+	uring_cq_mask = *(unsigned *) (cq_ring + params.cq_off.ring_mask);
+	uring_cqes = (struct io_uring_cqe *) (cq_ring + params.cq_off.cqes);
+
+	/* each entry of the submission queue always refers to the same request */
+	for ( index = 0; index < params.sq_entries; index++ ) {
+		((unsigned *) (sq_ring + params.sq_off.array))[index] = index;
+	}
+
+	return fd;
+}
+
+/** @brief Reaps the completed requests.
+ *
+ *  This function consumes the completion queue of the io_uring
+ *  instance and then retires the requests completed, in order,
+ *  noting the oldest one which failed. It is called with the mutex
+ *  of the io_uring instance held.
+ *
+ *  @param none
+ *
+ *  @return none
+ */
+static void FSAL_UringReap( void )
+{
+	FSAL_Uring_Slot_t * slot;
+	struct io_uring_cqe * cqe;
+	unsigned head = *uring_cq_head;
+
+	while ( head != __atomic_load_n( uring_cq_tail, __ATOMIC_ACQUIRE ) ) {
+		cqe = &uring_cqes[ head & uring_cq_mask ];
+		slot = &uring_slots[ (uint32_t) cqe->user_data & (FSAL_URING_DEPTH - 1) ];
+		slot->result = cqe->res;
+		slot->done = 1;
+		head++;
+	}
+	__atomic_store_n( uring_cq_head, head, __ATOMIC_RELEASE );
+
+	/* a request which failed (or wrote less) is noted unless an older one did */
+	while ( uring_completed != uring_submitted ) {
+		slot = &uring_slots[ (uring_completed + 1) & (FSAL_URING_DEPTH - 1) ];
+		if ( !slot->done ) {
+			break;
+		}
+		if ( ((slot->result < 0) || ((size_t) slot->result != slot->length)) && (uring_failed == 0) ) {
+			uring_failed = uring_completed + 1;
+		}
+
+		/* a close cancelled along with the rest of a failed chain is done here */
+		if ( (slot->close_fd != -1) && (slot->result == -ECANCELED) ) {
+			close( slot->close_fd );
+		}
+		slot->done = 0;
+		uring_completed++;
+	}
+}
+
+/** @brief Submits the deferred requests.
+ *
+ *  This function submits the requests deferred since the last
+ *  submission, as one chain of linked requests executed in order,
+ *  once the previous submission completed (so that the requests
+ *  complete in the order they were deferred, even those on the same
+ *  file through separate descriptors), and then reaps the completed
+ *  requests. Optionally, it waits for a request to complete. It is
+ *  called with the mutex of the io_uring instance held.
+ *
+ *  @param[in] wait - non-zero to wait for a request to complete
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+static int FSAL_UringSubmit( int wait )
+{
+	unsigned to_submit = 0;
+	int submitted;
+
+	/* the chain of the last submission has to complete first */
+	FSAL_UringReap();
+	if ( uring_completed == uring_submitted ) {
+
+		/* nothing in flight nor deferred */
+		if ( uring_queued == uring_submitted ) {
+			return FSAL_STATUS_OK;
+		}
+
+		/* the chain ends with the last request deferred */
+		to_submit = uring_queued - uring_submitted;
+		uring_sqes[ (*uring_sq_tail - 1) & uring_sq_mask ].flags &= (uint8_t) ~IOSQE_IO_LINK;
+
+	} else if ( !wait ) {
+
+		/* nothing to do until the chain in flight completes */
+		return FSAL_STATUS_OK;
+	}
+
+	do {
+		submitted = (int) syscall( __NR_io_uring_enter, uring_fd, to_submit, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0 );
+	} while ( (submitted < 0) && (errno == EINTR) );
+	if ( submitted < 0 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+	uring_submitted += (uint32_t) submitted;
+
+	FSAL_UringReap();
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Waits for all deferred requests to complete.
+ *
+ *  This function submits the requests deferred so far and waits for
+ *  all of them to complete, so that any request other than a
+ *  deferred one is performed after them.
+ *
+ *  @param none
+ *
+ *  @return none
+ */
+static void FSAL_UringWait( void )
+{
+	PSL_MutexLock( &uring_mutex );
+	while ( uring_completed != uring_queued ) {
+		if ( FSAL_UringSubmit( 1 ) != FSAL_STATUS_OK ) {
+			break;
+		}
+	}
+	PSL_MutexUnlock( &uring_mutex );
+}
+
+/** @brief Prepares a deferred request.
+ *
+ *  This function takes the next entry of the submission queue and
+ *  the slot of the next ticket, making room for one if all of them
+ *  are in flight, and copies the data of the request into the slot.
+ *  It is called with the mutex of the io_uring instance held, and
+ *  the request is deferred by FSAL_UringQueue once filled in.
+ *
+ *  @param[in] data - the reference of the data of the request
+ *
+ *  @param[in] length - the number of bytes of data
+ *
+ *  @return io_uring_sqe* - the reference of the entry of the
+ *                          submission queue or null on failure
+ */
+static struct io_uring_sqe * FSAL_UringPrepare( const void * data, size_t length )
+{
+	FSAL_Uring_Slot_t * slot = &uring_slots[ (uring_queued + 1) & (FSAL_URING_DEPTH - 1) ];
+	struct io_uring_sqe * sqe;
+
+	/* the requests in flight always retire in order */
+	while ( (uring_queued - uring_completed) == FSAL_URING_DEPTH ) {
+		if ( FSAL_UringSubmit( 1 ) != FSAL_STATUS_OK ) {
+			return NULL;
+		}
+	}
+
+	if ( length ) {
+		memcpy( slot->buffer, data, length );
+	}
+	slot->length = 0;
+	slot->close_fd = -1;
+	slot->done = 0;
+
+	sqe = &uring_sqes[ *uring_sq_tail & uring_sq_mask ];
+	memset( sqe, 0, sizeof(struct io_uring_sqe) );
+	sqe->flags = IOSQE_IO_LINK;
+	sqe->user_data = uring_queued + 1;
+
+	return sqe;
+}
+
+/** @brief Defers a prepared request.
+ *
+ *  This function hands the request prepared by FSAL_UringPrepare
+ *  over to the submission queue and submits the requests deferred
+ *  so far once enough of them are. It is called with the mutex of
+ *  the io_uring instance held.
+ *
+ *  @param[in] length - the result expected of the request
+ *
+ *  @return none
+ */
+static void FSAL_UringQueue( size_t length )
+{
+	uring_slots[ (uring_queued + 1) & (FSAL_URING_DEPTH - 1) ].length = length;
+	uring_queued++;
+	__atomic_store_n( uring_sq_tail, *uring_sq_tail + 1, __ATOMIC_RELEASE );
+
+	/* keep the batches large enough to save system calls */
+	if ( (uring_queued - uring_submitted) >= (FSAL_URING_DEPTH / 2) ) {
+		FSAL_UringSubmit( 0 );
+	}
+}
+
+/** @brief Defers a write of a file.
+ *
+ *  This function defers a write of the specified data to a file at
+ *  the specified position if the calling task defers its requests.
+ *
+ *  @param[in] fd - the descriptor of the file to write
+ *
+ *  @param[in] offset - the byte offset in the file where the data
+ *                      is to be written
+ *
+ *  @param[in] buffer - the location reference of the data to be
+ *                      written to the file
+ *
+ *  @param[in] length - the number of bytes to write to the file
+ *
+ *  @return int - non-zero if the write is deferred
+ */
+static int FSAL_UringWrite( int fd, size_t offset, const uint8_t * buffer, size_t length )
+{
+	struct io_uring_sqe * sqe;
+
+	if ( (uring_fd == -1) || !uring_defer || (length > FSAL_URING_BUFFER_SIZE) ) {
+		return 0;
+	}
+
+	PSL_MutexLock( &uring_mutex );
+	sqe = FSAL_UringPrepare( buffer, length );
+	if ( sqe != NULL ) {
+		sqe->opcode = IORING_OP_WRITE;
+		sqe->fd = fd;
+		sqe->addr = (uint64_t) (uintptr_t) uring_slots[ (uring_queued + 1) & (FSAL_URING_DEPTH - 1) ].buffer;
+		sqe->len = (uint32_t) length;
+		sqe->off = (uint64_t) offset;
+		FSAL_UringQueue( length );
+	}
+	PSL_MutexUnlock( &uring_mutex );
+
+	return (sqe != NULL);
+}
+
+/** @brief Opens a file in relative to a directory descriptor.
+ *
+ *  This function opens a file in the filesystem in relative to
+ *  the directory associated with the specified descriptor.
+ *
+ *  @param[in] dir_fd - the descriptor of the directory of the file
+ *                      (or AT_FDCWD for the current directory)
+ *
+ *  @param[in] file_name - the name of the file to open
+ *
+ *  @param[in] flags - the access mode the file when opened
+ *
+ *  @param[out] fsal_handle - the handle of the opened file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+static int FSAL_OpenFileAtFd( int dir_fd, char * file_name, int flags, FSAL_File_t * fsal_handle )
+{
+	int fd;
+	int open_flags = 0;
+
+	/* sanity checks */
+	if ( file_name == NULL ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	if (flags & FSAL_FLAGS_CREATE )
+		open_flags |= O_CREAT;
+
+	if (flags & FSAL_FLAGS_READ_ONLY )
+		open_flags |= O_RDONLY;
+	else if (flags & FSAL_FLAGS_WRITE_ONLY )
+		open_flags |= O_WRONLY;
+	else
+		open_flags |= O_RDWR;
+
+	/* open the specified file */
+	fd = openat( dir_fd, file_name, open_flags, 0777 );
+	if ( fd == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* the file position is only kept for so many descriptors */
+	if ( fd >= FSAL_URING_FILE_MAX ) {
+		close( fd );
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+	uring_position[fd] = 0;
+
+	/* copy the handle to the output parameter */
+	*fsal_handle = (FSAL_File_t) fd;
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Opens a file of a directory.
+ *
+ *  This function opens a file in the directory associated with the
+ *  specified directory handle.
+ *
+ *  @param[in] fsal_dir - the handle of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to open
+ *
+ *  @param[in] flags - the access mode the file when opened
+ *
+ *  @param[out] fsal_handle - the handle of the opened file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_OpenDirFile( FSAL_Dir_t fsal_dir, char * file_name, int flags, FSAL_File_t * fsal_handle )
+{
+	int fd = (int) fsal_dir;
+
+	/* sanity checks */
+	if ( fd == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* open the specified file in relative to the directory */
+	return FSAL_OpenFileAtFd( fd, file_name, flags, fsal_handle );
+}
+
+/** @brief Initializes the filesystem for use
+ *
+ *  This function performs the required filesystem-specific
+ *  initialization sequence.
+ *
+ *  @param none
+ *
+ *  @return none
+ */
+
+void FSAL_Init( void )
+{
+	PSL_MutexInit( &uring_mutex );
+
+	/* without an io_uring instance every request completes right away */
+	uring_fd = FSAL_UringSetup();
+}
+
+/** @brief Creates a directory.
+ *
+ *  This function creates a directory into the filesystem in
+ *  relative to the current directory.
+ *
+ *  @param[in] dir_name - the name of the directory to create
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_MakeDirectory( char * dir_name )
+{
+	/* sanity checks */
+	if ( dir_name == NULL ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* create a directory with read/write access */
+	if ( mkdir(dir_name, 0777) == -1 ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Changes working directory.
+ *
+ *  This function changes the current working directory to another
+ *  directory.
+ *
+ *  @param[in] dir_name - the name of the directory to change in
+ *                        relative to the current directory
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_ChangeDirectory( char * dir_name )
+{
+	/* sanity checks */
+	if ( dir_name == NULL ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* any request deferred completes first */
+	FSAL_UringWait();
+
+	/* change working directory as specified */
+	if ( chdir(dir_name) == -1 ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Removes a directory.
+ *
+ *  This function removes a directory from the filesystem in
+ *  relative to the current directory.
+ *
+ *  @param[in] dir_name - the name of the directory to remove
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_RemoveDirectory( char * dir_name )
+{
+	char file_name[32] = {0};
+	struct dirent * de;
+	DIR * dr;
+
+	/* sanity checks */
+	if ( dir_name == NULL ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* any request deferred completes first */
+	FSAL_UringWait();
+
+	/* open the specified directory */
+	dr = opendir( dir_name );
+	if ( dr == NULL ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* list all files in the directory */
+	de = readdir( dr );
+	while ( de != NULL ) {
+		if ((strcmp(de->d_name, ".") != 0) && (strcmp(de->d_name, "..") != 0)) {
+
+			/* a path cut short would unlink another file (and the directory
+			 * could not be removed with the file left in it anyway) */
+			if ( (unsigned int) snprintf(file_name, sizeof(file_name), "%s/%s", dir_name, de->d_name) >= sizeof(file_name) ) {
+				closedir( dr );
+				return FSAL_ERROR_DIR_ACCESS;
+			}
+			unlink(file_name);
+		}
+		de = readdir( dr );
+	}
+
+	closedir( dr );
+
+	/* delete the specified directory */
+	if ( rmdir(dir_name) == -1 ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Lists all directory entries.
+ *
+ *  This function display a listing of all entries of the current
+ *  directory.
+ *
+ *  @param[in] dir_name - the name of the directory to list entries
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_ListDirectory( char * dir_name )
+{
+	struct dirent * de;
+	DIR * dr;
+
+	/* sanity checks */
+	if ( dir_name == NULL ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* open the specified directory */
+	dr = opendir( dir_name );
+	if ( dr == NULL ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* list all files in the directory */
+	de = readdir( dr );
+	while ( de != NULL ) {
+		printf( "%s\n", de->d_name );
+		de = readdir( dr );
+	}
+
+	closedir( dr );
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Opens a directory.
+ *
+ *  This function opens a directory of the filesystem in relative to
+ *  the current directory so that files within it can be accessed
+ *  later on without changing the current directory.
+ *
+ *  @param[in] dir_name - the name of the directory to open
+ *
+ *  @param[out] fsal_dir - the handle of the opened directory
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_OpenDirectory( char * dir_name, FSAL_Dir_t * fsal_dir )
+{
+	int fd;
+
+	/* sanity checks */
+	if ( (dir_name == NULL) || (fsal_dir == NULL) ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* open the specified directory */
+	fd = open( dir_name, O_RDONLY | O_DIRECTORY );
+	if ( fd == -1 ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* copy the handle to the output parameter */
+	*fsal_dir = (FSAL_Dir_t) fd;
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Closes a directory.
+ *
+ *  This function closes a directory as specified by a specific
+ *  directory handle.
+ *
+ *  @param[in] fsal_dir - the handle associated to the directory
+ *                        to close
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_CloseDirectory( FSAL_Dir_t fsal_dir )
+{
+	int fd = (int) fsal_dir;
+
+	/* sanity check */
+	if ( fd == -1 ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* any request deferred completes first */
+	FSAL_UringWait();
+
+	/* close the directory */
+	close( fd );
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Lists a file and retrieves its size.
+ *
+ *  This function lists a file in the current directory and
+ *  retrieves the file size.
+ *
+ *  @param[in] file_name - the name of the file to list
+ *
+ *  @param[out] file_size - the current size of the file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_ListFile( char * file_name, size_t * file_size )
+{
+	int fd;
+	struct stat st;
+	int status;
+
+	/* sanity checks */
+	if ( file_name == NULL ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* any request deferred completes first */
+	FSAL_UringWait();
+
+	/* open the specified file */
+	fd = open( file_name, O_RDWR, 0 );
+	if ( fd == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* retrieve the file status */
+	status = fstat( fd, &st );
+
+	/* close the file */
+	close( fd );
+
+	/* check for error condition */
+	if ( status == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* copy the file size */
+	*file_size = st.st_size;
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Locks a directory.
+ *
+ *  This function places a shared or an exclusive lock on the
+ *  directory associated with the specified directory handle without
+ *  waiting for it. Any number of shared locks may be held on the
+ *  same directory at the same time while an exclusive lock can only
+ *  be held if no other lock is held on the directory.
+ *
+ *  @param[in] fsal_dir - the handle associated to the directory
+ *                        to lock
+ *
+ *  @param[in] lock_type - the type of lock to place:
+ *
+ *                         FSAL_LOCK_SHARED
+ *                         FSAL_LOCK_EXCLUSIVE
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *                FSAL_ERROR_DIR_LOCKED
+ *
+ */
+int FSAL_LockDirectory( FSAL_Dir_t fsal_dir, int lock_type )
+{
+	int fd = (int) fsal_dir;
+	int operation = (lock_type == FSAL_LOCK_EXCLUSIVE) ? LOCK_EX : LOCK_SH;
+
+	/* sanity check */
+	if ( fd == -1 ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* any request deferred completes first */
+	FSAL_UringWait();
+
+	/* place the advisory lock without blocking (the lock is released
+	 * as well once the directory is closed or the process terminates) */
+	if ( flock( fd, operation | LOCK_NB ) == -1 ) {
+		return (errno == EWOULDBLOCK) ? FSAL_ERROR_DIR_LOCKED : FSAL_ERROR_DIR_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Unlocks a directory.
+ *
+ *  This function releases the lock previously placed on the
+ *  directory associated with the specified directory handle.
+ *
+ *  @param[in] fsal_dir - the handle associated to the directory
+ *                        to unlock
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_UnlockDirectory( FSAL_Dir_t fsal_dir )
+{
+	int fd = (int) fsal_dir;
+
+	/* sanity check */
+	if ( fd == -1 ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* any request deferred completes first */
+	FSAL_UringWait();
+
+	/* release the advisory lock */
+	if ( flock( fd, LOCK_UN ) == -1 ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Lists a file of a directory and retrieves its size.
+ *
+ *  This function lists a file in the directory associated with the
+ *  specified directory handle and retrieves the file size.
+ *
+ *  @param[in] fsal_dir - the handle of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to list
+ *
+ *  @param[out] file_size - the current size of the file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_ListDirFile( FSAL_Dir_t fsal_dir, char * file_name, size_t * file_size )
+{
+	int fd = (int) fsal_dir;
+	struct stat st;
+
+	/* sanity checks */
+	if ( (fd == -1) || (file_name == NULL) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* any request deferred completes first */
+	FSAL_UringWait();
+
+	/* retrieve the file status without opening the file */
+	if ( (fstatat( fd, file_name, &st, 0 ) == -1) ||
+		 (!S_ISREG(st.st_mode)) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* copy the file size */
+	*file_size = st.st_size;
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Opens a file.
+ *
+ *  This function opens a file in the filesystem in relative to
+ *  the current directory.
+ *
+ *  @param[in] file_name - the name of the file to open
+ *
+ *  @param[in] flags - the access mode the file when opened
+ *
+ *  @param[out] fsal_handle - the handle of the opened file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_OpenFile( char * file_name, int flags, FSAL_File_t * fsal_handle )
+{
+	/* open the specified file in relative to the current directory */
+	return FSAL_OpenFileAtFd( AT_FDCWD, file_name, flags, fsal_handle );
+}
+
+/** @brief Closes a file.
+ *
+ *  This function closes a file as specified by a specific file
+ *  handle.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to close
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_CloseFile( FSAL_File_t fsal_handle )
+{
+	int fd = (int) fsal_handle;
+
+	struct io_uring_sqe * sqe = NULL;
+
+	/* sanity check */
+	if ( fd == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* close the file after the requests deferred on it, if possible */
+	if ( (uring_fd != -1) && uring_defer ) {
+		PSL_MutexLock( &uring_mutex );
+		sqe = FSAL_UringPrepare( NULL, 0 );
+		if ( sqe != NULL ) {
+			sqe->opcode = IORING_OP_CLOSE;
+			sqe->fd = fd;
+			uring_slots[ (uring_queued + 1) & (FSAL_URING_DEPTH - 1) ].close_fd = fd;
+			FSAL_UringQueue( 0 );
+		}
+		PSL_MutexUnlock( &uring_mutex );
+	}
+	if ( sqe == NULL ) {
+		FSAL_UringWait();
+		close( fd );
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Synchronizes a file with the storage media.
+ *
+ *  This function writes back whatever the filesystem still buffers
+ *  of the file as specified by a specific file handle, so that the
+ *  data written so far survives a power loss.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to synchronize
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_SyncFile( FSAL_File_t fsal_handle )
+{
+	int fd = (int) fsal_handle;
+
+	/* sanity check */
+	if ( fd == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* any request deferred completes first */
+	FSAL_UringWait();
+
+	/* flush the data (and the metadata needed to retrieve it) to the media */
+	if ( fdatasync( fd ) == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Allocates the storage of a file up front.
+ *
+ *  This function extends the file as specified by a specific file
+ *  handle to (at least) the specified length and reserves the storage
+ *  media for it, so that writing the file within that length later on
+ *  never has to allocate any more (and, where the filesystem allows
+ *  it, lands on contiguous clusters). What the file holds past its
+ *  previous end is left unspecified. A file already that long is left
+ *  as it is.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to allocate
+ *
+ *  @param[in] length - the number of bytes to allocate the file for
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_AllocateFile( FSAL_File_t fsal_handle, size_t length )
+{
+	int fd = (int) fsal_handle;
+
+	/* sanity check */
+	if ( fd == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* reserve the blocks of the file (which reads as zeroes past its previous end) */
+	if ( (length != 0) && (posix_fallocate( fd, 0, (off_t) length ) != 0) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Reads from a file.
+ *
+ *  This function reads data from a file as specified by a specific
+ *  file handle.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to read
+ *
+ *  @param[in] buffer - the location reference where the contents
+ *                      of the file will be stored
+ *
+ *  @param[in] length - the maximum bytes the location reference
+                        can store
+ *
+ *  @return int - the number of bytes actually read or a negative
+ *                error code if the operation failed
+ *
+ */
+ssize_t FSAL_ReadFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length )
+{
+	int fd = (int) fsal_handle;
+	ssize_t actual_length = 0;
+
+	/* sanity checks */
+	if ( (fd == -1) || (buffer == NULL) ) {
+		return -FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* any request deferred completes first */
+	FSAL_UringWait();
+
+	/* proceed operation with nonzero length */
+	if ( length ) {
+		actual_length = pread( fd, buffer, length, (off_t) uring_position[fd] );
+		if ( actual_length == -1 ) {
+			return -FSAL_ERROR_FILE_ACCESS;
+		}
+		uring_position[fd] += (size_t) actual_length;
+	}
+
+	return actual_length;
+}
+
+/** @brief Reads from a file at a specific position.
+ *
+ *  This function reads data from a file as specified by a specific
+ *  file handle, starting at the specified byte offset from the
+ *  beginning of the file.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to read
+ *
+ *  @param[in] offset - the byte offset in the file where the data
+ *                      is to be read from
+ *
+ *  @param[in] buffer - the location reference where the contents
+ *                      of the file will be stored
+ *
+ *  @param[in] length - the maximum bytes the location reference
+                        can store
+ *
+ *  @return int - the number of bytes actually read or a negative
+ *                error code if the operation failed
+ *
+ */
+ssize_t FSAL_ReadFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length )
+{
+	int fd = (int) fsal_handle;
+	ssize_t actual_length = 0;
+
+	/* sanity checks */
+	if ( (fd == -1) || (buffer == NULL) ) {
+		return -FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* any request deferred completes first */
+	FSAL_UringWait();
+
+	/* proceed operation with nonzero length */
+	if ( length ) {
+		actual_length = pread( fd, buffer, length, (off_t) offset );
+		if ( actual_length == -1 ) {
+			return -FSAL_ERROR_FILE_ACCESS;
+		}
+	}
+
+	return actual_length;
+}
+
+/** @brief Writes to a file.
+ *
+ *  This function writes data to a file as specified by a specific
+ *  file handle.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to write
+ *
+ *  @param[in] buffer - the location reference of the data to be
+ *                      written to the file
+ *
+ *  @param[in] length - the number of bytes to write to the file
+ *
+ *  @return int - the number of bytes actually written or a negative
+ *                error code if the operation failed
+ *
+ */
+ssize_t FSAL_WriteFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length )
+{
+	int fd = (int) fsal_handle;
+	ssize_t actual_length = 0;
+
+	/* sanity checks */
+	if ( (fd == -1) || (buffer == NULL) ) {
+		return -FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* proceed operation with nonzero length (deferred if possible) */
+	if ( length ) {
+		if ( FSAL_UringWrite( fd, uring_position[fd], buffer, length ) ) {
+			actual_length = (ssize_t) length;
+		} else {
+			FSAL_UringWait();
+			actual_length = pwrite( fd, buffer, length, (off_t) uring_position[fd] );
+			if ( actual_length == -1 ) {
+				return -FSAL_ERROR_FILE_ACCESS;
+			}
+		}
+		uring_position[fd] += (size_t) actual_length;
+	}
+
+	return actual_length;
+}
+
+/** @brief Writes to a file at a specific position.
+ *
+ *  This function writes data to a file as specified by a specific
+ *  file handle, starting at the specified byte offset from the
+ *  beginning of the file. Bytes outside of the written range are
+ *  left untouched.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to write
+ *
+ *  @param[in] offset - the byte offset in the file where the data
+ *                      is to be written
+ *
+ *  @param[in] buffer - the location reference of the data to be
+ *                      written to the file
+ *
+ *  @param[in] length - the number of bytes to write to the file
+ *
+ *  @return int - the number of bytes actually written or a negative
+ *                error code if the operation failed
+ *
+ */
+ssize_t FSAL_WriteFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length )
+{
+	int fd = (int) fsal_handle;
+	ssize_t actual_length = 0;
+
+	/* sanity checks */
+	if ( (fd == -1) || (buffer == NULL) ) {
+		return -FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* proceed operation with nonzero length (deferred if possible) */
+	if ( length ) {
+		if ( FSAL_UringWrite( fd, offset, buffer, length ) ) {
+			actual_length = (ssize_t) length;
+		} else {
+			FSAL_UringWait();
+			actual_length = pwrite( fd, buffer, length, (off_t) offset );
+			if ( actual_length == -1 ) {
+				return -FSAL_ERROR_FILE_ACCESS;
+			}
+		}
+	}
+
+	return actual_length;
+}
+
+/** @brief Maps a part of a file into memory.
+ *
+ *  This function maps the specified range of a file as specified
+ *  by a specific file handle into memory for read-only access. The
+ *  mapping stays valid after the file is closed, until it is
+ *  unmapped.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to map
+ *
+ *  @param[in] offset - the byte offset in the file where the range
+ *                      to map starts
+ *
+ *  @param[in] length - the number of bytes to map
+ *
+ *  @param[out] data - the reference where the location of the
+ *                     mapped range is set
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_MapFile( FSAL_File_t fsal_handle, size_t offset, size_t length, const uint8_t ** data )
+{
+	int fd = (int) fsal_handle;
+	size_t page_offset;
+	void * mapping;
+
+	/* sanity checks */
+	if ( (fd == -1) || (data == NULL) || (length == 0) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* any request deferred completes first */
+	FSAL_UringWait();
+
+	/* a mapping must start at a page boundary */
+	page_offset = offset % (size_t) sysconf( _SC_PAGESIZE );
+
+	mapping = mmap( NULL, length + page_offset, PROT_READ, MAP_SHARED, fd, (off_t)(offset - page_offset) );
+	if ( mapping == MAP_FAILED ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	*data = (const uint8_t *) mapping + page_offset;
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Unmaps a part of a file from memory.
+ *
+ *  This function releases a range of a file previously mapped into
+ *  memory.
+ *
+ *  @param[in] data - the location of the mapped range
+ *
+ *  @param[in] offset - the byte offset in the file where the mapped
+ *                      range starts
+ *
+ *  @param[in] length - the number of bytes mapped
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_UnmapFile( const uint8_t * data, size_t offset, size_t length )
+{
+	size_t page_offset;
+
+	/* sanity checks */
+	if ( data == NULL ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* the mapping started at the page boundary */
+	page_offset = offset % (size_t) sysconf( _SC_PAGESIZE );
+
+	if ( munmap( (void *)(data - page_offset), length + page_offset ) == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Maps a part of a file into memory for writing.
+ *
+ *  This function maps the specified range of a file as specified
+ *  by a specific file handle into memory for read and write access.
+ *  Stores into the mapped range are shared with the file, which is
+ *  updated by the filesystem on its own or when the mapped range is
+ *  synchronized. The mapping stays valid after the file is closed,
+ *  until it is unmapped.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to map (opened for read and write)
+ *
+ *  @param[in] offset - the byte offset in the file where the range
+ *                      to map starts
+ *
+ *  @param[in] length - the number of bytes to map
+ *
+ *  @param[out] data - the reference where the location of the
+ *                     mapped range is set
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_MapFileWritable( FSAL_File_t fsal_handle, size_t offset, size_t length, uint8_t ** data )
+{
+	int fd = (int) fsal_handle;
+	size_t page_offset;
+	void * mapping;
+
+	/* sanity checks */
+	if ( (fd == -1) || (data == NULL) || (length == 0) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* any request deferred completes first */
+	FSAL_UringWait();
+
+	/* a mapping must start at a page boundary */
+	page_offset = offset % (size_t) sysconf( _SC_PAGESIZE );
+
+	mapping = mmap( NULL, length + page_offset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t)(offset - page_offset) );
+	if ( mapping == MAP_FAILED ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	*data = (uint8_t *) mapping + page_offset;
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Synchronizes a part of a file mapped into memory.
+ *
+ *  This function writes the stores into a range of a file mapped
+ *  for writing back to the file, either by scheduling the write
+ *  or by waiting for the write to complete.
+ *
+ *  @param[in] data - the location of the mapped range
+ *
+ *  @param[in] offset - the byte offset in the file where the mapped
+ *                      range starts
+ *
+ *  @param[in] length - the number of bytes mapped
+ *
+ *  @param[in] sync_type - the type of synchronization to perform:
+ *
+ *                         FSAL_SYNC_ASYNC
+ *                         FSAL_SYNC_WAIT
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_SyncMappedFile( const uint8_t * data, size_t offset, size_t length, int sync_type )
+{
+	size_t page_offset;
+
+	/* sanity checks */
+	if ( data == NULL ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* any request deferred completes first */
+	FSAL_UringWait();
+
+	/* the mapping started at the page boundary */
+	page_offset = offset % (size_t) sysconf( _SC_PAGESIZE );
+
+	if ( msync( (void *)(data - page_offset), length + page_offset, (sync_type == FSAL_SYNC_WAIT) ? MS_SYNC : MS_ASYNC ) == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Deletes a file.
+ *
+ *  This function deletes a file from the filesystem in
+ *  relative to the current directory.
+ *
+ *  @param[in] file_name - the name of the file to remove
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_DeleteFile( char * file_name )
+{
+	/* sanity checks */
+	if ( file_name == NULL ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* any request deferred completes first */
+	FSAL_UringWait();
+
+	/* delete the specified file */
+	if ( unlink(file_name) == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Deletes a file of a directory.
+ *
+ *  This function deletes a file from the directory associated with
+ *  the specified directory handle.
+ *
+ *  @param[in] fsal_dir - the handle of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to remove
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_DeleteDirFile( FSAL_Dir_t fsal_dir, char * file_name )
+{
+	int fd = (int) fsal_dir;
+
+	struct io_uring_sqe * sqe = NULL;
+
+	/* sanity checks */
+	if ( (fd == -1) || (file_name == NULL) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* delete the file after the requests deferred on it, if possible */
+	if ( (uring_fd != -1) && uring_defer && (strlen(file_name) < FSAL_URING_BUFFER_SIZE) ) {
+		PSL_MutexLock( &uring_mutex );
+		sqe = FSAL_UringPrepare( file_name, strlen(file_name) + 1 );
+		if ( sqe != NULL ) {
+			sqe->opcode = IORING_OP_UNLINKAT;
+			sqe->fd = fd;
+			sqe->addr = (uint64_t) (uintptr_t) uring_slots[ (uring_queued + 1) & (FSAL_URING_DEPTH - 1) ].buffer;
+			FSAL_UringQueue( 0 );
+		}
+		PSL_MutexUnlock( &uring_mutex );
+	}
+	if ( sqe != NULL ) {
+		return FSAL_STATUS_OK;
+	}
+
+	/* delete the specified file */
+	FSAL_UringWait();
+	if ( unlinkat(fd, file_name, 0) == -1 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Defers the writes of the calling task.
+ *
+ *  This function sets whether the writes, closes and deletes of
+ *  files requested by the calling task (or thread) from now on are
+ *  deferred: such a call then returns once the request is queued
+ *  into the io_uring instance (the data written copied) and the
+ *  request completes later, in the order it was queued. Any other
+ *  call waits for all deferred requests to complete first.
+ *
+ *  @param[in] defer - non-zero to defer the requests, zero otherwise
+ *
+ *  @return none
+ */
+void FSAL_DeferWrites( int defer )
+{
+	uring_defer = defer;
+}
+
+/** @brief Retrieves the ticket of the last deferred write.
+ *
+ *  This function retrieves the ticket of the last request deferred
+ *  so far by any task (the tickets are numbered from 1 in the
+ *  order the requests are deferred, wrapping around).
+ *
+ *  @param none
+ *
+ *  @return uint32_t - the ticket of the last deferred request
+ */
+uint32_t FSAL_GetWriteTicket( void )
+{
+	uint32_t ticket;
+
+	PSL_MutexLock( &uring_mutex );
+	ticket = uring_queued;
+	PSL_MutexUnlock( &uring_mutex );
+
+	return ticket;
+}
+
+/** @brief Polls the deferred writes for completion.
+ *
+ *  This function submits the requests deferred so far and reaps
+ *  those completed, without waiting or waiting for all of them to
+ *  complete, and then retrieves the ticket up to which all requests
+ *  completed and the ticket of the oldest request which failed
+ *  since the last call (or zero if none).
+ *
+ *  @param[in] sync_type - the type of synchronization to perform:
+ *
+ *                         FSAL_SYNC_ASYNC
+ *                         FSAL_SYNC_WAIT
+ *
+ *  @param[out] completed - the ticket up to which all requests
+ *                          completed
+ *
+ *  @param[out] failed - the ticket of the oldest failed request
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_PollWrites( int sync_type, uint32_t * completed, uint32_t * failed )
+{
+	int status = FSAL_STATUS_OK;
+
+	/* sanity checks */
+	if ( (completed == NULL) || (failed == NULL) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	PSL_MutexLock( &uring_mutex );
+	if ( uring_fd != -1 ) {
+		status = FSAL_UringSubmit( 0 );
+		while ( (status == FSAL_STATUS_OK) && (sync_type == FSAL_SYNC_WAIT) && (uring_completed != uring_queued) ) {
+			status = FSAL_UringSubmit( 1 );
+		}
+	}
+	*completed = uring_completed;
+	*failed = uring_failed;
+	uring_failed = 0;
+	PSL_MutexUnlock( &uring_mutex );
+
+	return status;
+}
+
+#endif /* FSAL_LINUX_URING */
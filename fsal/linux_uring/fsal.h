@@ -0,0 +1,45 @@
+/**********************************************************************
+* Filename:     fsal.h
+*
+* Copyright 2018, Swift Labs / TR
+*
+* Author:       Ronald Miranda / Emil Ekmecic
+*
+* Created:      October 14, 2026
+*
+* Description:  This is the header file associated with the Filesystem
+*               Abstraction Layer or FASL specific to the Linux EXT4
+*               filesystem accessed through an io_uring instance.
+*
+* History
+* 14-Oct-2026   RMM      Initial code based on the Linux EXT4 FSAL.
+**********************************************************************/
+
+#ifndef __FSAL_LINUX_URING_H__
+#define __FSAL_LINUX_URING_H__
+
+#ifdef FSAL_LINUX_URING
+
+/**
+ * Number of deferred writes in flight at the same time (a power
+ * of two, the depth of the submission queue) and size of the copy
+ * of each (larger writes are never deferred)
+ */
+#if !defined( FSAL_URING_DEPTH )
+#define FSAL_URING_DEPTH				64
+#endif
+#if !defined( FSAL_URING_BUFFER_SIZE )
+#define FSAL_URING_BUFFER_SIZE			4096
+#endif
+
+/**
+ * Number of file descriptors whose file position is kept by the
+ * FSAL (files opened with a larger descriptor are closed again)
+ */
+#if !defined( FSAL_URING_FILE_MAX )
+#define FSAL_URING_FILE_MAX				1024
+#endif
+
+#endif /* FSAL_LINUX_URING */
+
+#endif /*__FSAL_LINUX_URING_H__ */
@@ -0,0 +1,1759 @@
+/**********************************************************************
+* Filename:     fsal.c
+*
+* Copyright 2018, Swift Labs / TR
+*
+* Author:       Ronald Miranda / Emil Ekmecic
+*
+* Created:      October 14, 2026
+*
+* Description:  This is the Filesystem Abstraction Layer or FSAL specific
+*               to a volatile filesystem kept in RAM. This file implements
+*               all required FSAL functions which are referenced by the
+*               data queue application API, storing the contents of all
+*               files into a statically allocated arena of blocks.
+*
+* History
+* 14-Oct-2026   RMM      Initial code replacing the stub filesystem.
+**********************************************************************/
+
+#ifdef FSAL_RAM
+
+#include "../../inc/fsal.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * Arena of blocks holding the contents of all files and the link
+ * from each block to the next block of the same file (or whether
+ * the block is free or the last one of its file)
+ */
+#define FSAL_RAM_BLOCK_FREE		0xFFFF
+#define FSAL_RAM_BLOCK_END		0xFFFE
+#if FSAL_RAM_BLOCK_COUNT >= FSAL_RAM_BLOCK_END
+#error "FSAL_RAM_BLOCK_COUNT exceeds the number of blocks which can be linked"
+#endif
+static uint8_t ram_block_store[FSAL_RAM_BLOCK_COUNT][FSAL_RAM_BLOCK_SIZE];
+static uint16_t ram_block_next[FSAL_RAM_BLOCK_COUNT];
+static uint32_t ram_block_hint;
+
+/**
+ * Full paths of the existing directories (the root directory is
+ * always the first one) and the current working directory
+ */
+#define FSAL_RAM_ROOT_DIR		0
+typedef struct FSAL_RAM_Dir {
+	int used;
+	char path[FSAL_PATH_NAME_MAX];
+} FSAL_RAM_Dir_t;
+static FSAL_RAM_Dir_t ram_dir_list[FSAL_RAM_DIR_MAX];
+static int current_working_dir = FSAL_RAM_ROOT_DIR;
+
+/**
+ * Existing files, hashed by their directory and name into the
+ * list with linear probing
+ */
+#define FSAL_RAM_FILE_FREE		-1
+typedef struct FSAL_RAM_File {
+	int dir;
+	char name[FSAL_RAM_NAME_MAX];
+	size_t size;
+	uint16_t first;
+} FSAL_RAM_File_t;
+static FSAL_RAM_File_t ram_file_list[FSAL_RAM_FILE_MAX];
+
+/**
+ * Currently opened files (indexed by the file handle) and the
+ * file each is opened for (or whether its file was deleted since)
+ */
+#define FSAL_RAM_FILE_DELETED	-2
+typedef struct FSAL_RAM_Handle {
+	int file;
+	int flags;
+	size_t position;
+} FSAL_RAM_Handle_t;
+static FSAL_RAM_Handle_t file_handle_list[FSAL_FILE_LIST_MAX];
+
+/**
+ * Directory of each of the currently opened directories (indexed
+ * by the directory handle) and the type of lock placed through it
+ */
+#define FSAL_DIR_CLOSED			-1
+#define FSAL_DIR_UNLOCKED		-1
+static int dir_handle_list[FSAL_DIR_LIST_MAX];
+static int dir_lock_list[FSAL_DIR_LIST_MAX];
+
+/**
+ * Mutex guarding all of the above from concurrent tasks
+ */
+static PSL_Mutex_t ram_mutex;
+
+/** @brief Hashes a file into the file list.
+ *
+ *  This function computes the slot of the file list where the
+ *  lookup of the specified file starts.
+ *
+ *  @param[in] dir - the index of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file
+ *
+ *  @return uint32_t - the slot of the file list
+ *
+ */
+static uint32_t FSAL_RamHash( int dir, const char * file_name )
+{
+	uint32_t hash = 2166136261u ^ (uint32_t) dir;
+
+	/* FNV-1a over the name of the file */
+	while ( *file_name != '\0' ) {
+		hash ^= (uint8_t) *file_name++;
+		hash *= 16777619u;
+	}
+
+	return hash % FSAL_RAM_FILE_MAX;
+}
+
+/** @brief Looks up a file.
+ *
+ *  This function looks up the specified file of a directory in
+ *  the file list.
+ *
+ *  @param[in] dir - the index of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file
+ *
+ *  @return int - the index of the file or -1 if it does not exist
+ *
+ */
+static int FSAL_RamFindFile( int dir, const char * file_name )
+{
+	uint32_t slot = FSAL_RamHash( dir, file_name );
+	int probe;
+
+	for ( probe = 0; probe < FSAL_RAM_FILE_MAX; probe++ ) {
+		if ( ram_file_list[slot].dir == FSAL_RAM_FILE_FREE ) {
+			break;
+		}
+		if ( (ram_file_list[slot].dir == dir) &&
+			 (strcmp(ram_file_list[slot].name, file_name) == 0) ) {
+			return (int) slot;
+		}
+		slot = (slot + 1) % FSAL_RAM_FILE_MAX;
+	}
+
+	return -1;
+}
+
+/** @brief Creates an empty file.
+ *
+ *  This function adds the specified (not yet existing) file of a
+ *  directory to the file list.
+ *
+ *  @param[in] dir - the index of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file
+ *
+ *  @return int - the index of the file or -1 if no more files can
+ *                be created
+ *
+ */
+static int FSAL_RamCreateFile( int dir, const char * file_name )
+{
+	uint32_t slot = FSAL_RamHash( dir, file_name );
+	int probe;
+
+	/* sanity check */
+	if ( strlen(file_name) >= FSAL_RAM_NAME_MAX ) {
+		return -1;
+	}
+
+	for ( probe = 0; probe < FSAL_RAM_FILE_MAX; probe++ ) {
+		if ( ram_file_list[slot].dir == FSAL_RAM_FILE_FREE ) {
+			ram_file_list[slot].dir = dir;
+			snprintf( ram_file_list[slot].name, sizeof(ram_file_list[slot].name), "%s", file_name );
+			ram_file_list[slot].size = 0;
+			ram_file_list[slot].first = FSAL_RAM_BLOCK_END;
+			return (int) slot;
+		}
+		slot = (slot + 1) % FSAL_RAM_FILE_MAX;
+	}
+
+	return -1;
+}
+
+/** @brief Removes a file.
+ *
+ *  This function returns the blocks of the specified file to the
+ *  arena, invalidates the handles it is opened with and removes it
+ *  from the file list (moving back the files probed past it so that
+ *  they can still be looked up).
+ *
+ *  @param[in] file - the index of the file to remove
+ *
+ *  @return none
+ *
+ */
+static void FSAL_RamRemoveFile( int file )
+{
+	uint32_t hole = (uint32_t) file;
+	uint32_t next = (uint32_t) file;
+	uint32_t home;
+	uint16_t block;
+	int index;
+
+	/* release the blocks of the file */
+	block = ram_file_list[file].first;
+	while ( block != FSAL_RAM_BLOCK_END ) {
+		uint16_t next_block = ram_block_next[block];
+		ram_block_next[block] = FSAL_RAM_BLOCK_FREE;
+		block = next_block;
+	}
+
+	/* the file can no longer be accessed through its handles */
+	for ( index = 0; index < FSAL_FILE_LIST_MAX; index++ ) {
+		if ( file_handle_list[index].file == file ) {
+			file_handle_list[index].file = FSAL_RAM_FILE_DELETED;
+		}
+	}
+
+	/* close the gap left in the probe sequence */
+	ram_file_list[hole].dir = FSAL_RAM_FILE_FREE;
+	for ( ;; ) {
+		next = (next + 1) % FSAL_RAM_FILE_MAX;
+		if ( ram_file_list[next].dir == FSAL_RAM_FILE_FREE ) {
+			break;
+		}
+
+		/* a file whose lookup starts past the gap stays where it is */
+		home = FSAL_RamHash( ram_file_list[next].dir, ram_file_list[next].name );
+		if ( (hole <= next) ? ((home > hole) && (home <= next)) : ((home > hole) || (home <= next)) ) {
+			continue;
+		}
+
+		/* otherwise move it into the gap (along with its handles) */
+		ram_file_list[hole] = ram_file_list[next];
+		ram_file_list[next].dir = FSAL_RAM_FILE_FREE;
+		for ( index = 0; index < FSAL_FILE_LIST_MAX; index++ ) {
+			if ( file_handle_list[index].file == (int) next ) {
+				file_handle_list[index].file = (int) hole;
+			}
+		}
+		hole = next;
+	}
+}
+
+/** @brief Allocates a block from the arena.
+ *
+ *  This function claims a free block of the arena as the last one
+ *  of a file and clears its contents.
+ *
+ *  @param none
+ *
+ *  @return uint16_t - the index of the block or FSAL_RAM_BLOCK_END
+ *                     if the arena is full
+ *
+ */
+static uint16_t FSAL_RamAllocBlock( void )
+{
+	uint32_t count;
+	uint32_t block;
+
+	for ( count = 0; count < FSAL_RAM_BLOCK_COUNT; count++ ) {
+		block = ram_block_hint;
+		ram_block_hint = (ram_block_hint + 1) % FSAL_RAM_BLOCK_COUNT;
+		if ( ram_block_next[block] == FSAL_RAM_BLOCK_FREE ) {
+			ram_block_next[block] = FSAL_RAM_BLOCK_END;
+			memset( ram_block_store[block], 0, FSAL_RAM_BLOCK_SIZE );
+			return (uint16_t) block;
+		}
+	}
+
+	return FSAL_RAM_BLOCK_END;
+}
+
+/** @brief Reads from a file at a specific position.
+ *
+ *  This function copies the contents of a file, starting at the
+ *  specified byte offset, out of the blocks holding them.
+ *
+ *  @param[in] file - the index of the file to read
+ *
+ *  @param[in] offset - the byte offset in the file where the data
+ *                      is to be read from
+ *
+ *  @param[in] buffer - the location reference where the contents
+ *                      of the file will be stored
+ *
+ *  @param[in] length - the maximum bytes the location reference
+ *                      can store
+ *
+ *  @return ssize_t - the number of bytes actually read
+ *
+ */
+static ssize_t FSAL_RamRead( int file, size_t offset, uint8_t * buffer, size_t length )
+{
+	FSAL_RAM_File_t * ram_file = &ram_file_list[file];
+	uint16_t block = ram_file->first;
+	size_t block_offs = offset;
+	size_t actual_length = 0;
+	size_t chunk;
+
+	/* nothing to read past the end of the file */
+	if ( offset >= ram_file->size ) {
+		return 0;
+	}
+	if ( length > (ram_file->size - offset) ) {
+		length = ram_file->size - offset;
+	}
+
+	/* walk the blocks of the file up to the one holding the offset */
+	while ( block_offs >= FSAL_RAM_BLOCK_SIZE ) {
+		block = ram_block_next[block];
+		block_offs -= FSAL_RAM_BLOCK_SIZE;
+	}
+
+	/* and copy from there */
+	while ( actual_length < length ) {
+		chunk = FSAL_RAM_BLOCK_SIZE - block_offs;
+		if ( chunk > (length - actual_length) ) {
+			chunk = length - actual_length;
+		}
+		memcpy( &buffer[actual_length], &ram_block_store[block][block_offs], chunk );
+		actual_length += chunk;
+		block = ram_block_next[block];
+		block_offs = 0;
+	}
+
+	return (ssize_t) actual_length;
+}
+
+/** @brief Writes to a file at a specific position.
+ *
+ *  This function copies data into the blocks of a file, starting
+ *  at the specified byte offset and allocating the blocks the file
+ *  grows into (a gap past the former end of the file reads as
+ *  zeroes).
+ *
+ *  @param[in] file - the index of the file to write
+ *
+ *  @param[in] offset - the byte offset in the file where the data
+ *                      is to be written
+ *
+ *  @param[in] buffer - the location reference of the data to be
+ *                      written to the file
+ *
+ *  @param[in] length - the number of bytes to write to the file
+ *
+ *  @return ssize_t - the number of bytes actually written or a
+ *                    negative error code if the arena is full
+ *
+ */
+static ssize_t FSAL_RamWrite( int file, size_t offset, uint8_t * buffer, size_t length )
+{
+	FSAL_RAM_File_t * ram_file = &ram_file_list[file];
+	uint16_t * link = &ram_file->first;
+	size_t block_offs = offset;
+	size_t actual_length = 0;
+	size_t chunk;
+
+	while ( actual_length < length ) {
+
+		/* grow the file by another block when needed */
+		if ( (*link == FSAL_RAM_BLOCK_END) &&
+			 ((*link = FSAL_RamAllocBlock()) == FSAL_RAM_BLOCK_END) ) {
+			break;
+		}
+
+		/* walk the blocks of the file up to the one holding the offset */
+		if ( block_offs >= FSAL_RAM_BLOCK_SIZE ) {
+			block_offs -= FSAL_RAM_BLOCK_SIZE;
+			link = &ram_block_next[*link];
+			continue;
+		}
+
+		/* and copy from there */
+		chunk = FSAL_RAM_BLOCK_SIZE - block_offs;
+		if ( chunk > (length - actual_length) ) {
+			chunk = length - actual_length;
+		}
+		memcpy( &ram_block_store[*link][block_offs], &buffer[actual_length], chunk );
+		actual_length += chunk;
+		block_offs += chunk;
+	}
+
+	if ( (offset + actual_length) > ram_file->size ) {
+		ram_file->size = offset + actual_length;
+	}
+
+	/* the arena is full */
+	if ( (actual_length == 0) && (length != 0) ) {
+		return -FSAL_ERROR_FILE_ACCESS;
+	}
+
+	return (ssize_t) actual_length;
+}
+
+/** @brief Maps a part of a file into memory.
+ *
+ *  This function locates the specified range of a file within the
+ *  arena, which is only possible if the range lies within a single
+ *  block.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to map
+ *
+ *  @param[in] offset - the byte offset in the file where the range
+ *                      to map starts
+ *
+ *  @param[in] length - the number of bytes to map
+ *
+ *  @param[in] writable - whether the range is mapped for writing
+ *
+ *  @param[out] data - the reference where the location of the
+ *                     mapped range is set
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+static int FSAL_RamMap( FSAL_File_t fsal_handle, size_t offset, size_t length, int writable, uint8_t ** data )
+{
+	int index = (int) fsal_handle;
+	int fsal_status = FSAL_STATUS_OK;
+	size_t block_offs = offset;
+	uint16_t block;
+	int file;
+
+	/* sanity checks */
+	if ( (index < 0) || (index >= FSAL_FILE_LIST_MAX) || (data == NULL) || (length == 0) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	PSL_MutexLock( &ram_mutex );
+
+	file = file_handle_list[index].file;
+	if ( (file < 0) ||
+		 (writable && (file_handle_list[index].flags & FSAL_FLAGS_READ_ONLY)) ||
+		 ((offset + length) > ram_file_list[file].size) ) {
+
+		fsal_status = FSAL_ERROR_FILE_ACCESS;
+
+	} else if ( ((offset % FSAL_RAM_BLOCK_SIZE) + length) > FSAL_RAM_BLOCK_SIZE ) {
+
+		/* the range spans blocks that are not contiguous */
+		fsal_status = FSAL_ERROR_NOT_SUPPORTED;
+
+	} else {
+
+		/* walk the blocks of the file up to the one holding the range */
+		block = ram_file_list[file].first;
+		while ( block_offs >= FSAL_RAM_BLOCK_SIZE ) {
+			block = ram_block_next[block];
+			block_offs -= FSAL_RAM_BLOCK_SIZE;
+		}
+		*data = &ram_block_store[block][block_offs];
+	}
+
+	PSL_MutexUnlock( &ram_mutex );
+
+	return fsal_status;
+}
+
+/** @brief Builds the full path of a directory.
+ *
+ *  This function builds the full path of a directory as specified
+ *  by its name in relative to another directory.
+ *
+ *  @param[out] dir_path - the location where the full path is stored
+ *                         (FSAL_PATH_NAME_MAX bytes long)
+ *
+ *  @param[in] parent - the index of the directory the name is in
+ *                      relative to
+ *
+ *  @param[in] dir_name - the name of the directory
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+static int FSAL_RamDirPath( char * dir_path, int parent, const char * dir_name )
+{
+	int length;
+
+	if ( ram_dir_list[parent].path[0] == '\0' ) {
+		length = snprintf( dir_path, FSAL_PATH_NAME_MAX, "%s", dir_name );
+	} else {
+		length = snprintf( dir_path, FSAL_PATH_NAME_MAX, "%s/%s", ram_dir_list[parent].path, dir_name );
+	}
+
+	/* an empty or truncated path denotes no directory */
+	if ( (length <= 0) || (length >= FSAL_PATH_NAME_MAX) || (dir_name[0] == '\0') ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Looks up a directory.
+ *
+ *  This function looks up a directory as specified by its name in
+ *  relative to the current directory.
+ *
+ *  @param[in] dir_name - the name of the directory
+ *
+ *  @return int - the index of the directory or -1 if it does not
+ *                exist
+ *
+ */
+static int FSAL_RamFindDir( const char * dir_name )
+{
+	char dir_path[FSAL_PATH_NAME_MAX] = {0};
+	int index;
+
+	if ( FSAL_RamDirPath( dir_path, current_working_dir, dir_name ) != FSAL_STATUS_OK ) {
+		return -1;
+	}
+
+	for ( index = 0; index < FSAL_RAM_DIR_MAX; index++ ) {
+		if ( ram_dir_list[index].used &&
+			 (strcmp(ram_dir_list[index].path, dir_path) == 0) ) {
+			return index;
+		}
+	}
+
+	return -1;
+}
+
+/** @brief Retrieves the directory of a directory handle.
+ *
+ *  This function retrieves the directory opened with the specified
+ *  directory handle.
+ *
+ *  @param[in] fsal_dir - the handle of the directory
+ *
+ *  @return int - the index of the directory or -1 if the handle is
+ *                not valid
+ *
+ */
+static int FSAL_RamGetDir( FSAL_Dir_t fsal_dir )
+{
+	int index = (int) fsal_dir;
+
+	if ( (index < 0) || (index >= FSAL_DIR_LIST_MAX) ) {
+		return -1;
+	}
+
+	return dir_handle_list[index];
+}
+
+/** @brief Lists a file of a directory and retrieves its size.
+ *
+ *  This function lists a file of a directory as specified by its
+ *  index and retrieves the file size.
+ *
+ *  @param[in] dir - the index of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to list
+ *
+ *  @param[out] file_size - the current size of the file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+static int FSAL_RamListFile( int dir, char * file_name, size_t * file_size )
+{
+	int file;
+
+	/* sanity checks */
+	if ( (dir < 0) || (file_name == NULL) || (file_size == NULL) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	PSL_MutexLock( &ram_mutex );
+	file = FSAL_RamFindFile( dir, file_name );
+	if ( file != -1 ) {
+		*file_size = ram_file_list[file].size;
+	}
+	PSL_MutexUnlock( &ram_mutex );
+
+	return (file == -1) ? FSAL_ERROR_FILE_ACCESS : FSAL_STATUS_OK;
+}
+
+/** @brief Opens a file of a directory.
+ *
+ *  This function opens a file of a directory as specified by its
+ *  index, creating the file first if requested.
+ *
+ *  @param[in] dir - the index of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to open
+ *
+ *  @param[in] flags - the access mode the file when opened
+ *
+ *  @param[out] fsal_handle - the handle of the opened file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+static int FSAL_RamOpenFile( int dir, char * file_name, int flags, FSAL_File_t * fsal_handle )
+{
+	int fsal_status = FSAL_ERROR_FILE_ACCESS;
+	int index;
+	int file;
+
+	/* sanity checks */
+	if ( (dir < 0) || (file_name == NULL) || (fsal_handle == NULL) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	PSL_MutexLock( &ram_mutex );
+
+	/* locate an available file handle */
+	for ( index = 0; index < FSAL_FILE_LIST_MAX; index++ ) {
+		if ( file_handle_list[index].file == FSAL_RAM_FILE_FREE ) {
+			break;
+		}
+	}
+
+	if ( index < FSAL_FILE_LIST_MAX ) {
+
+		/* look up the file (or create it if requested) */
+		file = FSAL_RamFindFile( dir, file_name );
+		if ( (file == -1) && (flags & FSAL_FLAGS_CREATE) ) {
+			file = FSAL_RamCreateFile( dir, file_name );
+		}
+
+		/* and claim the handle for it */
+		if ( file != -1 ) {
+			file_handle_list[index].file = file;
+			file_handle_list[index].flags = flags;
+			file_handle_list[index].position = 0;
+			*fsal_handle = (FSAL_File_t) index;
+			fsal_status = FSAL_STATUS_OK;
+		}
+	}
+
+	PSL_MutexUnlock( &ram_mutex );
+
+	return fsal_status;
+}
+
+/** @brief Deletes a file of a directory.
+ *
+ *  This function deletes a file of a directory as specified by its
+ *  index.
+ *
+ *  @param[in] dir - the index of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to remove
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+static int FSAL_RamDeleteFile( int dir, char * file_name )
+{
+	int file;
+
+	/* sanity checks */
+	if ( (dir < 0) || (file_name == NULL) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	PSL_MutexLock( &ram_mutex );
+	file = FSAL_RamFindFile( dir, file_name );
+	if ( file != -1 ) {
+		FSAL_RamRemoveFile( file );
+	}
+	PSL_MutexUnlock( &ram_mutex );
+
+	return (file == -1) ? FSAL_ERROR_FILE_ACCESS : FSAL_STATUS_OK;
+}
+
+/** @brief Initializes the filesystem for use
+ *
+ *  This function performs the required filesystem-specific
+ *  initialization sequence, which leaves the filesystem with
+ *  nothing but an empty root directory.
+ *
+ *  @param none
+ *
+ *  @return none
+ */
+
+void FSAL_Init( void )
+{
+	int index;
+
+	/* all blocks of the arena are free */
+	for ( index = 0; index < FSAL_RAM_BLOCK_COUNT; index++ ) {
+		ram_block_next[index] = FSAL_RAM_BLOCK_FREE;
+	}
+	ram_block_hint = 0;
+
+	/* only the root directory exists and is the current directory */
+	memset( ram_dir_list, 0, sizeof(ram_dir_list) );
+	ram_dir_list[FSAL_RAM_ROOT_DIR].used = 1;
+	current_working_dir = FSAL_RAM_ROOT_DIR;
+
+	/* no file exists */
+	for ( index = 0; index < FSAL_RAM_FILE_MAX; index++ ) {
+		ram_file_list[index].dir = FSAL_RAM_FILE_FREE;
+	}
+
+	/* no file or directory is opened (or locked) yet */
+	for ( index = 0; index < FSAL_FILE_LIST_MAX; index++ ) {
+		file_handle_list[index].file = FSAL_RAM_FILE_FREE;
+	}
+	for ( index = 0; index < FSAL_DIR_LIST_MAX; index++ ) {
+		dir_handle_list[index] = FSAL_DIR_CLOSED;
+		dir_lock_list[index] = FSAL_DIR_UNLOCKED;
+	}
+	PSL_MutexInit( &ram_mutex );
+}
+
+/** @brief Creates a directory.
+ *
+ *  This function creates a directory into the filesystem in
+ *  relative to the current directory.
+ *
+ *  @param[in] dir_name - the name of the directory to create
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_MakeDirectory( char * dir_name )
+{
+	int fsal_status = FSAL_ERROR_DIR_ACCESS;
+	int index;
+
+	/* sanity checks */
+	if ( dir_name == NULL ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	PSL_MutexLock( &ram_mutex );
+
+	/* claim an available directory unless it already exists */
+	if ( FSAL_RamFindDir( dir_name ) == -1 ) {
+		for ( index = 0; index < FSAL_RAM_DIR_MAX; index++ ) {
+			if ( !ram_dir_list[index].used ) {
+				fsal_status = FSAL_RamDirPath( ram_dir_list[index].path, current_working_dir, dir_name );
+				ram_dir_list[index].used = (fsal_status == FSAL_STATUS_OK);
+				break;
+			}
+		}
+	}
+
+	PSL_MutexUnlock( &ram_mutex );
+
+	return fsal_status;
+}
+
+/** @brief Changes working directory.
+ *
+ *  This function changes the current working directory to another
+ *  directory.
+ *
+ *  @param[in] dir_name - the name of the directory to change in
+ *                        relative to the current directory
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_ChangeDirectory( char * dir_name )
+{
+	char dir_path[FSAL_PATH_NAME_MAX] = {0};
+	char * separator;
+	int fsal_status = FSAL_ERROR_DIR_ACCESS;
+	int index;
+
+	/* sanity checks */
+	if ( dir_name == NULL ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	PSL_MutexLock( &ram_mutex );
+
+	if ( (strcmp(dir_name, "../") == 0) || (strcmp(dir_name, "..") == 0) ) {
+
+		/* change to the parent of the current directory */
+		snprintf( dir_path, sizeof(dir_path), "%s", ram_dir_list[current_working_dir].path );
+		separator = strrchr( dir_path, '/' );
+		if ( separator != NULL ) {
+			*separator = '\0';
+		} else {
+			dir_path[0] = '\0';
+		}
+
+		for ( index = 0; index < FSAL_RAM_DIR_MAX; index++ ) {
+			if ( ram_dir_list[index].used &&
+				 (strcmp(ram_dir_list[index].path, dir_path) == 0) ) {
+				current_working_dir = index;
+				fsal_status = FSAL_STATUS_OK;
+				break;
+			}
+		}
+
+	} else {
+
+		index = FSAL_RamFindDir( dir_name );
+		if ( index != -1 ) {
+			current_working_dir = index;
+			fsal_status = FSAL_STATUS_OK;
+		}
+	}
+
+	PSL_MutexUnlock( &ram_mutex );
+
+	return fsal_status;
+}
+
+/** @brief Removes a directory.
+ *
+ *  This function removes a directory and all files within it from
+ *  the filesystem in relative to the current directory. A directory
+ *  which holds other directories, is the current directory or is
+ *  still opened is not removed.
+ *
+ *  @param[in] dir_name - the name of the directory to remove
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_RemoveDirectory( char * dir_name )
+{
+	int fsal_status = FSAL_STATUS_OK;
+	size_t path_length;
+	int removed;
+	int index;
+	int dir;
+
+	/* sanity checks */
+	if ( dir_name == NULL ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	PSL_MutexLock( &ram_mutex );
+
+	dir = FSAL_RamFindDir( dir_name );
+	if ( (dir == -1) || (dir == FSAL_RAM_ROOT_DIR) || (dir == current_working_dir) ) {
+		fsal_status = FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* check that no other directory is within it and that it is not opened */
+	if ( fsal_status == FSAL_STATUS_OK ) {
+		path_length = strlen( ram_dir_list[dir].path );
+		for ( index = 0; index < FSAL_RAM_DIR_MAX; index++ ) {
+			if ( ram_dir_list[index].used &&
+				 (strncmp(ram_dir_list[index].path, ram_dir_list[dir].path, path_length) == 0) &&
+				 (ram_dir_list[index].path[path_length] == '/') ) {
+				fsal_status = FSAL_ERROR_DIR_ACCESS;
+			}
+		}
+		for ( index = 0; index < FSAL_DIR_LIST_MAX; index++ ) {
+			if ( dir_handle_list[index] == dir ) {
+				fsal_status = FSAL_ERROR_DIR_ACCESS;
+			}
+		}
+	}
+
+	if ( fsal_status == FSAL_STATUS_OK ) {
+
+		/* delete all files in the directory (removing a file may move
+		 * others around the file list, so look again until none is left) */
+		do {
+			removed = 0;
+			for ( index = 0; index < FSAL_RAM_FILE_MAX; index++ ) {
+				if ( ram_file_list[index].dir == dir ) {
+					FSAL_RamRemoveFile( index );
+					removed = 1;
+				}
+			}
+		} while ( removed );
+
+		/* delete the specified directory */
+		memset( &ram_dir_list[dir], 0, sizeof(ram_dir_list[dir]) );
+	}
+
+	PSL_MutexUnlock( &ram_mutex );
+
+	return fsal_status;
+}
+
+/** @brief Lists all directory entries.
+ *
+ *  This function display a listing of all entries of the current
+ *  directory.
+ *
+ *  @param[in] dir_name - the name of the directory to list entries
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_ListDirectory( char * dir_name )
+{
+	int index;
+	int dir;
+
+	/* sanity checks */
+	if ( dir_name == NULL ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	PSL_MutexLock( &ram_mutex );
+
+	dir = FSAL_RamFindDir( dir_name );
+
+	/* list all files in the directory */
+	for ( index = 0; (dir != -1) && (index < FSAL_RAM_FILE_MAX); index++ ) {
+		if ( ram_file_list[index].dir == dir ) {
+			printf( "%s\n", ram_file_list[index].name );
+		}
+	}
+
+	PSL_MutexUnlock( &ram_mutex );
+
+	return (dir == -1) ? FSAL_ERROR_DIR_ACCESS : FSAL_STATUS_OK;
+}
+
+/** @brief Opens a directory.
+ *
+ *  This function opens a directory of the filesystem in relative to
+ *  the current directory so that files within it can be accessed
+ *  later on without changing the current directory.
+ *
+ *  @param[in] dir_name - the name of the directory to open
+ *
+ *  @param[out] fsal_dir - the handle of the opened directory
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_OpenDirectory( char * dir_name, FSAL_Dir_t * fsal_dir )
+{
+	int index = FSAL_DIR_LIST_MAX;
+	int dir;
+
+	/* sanity checks */
+	if ( (dir_name == NULL) || (fsal_dir == NULL) ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	PSL_MutexLock( &ram_mutex );
+
+	/* locate an available directory handle for an existing directory */
+	dir = FSAL_RamFindDir( dir_name );
+	if ( dir != -1 ) {
+		for ( index = 0; index < FSAL_DIR_LIST_MAX; index++ ) {
+			if ( dir_handle_list[index] == FSAL_DIR_CLOSED ) {
+				break;
+			}
+		}
+	}
+
+	/* and claim it */
+	if ( index < FSAL_DIR_LIST_MAX ) {
+		dir_handle_list[index] = dir;
+		dir_lock_list[index] = FSAL_DIR_UNLOCKED;
+	}
+
+	PSL_MutexUnlock( &ram_mutex );
+
+	if ( index == FSAL_DIR_LIST_MAX ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* copy the handle to the output parameter */
+	*fsal_dir = (FSAL_Dir_t) index;
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Closes a directory.
+ *
+ *  This function closes a directory as specified by a specific
+ *  directory handle.
+ *
+ *  @param[in] fsal_dir - the handle associated to the directory
+ *                        to close
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_CloseDirectory( FSAL_Dir_t fsal_dir )
+{
+	int index = (int) fsal_dir;
+
+	/* sanity check */
+	if ( (index < 0) || (index >= FSAL_DIR_LIST_MAX) ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* release the directory handle (and any lock placed through it) */
+	PSL_MutexLock( &ram_mutex );
+	dir_handle_list[index] = FSAL_DIR_CLOSED;
+	dir_lock_list[index] = FSAL_DIR_UNLOCKED;
+	PSL_MutexUnlock( &ram_mutex );
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Lists a file and retrieves its size.
+ *
+ *  This function lists a file in the current directory and
+ *  retrieves the file size.
+ *
+ *  @param[in] file_name - the name of the file to list
+ *
+ *  @param[out] file_size - the current size of the file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_ListFile( char * file_name, size_t * file_size )
+{
+	return FSAL_RamListFile( current_working_dir, file_name, file_size );
+}
+
+/** @brief Locks a directory.
+ *
+ *  This function places a shared or an exclusive lock on the
+ *  directory associated with the specified directory handle without
+ *  waiting for it. Any number of shared locks may be held on the
+ *  same directory at the same time while an exclusive lock can only
+ *  be held if no other lock is held on the directory.
+ *
+ *  @param[in] fsal_dir - the handle associated to the directory
+ *                        to lock
+ *
+ *  @param[in] lock_type - the type of lock to place:
+ *
+ *                         FSAL_LOCK_SHARED
+ *                         FSAL_LOCK_EXCLUSIVE
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *                FSAL_ERROR_DIR_LOCKED
+ *
+ */
+int FSAL_LockDirectory( FSAL_Dir_t fsal_dir, int lock_type )
+{
+	int index = (int) fsal_dir;
+	int fsal_status = FSAL_STATUS_OK;
+	int other;
+
+	PSL_MutexLock( &ram_mutex );
+
+	/* sanity check */
+	if ( FSAL_RamGetDir( fsal_dir ) == FSAL_DIR_CLOSED ) {
+		fsal_status = FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* look for a conflicting lock placed through another handle of the same directory */
+	for ( other = 0; (fsal_status == FSAL_STATUS_OK) && (other < FSAL_DIR_LIST_MAX); other++ ) {
+		if ( (other != index) &&
+			 (dir_lock_list[other] != FSAL_DIR_UNLOCKED) &&
+			 (dir_handle_list[other] == dir_handle_list[index]) &&
+			 ((lock_type == FSAL_LOCK_EXCLUSIVE) || (dir_lock_list[other] == FSAL_LOCK_EXCLUSIVE)) ) {
+			fsal_status = FSAL_ERROR_DIR_LOCKED;
+		}
+	}
+
+	/* place the lock */
+	if ( fsal_status == FSAL_STATUS_OK ) {
+		dir_lock_list[index] = lock_type;
+	}
+
+	PSL_MutexUnlock( &ram_mutex );
+
+	return fsal_status;
+}
+
+/** @brief Unlocks a directory.
+ *
+ *  This function releases the lock previously placed on the
+ *  directory associated with the specified directory handle.
+ *
+ *  @param[in] fsal_dir - the handle associated to the directory
+ *                        to unlock
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_UnlockDirectory( FSAL_Dir_t fsal_dir )
+{
+	int index = (int) fsal_dir;
+
+	/* sanity check */
+	if ( (index < 0) || (index >= FSAL_DIR_LIST_MAX) ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* release the lock */
+	PSL_MutexLock( &ram_mutex );
+	dir_lock_list[index] = FSAL_DIR_UNLOCKED;
+	PSL_MutexUnlock( &ram_mutex );
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Lists a file of a directory and retrieves its size.
+ *
+ *  This function lists a file in the directory associated with the
+ *  specified directory handle and retrieves the file size.
+ *
+ *  @param[in] fsal_dir - the handle of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to list
+ *
+ *  @param[out] file_size - the current size of the file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_ListDirFile( FSAL_Dir_t fsal_dir, char * file_name, size_t * file_size )
+{
+	return FSAL_RamListFile( FSAL_RamGetDir(fsal_dir), file_name, file_size );
+}
+
+/** @brief Opens a file.
+ *
+ *  This function opens a file in the filesystem in relative to
+ *  the current directory.
+ *
+ *  @param[in] file_name - the name of the file to open
+ *
+ *  @param[in] flags - the access mode the file when opened
+ *
+ *  @param[out] fsal_handle - the handle of the opened file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_OpenFile( char * file_name, int flags, FSAL_File_t * fsal_handle )
+{
+	return FSAL_RamOpenFile( current_working_dir, file_name, flags, fsal_handle );
+}
+
+/** @brief Opens a file of a directory.
+ *
+ *  This function opens a file in the directory associated with the
+ *  specified directory handle.
+ *
+ *  @param[in] fsal_dir - the handle of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to open
+ *
+ *  @param[in] flags - the access mode the file when opened
+ *
+ *  @param[out] fsal_handle - the handle of the opened file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_OpenDirFile( FSAL_Dir_t fsal_dir, char * file_name, int flags, FSAL_File_t * fsal_handle )
+{
+	return FSAL_RamOpenFile( FSAL_RamGetDir(fsal_dir), file_name, flags, fsal_handle );
+}
+
+/** @brief Closes a file.
+ *
+ *  This function closes a file as specified by a specific file
+ *  handle.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to close
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_CloseFile( FSAL_File_t fsal_handle )
+{
+	int index = (int) fsal_handle;
+
+	/* sanity check */
+	if ( (index < 0) || (index >= FSAL_FILE_LIST_MAX) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* release the file handle */
+	PSL_MutexLock( &ram_mutex );
+	file_handle_list[index].file = FSAL_RAM_FILE_FREE;
+	PSL_MutexUnlock( &ram_mutex );
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Synchronizes a file with the storage media.
+ *
+ *  This function writes back whatever the filesystem still buffers
+ *  of the file as specified by a specific file handle, so that the
+ *  data written so far survives a power loss.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to synchronize
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_SyncFile( FSAL_File_t fsal_handle )
+{
+	int index = (int) fsal_handle;
+
+	/* sanity check */
+	if ( (index < 0) || (index >= FSAL_FILE_LIST_MAX) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* the arena is the media itself, so there is nothing to write back */
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Allocates the storage of a file up front.
+ *
+ *  This function extends the file as specified by a specific file
+ *  handle to (at least) the specified length and reserves the storage
+ *  media for it, so that writing the file within that length later on
+ *  never has to allocate any more (and, where the filesystem allows
+ *  it, lands on contiguous clusters). What the file holds past its
+ *  previous end is left unspecified. A file already that long is left
+ *  as it is.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to allocate
+ *
+ *  @param[in] length - the number of bytes to allocate the file for
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_AllocateFile( FSAL_File_t fsal_handle, size_t length )
+{
+	int index = (int) fsal_handle;
+	uint8_t last = 0;
+	int file;
+	int fsal_status = FSAL_ERROR_FILE_ACCESS;
+
+	/* sanity check */
+	if ( (index < 0) || (index >= FSAL_FILE_LIST_MAX) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	PSL_MutexLock( &ram_mutex );
+
+	file = file_handle_list[index].file;
+	if ( (file >= 0) && !(file_handle_list[index].flags & FSAL_FLAGS_READ_ONLY) ) {
+
+		/* writing the last byte takes (zeroed) blocks for the whole file */
+		fsal_status = FSAL_STATUS_OK;
+		if ( (ram_file_list[file].size < length) &&
+			 (FSAL_RamWrite( file, length - 1, &last, 1 ) != 1) ) {
+			fsal_status = FSAL_ERROR_FILE_ACCESS;
+		}
+	}
+
+	PSL_MutexUnlock( &ram_mutex );
+
+	return fsal_status;
+}
+
+/** @brief Reads from a file.
+ *
+ *  This function reads data from a file as specified by a specific
+ *  file handle.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to read
+ *
+ *  @param[in] buffer - the location reference where the contents
+ *                      of the file will be stored
+ *
+ *  @param[in] length - the maximum bytes the location reference
+                        can store
+ *
+ *  @return int - the number of bytes actually read or a negative
+ *                error code if the operation failed
+ *
+ */
+ssize_t FSAL_ReadFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length )
+{
+	int index = (int) fsal_handle;
+	ssize_t actual_length = -FSAL_ERROR_FILE_ACCESS;
+
+	/* sanity checks */
+	if ( (index < 0) || (index >= FSAL_FILE_LIST_MAX) || (buffer == NULL) ) {
+		return -FSAL_ERROR_FILE_ACCESS;
+	}
+
+	PSL_MutexLock( &ram_mutex );
+
+	/* read from the file position and move it past the data read */
+	if ( (file_handle_list[index].file >= 0) &&
+		 !(file_handle_list[index].flags & FSAL_FLAGS_WRITE_ONLY) ) {
+		actual_length = FSAL_RamRead( file_handle_list[index].file, file_handle_list[index].position, buffer, length );
+		file_handle_list[index].position += actual_length;
+	}
+
+	PSL_MutexUnlock( &ram_mutex );
+
+	return actual_length;
+}
+
+/** @brief Reads from a file at a specific position.
+ *
+ *  This function reads data from a file as specified by a specific
+ *  file handle, starting at the specified byte offset from the
+ *  beginning of the file.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to read
+ *
+ *  @param[in] offset - the byte offset in the file where the data
+ *                      is to be read from
+ *
+ *  @param[in] buffer - the location reference where the contents
+ *                      of the file will be stored
+ *
+ *  @param[in] length - the maximum bytes the location reference
+                        can store
+ *
+ *  @return int - the number of bytes actually read or a negative
+ *                error code if the operation failed
+ *
+ */
+ssize_t FSAL_ReadFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length )
+{
+	int index = (int) fsal_handle;
+
+	/* sanity checks */
+	if ( (index < 0) || (index >= FSAL_FILE_LIST_MAX) ) {
+		return -FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* move the file position to the specified offset */
+	PSL_MutexLock( &ram_mutex );
+	file_handle_list[index].position = offset;
+	PSL_MutexUnlock( &ram_mutex );
+
+	/* and read from there */
+	return FSAL_ReadFile( fsal_handle, buffer, length );
+}
+
+/** @brief Writes to a file.
+ *
+ *  This function writes data to a file as specified by a specific
+ *  file handle.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to write
+ *
+ *  @param[in] buffer - the location reference of the data to be
+ *                      written to the file
+ *
+ *  @param[in] length - the number of bytes to write to the file
+ *
+ *  @return int - the number of bytes actually written or a negative
+ *                error code if the operation failed
+ *
+ */
+ssize_t FSAL_WriteFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length )
+{
+	int index = (int) fsal_handle;
+	ssize_t actual_length = -FSAL_ERROR_FILE_ACCESS;
+	int file;
+
+	/* sanity checks */
+	if ( (index < 0) || (index >= FSAL_FILE_LIST_MAX) || (buffer == NULL) ) {
+		return -FSAL_ERROR_FILE_ACCESS;
+	}
+
+	PSL_MutexLock( &ram_mutex );
+
+	file = file_handle_list[index].file;
+	if ( (file >= 0) && !(file_handle_list[index].flags & FSAL_FLAGS_READ_ONLY) ) {
+
+		/* a file opened for append only is always written at its end */
+		if ( file_handle_list[index].flags & FSAL_FLAGS_APPEND_ONLY ) {
+			file_handle_list[index].position = ram_file_list[file].size;
+		}
+
+		/* write at the file position and move it past the data written */
+		actual_length = FSAL_RamWrite( file, file_handle_list[index].position, buffer, length );
+		if ( actual_length > 0 ) {
+			file_handle_list[index].position += actual_length;
+		}
+	}
+
+	PSL_MutexUnlock( &ram_mutex );
+
+	return actual_length;
+}
+
+/** @brief Writes to a file at a specific position.
+ *
+ *  This function writes data to a file as specified by a specific
+ *  file handle, starting at the specified byte offset from the
+ *  beginning of the file. Bytes outside of the written range are
+ *  left untouched.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to write
+ *
+ *  @param[in] offset - the byte offset in the file where the data
+ *                      is to be written
+ *
+ *  @param[in] buffer - the location reference of the data to be
+ *                      written to the file
+ *
+ *  @param[in] length - the number of bytes to write to the file
+ *
+ *  @return int - the number of bytes actually written or a negative
+ *                error code if the operation failed
+ *
+ */
+ssize_t FSAL_WriteFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length )
+{
+	int index = (int) fsal_handle;
+
+	/* sanity checks */
+	if ( (index < 0) || (index >= FSAL_FILE_LIST_MAX) ) {
+		return -FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* move the file position to the specified offset */
+	PSL_MutexLock( &ram_mutex );
+	file_handle_list[index].position = offset;
+	PSL_MutexUnlock( &ram_mutex );
+
+	/* and write from there */
+	return FSAL_WriteFile( fsal_handle, buffer, length );
+}
+
+/** @brief Maps a part of a file into memory.
+ *
+ *  This function maps the specified range of a file as specified
+ *  by a specific file handle into memory for read-only access. The
+ *  mapping stays valid after the file is closed, until it is
+ *  unmapped (or the file is deleted). Only a range lying within a
+ *  single block of the arena can be mapped.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to map
+ *
+ *  @param[in] offset - the byte offset in the file where the range
+ *                      to map starts
+ *
+ *  @param[in] length - the number of bytes to map
+ *
+ *  @param[out] data - the reference where the location of the
+ *                     mapped range is set
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_MapFile( FSAL_File_t fsal_handle, size_t offset, size_t length, const uint8_t ** data )
+{
+	uint8_t * mapping = NULL;
+	int fsal_status;
+
+	fsal_status = FSAL_RamMap( fsal_handle, offset, length, 0, &mapping );
+	if ( fsal_status == FSAL_STATUS_OK ) {
+		*data = mapping;
+	}
+
+	return fsal_status;
+}
+
+/** @brief Unmaps a part of a file from memory.
+ *
+ *  This function releases a range of a file previously mapped into
+ *  memory.
+ *
+ *  @param[in] data - the location of the mapped range
+ *
+ *  @param[in] offset - the byte offset in the file where the mapped
+ *                      range starts
+ *
+ *  @param[in] length - the number of bytes mapped
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_UnmapFile( const uint8_t * data, size_t offset, size_t length )
+{
+	/* sanity checks */
+	if ( data == NULL ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* the mapped range is part of the arena which is never released */
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Maps a part of a file into memory for writing.
+ *
+ *  This function maps the specified range of a file as specified
+ *  by a specific file handle into memory for read and write access.
+ *  Stores into the mapped range are stores into the file itself.
+ *  The mapping stays valid after the file is closed, until it is
+ *  unmapped (or the file is deleted). Only a range lying within a
+ *  single block of the arena can be mapped.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to map (opened for read and write)
+ *
+ *  @param[in] offset - the byte offset in the file where the range
+ *                      to map starts
+ *
+ *  @param[in] length - the number of bytes to map
+ *
+ *  @param[out] data - the reference where the location of the
+ *                     mapped range is set
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_MapFileWritable( FSAL_File_t fsal_handle, size_t offset, size_t length, uint8_t ** data )
+{
+	return FSAL_RamMap( fsal_handle, offset, length, 1, data );
+}
+
+/** @brief Synchronizes a part of a file mapped into memory.
+ *
+ *  This function writes the stores into a range of a file mapped
+ *  for writing back to the file, either by scheduling the write
+ *  or by waiting for the write to complete.
+ *
+ *  @param[in] data - the location of the mapped range
+ *
+ *  @param[in] offset - the byte offset in the file where the mapped
+ *                      range starts
+ *
+ *  @param[in] length - the number of bytes mapped
+ *
+ *  @param[in] sync_type - the type of synchronization to perform:
+ *
+ *                         FSAL_SYNC_ASYNC
+ *                         FSAL_SYNC_WAIT
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_SyncMappedFile( const uint8_t * data, size_t offset, size_t length, int sync_type )
+{
+	/* sanity checks */
+	if ( data == NULL ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* the mapped range is the file itself, so there is nothing to write back */
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Deletes a file.
+ *
+ *  This function deletes a file from the filesystem in
+ *  relative to the current directory.
+ *
+ *  @param[in] file_name - the name of the file to remove
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_DeleteFile( char * file_name )
+{
+	return FSAL_RamDeleteFile( current_working_dir, file_name );
+}
+
+/** @brief Deletes a file of a directory.
+ *
+ *  This function deletes a file from the directory associated with
+ *  the specified directory handle.
+ *
+ *  @param[in] fsal_dir - the handle of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to remove
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_DeleteDirFile( FSAL_Dir_t fsal_dir, char * file_name )
+{
+	return FSAL_RamDeleteFile( FSAL_RamGetDir(fsal_dir), file_name );
+}
+
+/** @brief Defers the writes of the calling task.
+ *
+ *  This function sets whether the writes, closes and deletes of
+ *  files requested by the calling task (or thread) may be deferred,
+ *  which this filesystem never does.
+ *
+ *  @param[in] defer - non-zero to defer the requests, zero otherwise
+ *
+ *  @return none
+ */
+void FSAL_DeferWrites( int defer )
+{
+	/* every request completes before its call returns */
+	(void) defer;
+}
+
+/** @brief Retrieves the ticket of the last deferred write.
+ *
+ *  This function retrieves the ticket of the last request deferred
+ *  so far, always zero as this filesystem never defers any request.
+ *
+ *  @param none
+ *
+ *  @return uint32_t - the ticket of the last deferred request
+ */
+uint32_t FSAL_GetWriteTicket( void )
+{
+	return 0;
+}
+
+/** @brief Polls the deferred writes for completion.
+ *
+ *  This function retrieves the ticket up to which all deferred
+ *  requests completed and the ticket of the oldest one which failed,
+ *  both always zero as this filesystem never defers any request.
+ *
+ *  @param[in] sync_type - the type of synchronization to perform:
+ *
+ *                         FSAL_SYNC_ASYNC
+ *                         FSAL_SYNC_WAIT
+ *
+ *  @param[out] completed - the ticket up to which all requests
+ *                          completed
+ *
+ *  @param[out] failed - the ticket of the oldest failed request
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_PollWrites( int sync_type, uint32_t * completed, uint32_t * failed )
+{
+	/* sanity checks */
+	if ( (completed == NULL) || (failed == NULL) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* nothing is ever in flight */
+	*completed = 0;
+	*failed = 0;
+
+	return FSAL_STATUS_OK;
+}
+
+#endif /* FSAL_RAM */
@@ -0,0 +1,58 @@
+/**********************************************************************
+* Filename:     fsal.h
+*
+* Copyright 2018, Swift Labs / TR
+*
+* Author:       Ronald Miranda / Emil Ekmecic
+*
+* Created:      October 14, 2026
+*
+* Description:  This is the header file associated with the Filesystem
+*               Abstraction Layer or FASL specific to a volatile
+*               filesystem kept in RAM.
+*
+* History
+* 14-Oct-2026   RMM      Initial code replacing the stub filesystem.
+**********************************************************************/
+
+#ifndef __FSAL_RAM_H__
+#define __FSAL_RAM_H__
+
+#ifdef FSAL_RAM
+
+/**
+ * Size and number of the blocks of the arena holding the contents
+ * of all files (the capacity of the filesystem is their product)
+ */
+#if !defined( FSAL_RAM_BLOCK_SIZE )
+#define FSAL_RAM_BLOCK_SIZE				256
+#endif
+#if !defined( FSAL_RAM_BLOCK_COUNT )
+#define FSAL_RAM_BLOCK_COUNT			256
+#endif
+
+/**
+ * Maximum number of directories and files existing at the same
+ * time and maximum length of a file name and of the full path of
+ * a directory
+ */
+#if !defined( FSAL_RAM_DIR_MAX )
+#define FSAL_RAM_DIR_MAX				(DATA_QUEUE_FILE_HANDLE_LIST_MAX + 2)
+#endif
+#if !defined( FSAL_RAM_FILE_MAX )
+#define FSAL_RAM_FILE_MAX				128
+#endif
+#define FSAL_RAM_NAME_MAX				16
+#define FSAL_PATH_NAME_MAX				32
+
+/**
+ * Maximum number of directories and files opened at the same time
+ */
+#define FSAL_DIR_LIST_MAX				(DATA_QUEUE_FILE_HANDLE_LIST_MAX + 2)
+#if !defined( FSAL_FILE_LIST_MAX )
+#define FSAL_FILE_LIST_MAX				8
+#endif
+
+#endif /* FSAL_RAM */
+
+#endif /*__FSAL_RAM_H__ */
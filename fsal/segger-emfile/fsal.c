@@ -28,6 +28,132 @@
 
 static char current_working_dir[20] = {0};
 
+/**
+ * Full paths of the currently opened directories
+ * (indexed by the directory handle)
+ */
+static char dir_path_list[FSAL_DIR_LIST_MAX][FSAL_PATH_NAME_MAX] = { { 0 } };
+
+/**
+ * Type of lock placed through each of the currently opened
+ * directories (indexed by the directory handle) and the mutex
+ * guarding it from concurrent tasks
+ */
+#define FSAL_DIR_UNLOCKED		-1
+static int dir_lock_list[FSAL_DIR_LIST_MAX];
+static PSL_Mutex_t dir_lock_mutex;
+
+/** @brief Lists a file by its full path and retrieves its size.
+ *
+ *  This function lists a file as specified by its full path and
+ *  retrieves the file size.
+ *
+ *  @param[in] file_path - the full path of the file to list
+ *
+ *  @param[out] file_size - the current size of the file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+static int FSAL_ListFilePath( char * file_path, size_t * file_size )
+{
+	FS_FILE * fd;
+
+	/* open the specified file */
+	fd = FS_FOpen( file_path, "rb" );
+	if ( fd == 0 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* retrieve the file size */
+	*file_size = FS_GetFileSize( fd );
+
+	/* close the file */
+	FS_FClose( fd );
+
+	/* check for error condition */
+	if ( *file_size == 0xFFFFFFFF ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Opens a file by its full path.
+ *
+ *  This function opens a file of the filesystem as specified by
+ *  its full path.
+ *
+ *  @param[in] file_path - the full path of the file to open
+ *
+ *  @param[in] flags - the access mode the file when opened
+ *
+ *  @param[out] fsal_handle - the handle of the opened file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+static int FSAL_OpenFilePath( char * file_path, int flags, FSAL_File_t * fsal_handle )
+{
+	FS_FILE * fd;
+
+	if (flags & FSAL_FLAGS_CREATE ) {
+		/* create the specified file */
+		fd = FS_FOpen( file_path, "wb" );
+		if ( fd == 0 ) {
+			return FSAL_ERROR_FILE_ACCESS;
+		}
+		FS_FClose( fd );
+	}
+
+	if (flags & FSAL_FLAGS_READ_ONLY ) {
+
+		/* open the specified file for reading only */
+		fd = FS_FOpen( file_path, "rb" );
+		if ( fd == 0 ) {
+			return FSAL_ERROR_FILE_ACCESS;
+		}
+
+	} else if (flags & FSAL_FLAGS_APPEND_ONLY ) {
+
+		/* open the specified file for append only */
+		fd = FS_FOpen( file_path, "ab" );
+		if ( fd == 0 ) {
+			return FSAL_ERROR_FILE_ACCESS;
+		}
+
+	} else if (flags & FSAL_FLAGS_WRITE_ONLY ) {
+
+		/* open the specified file for writing only */
+		fd = FS_FOpen( file_path, "wb" );
+		if ( fd == 0 ) {
+			return FSAL_ERROR_FILE_ACCESS;
+		}
+
+	} else {
+
+		/* open the specified file for reading and writing */
+		fd = FS_FOpen( file_path, "r+b" );
+		if ( fd == 0 ) {
+			return FSAL_ERROR_FILE_ACCESS;
+		}
+
+	}
+
+	/* copy the handle to the output parameter */
+	*fsal_handle = (FSAL_File_t)((intptr_t)fd);
+
+	return FSAL_STATUS_OK;
+}
+
 /** @brief Initializes the filesystem for use
  *
  *  This function performs the required filesystem-specific
@@ -46,6 +172,12 @@ void FSAL_Init( void )
 	/* set current working directory to "" */
 	//snprintf( current_working_dir, sizeof(current_working_dir), "" );
 	memset( current_working_dir, 0, sizeof(current_working_dir) );
+
+	/* no directory is locked yet */
+	for ( int index = 0; index < FSAL_DIR_LIST_MAX; index++ ) {
+		dir_lock_list[index] = FSAL_DIR_UNLOCKED;
+	}
+	PSL_MutexInit( &dir_lock_mutex );
 }
 
 /** @brief Creates a directory.
@@ -185,64 +317,111 @@ int FSAL_ListDirectory( char * dir_name )
 	return FSAL_ERROR_DIR_ACCESS;
 }
 
-/** @brief Lists a file and retrieves its size.
+/** @brief Opens a directory.
  *
- *  This function lists a file in the current directory and
- *  retrieves the file size.
+ *  This function opens a directory of the filesystem in relative to
+ *  the current directory so that files within it can be accessed
+ *  later on without changing the current directory.
  *
- *  @param[in] file_name - the name of the file to list
+ *  @param[in] dir_name - the name of the directory to open
  *
- *  @param[out] file_size - the current size of the file
+ *  @param[out] fsal_dir - the handle of the opened directory
  *
  *  @return int - the status or error code of the operation after
  *                the call:
  *
  *                FSAL_STATUS_OK
- *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_DIR_ACCESS
  *
  */
-int FSAL_ListFile( char * file_name, size_t * file_size )
+int FSAL_OpenDirectory( char * dir_name, FSAL_Dir_t * fsal_dir )
 {
-	FS_FILE * fd;
-	char file_path[20] = {0};
+	FS_FIND_DATA fd;
+	char dir_path_name[FSAL_PATH_NAME_MAX] = {0};
+	char file_name[20] = {0};
+	int index;
 
 	/* sanity checks */
-	if ( file_name == NULL ) {
-		return FSAL_ERROR_FILE_ACCESS;
+	if ( (dir_name == NULL) || (fsal_dir == NULL) ) {
+		return FSAL_ERROR_DIR_ACCESS;
 	}
 
-	snprintf( file_path, sizeof(file_path), "%s\\%s", current_working_dir, file_name);
+	snprintf( dir_path_name, sizeof(dir_path_name), "%s\\%s", current_working_dir, dir_name );
 
-	/* open the specified file */
-	fd = FS_FOpen( file_path, "rb" );
-	if ( fd == 0 ) {
-		return FSAL_ERROR_FILE_ACCESS;
+	/* check once that the directory exists */
+	if ( FS_FindFirstFile(&fd, dir_path_name, file_name, sizeof(file_name)) != 0 ) {
+		FS_FindClose( &fd );
+		return FSAL_ERROR_DIR_ACCESS;
 	}
+	FS_FindClose( &fd );
 
-	/* retrieve the file size */
-	*file_size = FS_GetFileSize( fd );
+	PSL_MutexLock( &dir_lock_mutex );
 
-	/* close the file */
-	FS_FClose( fd );
+	/* locate an available directory handle */
+	for ( index = 0; index < FSAL_DIR_LIST_MAX; index++ ) {
+		if ( dir_path_list[index][0] == '\0' ) {
+			break;
+		}
+	}
 
-	/* check for error condition */
-	if ( *file_size == 0xFFFFFFFF ) {
-		return FSAL_ERROR_FILE_ACCESS;
+	/* and claim it by caching the full path of the directory */
+	if ( index < FSAL_DIR_LIST_MAX ) {
+		snprintf( dir_path_list[index], sizeof(dir_path_list[index]), "%s", dir_path_name );
+	}
+
+	PSL_MutexUnlock( &dir_lock_mutex );
+
+	if ( index == FSAL_DIR_LIST_MAX ) {
+		return FSAL_ERROR_DIR_ACCESS;
 	}
 
+	/* copy the handle to the output parameter */
+	*fsal_dir = (FSAL_Dir_t) index;
+
 	return FSAL_STATUS_OK;
 }
 
-/** @brief Opens a file.
+/** @brief Closes a directory.
  *
- *  This function opens a file in the filesystem in relative to
- *  the current directory.
+ *  This function closes a directory as specified by a specific
+ *  directory handle.
  *
- *  @param[in] file_name - the name of the file to open
+ *  @param[in] fsal_dir - the handle associated to the directory
+ *                        to close
  *
- *  @param[in] flags - the access mode the file when opened
+ *  @return int - the status or error code of the operation after
+ *                the call:
  *
- *  @param[out] fsal_handle - the handle of the opened file
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+int FSAL_CloseDirectory( FSAL_Dir_t fsal_dir )
+{
+	int index = (int) fsal_dir;
+
+	/* sanity check */
+	if ( (index < 0) || (index >= FSAL_DIR_LIST_MAX) ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
+
+	/* release the cached path of the directory (and any lock placed through it) */
+	PSL_MutexLock( &dir_lock_mutex );
+	memset( dir_path_list[index], 0, sizeof(dir_path_list[index]) );
+	dir_lock_list[index] = FSAL_DIR_UNLOCKED;
+	PSL_MutexUnlock( &dir_lock_mutex );
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Lists a file and retrieves its size.
+ *
+ *  This function lists a file in the current directory and
+ *  retrieves the file size.
+ *
+ *  @param[in] file_name - the name of the file to list
+ *
+ *  @param[out] file_size - the current size of the file
  *
  *  @return int - the status or error code of the operation after
  *                the call:
@@ -251,9 +430,8 @@ int FSAL_ListFile( char * file_name, size_t * file_size )
  *                FSAL_ERROR_FILE_ACCESS
  *
  */
-int FSAL_OpenFile( char * file_name, int flags, FSAL_File_t * fsal_handle )
+int FSAL_ListFile( char * file_name, size_t * file_size )
 {
-	FS_FILE * fd;
 	char file_path[20] = {0};
 
 	/* sanity checks */
@@ -263,94 +441,313 @@ int FSAL_OpenFile( char * file_name, int flags, FSAL_File_t * fsal_handle )
 
 	snprintf( file_path, sizeof(file_path), "%s\\%s", current_working_dir, file_name);
 
-	if (flags & FSAL_FLAGS_CREATE ) {
-		/* create the specified file */
-		fd = FS_FOpen( file_path, "wb" );
-		if ( fd == 0 ) {
-			return FSAL_ERROR_FILE_ACCESS;
-		}
-		FS_FClose( fd );
-	}
-
-	if (flags & FSAL_FLAGS_READ_ONLY ) {
-
-		/* open the specified file for reading only */
-		fd = FS_FOpen( file_path, "rb" );
-		if ( fd == 0 ) {
-			return FSAL_ERROR_FILE_ACCESS;
-		}
-
-	} else if (flags & FSAL_FLAGS_APPEND_ONLY ) {
-
-		/* open the specified file for append only */
-		fd = FS_FOpen( file_path, "ab" );
-		if ( fd == 0 ) {
-			return FSAL_ERROR_FILE_ACCESS;
-		}
+	/* list the file using its full path */
+	return FSAL_ListFilePath( file_path, file_size );
+}
 
-	} else if (flags & FSAL_FLAGS_WRITE_ONLY ) {
+/** @brief Locks a directory.
+ *
+ *  This function places a shared or an exclusive lock on the
+ *  directory associated with the specified directory handle without
+ *  waiting for it. Any number of shared locks may be held on the
+ *  same directory at the same time while an exclusive lock can only
+ *  be held if no other lock is held on the directory.
+ *
+ *  @param[in] fsal_dir - the handle associated to the directory
+ *                        to lock
+ *
+ *  @param[in] lock_type - the type of lock to place:
+ *
+ *                         FSAL_LOCK_SHARED
+ *                         FSAL_LOCK_EXCLUSIVE
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *                FSAL_ERROR_DIR_LOCKED
+ *
+ */
+int FSAL_LockDirectory( FSAL_Dir_t fsal_dir, int lock_type )
+{
+	int index = (int) fsal_dir;
+	int fsal_status = FSAL_STATUS_OK;
+	int other;
 
-		/* open the specified file for writing only */
-		fd = FS_FOpen( file_path, "wb" );
-		if ( fd == 0 ) {
-			return FSAL_ERROR_FILE_ACCESS;
-		}
+	/* sanity check */
+	if ( (index < 0) || (index >= FSAL_DIR_LIST_MAX) || (dir_path_list[index][0] == '\0') ) {
+		return FSAL_ERROR_DIR_ACCESS;
+	}
 
-	} else {
+	PSL_MutexLock( &dir_lock_mutex );
 
-		/* open the specified file for reading and writing */
-		fd = FS_FOpen( file_path, "r+b" );
-		if ( fd == 0 ) {
-			return FSAL_ERROR_FILE_ACCESS;
+	/* look for a conflicting lock placed through another handle of the same directory */
+	for ( other = 0; other < FSAL_DIR_LIST_MAX; other++ ) {
+		if ( (other != index) &&
+			 (dir_lock_list[other] != FSAL_DIR_UNLOCKED) &&
+			 (strcmp(dir_path_list[other], dir_path_list[index]) == 0) &&
+			 ((lock_type == FSAL_LOCK_EXCLUSIVE) || (dir_lock_list[other] == FSAL_LOCK_EXCLUSIVE)) ) {
+			fsal_status = FSAL_ERROR_DIR_LOCKED;
+			break;
 		}
+	}
 
+	/* place the lock */
+	if ( fsal_status == FSAL_STATUS_OK ) {
+		dir_lock_list[index] = lock_type;
 	}
 
-	/* copy the handle to the output parameter */
-	*fsal_handle = (FSAL_File_t)((intptr_t)fd);
+	PSL_MutexUnlock( &dir_lock_mutex );
 
-	return FSAL_STATUS_OK;
+	return fsal_status;
 }
 
-/** @brief Closes a file.
+/** @brief Unlocks a directory.
  *
- *  This function closes a file as specified by a specific file
- *  handle.
+ *  This function releases the lock previously placed on the
+ *  directory associated with the specified directory handle.
  *
- *  @param[in] fsal_handle - the handle associated to the file
- *                           to close
+ *  @param[in] fsal_dir - the handle associated to the directory
+ *                        to unlock
  *
  *  @return int - the status or error code of the operation after
  *                the call:
  *
  *                FSAL_STATUS_OK
- *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_DIR_ACCESS
  *
  */
-int FSAL_CloseFile( FSAL_File_t fsal_handle )
+int FSAL_UnlockDirectory( FSAL_Dir_t fsal_dir )
 {
-	FS_FILE * fd = (FS_FILE *)((intptr_t)fsal_handle);
+	int index = (int) fsal_dir;
 
 	/* sanity check */
-	if ( fd == 0 ) {
-		return FSAL_ERROR_FILE_ACCESS;
+	if ( (index < 0) || (index >= FSAL_DIR_LIST_MAX) ) {
+		return FSAL_ERROR_DIR_ACCESS;
 	}
 
-	FS_FClose( fd );
+	/* release the lock */
+	PSL_MutexLock( &dir_lock_mutex );
+	dir_lock_list[index] = FSAL_DIR_UNLOCKED;
+	PSL_MutexUnlock( &dir_lock_mutex );
 
 	return FSAL_STATUS_OK;
 }
 
-/** @brief Reads from a file.
+/** @brief Lists a file of a directory and retrieves its size.
  *
- *  This function reads data from a file as specified by a specific
- *  file handle.
+ *  This function lists a file in the directory associated with the
+ *  specified directory handle and retrieves the file size.
  *
- *  @param[in] fsal_handle - the handle associated to the file
- *                           to read
+ *  @param[in] fsal_dir - the handle of the directory of the file
  *
- *  @param[in] buffer - the location reference where the contents
- *                      of the file will be stored
+ *  @param[in] file_name - the name of the file to list
+ *
+ *  @param[out] file_size - the current size of the file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_ListDirFile( FSAL_Dir_t fsal_dir, char * file_name, size_t * file_size )
+{
+	char file_path[FSAL_PATH_NAME_MAX] = {0};
+
+	/* sanity checks */
+	if ( (fsal_dir < 0) || (fsal_dir >= FSAL_DIR_LIST_MAX) || (file_name == NULL) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	snprintf( file_path, sizeof(file_path), "%s\\%s", dir_path_list[fsal_dir], file_name );
+
+	/* list the file using its full path */
+	return FSAL_ListFilePath( file_path, file_size );
+}
+
+/** @brief Opens a file.
+ *
+ *  This function opens a file in the filesystem in relative to
+ *  the current directory.
+ *
+ *  @param[in] file_name - the name of the file to open
+ *
+ *  @param[in] flags - the access mode the file when opened
+ *
+ *  @param[out] fsal_handle - the handle of the opened file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_OpenFile( char * file_name, int flags, FSAL_File_t * fsal_handle )
+{
+	char file_path[20] = {0};
+
+	/* sanity checks */
+	if ( file_name == NULL ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	snprintf( file_path, sizeof(file_path), "%s\\%s", current_working_dir, file_name);
+
+	/* open the file using its full path */
+	return FSAL_OpenFilePath( file_path, flags, fsal_handle );
+}
+
+/** @brief Opens a file of a directory.
+ *
+ *  This function opens a file in the directory associated with the
+ *  specified directory handle.
+ *
+ *  @param[in] fsal_dir - the handle of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to open
+ *
+ *  @param[in] flags - the access mode the file when opened
+ *
+ *  @param[out] fsal_handle - the handle of the opened file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_OpenDirFile( FSAL_Dir_t fsal_dir, char * file_name, int flags, FSAL_File_t * fsal_handle )
+{
+	char file_path[FSAL_PATH_NAME_MAX] = {0};
+
+	/* sanity checks */
+	if ( (fsal_dir < 0) || (fsal_dir >= FSAL_DIR_LIST_MAX) || (file_name == NULL) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	snprintf( file_path, sizeof(file_path), "%s\\%s", dir_path_list[fsal_dir], file_name );
+
+	/* open the file using its full path */
+	return FSAL_OpenFilePath( file_path, flags, fsal_handle );
+}
+
+/** @brief Closes a file.
+ *
+ *  This function closes a file as specified by a specific file
+ *  handle.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to close
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_CloseFile( FSAL_File_t fsal_handle )
+{
+	FS_FILE * fd = (FS_FILE *)((intptr_t)fsal_handle);
+
+	/* sanity check */
+	if ( fd == 0 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	FS_FClose( fd );
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Synchronizes a file with the storage media.
+ *
+ *  This function writes back whatever the filesystem still buffers
+ *  of the file as specified by a specific file handle, so that the
+ *  data written so far survives a power loss.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to synchronize
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_SyncFile( FSAL_File_t fsal_handle )
+{
+	FS_FILE * fd = (FS_FILE *)((intptr_t)fsal_handle);
+
+	/* sanity check */
+	if ( fd == 0 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* write back the file buffer and the cached sectors of the file */
+	if ( FS_SyncFile( fd ) != 0 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Allocates the storage of a file up front.
+ *
+ *  This function extends the file as specified by a specific file
+ *  handle to (at least) the specified length and reserves the storage
+ *  media for it, so that writing the file within that length later on
+ *  never has to allocate any more (and, where the filesystem allows
+ *  it, lands on contiguous clusters). What the file holds past its
+ *  previous end is left unspecified. A file already that long is left
+ *  as it is.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to allocate
+ *
+ *  @param[in] length - the number of bytes to allocate the file for
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_AllocateFile( FSAL_File_t fsal_handle, size_t length )
+{
+	FS_FILE * fd = (FS_FILE *)((intptr_t)fsal_handle);
+
+	/* sanity check */
+	if ( fd == 0 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* setting the file size allocates the clusters of the file up front */
+	if ( (FS_GetFileSize( fd ) < length) &&
+		 (FS_SetFileSize( fd, (uint32_t) length ) != 0) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Reads from a file.
+ *
+ *  This function reads data from a file as specified by a specific
+ *  file handle.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to read
+ *
+ *  @param[in] buffer - the location reference where the contents
+ *                      of the file will be stored
  *
  *  @param[in] length - the maximum bytes the location reference
                         can store
@@ -383,6 +780,46 @@ ssize_t FSAL_ReadFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length
 	return actual_length;
 }
 
+/** @brief Reads from a file at a specific position.
+ *
+ *  This function reads data from a file as specified by a specific
+ *  file handle, starting at the specified byte offset from the
+ *  beginning of the file.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to read
+ *
+ *  @param[in] offset - the byte offset in the file where the data
+ *                      is to be read from
+ *
+ *  @param[in] buffer - the location reference where the contents
+ *                      of the file will be stored
+ *
+ *  @param[in] length - the maximum bytes the location reference
+                        can store
+ *
+ *  @return int - the number of bytes actually read or a negative
+ *                error code if the operation failed
+ *
+ */
+ssize_t FSAL_ReadFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length )
+{
+	FS_FILE * fd = (FS_FILE *)((intptr_t)fsal_handle);
+
+	/* sanity checks */
+	if ( (fd == 0) || (buffer == NULL) ) {
+		return -FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* move the file position to the specified offset */
+	if ( FS_FSeek( fd, (int32_t) offset, FS_SEEK_SET ) != 0 ) {
+		return -FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* and read from there */
+	return FSAL_ReadFile( fsal_handle, buffer, length );
+}
+
 /** @brief Writes to a file.
  *
  *  This function writes data to a file as specified by a specific
@@ -424,6 +861,170 @@ ssize_t FSAL_WriteFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length
 	return actual_length;
 }
 
+/** @brief Writes to a file at a specific position.
+ *
+ *  This function writes data to a file as specified by a specific
+ *  file handle, starting at the specified byte offset from the
+ *  beginning of the file. Bytes outside of the written range are
+ *  left untouched.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to write
+ *
+ *  @param[in] offset - the byte offset in the file where the data
+ *                      is to be written
+ *
+ *  @param[in] buffer - the location reference of the data to be
+ *                      written to the file
+ *
+ *  @param[in] length - the number of bytes to write to the file
+ *
+ *  @return int - the number of bytes actually written or a negative
+ *                error code if the operation failed
+ *
+ */
+ssize_t FSAL_WriteFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length )
+{
+	FS_FILE * fd = (FS_FILE *)((intptr_t)fsal_handle);
+
+	/* sanity checks */
+	if ( (fd == 0) || (buffer == NULL) ) {
+		return -FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* move the file position to the specified offset */
+	if ( FS_FSeek( fd, (int32_t) offset, FS_SEEK_SET ) != 0 ) {
+		return -FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* and write from there */
+	return FSAL_WriteFile( fsal_handle, buffer, length );
+}
+
+/** @brief Maps a part of a file into memory.
+ *
+ *  This function maps the specified range of a file as specified
+ *  by a specific file handle into memory for read-only access. The
+ *  mapping stays valid after the file is closed, until it is
+ *  unmapped.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to map
+ *
+ *  @param[in] offset - the byte offset in the file where the range
+ *                      to map starts
+ *
+ *  @param[in] length - the number of bytes to map
+ *
+ *  @param[out] data - the reference where the location of the
+ *                     mapped range is set
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_MapFile( FSAL_File_t fsal_handle, size_t offset, size_t length, const uint8_t ** data )
+{
+	/* emFile has no memory mapped files */
+	return FSAL_ERROR_NOT_SUPPORTED;
+}
+
+/** @brief Unmaps a part of a file from memory.
+ *
+ *  This function releases a range of a file previously mapped into
+ *  memory.
+ *
+ *  @param[in] data - the location of the mapped range
+ *
+ *  @param[in] offset - the byte offset in the file where the mapped
+ *                      range starts
+ *
+ *  @param[in] length - the number of bytes mapped
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_UnmapFile( const uint8_t * data, size_t offset, size_t length )
+{
+	/* emFile has no memory mapped files */
+	return FSAL_ERROR_NOT_SUPPORTED;
+}
+
+/** @brief Maps a part of a file into memory for writing.
+ *
+ *  This function maps the specified range of a file as specified
+ *  by a specific file handle into memory for read and write access.
+ *  Stores into the mapped range are shared with the file, which is
+ *  updated by the filesystem on its own or when the mapped range is
+ *  synchronized. The mapping stays valid after the file is closed,
+ *  until it is unmapped.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to map (opened for read and write)
+ *
+ *  @param[in] offset - the byte offset in the file where the range
+ *                      to map starts
+ *
+ *  @param[in] length - the number of bytes to map
+ *
+ *  @param[out] data - the reference where the location of the
+ *                     mapped range is set
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_MapFileWritable( FSAL_File_t fsal_handle, size_t offset, size_t length, uint8_t ** data )
+{
+	/* emFile has no memory mapped files */
+	return FSAL_ERROR_NOT_SUPPORTED;
+}
+
+/** @brief Synchronizes a part of a file mapped into memory.
+ *
+ *  This function writes the stores into a range of a file mapped
+ *  for writing back to the file, either by scheduling the write
+ *  or by waiting for the write to complete.
+ *
+ *  @param[in] data - the location of the mapped range
+ *
+ *  @param[in] offset - the byte offset in the file where the mapped
+ *                      range starts
+ *
+ *  @param[in] length - the number of bytes mapped
+ *
+ *  @param[in] sync_type - the type of synchronization to perform:
+ *
+ *                         FSAL_SYNC_ASYNC
+ *                         FSAL_SYNC_WAIT
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+int FSAL_SyncMappedFile( const uint8_t * data, size_t offset, size_t length, int sync_type )
+{
+	/* emFile has no memory mapped files */
+	return FSAL_ERROR_NOT_SUPPORTED;
+}
+
 /** @brief Deletes a file.
  *
  *  This function deletes a file from the filesystem in
@@ -457,5 +1058,107 @@ int FSAL_DeleteFile( char * file_name )
 	return FSAL_STATUS_OK;
 }
 
+/** @brief Deletes a file of a directory.
+ *
+ *  This function deletes a file from the directory associated with
+ *  the specified directory handle.
+ *
+ *  @param[in] fsal_dir - the handle of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to remove
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_DeleteDirFile( FSAL_Dir_t fsal_dir, char * file_name )
+{
+	char file_path[FSAL_PATH_NAME_MAX] = {0};
+
+	/* sanity checks */
+	if ( (fsal_dir < 0) || (fsal_dir >= FSAL_DIR_LIST_MAX) || (file_name == NULL) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	snprintf( file_path, sizeof(file_path), "%s\\%s", dir_path_list[fsal_dir], file_name );
+
+	/* delete the specified file */
+	if ( FS_Remove(file_path) != 0 ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	return FSAL_STATUS_OK;
+}
+
+/** @brief Defers the writes of the calling task.
+ *
+ *  This function sets whether the writes, closes and deletes of
+ *  files requested by the calling task (or thread) may be deferred,
+ *  which this filesystem never does.
+ *
+ *  @param[in] defer - non-zero to defer the requests, zero otherwise
+ *
+ *  @return none
+ */
+void FSAL_DeferWrites( int defer )
+{
+	/* every request completes before its call returns */
+	(void) defer;
+}
+
+/** @brief Retrieves the ticket of the last deferred write.
+ *
+ *  This function retrieves the ticket of the last request deferred
+ *  so far, always zero as this filesystem never defers any request.
+ *
+ *  @param none
+ *
+ *  @return uint32_t - the ticket of the last deferred request
+ */
+uint32_t FSAL_GetWriteTicket( void )
+{
+	return 0;
+}
+
+/** @brief Polls the deferred writes for completion.
+ *
+ *  This function retrieves the ticket up to which all deferred
+ *  requests completed and the ticket of the oldest one which failed,
+ *  both always zero as this filesystem never defers any request.
+ *
+ *  @param[in] sync_type - the type of synchronization to perform:
+ *
+ *                         FSAL_SYNC_ASYNC
+ *                         FSAL_SYNC_WAIT
+ *
+ *  @param[out] completed - the ticket up to which all requests
+ *                          completed
+ *
+ *  @param[out] failed - the ticket of the oldest failed request
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+int FSAL_PollWrites( int sync_type, uint32_t * completed, uint32_t * failed )
+{
+	/* sanity checks */
+	if ( (completed == NULL) || (failed == NULL) ) {
+		return FSAL_ERROR_FILE_ACCESS;
+	}
+
+	/* nothing is ever in flight */
+	*completed = 0;
+	*failed = 0;
+
+	return FSAL_STATUS_OK;
+}
+
 
 #endif /* FSAL_SEGGER_EMFILE */
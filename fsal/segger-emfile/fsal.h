@@ -20,7 +20,12 @@
 
 #ifdef FSAL_SEGGER_EMFILE
 
-/* nothing to define yet */
+/**
+ * Maximum number of directories opened at the same time and
+ * maximum length of the cached full path of a directory
+ */
+#define FSAL_DIR_LIST_MAX				(DATA_QUEUE_FILE_HANDLE_LIST_MAX + 2)
+#define FSAL_PATH_NAME_MAX				20
 
 #endif /* FSAL_SEGGER_EMFILE */
 
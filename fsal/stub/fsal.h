@@ -1,28 +0,0 @@
-/**********************************************************************
-* Filename:     fsal.h
-*
-* Copyright 2018, Swift Labs / TR
-*
-* Author:       Ronald Miranda / Emil Ekmecic
-*
-* Created:      August 20, 2018
-*
-* Description:  This is the header file associated with the Filesystem
-*               Abstraction Layer or FASL specific to a stub or empty
-*               filesystem.
-*
-* History
-* 20-Aug-2018   RMM      Initial code  based on expected APIs.
-**********************************************************************/
-
-#ifndef __FSAL_STUB_H__
-#define __FSAL_STUB_H__
-
-#ifdef FSAL_STUB
-
-/* nothing to define yet */
-
-#endif /* FSAL_STUB */
-
-#endif /*__FSAL_STUB_H__ */
-
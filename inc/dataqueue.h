@@ -45,6 +45,10 @@
 #define CODE_ERROR_FS_ACCESS_FAIL       		14
 #define CODE_ERROR_HANDLE_NOT_AVAIL       		15
 #define CODE_ERROR_QUEUE_ENTRY_NOT_LISTED  		16
+#define CODE_ERROR_QUEUE_ENTRY_CORRUPT  		17
+#define CODE_ERROR_BUFFER_TOO_SMALL       		18
+#define CODE_ERROR_BUFFER_NOT_AVAIL       		19
+#define CODE_ERROR_WAIT_TIMEOUT       			20
 
 
 
@@ -54,6 +58,115 @@
  */
 #define FLAGS_MESSAGE_LOG						0x0001
 #define FLAGS_RANDOM_ACCESS						0x0002
+#define FLAGS_SEGMENTED_STORAGE					0x0004
+#define FLAGS_METADATA_JOURNAL					0x0008
+#define FLAGS_FIXED_RECORD						0x0010
+#define FLAGS_PREALLOCATE						0x0020
+
+/**
+ * Data queue LUT versions to determine
+ * the layout of the LUT entries
+ */
+#define LUT_VERSION_LEGACY						0
+#define LUT_VERSION_RECORD						1
+#define LUT_VERSION_SEQUENCE					2
+
+/**
+ * Encodings of the data of an entry
+ * as it is kept on flash (only in the
+ * LUT records of the record or sequence
+ * LUT version)
+ */
+#define ENCODING_TYPE_NONE						0
+#define ENCODING_TYPE_PACKED					1
+
+/**
+ * Data queue header versions and the
+ * magic number which marks a header
+ * that is not of the first version
+ */
+#define HDR_VERSION_1							1
+#define HDR_VERSION_2							2
+#define HDR_MAGIC								0x32514644
+
+/**
+ * Magic number which marks a record of
+ * the metadata journal, the flag of a
+ * record written by a checkpoint (once
+ * the LUT and header files were stored)
+ * and the flag of a record followed by
+ * more records of the same commit
+ */
+#define JOURNAL_MAGIC							0x4C4E524A
+#define JOURNAL_FLAGS_CHECKPOINT				0x0001
+#define JOURNAL_FLAGS_CONTINUED					0x0002
+
+/**
+ * Data queue msync policies used to
+ * determine when the metadata mapped
+ * into memory is written back (only
+ * for builds with mapped metadata)
+ */
+#define MSYNC_POLICY_NONE						0
+#define MSYNC_POLICY_ASYNC						1
+#define MSYNC_POLICY_SYNC						2
+
+/**
+ * Types of FSAL calls the statistics of
+ * a data queue keep apart (only for
+ * builds with DATA_QUEUE_STATS)
+ */
+#define STATS_FSAL_DIRECTORY					0
+#define STATS_FSAL_LIST_FILE					1
+#define STATS_FSAL_OPEN_FILE					2
+#define STATS_FSAL_CLOSE_FILE					3
+#define STATS_FSAL_READ_FILE					4
+#define STATS_FSAL_WRITE_FILE					5
+#define STATS_FSAL_DELETE_FILE					6
+#define STATS_FSAL_LOCK							7
+#define STATS_FSAL_MAP_FILE						8
+#define STATS_FSAL_SYNC_FILE					9
+#define STATS_FSAL_ALLOCATE_FILE				10
+#define STATS_FSAL_CALL_MAX						11
+
+/**
+ * Types of the records of an FSAL trace
+ * (only written by builds with
+ * DATA_QUEUE_TRACE): one per FSAL call
+ * the engine makes, the first one being
+ * that of FSAL_Init (whose offset and
+ * length keep the magic and version of
+ * the trace), plus one per entry
+ * enqueued keeping its payload size
+ */
+#define TRACE_MAGIC								0x52545144
+#define TRACE_VERSION							1
+#define TRACE_OP_INIT							0
+#define TRACE_OP_MAKE_DIRECTORY					1
+#define TRACE_OP_REMOVE_DIRECTORY				2
+#define TRACE_OP_OPEN_DIRECTORY					3
+#define TRACE_OP_CLOSE_DIRECTORY				4
+#define TRACE_OP_LOCK_DIRECTORY					5
+#define TRACE_OP_UNLOCK_DIRECTORY				6
+#define TRACE_OP_LIST_DIR_FILE					7
+#define TRACE_OP_OPEN_DIR_FILE					8
+#define TRACE_OP_CLOSE_FILE						9
+#define TRACE_OP_SYNC_FILE						10
+#define TRACE_OP_ALLOCATE_FILE					11
+#define TRACE_OP_READ_FILE						12
+#define TRACE_OP_READ_FILE_AT					13
+#define TRACE_OP_WRITE_FILE						14
+#define TRACE_OP_WRITE_FILE_AT					15
+#define TRACE_OP_DELETE_DIR_FILE				16
+#define TRACE_OP_MAP_FILE						17
+#define TRACE_OP_UNMAP_FILE						18
+#define TRACE_OP_MAP_FILE_WRITABLE				19
+#define TRACE_OP_SYNC_MAPPED_FILE				20
+#define TRACE_OP_DEFER_WRITES					21
+#define TRACE_OP_GET_WRITE_TICKET				22
+#define TRACE_OP_POLL_WRITES					23
+#define TRACE_OP_PAYLOAD						24
+#define TRACE_OP_MAX							25
 
 /**
  * Data queue access type used by
@@ -85,7 +198,61 @@
 #define SEEK_TYPE_HEAD							0
 #define SEEK_TYPE_TAIL							1
 #define SEEK_TYPE_POSITION						2
-#define SEEK_TYPE_MAX							3
+#define SEEK_TYPE_SEQUENCE						3
+#define SEEK_TYPE_MAX							4
+
+
+/**
+ * Maximum length of the name of a
+ * cursor of a data queue
+ */
+#define CURSOR_NAME_MAX							8
+
+
+/**
+ * Durability policy of an opened data
+ * queue used to determine when the
+ * changes are committed (the metadata
+ * written) and synchronized with the
+ * storage media
+ */
+#define DURABILITY_TYPE_DEFAULT					0
+#define DURABILITY_TYPE_SYNC					1
+#define DURABILITY_TYPE_GROUP					2
+#define DURABILITY_TYPE_WRITE_BACK				3
+#define DURABILITY_TYPE_MAX						4
+
+
+/**
+ * Overflow policy of the staging ring
+ * of a data queue used to determine
+ * what happens to an entry staged
+ * while the ring is full
+ */
+#define OVERFLOW_TYPE_FAIL						0
+#define OVERFLOW_TYPE_DROP_NEWEST				1
+#define OVERFLOW_TYPE_DROP_OLDEST				2
+#define OVERFLOW_TYPE_MAX						3
+
+
+/**
+ * Timeout of a wait on a data queue
+ * with no time limit
+ */
+#define WAIT_TIMEOUT_FOREVER					0xFFFFFFFF
+
+
+/**
+ * Type of check of the recovery of
+ * a data queue used to determine if
+ * the data of the entries is read
+ * back (and checked against their
+ * CRC32) or only their metadata and
+ * storage are checked
+ */
+#define RECOVERY_CHECK_METADATA					0
+#define RECOVERY_CHECK_DATA						1
+#define RECOVERY_CHECK_MAX						2
 
 
 /**
@@ -100,11 +267,50 @@ typedef struct DataQ_File {
 } DataQ_File_t;
 
 
+/**
+ * Data structure used to set the
+ * durability policy of a data queue
+ * when it is opened (the number of
+ * operations and the time in ms after
+ * which the changes are committed only
+ * apply to the group commit policy,
+ * where a zero value disables either)
+ */
+typedef struct DataQ_Durability {
+	int type;
+	uint32_t commit_ops;
+	uint32_t commit_time;
+} DataQ_Durability_t;
+
+
 /**
  * Data structure used as a header
  * of a specific data queue
  */
 typedef struct DataQ_Hdr {
+	uint32_t magic;
+	uint8_t hdr_version;
+	uint8_t lut_version;
+	uint16_t flags;
+	size_t flash_size;
+	size_t max_flash_size;
+	size_t max_entry_size;
+	uint32_t max_entries;
+	uint32_t num_of_entries;
+	uint32_t head_lut_offs;
+	uint32_t tail_lut_offs;
+	uint32_t seek_lut_offs;
+	uint32_t reference_count;
+} DataQ_Hdr_t;
+
+
+/**
+ * Data structure used as a header
+ * of a data queue created with the
+ * first header version (still kept
+ * by the queues created with it)
+ */
+typedef struct DataQ_Hdr_v1 {
 	size_t flash_size;
 	size_t max_flash_size;
 	size_t max_entry_size;
@@ -113,10 +319,10 @@ typedef struct DataQ_Hdr {
 	uint8_t head_lut_offs;
 	uint8_t tail_lut_offs;
 	uint8_t seek_lut_offs;
-	uint8_t reserved;
+	uint8_t lut_version;
 	uint16_t reference_count;
 	uint16_t flags;
-} DataQ_Hdr_t;
+} DataQ_Hdr_v1_t;
 
 
 /**
@@ -130,11 +336,248 @@ typedef struct DataQ_LUT_Entry {
 #define DATAQ_LUT_FILE_SIZE_MAX		(256 * DATA_QUEUE_LUT_ENTRY_SIZE)
 
 
+/**
+ * Data structure used as a LUT entry
+ * of a data queue created with the
+ * segmented storage flag
+ */
+typedef struct DataQ_LUT_Segment {
+	uint32_t segment;
+	uint32_t offset;
+	uint32_t length;
+} DataQ_LUT_Segment_t;
+
+
+/**
+ * Data structure used as a LUT entry
+ * of a data queue created with the
+ * record or sequence LUT version (any
+ * storage mode); with the sequence
+ * LUT version, the reference holds
+ * the 32-bit reference count instead
+ * of its last decimal digits (in any
+ * case, the length is the size of the
+ * data as stored, packed or not)
+ */
+typedef struct DataQ_LUT_Record {
+	uint8_t version;
+	uint8_t encoding;
+	uint8_t reserved[2];
+	char reference[DATA_QUEUE_LUT_ENTRY_SIZE];
+	uint32_t segment;
+	uint32_t offset;
+	uint32_t length;
+	uint32_t crc;
+} DataQ_LUT_Record_t;
+
+
+/**
+ * Data structure used as the header of
+ * a record of the metadata journal of a
+ * data queue created with the metadata
+ * journal flag, followed by the changed
+ * LUT entries (each as its 32-bit LUT
+ * offset and the LUT entry itself); the
+ * CRC32 covers the whole record (of the
+ * specified size) with the CRC zeroed
+ */
+typedef struct DataQ_Journal_Record {
+	uint32_t magic;
+	uint32_t sequence;
+	uint32_t size;
+	uint32_t crc;
+	uint16_t flags;
+	uint16_t slot_count;
+	DataQ_Hdr_t hdr;
+} DataQ_Journal_Record_t;
+
+
+/**
+ * Data structure used as the contents
+ * of a lock file of a data queue: the
+ * number of users sharing the lock
+ * (only counted by the read-only lock
+ * file) followed by the boot and the
+ * session the lock was taken in, so
+ * that a lock left behind by a session
+ * which is gone can be told apart
+ */
+typedef struct DataQ_Lock {
+	uint8_t users;
+	uint8_t reserved[3];
+	uint32_t boot_id;
+	uint32_t session_id;
+} DataQ_Lock_t;
+
+
+/**
+ * Data structure used to report the
+ * recovery of a data queue: the number
+ * of stale lock files cleared, of the
+ * entries checked and of those dropped
+ * (as missing or corrupt), the bytes
+ * of data read back, whether anything
+ * was repaired and the time in us the
+ * recovery took
+ */
+typedef struct DataQ_Recovery {
+	uint32_t locks_cleared;
+	uint32_t entries_checked;
+	uint32_t entries_dropped;
+	uint32_t bytes_checked;
+	uint32_t repaired;
+	uint32_t elapsed_time;
+} DataQ_Recovery_t;
+
+
+/**
+ * Data structure used to keep a record
+ * of an FSAL trace, followed by the name
+ * of the file or directory of the call
+ * (if any, not terminated): the time in
+ * us from the start of the call recorded
+ * before (negative if calls of separate
+ * tasks ended out of order) and that of
+ * the call, the handle (file, directory
+ * or mapping, or the data queue of a
+ * payload) it operates on, its offset,
+ * length and flags (open flags, or lock,
+ * sync or defer type), its result (the
+ * status code or bytes transferred) and
+ * its output (the handle opened, file
+ * size listed, mapping, write ticket or
+ * writes completed)
+ */
+typedef struct DataQ_Trace_Record {
+	int32_t delta;
+	uint32_t elapsed;
+	uint32_t handle;
+	uint32_t offset;
+	uint32_t length;
+	uint32_t flags;
+	int32_t result;
+	uint32_t output;
+	uint8_t op;
+	uint8_t reserved;
+	uint16_t name_length;
+} DataQ_Trace_Record_t;
+
+
+/**
+ * Data structure used as a read-only
+ * view of an entry of the data queue
+ * (only the data and size are meant
+ * to be used by the application)
+ */
+typedef struct DataQ_View {
+	const void * data;
+	size_t size;
+	size_t offset;
+	int buffer;
+	DataQ_LUT_Record_t record;
+} DataQ_View_t;
+
+
+/**
+ * Data structure used as an iterator
+ * over a range of entries of the data
+ * queue, along with its (optional)
+ * read-ahead buffer and the part of a
+ * segment it currently holds (none of
+ * them are meant to be used by the
+ * application)
+ */
+typedef struct DataQ_Iter {
+	DataQ_File_t * fifo_handle;
+	uint32_t reference;
+	uint32_t remaining;
+	uint8_t * buffer;
+	size_t buffer_size;
+	size_t buffer_length;
+	uint32_t buffer_reference;
+	uint32_t buffer_segment;
+	uint32_t buffer_offset;
+} DataQ_Iter_t;
+
+
+/**
+ * Data structure used to report the
+ * state of the staging ring of a data
+ * queue (the sizes are in bytes of the
+ * ring, each staged entry taking its
+ * size rounded up to a multiple of 4
+ * plus 4 bytes)
+ */
+typedef struct DataQ_Staging_Info {
+	size_t ring_size;
+	size_t length;
+	size_t high_water;
+	uint32_t dropped;
+} DataQ_Staging_Info_t;
+
+
+/**
+ * Function called back once an entry
+ * enqueued asynchronously is written
+ * (or failed to be), given the data
+ * queue, the status or error code of
+ * the operation and the context the
+ * operation was started with
+ */
+typedef void (* DataQ_Callback_t)( DataQ_File_t * fifo_handle, int status, void * context );
+
+#if defined( DATA_QUEUE_STATS )
+
+/**
+ * Data structure used to keep the
+ * statistics of one type of FSAL
+ * call (times are in the units of
+ * the PSL timestamp)
+ */
+typedef struct DataQ_Call_Stats {
+	uint32_t count;
+	uint32_t errors;
+	uint64_t bytes;
+	uint64_t total_time;
+	uint32_t max_time;
+} DataQ_Call_Stats_t;
+
+
+/**
+ * Data structure used to keep the
+ * statistics of an opened data queue
+ * (the FSAL calls are indexed by
+ * their STATS_FSAL_xxx type)
+ */
+typedef struct DataQ_Stats {
+	DataQ_Call_Stats_t fsal[STATS_FSAL_CALL_MAX];
+	uint32_t enqueues;
+	uint32_t evictions;
+	uint32_t dequeues;
+	uint32_t discards;
+	uint32_t trims;
+	uint32_t lut_cache_hits;
+	uint32_t lut_cache_misses;
+	uint32_t lut_page_stores;
+	uint32_t header_stores;
+	uint32_t journal_stores;
+	uint32_t lock_operations;
+} DataQ_Stats_t;
+
+#endif /* DATA_QUEUE_STATS */
+
+
 /** @brief Performs initialization of the first-in, first-out (FIFO)
  *         data queue engine
  *
  *  This function initializes the data queue engine including the
- *  underlying filesystem abstraction layer.
+ *  underlying filesystem abstraction layer. The engine is initialized
+ *  only once even if more tasks (or threads) call this function,
+ *  after which all of them may use the engine at the same time:
+ *  operations on separate data queues run in parallel while the
+ *  operations on the same data queue are serialized. After a system
+ *  failure, each data queue may then be recovered (see
+ *  DataQ_FifoRecover) before it is opened.
  *
  *  @param none
  *
@@ -149,11 +592,58 @@ void DataQ_InitEngine( void );
  *  operation sets up the associated metadata and lookup table with
  *  an empty (although pre-allocated) data queue.
  *
+ *  By default, each entry is stored in a file of its own. With the
+ *  segmented storage flag, the entries are rather appended into a
+ *  rotating set of fixed-size segment files and a segment is deleted
+ *  as a whole once the 'head' end moves past it.
+ *
+ *  The data queue is created with the second header version, whose
+ *  32-bit offsets and reference count are not limited to 255 entries
+ *  (each entry file is then named after the hexadecimal digits of its
+ *  reference count). Its LUT is only ever cached a few pages at a
+ *  time, so a large LUT is never held in memory as a whole.
+ *
+ *  With the metadata journal flag, a change to the data queue is
+ *  committed by writing one record (the header and the changed LUT
+ *  entries, or as many records as these entries need) into the next
+ *  slots of a ring of fixed-size records kept in a journal file,
+ *  instead of rewriting both the LUT and header files. These files
+ *  are only brought up to date with changes already journaled, by a
+ *  checkpoint made before the ring runs out of room, and opening the
+ *  data queue replays the records written since the last checkpoint,
+ *  skipping a record torn by a power loss (along with the records of
+ *  a commit cut short). The changed LUT entries of a commit that spill
+ *  out of the cached LUT pages are journaled ahead of it, so a commit
+ *  may change at most as many LUT entries as the ring of records holds
+ *  (DATA_QUEUE_JOURNAL_RECORD_COUNT records, less the room kept for
+ *  the cached pages), beyond which it fails.
+ *
+ *  With the fixed record flag, every entry is exactly the maximum
+ *  entry size and the entries are kept in the slots of one ring file
+ *  preallocated for all of them, the slot of an entry being its LUT
+ *  offset. No LUT file is kept (nor any file created or deleted once
+ *  the data queue is created), the oldest entry is overwritten in
+ *  place once the data queue is full and the maximum flash size is
+ *  that of the ring file. This flag may not be combined with the
+ *  segmented storage flag, and the library may be built with the
+ *  record size set (DATA_QUEUE_FIXED_RECORD_SIZE) so that the size
+ *  of the record I/O is a compile-time constant, in which case it
+ *  must be the maximum entry size.
+ *
+ *  With the preallocate flag, the storage of the entries is reserved
+ *  up front (contiguously where the filesystem allows it): every
+ *  segment file of a data queue created with the segmented storage
+ *  flag is allocated to the segment size and then reused in place
+ *  rather than deleted and created again, as is the ring file of one
+ *  created with the fixed record flag. The flag may not be used for
+ *  a data queue keeping each entry in a file of its own.
+ *
  *  @param[in] fifo_name - the reference by which the data queue is
  *                         identified
  *
  *  @param[in] max_entries - the maximum allowable entries for the
- *                           data queue to be created
+ *                           data queue to be created (if zero, 255
+ *                           entries are allowed)
  *
  *  @param[in] max_entry_size - the maximum allowable size of one
  *                              data queue entry
@@ -166,6 +656,10 @@ void DataQ_InitEngine( void );
  *
  *                     FLAGS_MESSAGE_LOG
  *                     FLAGS_RANDOM_ACCESS
+ *                     FLAGS_SEGMENTED_STORAGE
+ *                     FLAGS_METADATA_JOURNAL
+ *                     FLAGS_FIXED_RECORD
+ *                     FLAGS_PREALLOCATE
  *
  *  @return int - the status or error code of the operation after
  *                the call:
@@ -176,7 +670,7 @@ void DataQ_InitEngine( void );
  *                CODE_ERROR_FS_ACCESS_FAIL
  *
  */
-int DataQ_FifoCreate( char * fifo_name, uint8_t max_entries, size_t max_entry_size, size_t max_flash_size, uint16_t flags );
+int DataQ_FifoCreate( char * fifo_name, uint32_t max_entries, size_t max_entry_size, size_t max_flash_size, uint16_t flags );
 
 
 /** @brief Destroys a first-in, first-out (FIFO) data queue.
@@ -211,11 +705,37 @@ int DataQ_FifoDestroy( char * fifo_name );
  *  binary or packed). If the operation succeeded, the output
  *  parameter is updated with the fifo handle.
  *
+ *  The entries enqueued through a handle opened with the binary
+ *  packed mode are packed with a small LZ77 codec before they are
+ *  written, as long as that takes less room (and the entry fits into
+ *  the packing buffer), so that fewer bytes are written and the flash
+ *  size of the data queue accounts for the packed size. The encoding
+ *  is kept in the LUT record of each entry, so that any handle reads
+ *  back the data as it was enqueued whatever its mode; a data queue
+ *  created with the legacy LUT version keeps no encoding and always
+ *  stores the data as it is.
+ *
+ *  The header of the data queue is loaded once into a state
+ *  block cached for the lifetime of the fifo handle, along with
+ *  the pages of the LUT as they are needed, and all other
+ *  operations on the handle work on that cache (writing it back
+ *  only when the data queue changes). A data queue created with
+ *  the first header version is opened as well and keeps its
+ *  header in that version. The
+ *  directory of the data queue is likewise resolved once and
+ *  all files are accessed in relative to it, so the current
+ *  directory is never changed.
+ *
  *  If the data queue is already opened by this process, it
  *  checks if the current access type and mode match the new
  *  one - if it does, the function updates the output parameter
  *  with the already opened fifo handle and considers a successful
  *  operation; otherwise, the function considers a failed operation.
+ *  A data queue opened for read-only access is the exception: each
+ *  read-only open gets a fifo handle of its own (whatever its mode),
+ *  with its own cursor, sharing the header and LUT cached by the
+ *  readers already opened, so every reader scans the data queue at
+ *  its own pace and closes its own fifo handle.
  *
  *  If the data queue is already opened by another process, the
  *  function considers a failed operation and the error code is
@@ -232,7 +752,14 @@ int DataQ_FifoDestroy( char * fifo_name );
  *  data queue opened) and had the current byte value incremented
  *  by one. For all other access type (write-only and read/write),
  *  the associated lock files are created empty because only one
- *  user is allowed for such access types.
+ *  user is allowed for such access types. When the library is built
+ *  with DATA_QUEUE_NATIVE_LOCK, a shared (read-only) or exclusive
+ *  lock is instead taken on the data queue directory through the
+ *  FSAL and no lock file is created.
+ *
+ *  The lock is taken once and held by the fifo handle until the
+ *  fifo is closed; the other operations trust the handle and do
+ *  not probe the lock again.
  *
  *  @param[in] fifo_name - the reference of the data queue to be
  *                         accessed
@@ -267,6 +794,66 @@ int DataQ_FifoDestroy( char * fifo_name );
 int DataQ_FifoOpen( char * fifo_name, int access, int mode, DataQ_File_t ** fifo_handle );
 
 
+/** @brief Opens a first-in, first-out (FIFO) data queue for
+ *         access with a durability policy.
+ *
+ *  This function opens a specified data queue the same way as
+ *  DataQ_FifoOpen and sets the durability policy of the fifo
+ *  handle, which determines when the changes made through the
+ *  handle are committed to the LUT and header (or metadata) files
+ *  and when the files are synchronized with the storage media:
+ *
+ *  - DURABILITY_TYPE_DEFAULT commits the changes of every operation
+ *    and leaves the synchronization to the filesystem (this is the
+ *    policy of a data queue opened with DataQ_FifoOpen);
+ *  - DURABILITY_TYPE_SYNC commits the changes of every operation
+ *    and synchronizes the files written before the operation
+ *    returns;
+ *  - DURABILITY_TYPE_GROUP keeps the changes in the cached state
+ *    and commits and synchronizes them once the specified number
+ *    of operations is reached or the specified time has elapsed
+ *    since the first uncommitted operation (checked on every
+ *    operation, there is no timer);
+ *  - DURABILITY_TYPE_WRITE_BACK keeps the changes in the cached
+ *    state until DataQ_FifoFlush or DataQ_FifoClose is called,
+ *    which commit and synchronize them.
+ *
+ *  With the last two policies, the operations made since the last
+ *  commit are lost if the system fails before the next one, and
+ *  the data queue as seen by other processes only changes when a
+ *  commit is made. If the data queue is already opened by this
+ *  process (other than for read-only access, see DataQ_FifoOpen),
+ *  the durability policy of the fifo handle is left as it is.
+ *
+ *  @param[in] fifo_name - the reference of the data queue to be
+ *                         accessed
+ *
+ *  @param[in] access - the access type to be performed on the data
+ *                      data queue (see DataQ_FifoOpen)
+ *
+ *  @param[in] mode - the access mode to be considered on the data
+ *                    data queue (see DataQ_FifoOpen)
+ *
+ *  @param[in] durability - the reference of the durability policy
+ *                          or NULL for DURABILITY_TYPE_DEFAULT
+ *
+ *  @param[out] fifo_handle - the reference where the pointer to the
+ *                            fifo handle is copied.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_QUEUE_MISSING
+ *                CODE_ERROR_QUEUE_OPENED
+ *                CODE_ERROR_QUEUE_IS_BUSY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_FifoOpenEx( char * fifo_name, int access, int mode, DataQ_Durability_t * durability, DataQ_File_t ** fifo_handle );
+
+
 /** @brief Closes a first-in, first-out (FIFO) data queue for
  *         access.
  *
@@ -283,7 +870,16 @@ int DataQ_FifoOpen( char * fifo_name, int access, int mode, DataQ_File_t ** fifo
  *  it by one. If the result is a zero value, the lock file
  *  is deleted. For all other lock files (write-only or read
  *  write access types), the lock file is deleted immediately
- *  as such access types only allows one user at a time.
+ *  as such access types only allows one user at a time. Only the
+ *  lock file matching the access type of the fifo handle is
+ *  updated. When the library is built with DATA_QUEUE_NATIVE_LOCK,
+ *  the directory lock taken by the open is released instead.
+ *
+ *  The changes not yet committed under the durability policy of
+ *  the fifo handle are committed and synchronized first, and the
+ *  named cursor of the fifo handle, if any, is stored if it moved.
+ *  The staging ring of the fifo handle, if any, is released along
+ *  with the entries it still holds (see DataQ_FifoDrain).
  *
  *
  *  @param[in] fifo_handle - the reference of the data queue to be
@@ -294,68 +890,108 @@ int DataQ_FifoOpen( char * fifo_name, int access, int mode, DataQ_File_t ** fifo
  *
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
- *                CODE_ERROR_QUEUE_MISSING
  *                CODE_ERROR_FS_ACCESS_FAIL
  *
  */
 int DataQ_FifoClose( DataQ_File_t * fifo_handle );
 
 
-/** @brief Enqueues an entry into the specified first-in, first-out
- *         (FIFO) data queue.
+/** @brief Recovers a first-in, first-out (FIFO) data queue at
+ *         start-up.
+ *
+ *  This function brings a data queue back to a consistent state
+ *  after the system failed (such as on a power loss) while the data
+ *  queue was in use. It is meant to be called at start-up for each
+ *  data queue, right after DataQ_InitEngine and before the data
+ *  queue is opened (the engine does not know which data queues are
+ *  kept on the filesystem).
+ *
+ *  The lock files left behind by the sessions which are gone are
+ *  cleared first: a lock file is stale if it was taken during an
+ *  earlier boot, or for write access by a session which is no
+ *  longer running (see PSL_GetBootId and PSL_IsSessionAlive), or if
+ *  it does not name its boot and session (as left by an earlier
+ *  version of the library). A data queue still locked otherwise is
+ *  busy. When the library is built with DATA_QUEUE_NATIVE_LOCK, the
+ *  locks go away along with the sessions holding them, so there is
+ *  nothing to clear.
+ *
+ *  The header (or metadata, once its journal is replayed) is then
+ *  checked against the LUT and the storage of the entries, streaming
+ *  through the entries once from the 'head' end: each entry must be
+ *  listed with the size its LUT record keeps (within its segment or
+ *  ring file in shared storage) and, with RECOVERY_CHECK_DATA, its
+ *  data must match the CRC32 its LUT record keeps (read back through
+ *  a buffer of DATA_QUEUE_RECOVERY_BUFFER_SIZE bytes whatever the
+ *  size of the entries; a fixed record keeps no CRC32 and the CRC32
+ *  of a packed entry covers its unpacked data, so only their size is
+ *  checked). Each entry must also follow on from the one before it:
+ *  the reference its LUT record keeps (if any) must be the reference
+ *  of its position, and an entry in segmented storage must lie right
+ *  after the previous entry within its segment or at the start of the
+ *  next one. The entries missing, corrupt or out of sequence at the
+ *  'head' end, as left by a torn eviction, are dropped, while the
+ *  first such entry after a sound one, as left by a torn enqueue,
+ *  truncates the data queue there, unless its LUT record is cleared
+ *  and sound entries follow it up to the 'tail' end: the gap was then
+ *  left by a torn eviction (whose LUT records are not stored from the
+ *  'head' end on) and the entries before it are dropped instead. A
+ *  full data queue whose LUT was
+ *  committed one enqueue ahead of its header keeps the entry enqueued
+ *  last at the 'head' end, and that enqueue is completed instead.
+ *  The number of entries and the flash size are then set from the
+ *  entries kept and the repaired header and LUT are committed. A
+ *  header which can not locate the entries is beyond repair (the
+ *  data queue has to be destroyed and created again).
+ *
+ *  The time the recovery takes is bounded by the size of the data
+ *  queue: the lock files, the header and LUT files and one listing
+ *  per entry with RECOVERY_CHECK_METADATA, plus one open and one read
+ *  per DATA_QUEUE_RECOVERY_BUFFER_SIZE bytes of each entry with
+ *  RECOVERY_CHECK_DATA. The time it actually took is reported.
  *
- *  This function enqueues or inserts a new entry into the specified
- *  data queue. For a FIFO type of queue, insertion happens on the
- *  'tail' end only (where the youngest entry can be found) and not
- *  anywhere else. If the data queue is full, then the oldest entry
- *  in the queue, located in the 'head' end, is removed from the queue
- *  before the new entry is inserted.
  *
+ *  @param[in] fifo_name - the reference of the data queue to be
+ *                         recovered
  *
- *  @param[in] fifo_handle - the reference of the data queue to be
- *                           accessed for the enqueue operation.
+ *  @param[in] check - the type of check of the entries:
  *
- *  @param[in] data - the reference of the data to be enqueued.
+ *                     RECOVERY_CHECK_METADATA
+ *                     RECOVERY_CHECK_DATA
  *
- *  @param[in] size - the size of the data to be enqueued.
+ *  @param[out] report - the reference where the report of the
+ *                       recovery is copied (may be null)
  *
  *  @return int - the status or error code of the operation after
  *                the call:
  *
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
- *                CODE_ERROR_INVALID_HANDLE
- *                CODE_ERROR_QUEUE_READ_ONLY
  *                CODE_ERROR_QUEUE_MISSING
- *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_OPENED
+ *                CODE_ERROR_QUEUE_IS_BUSY
+ *                CODE_ERROR_HANDLE_NOT_AVAIL
  *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
  *
  */
-int DataQ_FifoEnqueue( DataQ_File_t * fifo_handle, void * data, size_t size );
+int DataQ_FifoRecover( char * fifo_name, int check, DataQ_Recovery_t * report );
 
 
-/** @brief Dequeues an entry from the specified first-in, first-out
- *         (FIFO) data queue.
+/** @brief Flushes a first-in, first-out (FIFO) data queue.
  *
- *  This function dequeues or removes a new entry on the specified
- *  data queue. For a FIFO type of queue, deletion happens on the
- *  'head' end only (where the oldest entry can be found) and not
- *  anywhere else. On successful operation, the contents and size
- *  of the data removed from the queue is copied into the non-null
- *  output parameters. The queue needs to have at least one entry
- *  for the operation to succeed.
+ *  This function commits the changes made through the specified
+ *  fifo handle that are not yet committed under its durability
+ *  policy and synchronizes the files written with the storage
+ *  media (the files are only synchronized with a policy other than
+ *  DURABILITY_TYPE_DEFAULT). The named cursor of the fifo handle,
+ *  if any, is stored as well if it moved. If there is nothing to
+ *  commit, it does not do anything and considers a successful
+ *  operation.
  *
  *
  *  @param[in] fifo_handle - the reference of the data queue to be
- *                           access for the dequeue operation.
- *
- *  @param[out] data - if not null, the reference where the data to be
- *                     dequeued is to be copied (otherwise, it is not
- *                     copied).
- *
- *  @param[out] size - if not null, the reference where the data size
- *                     of the data to be dequeued is set (otherwise,
- *                     it is not set).
+ *                           flushed
  *
  *  @return int - the status or error code of the operation after
  *                the call:
@@ -363,40 +999,30 @@ int DataQ_FifoEnqueue( DataQ_File_t * fifo_handle, void * data, size_t size );
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
  *                CODE_ERROR_INVALID_HANDLE
- *                CODE_ERROR_QUEUE_READ_ONLY
- *                CODE_ERROR_QUEUE_MISSING
  *                CODE_ERROR_QUEUE_CLOSED
  *                CODE_ERROR_FS_ACCESS_FAIL
- *                CODE_ERROR_QUEUE_IS_EMPTY
  *
  */
-int DataQ_FifoDequeue( DataQ_File_t * fifo_handle, void * data, size_t * size );
+int DataQ_FifoFlush( DataQ_File_t * fifo_handle );
 
 
-/** @brief Seeks to an entry from the specified first-in, first-out
+/** @brief Enqueues an entry into the specified first-in, first-out
  *         (FIFO) data queue.
  *
- *  This function sets the current position of the 'seek' pointer
- *  to a particular entry from the specified data queue. The seek
- *  operation can be either seek to the 'head' end, seek to the
- *  'tail' end, or seek to a specific position between 'head' and
- *  'tail' ends. The data queue should be seekable and should have
- *  at least one entry for the operation to succeed.
+ *  This function enqueues or inserts a new entry into the specified
+ *  data queue. For a FIFO type of queue, insertion happens on the
+ *  'tail' end only (where the youngest entry can be found) and not
+ *  anywhere else. If the data queue is full, then the oldest entry
+ *  in the queue, located in the 'head' end, is removed from the queue
+ *  before the new entry is inserted.
  *
  *
  *  @param[in] fifo_handle - the reference of the data queue to be
- *                           accessed for the seek operation.
- *
- *  @param[in] seek_type - the type of seek to be performed:
+ *                           accessed for the enqueue operation.
  *
- *                         SEEK_TYPE_HEAD
- *                         SEEK_TYPE_TAIL
- *                         SEEK_TYPE_POSITION
+ *  @param[in] data - the reference of the data to be enqueued.
  *
- *  @param[in] position - if SEEK_TYPE_POSITION is specified as the
- *                        seek type, the position where the 'seek'
- *                        pointer would be set (otherwise, this
- *                        parameter is ignored).
+ *  @param[in] size - the size of the data to be enqueued.
  *
  *  @return int - the status or error code of the operation after
  *                the call:
@@ -404,38 +1030,37 @@ int DataQ_FifoDequeue( DataQ_File_t * fifo_handle, void * data, size_t * size );
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
  *                CODE_ERROR_INVALID_HANDLE
- *                CODE_ERROR_INVALID_SEEK
- *                CODE_ERROR_QUEUE_WRITE_ONLY
- *                CODE_ERROR_QUEUE_MISSING
+ *                CODE_ERROR_QUEUE_READ_ONLY
  *                CODE_ERROR_QUEUE_CLOSED
- *                CODE_ERROR_QUEUE_IS_EMPTY
- *                CODE_ERROR_QUEUE_NOT_SEEKABLE
  *                CODE_ERROR_FS_ACCESS_FAIL
  *
  */
-int DataQ_FifoSeek( DataQ_File_t * fifo_handle, int seek_type, int position );
+int DataQ_FifoEnqueue( DataQ_File_t * fifo_handle, void * data, size_t size );
 
 
-/** @brief Copies an entry from the specified first-in, first-out
- *         (FIFO) data queue.
+/** @brief Enqueues a batch of entries into the specified first-in,
+ *         first-out (FIFO) data queue.
  *
- *  This function copies an entry from the specified data queue,
- *  particularly where the 'seek' pointer is currently positioned.
- *  After the contents and size of the entry are copied and set to
- *  the corresponding output parameters, the position of the 'seek'
- *  pointer is advanced to the next entry. If the old 'seek' pointer
- *  position is the 'head' end of the queue, then the new position
- *  would be the 'tail' end of the queue. The queue needs to have
- *  at least one entry for the operation to succeed.
+ *  This function enqueues or inserts new entries into the specified
+ *  data queue, in the order given, as if each of them were enqueued
+ *  individually. The oldest entries are removed from the 'head' end
+ *  of the queue to make room for the whole batch in one go (entries
+ *  at the front of a batch that does not fit the queue by itself are
+ *  dropped without being written), all payloads are written, and the
+ *  LUT and header (or metadata) files are then updated only once.
+ *
+ *  If writing one of the payloads fails, the entries preceding it
+ *  stay enqueued (and committed) and the error code is returned.
  *
  *
  *  @param[in] fifo_handle - the reference of the data queue to be
- *                           accessed for the copy operation.
+ *                           accessed for the enqueue operation.
  *
- *  @param[out] data - the reference where the data is to be copied.
+ *  @param[in] data - the references of the data to be enqueued.
+ *
+ *  @param[in] sizes - the sizes of the data to be enqueued.
  *
- *  @param[out] size - the reference where the size of the copied
- *                     data is to be set.
+ *  @param[in] count - the number of data to be enqueued.
  *
  *  @return int - the status or error code of the operation after
  *                the call:
@@ -443,29 +1068,46 @@ int DataQ_FifoSeek( DataQ_File_t * fifo_handle, int seek_type, int position );
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
  *                CODE_ERROR_INVALID_HANDLE
- *                CODE_ERROR_QUEUE_WRITE_ONLY
- *                CODE_ERROR_QUEUE_MISSING
+ *                CODE_ERROR_QUEUE_READ_ONLY
  *                CODE_ERROR_QUEUE_CLOSED
- *                CODE_ERROR_QUEUE_IS_EMPTY
  *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_ENTRY_NOT_LISTED
  *
  */
-int DataQ_FifoGetEntry( DataQ_File_t * fifo_handle, void * data, size_t * size );
-
+int DataQ_FifoEnqueueBatch( DataQ_File_t * fifo_handle, const void ** data, const size_t * sizes, size_t count );
 
-/** @brief Retrieves the current number of entries of the specified
- *         first-in, first-out (FIFO) data queue.
- *
- *  This function gets the number of entries the specified data queue
- *  currently has. If the operation succeeds, the number of entries
- *  is stored in the output parameter.
+/** @brief Enqueues an entry into the specified first-in, first-out
+ *         (FIFO) data queue asynchronously.
+ *
+ *  This function enqueues a new entry into the specified data queue
+ *  as DataQ_FifoEnqueue does, except that the writes, closes and
+ *  deletes of files it requests from a filesystem deferring requests
+ *  (FSAL_LINUX_URING) are only queued, to be submitted along with
+ *  those of the other operations, so that the function returns
+ *  without waiting for them. The operation completes once all of
+ *  them did, when DataQ_Poll calls the specified callback with the
+ *  status of the operation (the callback is called by the first
+ *  poll for filesystems which never defer requests).
+ *
+ *  The entry is enqueued into the cached state of the data queue
+ *  right away so that any later operation on it sees the entry. If
+ *  a deferred request fails, the operation it belongs to and those
+ *  completing after it (until no operation is left in flight) fail,
+ *  and the cached state of their data queues is read back from their
+ *  files then.
  *
  *
  *  @param[in] fifo_handle - the reference of the data queue to be
- *                           accessed for the get length operation.
+ *                           accessed for the enqueue operation.
  *
- *  @param[out] length - the reference where the number of entries
- *                       is to be stored.
+ *  @param[in] data - the reference of the data to be enqueued.
+ *
+ *  @param[in] size - the size of the data to be enqueued.
+ *
+ *  @param[in] callback - the function called once the operation
+ *                        completed
+ *
+ *  @param[in] context - the reference passed to the callback
  *
  *  @return int - the status or error code of the operation after
  *                the call:
@@ -473,19 +1115,657 @@ int DataQ_FifoGetEntry( DataQ_File_t * fifo_handle, void * data, size_t * size )
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
  *                CODE_ERROR_INVALID_HANDLE
- *                CODE_ERROR_QUEUE_MISSING
+ *                CODE_ERROR_QUEUE_READ_ONLY
  *                CODE_ERROR_QUEUE_CLOSED
  *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_ENTRY_NOT_LISTED
+ *                CODE_ERROR_BUFFER_NOT_AVAIL
  *
  */
-int DataQ_FifoGetLength( DataQ_File_t * fifo_handle, size_t * length );
+int DataQ_FifoEnqueueAsync( DataQ_File_t * fifo_handle, void * data, size_t size, DataQ_Callback_t callback, void * context );
 
-/** @brief Retrieves the current flash size usage of the specified
- *         first-in, first-out (FIFO) data queue.
+/** @brief Polls the asynchronous operations for completion.
  *
- *  This function gets the current size in flash storage of the
- *  specified data queue. If the operation succeeds, the flash size
- *  in bytes is stored in the output parameter.
+ *  This function submits the requests the asynchronous operations
+ *  on any data queue deferred so far and calls the callback of each
+ *  operation whose requests completed, in the order the operations
+ *  were started (see DataQ_FifoEnqueueAsync). Optionally, it waits
+ *  for all the operations started so far to complete. The callbacks
+ *  are called without any lock held by the engine, so they may
+ *  operate on the data queues.
+ *
+ *
+ *  @param[in] wait - non-zero to wait for all the operations started
+ *                    so far to complete
+ *
+ *  @param[out] count - the number of operations completed (may be
+ *                      null)
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_Poll( int wait, size_t * count );
+
+
+/** @brief Dequeues an entry from the specified first-in, first-out
+ *         (FIFO) data queue.
+ *
+ *  This function dequeues or removes a new entry on the specified
+ *  data queue. For a FIFO type of queue, deletion happens on the
+ *  'head' end only (where the oldest entry can be found) and not
+ *  anywhere else. On successful operation, the contents and size
+ *  of the data removed from the queue is copied into the non-null
+ *  output parameters. The queue needs to have at least one entry
+ *  for the operation to succeed.
+ *
+ *  If the buffer is smaller than the entry, nothing is dequeued
+ *  and the size is set to the size of the entry. If the entry
+ *  fails its integrity check, it is still removed (so that it does
+ *  not stall the queue) and the error code is returned.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           access for the dequeue operation.
+ *
+ *  @param[out] data - if not null, the reference where the data to be
+ *                     dequeued is to be copied (otherwise, it is not
+ *                     copied).
+ *
+ *  @param[in,out] size - if not null, the reference of the size of
+ *                        the buffer, which is then set to the data
+ *                        size of the data to be dequeued (otherwise,
+ *                        it is not set).
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_READ_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ *
+ */
+int DataQ_FifoDequeue( DataQ_File_t * fifo_handle, void * data, size_t * size );
+
+
+/** @brief Discards entries from the specified first-in, first-out
+ *         (FIFO) data queue.
+ *
+ *  This function removes the specified number of the oldest entries
+ *  from the 'head' end of the specified data queue, as if each of
+ *  them were dequeued, but without reading them: their files (or
+ *  their segments, once the 'head' end moved past them) are deleted,
+ *  their sizes kept in the LUT are taken off the flash size and the
+ *  LUT and header (or metadata) files are then updated only once. If
+ *  the data queue has fewer entries, all of them are discarded.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the discard operation.
+ *
+ *  @param[in] count - the number of entries to be discarded.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_READ_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_FifoDiscard( DataQ_File_t * fifo_handle, uint32_t count );
+
+
+/** @brief Discards entries from the specified first-in, first-out
+ *         (FIFO) data queue up to a reference.
+ *
+ *  This function removes the oldest entries from the 'head' end of
+ *  the specified data queue up to and including the entry enqueued
+ *  with the specified reference count, the same way as
+ *  DataQ_FifoDiscard. The entries of a data queue are numbered in
+ *  the order they are enqueued, starting at 1 (a data queue created
+ *  with the first header version only keeps 16 bits of it). If the
+ *  entry is already removed, it does not do anything and considers
+ *  a successful operation.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the discard operation.
+ *
+ *  @param[in] reference - the reference count of the last entry to
+ *                         be discarded.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_READ_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_FifoDiscardUntil( DataQ_File_t * fifo_handle, uint32_t reference );
+
+
+/** @brief Sets the watermarks of the specified first-in, first-out
+ *         (FIFO) data queue.
+ *
+ *  This function sets the high and low watermarks DataQ_FifoMaintain
+ *  trims the data queue by, as percentages of its capacity (both of
+ *  the maximum number of entries and of the maximum flash size). The
+ *  watermarks are kept by the fifo handle; a fifo handle is opened
+ *  without them, in which case DataQ_FifoMaintain does not trim
+ *  anything and the entries are only evicted by the enqueue that
+ *  finds the data queue full.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the set watermarks operation.
+ *
+ *  @param[in] high - the percentage of the capacity above which the
+ *                    data queue is trimmed (at most 100, or zero to
+ *                    remove the watermarks).
+ *
+ *  @param[in] low - the percentage of the capacity the data queue is
+ *                   trimmed down to (below the high watermark, or
+ *                   zero along with it).
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_CLOSED
+ *
+ */
+int DataQ_FifoSetWatermarks( DataQ_File_t * fifo_handle, uint8_t high, uint8_t low );
+
+
+/** @brief Maintains the specified first-in, first-out (FIFO) data
+ *         queue.
+ *
+ *  This function is meant to be called when the system is idle so
+ *  that the enqueues rarely have to evict the oldest entries of a
+ *  full data queue themselves: if either the number of entries or
+ *  the flash size of the data queue is above the high watermark set
+ *  by DataQ_FifoSetWatermarks, the oldest entries are removed from
+ *  the 'head' end of the data queue (the same way as with
+ *  DataQ_FifoDiscard) until both are back at or below the low
+ *  watermark, and the LUT and header (or metadata) files are then
+ *  updated only once. Otherwise it does not do anything and considers
+ *  a successful operation.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the maintain operation.
+ *
+ *  @param[out] count - the reference where the number of entries
+ *                      removed is to be stored (optional).
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_READ_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_FifoMaintain( DataQ_File_t * fifo_handle, uint32_t * count );
+
+
+/** @brief Seeks to an entry from the specified first-in, first-out
+ *         (FIFO) data queue.
+ *
+ *  This function sets the current position of the 'seek' pointer
+ *  to a particular entry from the specified data queue. The seek
+ *  operation can be either seek to the 'head' end, seek to the
+ *  'tail' end, or seek to a specific position between 'head' and
+ *  'tail' ends. The data queue should be seekable and should have
+ *  at least one entry for the operation to succeed.
+ *
+ *  A position shifts as entries are removed from the 'head' end, so
+ *  a reader resuming where it left off seeks by sequence number
+ *  instead: the reference count the entry was enqueued with (see
+ *  DataQ_FifoDiscardUntil and DataQ_FifoGetEntryEx). The entries
+ *  between the 'head' and 'tail' ends are numbered consecutively,
+ *  so the entry is located without reading anything from the
+ *  storage media. If it was already removed (or not enqueued yet),
+ *  CODE_ERROR_INVALID_SEEK is returned.
+ *
+ *  The 'seek' pointer (the cursor) belongs to the fifo handle and
+ *  only lives in its cached state, so seeking never writes to the
+ *  storage media and every process reading the data queue has a
+ *  cursor of its own. The cursor starts at the 'head' end when the
+ *  data queue is opened, unless a named cursor is set with
+ *  DataQ_FifoSetCursor.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the seek operation.
+ *
+ *  @param[in] seek_type - the type of seek to be performed:
+ *
+ *                         SEEK_TYPE_HEAD
+ *                         SEEK_TYPE_TAIL
+ *                         SEEK_TYPE_POSITION
+ *                         SEEK_TYPE_SEQUENCE
+ *
+ *  @param[in] position - if SEEK_TYPE_POSITION is specified as the
+ *                        seek type, the position where the 'seek'
+ *                        pointer would be set, or, if
+ *                        SEEK_TYPE_SEQUENCE is specified, the
+ *                        sequence number of the entry it would be
+ *                        set to (as a 32-bit value); otherwise, this
+ *                        parameter is ignored.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_INVALID_SEEK
+ *                CODE_ERROR_QUEUE_WRITE_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_QUEUE_NOT_SEEKABLE
+ *
+ */
+int DataQ_FifoSeek( DataQ_File_t * fifo_handle, int seek_type, int position );
+
+
+/** @brief Copies an entry from the specified first-in, first-out
+ *         (FIFO) data queue.
+ *
+ *  This function copies an entry from the specified data queue,
+ *  particularly where the 'seek' pointer is currently positioned.
+ *  After the contents and size of the entry are copied and set to
+ *  the corresponding output parameters, the position of the 'seek'
+ *  pointer is advanced to the next entry. If the old 'seek' pointer
+ *  position is the 'head' end of the queue, then the new position
+ *  would be the 'tail' end of the queue. The queue needs to have
+ *  at least one entry for the operation to succeed.
+ *
+ *  The size set is the true size of the entry as kept in its LUT
+ *  record. If the buffer is smaller than the entry, nothing is
+ *  copied, the 'seek' pointer is not advanced and the size is set
+ *  to the size of the entry so that the caller can retry.
+ *
+ *  Advancing the 'seek' pointer only changes the cached state of
+ *  the fifo handle (see DataQ_FifoSeek), so reading an entry never
+ *  writes to the storage media. If the entry the 'seek' pointer is
+ *  positioned at was evicted in the meantime, the entry at the
+ *  'head' end is copied instead.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the copy operation.
+ *
+ *  @param[out] data - the reference where the data is to be copied.
+ *
+ *  @param[in,out] size - the reference of the size of the buffer,
+ *                        which is then set to the size of the
+ *                        copied data.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_WRITE_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ *
+ */
+int DataQ_FifoGetEntry( DataQ_File_t * fifo_handle, void * data, size_t * size );
+
+
+/** @brief Copies an entry along with its sequence number from the
+ *         specified first-in, first-out (FIFO) data queue.
+ *
+ *  This function copies the entry the 'seek' pointer is currently
+ *  positioned at the same way as DataQ_FifoGetEntry and sets the
+ *  sequence number of the entry: the reference count the entry was
+ *  enqueued with, which the entries of a data queue are numbered by
+ *  in the order they are enqueued, starting at 1 (a data queue
+ *  created with the first header version only keeps 16 bits of it).
+ *  A reader resuming later seeks right after the last entry it read
+ *  with SEEK_TYPE_SEQUENCE (see DataQ_FifoSeek).
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the copy operation.
+ *
+ *  @param[out] data - the reference where the data is to be copied.
+ *
+ *  @param[in,out] size - the reference of the size of the buffer,
+ *                        which is then set to the size of the
+ *                        copied data.
+ *
+ *  @param[out] sequence - the reference where the sequence number of
+ *                         the copied entry is to be stored (may be
+ *                         null).
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_WRITE_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ *
+ */
+int DataQ_FifoGetEntryEx( DataQ_File_t * fifo_handle, void * data, size_t * size, uint32_t * sequence );
+
+
+/** @brief Sets a named cursor of the specified first-in, first-out
+ *         (FIFO) data queue.
+ *
+ *  This function replaces the 'seek' pointer (the cursor) of the
+ *  fifo handle with the named cursor, which is positioned where it
+ *  was last stored (or at the 'head' end if it was never stored, or
+ *  if the entry it was positioned at has been evicted since). A named
+ *  cursor is kept in a small file of its own within the data queue
+ *  and stored lazily - only by DataQ_FifoFlush, DataQ_FifoClose or
+ *  when another cursor is set, and only if it moved - so separate
+ *  readers (each using a cursor of its own name) can resume reading
+ *  the data queue where they left off without sharing one position.
+ *
+ *  The cursor being replaced is stored first, if it is named. If the
+ *  name is NULL, the cursor of the fifo handle stays positioned
+ *  where it is but is no longer named (and no longer stored).
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the set cursor operation.
+ *
+ *  @param[in] cursor_name - the name of the cursor (of at most
+ *                           CURSOR_NAME_MAX characters), or NULL.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_WRITE_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_FifoSetCursor( DataQ_File_t * fifo_handle, char * cursor_name );
+
+
+/** @brief Begins an iteration over a range of entries of the
+ *         specified first-in, first-out (FIFO) data queue.
+ *
+ *  This function sets up an iterator over the specified number of
+ *  entries of the data queue, starting at the specified position in
+ *  relative to the 'head' end, which are then copied in order by
+ *  DataQ_FifoIterNext. The range is resolved once from the cached
+ *  header: the entries enqueued afterwards are not part of it, and
+ *  the entries of it evicted before they are reached are skipped.
+ *  The iteration does not move the 'seek' pointer of the fifo
+ *  handle and never writes to the storage media. The data queue
+ *  should be seekable if the range does not start at the 'head' end.
+ *
+ *  If a read-ahead buffer is given and the data queue is created
+ *  with the segmented storage flag, the entries of the range that
+ *  follow each other within a segment are read into the buffer with
+ *  one read of the segment file (as many as fit into the buffer) and
+ *  then copied from it, instead of opening the segment file for each
+ *  entry (and so are the records that follow each other within the
+ *  ring file of a data queue created with the fixed record flag).
+ *  The buffer must stay valid until the iteration is over.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the iteration.
+ *
+ *  @param[in] start - the position of the first entry of the range
+ *                     in relative to the 'head' end.
+ *
+ *  @param[in] count - the number of entries of the range, which is
+ *                     cut down to the 'tail' end (if zero, all the
+ *                     entries up to the 'tail' end).
+ *
+ *  @param[in] buffer - if not null, the reference of the read-ahead
+ *                      buffer (otherwise, no entry is read ahead).
+ *
+ *  @param[in] buffer_size - the size of the read-ahead buffer.
+ *
+ *  @param[out] iter - the reference of the iterator to be set.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_INVALID_SEEK
+ *                CODE_ERROR_QUEUE_WRITE_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_QUEUE_NOT_SEEKABLE
+ *
+ */
+int DataQ_FifoIterBegin( DataQ_File_t * fifo_handle, uint32_t start, uint32_t count, void * buffer, size_t buffer_size, DataQ_Iter_t * iter );
+
+
+/** @brief Copies the next entry of an iteration over the specified
+ *         first-in, first-out (FIFO) data queue.
+ *
+ *  This function copies the next entry of the range of an iterator
+ *  set by DataQ_FifoIterBegin and moves the iterator on to the
+ *  following entry. Once all the entries of the range are copied,
+ *  the error code is set to empty to indicate the end of the
+ *  iteration.
+ *
+ *  If the buffer is smaller than the entry, nothing is copied, the
+ *  iterator is not moved and the size is set to the size of the
+ *  entry so that the caller can retry. If the entry fails its
+ *  integrity check, the iterator is still moved (so that it does
+ *  not stall the iteration) and the error code is returned.
+ *
+ *
+ *  @param[in,out] iter - the reference of the iterator.
+ *
+ *  @param[out] data - the reference where the data is to be copied.
+ *
+ *  @param[in,out] size - the reference of the size of the buffer,
+ *                        which is then set to the size of the
+ *                        copied data.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ *
+ */
+int DataQ_FifoIterNext( DataQ_Iter_t * iter, void * data, size_t * size );
+
+
+/** @brief Peeks at the oldest entry of the specified first-in,
+ *         first-out (FIFO) data queue.
+ *
+ *  This function hands back a read-only view of the entry at the
+ *  'head' end of the specified data queue without copying it into
+ *  a caller buffer. The view is backed by a memory mapping of the
+ *  file holding the entry if the filesystem supports it, or else by
+ *  one of a pool of bounce buffers (in which case an entry larger
+ *  than a bounce buffer can not be peeked at), which a packed entry
+ *  is always unpacked into, and a fixed record or an entry of a
+ *  preallocated segment always copied into (an enqueue reusing its
+ *  room rewrites it in place, which would show through a mapping).
+ *  The view must be handed back with DataQ_FifoRelease once it is no
+ *  longer used.
+ *  The queue needs to have at least one entry for the operation to
+ *  succeed.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the peek operation.
+ *
+ *  @param[out] view - the reference where the view of the entry
+ *                     is set.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_WRITE_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_BUFFER_NOT_AVAIL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ *
+ */
+int DataQ_FifoPeek( DataQ_File_t * fifo_handle, DataQ_View_t * view );
+
+
+/** @brief Releases a view of an entry of the specified first-in,
+ *         first-out (FIFO) data queue.
+ *
+ *  This function hands back a view previously set by DataQ_FifoPeek
+ *  and, if requested, dequeues the viewed entry right away (as long
+ *  as it is still at the 'head' end of the queue). The view is
+ *  released in any case and must not be used anymore.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the release operation.
+ *
+ *  @param[in] view - the reference of the view to be released.
+ *
+ *  @param[in] dequeue - non-zero if the viewed entry is to be
+ *                       dequeued as well.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_READ_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_ENTRY_NOT_LISTED
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_FifoRelease( DataQ_File_t * fifo_handle, DataQ_View_t * view, int dequeue );
+
+
+/** @brief Retrieves the current number of entries of the specified
+ *         first-in, first-out (FIFO) data queue.
+ *
+ *  This function gets the number of entries the specified data queue
+ *  currently has. If the operation succeeds, the number of entries
+ *  is stored in the output parameter.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the get length operation.
+ *
+ *  @param[out] length - the reference where the number of entries
+ *                       is to be stored.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_CLOSED
+ *
+ */
+int DataQ_FifoGetLength( DataQ_File_t * fifo_handle, size_t * length );
+
+/** @brief Waits for entries of the specified first-in, first-out
+ *         (FIFO) data queue.
+ *
+ *  This function blocks the calling task (or thread) until the
+ *  specified data queue has at least the specified number of entries
+ *  (as enqueued through the same fifo handle by another task or
+ *  thread) or until the timeout elapses, whichever happens first. It
+ *  returns right away, without any access to the file system, if the
+ *  data queue already has enough entries, so a consumer waiting for
+ *  more than one entry wakes once for the whole batch. The data queue
+ *  is not locked while the function waits, so any other operation may
+ *  be made on it meanwhile. If the data queue is closed while waiting,
+ *  the function returns CODE_ERROR_QUEUE_CLOSED.
+ *
+ *  A zero timeout only checks the number of entries, while a timeout
+ *  of WAIT_TIMEOUT_FOREVER waits with no time limit.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the wait operation.
+ *
+ *  @param[in] min_entries - the number of entries to wait for (at
+ *                           least one and at most the maximum number
+ *                           of entries of the data queue).
+ *
+ *  @param[in] timeout_ms - the longest time to wait (in milliseconds).
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_WRITE_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_WAIT_TIMEOUT
+ *
+ */
+int DataQ_FifoWait( DataQ_File_t * fifo_handle, uint32_t min_entries, uint32_t timeout_ms );
+
+/** @brief Retrieves the current flash size usage of the specified
+ *         first-in, first-out (FIFO) data queue.
+ *
+ *  This function gets the current size in flash storage of the
+ *  specified data queue. If the operation succeeds, the flash size
+ *  in bytes is stored in the output parameter.
  *
  *
  *  @param[in] fifo_handle - the reference of the data queue to be
@@ -500,12 +1780,200 @@ int DataQ_FifoGetLength( DataQ_File_t * fifo_handle, size_t * length );
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
  *                CODE_ERROR_INVALID_HANDLE
- *                CODE_ERROR_QUEUE_MISSING
  *                CODE_ERROR_QUEUE_CLOSED
- *                CODE_ERROR_FS_ACCESS_FAIL
  *
  */
 int DataQ_FifoGetSize( DataQ_File_t * fifo_handle, size_t * flash_size );
 
+/** @brief Opens a staging ring in front of the specified first-in,
+ *         first-out (FIFO) data queue.
+ *
+ *  This function sets up a fixed-capacity ring buffer in memory,
+ *  taken from a static arena, where entries are staged without
+ *  accessing the filesystem (see DataQ_FifoStage) until a task
+ *  drains them into the data queue (see DataQ_FifoDrain). The ring
+ *  is released when the data queue is closed, discarding whatever
+ *  was not drained.
+ *
+ *  The overflow policy determines what happens to an entry staged
+ *  while the ring is full: OVERFLOW_TYPE_FAIL rejects it,
+ *  OVERFLOW_TYPE_DROP_NEWEST silently drops it and
+ *  OVERFLOW_TYPE_DROP_OLDEST drops the oldest staged entries to
+ *  make room for it (the dropped entries are counted).
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the open staging operation.
+ *
+ *  @param[in] ring_size - the size of the ring in bytes (a power of
+ *                         two of at least 8)
+ *
+ *  @param[in] overflow - the overflow policy of the ring
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_READ_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_OPENED
+ *                CODE_ERROR_BUFFER_NOT_AVAIL
+ *
+ */
+int DataQ_FifoOpenStaging( DataQ_File_t * fifo_handle, size_t ring_size, int overflow );
+
+/** @brief Stages an entry for the specified first-in, first-out
+ *         (FIFO) data queue.
+ *
+ *  This function copies a new entry into the staging ring of the
+ *  data queue, to be enqueued when the ring is next drained. It
+ *  neither blocks nor accesses the filesystem, so it can be called
+ *  from an interrupt service routine, as long as a single task (or
+ *  interrupt) stages entries for a data queue at a time. What
+ *  happens when the ring is full depends on its overflow policy.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the stage operation.
+ *
+ *  @param[in] data - the reference of the data to be staged.
+ *
+ *  @param[in] size - the size of the data to be staged.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_IS_FULL
+ *                CODE_ERROR_BUFFER_NOT_AVAIL
+ *
+ */
+int DataQ_FifoStage( DataQ_File_t * fifo_handle, const void * data, size_t size );
+
+/** @brief Drains the staging ring of the specified first-in,
+ *         first-out (FIFO) data queue.
+ *
+ *  This function moves the entries staged so far into the data
+ *  queue, in the order they were staged, copying them into the
+ *  specified buffer and enqueuing each buffer full of them as one
+ *  batch (see DataQ_FifoEnqueueBatch). It is meant to be called by
+ *  a background task, and entries staged while it runs are drained
+ *  too. If enqueuing a batch fails, its entries stay staged (except
+ *  under the drop-oldest overflow policy, where the ring no longer
+ *  holds them) and the error code is returned.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the drain operation.
+ *
+ *  @param[in] buffer - the reference of the buffer the staged entries
+ *                      are copied into
+ *
+ *  @param[in] buffer_size - the size of the buffer (at least the size
+ *                           of the largest staged entry)
+ *
+ *  @param[out] count - the number of entries drained (may be null)
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_ENTRY_NOT_LISTED
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_BUFFER_NOT_AVAIL
+ *
+ */
+int DataQ_FifoDrain( DataQ_File_t * fifo_handle, void * buffer, size_t buffer_size, size_t * count );
+
+/** @brief Retrieves the state of the staging ring of the specified
+ *         first-in, first-out (FIFO) data queue.
+ *
+ *  This function reports the size of the staging ring of the data
+ *  queue, how much of it is currently used by staged entries, the
+ *  most of it ever used (the high-water mark) and the number of
+ *  entries dropped under its overflow policy.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the staging info operation.
+ *
+ *  @param[out] info - the reference of the state of the ring
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_BUFFER_NOT_AVAIL
+ *
+ */
+int DataQ_FifoGetStagingInfo( DataQ_File_t * fifo_handle, DataQ_Staging_Info_t * info );
+
+#if defined( DATA_QUEUE_STATS )
+
+/** @brief Retrieves the statistics of the specified first-in,
+ *         first-out (FIFO) data queue.
+ *
+ *  This function copies the statistics gathered since the data
+ *  queue was opened (or since they were last reset) into the output
+ *  parameter: the count, errors, bytes transferred and cumulative
+ *  and maximum latency of each type of FSAL call made on behalf of
+ *  the data queue, and the counters of the engine (enqueues,
+ *  evictions, dequeues, discards, trims, LUT cache hits and misses, LUT page and
+ *  header stores and lock operations). Only available when the
+ *  library is built with DATA_QUEUE_STATS.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the get stats operation.
+ *
+ *  @param[out] stats - the reference where the statistics are to
+ *                      be stored.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_CLOSED
+ *
+ */
+int DataQ_GetStats( DataQ_File_t * fifo_handle, DataQ_Stats_t * stats );
+
+/** @brief Resets the statistics of the specified first-in,
+ *         first-out (FIFO) data queue.
+ *
+ *  This function clears all statistics gathered for the data queue
+ *  so far. Only available when the library is built with
+ *  DATA_QUEUE_STATS.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the reset stats operation.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_CLOSED
+ *
+ */
+int DataQ_ResetStats( DataQ_File_t * fifo_handle );
+
+#endif /* DATA_QUEUE_STATS */
+
 #endif /* __DATA_QUEUE_H__ */
 
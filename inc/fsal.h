@@ -25,8 +25,10 @@
 #include "../fsal/segger-emfile/fsal.h"
 #elif defined( FSAL_LINUX_EXT4 )
 #include "../fsal/linux_ext4/fsal.h"
-#elif defined( FSAL_STUB )
-#include "../fsal/stub/fsal.h"
+#elif defined( FSAL_RAM )
+#include "../fsal/ram/fsal.h"
+#elif defined( FSAL_LINUX_URING )
+#include "../fsal/linux_uring/fsal.h"
 #else
 #error "Please define one of the supported Filesystem Abstraction Layers"
 #endif
@@ -40,6 +42,8 @@
 #define FSAL_STATUS_OK				0
 #define FSAL_ERROR_DIR_ACCESS		1
 #define FSAL_ERROR_FILE_ACCESS		2
+#define FSAL_ERROR_DIR_LOCKED		3
+#define FSAL_ERROR_NOT_SUPPORTED	4
 
 #define FSAL_FLAGS_CREATE			0x00000001
 #define FSAL_FLAGS_READ_ONLY		0x00000010
@@ -48,11 +52,18 @@
 #define FSAL_FLAGS_READ_WRITE		0x00000080
 #define FSAL_FLAGS_BINARY			0x00000100
 
+#define FSAL_LOCK_SHARED			0
+#define FSAL_LOCK_EXCLUSIVE			1
+
+#define FSAL_SYNC_ASYNC				0
+#define FSAL_SYNC_WAIT				1
+
 /**
  * Filesystem specific data types
  */
 
 typedef int FSAL_File_t;
+typedef int FSAL_Dir_t;
 
 
 /** @brief Initializes the filesystem for use
@@ -131,6 +142,42 @@ extern int FSAL_RemoveDirectory( char * dir_name );
  */
 extern int FSAL_ListDirectory( char * dir_name );
 
+/** @brief Opens a directory.
+ *
+ *  This function opens a directory of the filesystem in relative to
+ *  the current directory so that files within it can be accessed
+ *  later on without changing the current directory.
+ *
+ *  @param[in] dir_name - the name of the directory to open
+ *
+ *  @param[out] fsal_dir - the handle of the opened directory
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+extern int FSAL_OpenDirectory( char * dir_name, FSAL_Dir_t * fsal_dir );
+
+/** @brief Closes a directory.
+ *
+ *  This function closes a directory as specified by a specific
+ *  directory handle.
+ *
+ *  @param[in] fsal_dir - the handle associated to the directory
+ *                        to close
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+extern int FSAL_CloseDirectory( FSAL_Dir_t fsal_dir );
+
 /** @brief Lists a file and retrieves its size.
  *
  *  This function lists a file in the current directory and
@@ -149,6 +196,69 @@ extern int FSAL_ListDirectory( char * dir_name );
  */
 extern int FSAL_ListFile( char * file_name, size_t * file_size );
 
+/** @brief Locks a directory.
+ *
+ *  This function places a shared or an exclusive lock on the
+ *  directory associated with the specified directory handle without
+ *  waiting for it. Any number of shared locks may be held on the
+ *  same directory at the same time while an exclusive lock can only
+ *  be held if no other lock is held on the directory.
+ *
+ *  @param[in] fsal_dir - the handle associated to the directory
+ *                        to lock
+ *
+ *  @param[in] lock_type - the type of lock to place:
+ *
+ *                         FSAL_LOCK_SHARED
+ *                         FSAL_LOCK_EXCLUSIVE
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *                FSAL_ERROR_DIR_LOCKED
+ *
+ */
+extern int FSAL_LockDirectory( FSAL_Dir_t fsal_dir, int lock_type );
+
+/** @brief Unlocks a directory.
+ *
+ *  This function releases the lock previously placed on the
+ *  directory associated with the specified directory handle.
+ *
+ *  @param[in] fsal_dir - the handle associated to the directory
+ *                        to unlock
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_DIR_ACCESS
+ *
+ */
+extern int FSAL_UnlockDirectory( FSAL_Dir_t fsal_dir );
+
+/** @brief Lists a file of a directory and retrieves its size.
+ *
+ *  This function lists a file in the directory associated with the
+ *  specified directory handle and retrieves the file size.
+ *
+ *  @param[in] fsal_dir - the handle of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to list
+ *
+ *  @param[out] file_size - the current size of the file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+extern int FSAL_ListDirFile( FSAL_Dir_t fsal_dir, char * file_name, size_t * file_size );
+
 /** @brief Opens a file.
  *
  *  This function opens a file in the filesystem in relative to
@@ -169,6 +279,28 @@ extern int FSAL_ListFile( char * file_name, size_t * file_size );
  */
 extern int FSAL_OpenFile( char * file_name, int flags, FSAL_File_t * fsal_handle );
 
+/** @brief Opens a file of a directory.
+ *
+ *  This function opens a file in the directory associated with the
+ *  specified directory handle.
+ *
+ *  @param[in] fsal_dir - the handle of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to open
+ *
+ *  @param[in] flags - the access mode the file when opened
+ *
+ *  @param[out] fsal_handle - the handle of the opened file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+extern int FSAL_OpenDirFile( FSAL_Dir_t fsal_dir, char * file_name, int flags, FSAL_File_t * fsal_handle );
+
 /** @brief Closes a file.
  *
  *  This function closes a file as specified by a specific file
@@ -186,6 +318,48 @@ extern int FSAL_OpenFile( char * file_name, int flags, FSAL_File_t * fsal_handle
  */
 extern int FSAL_CloseFile( FSAL_File_t fsal_handle );
 
+/** @brief Synchronizes a file with the storage media.
+ *
+ *  This function writes back whatever the filesystem still buffers
+ *  of the file as specified by a specific file handle, so that the
+ *  data written so far survives a power loss.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to synchronize
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+extern int FSAL_SyncFile( FSAL_File_t fsal_handle );
+
+/** @brief Allocates the storage of a file up front.
+ *
+ *  This function extends the file as specified by a specific file
+ *  handle to (at least) the specified length and reserves the storage
+ *  media for it, so that writing the file within that length later on
+ *  never has to allocate any more (and, where the filesystem allows
+ *  it, lands on contiguous clusters). What the file holds past its
+ *  previous end is left unspecified. A file already that long is left
+ *  as it is.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to allocate
+ *
+ *  @param[in] length - the number of bytes to allocate the file for
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+extern int FSAL_AllocateFile( FSAL_File_t fsal_handle, size_t length );
+
 /** @brief Reads from a file.
  *
  *  This function reads data from a file as specified by a specific
@@ -207,6 +381,31 @@ extern int FSAL_CloseFile( FSAL_File_t fsal_handle );
 extern ssize_t FSAL_ReadFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length );
 
 
+/** @brief Reads from a file at a specific position.
+ *
+ *  This function reads data from a file as specified by a specific
+ *  file handle, starting at the specified byte offset from the
+ *  beginning of the file.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to read
+ *
+ *  @param[in] offset - the byte offset in the file where the data
+ *                      is to be read from
+ *
+ *  @param[in] buffer - the location reference where the contents
+ *                      of the file will be stored
+ *
+ *  @param[in] length - the maximum bytes the location reference
+                        can store
+ *
+ *  @return int - the number of bytes actually read or a negative
+ *                error code if the operation failed
+ *
+ */
+extern ssize_t FSAL_ReadFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length );
+
+
 /** @brief Writes to a file.
  *
  *  This function writes data to a file as specified by a specific
@@ -226,6 +425,138 @@ extern ssize_t FSAL_ReadFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t
  */
 extern ssize_t FSAL_WriteFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length );
 
+/** @brief Writes to a file at a specific position.
+ *
+ *  This function writes data to a file as specified by a specific
+ *  file handle, starting at the specified byte offset from the
+ *  beginning of the file. Bytes outside of the written range are
+ *  left untouched.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to write
+ *
+ *  @param[in] offset - the byte offset in the file where the data
+ *                      is to be written
+ *
+ *  @param[in] buffer - the location reference of the data to be
+ *                      written to the file
+ *
+ *  @param[in] length - the number of bytes to write to the file
+ *
+ *  @return int - the number of bytes actually written or a negative
+ *                error code if the operation failed
+ *
+ */
+extern ssize_t FSAL_WriteFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length );
+
+/** @brief Maps a part of a file into memory.
+ *
+ *  This function maps the specified range of a file as specified
+ *  by a specific file handle into memory for read-only access. The
+ *  mapping stays valid after the file is closed, until it is
+ *  unmapped.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to map
+ *
+ *  @param[in] offset - the byte offset in the file where the range
+ *                      to map starts
+ *
+ *  @param[in] length - the number of bytes to map
+ *
+ *  @param[out] data - the reference where the location of the
+ *                     mapped range is set
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+extern int FSAL_MapFile( FSAL_File_t fsal_handle, size_t offset, size_t length, const uint8_t ** data );
+
+/** @brief Unmaps a part of a file from memory.
+ *
+ *  This function releases a range of a file previously mapped into
+ *  memory.
+ *
+ *  @param[in] data - the location of the mapped range
+ *
+ *  @param[in] offset - the byte offset in the file where the mapped
+ *                      range starts
+ *
+ *  @param[in] length - the number of bytes mapped
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+extern int FSAL_UnmapFile( const uint8_t * data, size_t offset, size_t length );
+
+/** @brief Maps a part of a file into memory for writing.
+ *
+ *  This function maps the specified range of a file as specified
+ *  by a specific file handle into memory for read and write access.
+ *  Stores into the mapped range are shared with the file, which is
+ *  updated by the filesystem on its own or when the mapped range is
+ *  synchronized. The mapping stays valid after the file is closed,
+ *  until it is unmapped.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to map (opened for read and write)
+ *
+ *  @param[in] offset - the byte offset in the file where the range
+ *                      to map starts
+ *
+ *  @param[in] length - the number of bytes to map
+ *
+ *  @param[out] data - the reference where the location of the
+ *                     mapped range is set
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+extern int FSAL_MapFileWritable( FSAL_File_t fsal_handle, size_t offset, size_t length, uint8_t ** data );
+
+/** @brief Synchronizes a part of a file mapped into memory.
+ *
+ *  This function writes the stores into a range of a file mapped
+ *  for writing back to the file, either by scheduling the write
+ *  or by waiting for the write to complete.
+ *
+ *  @param[in] data - the location of the mapped range
+ *
+ *  @param[in] offset - the byte offset in the file where the mapped
+ *                      range starts
+ *
+ *  @param[in] length - the number of bytes mapped
+ *
+ *  @param[in] sync_type - the type of synchronization to perform:
+ *
+ *                         FSAL_SYNC_ASYNC
+ *                         FSAL_SYNC_WAIT
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *                FSAL_ERROR_NOT_SUPPORTED
+ *
+ */
+extern int FSAL_SyncMappedFile( const uint8_t * data, size_t offset, size_t length, int sync_type );
+
 /** @brief Deletes a file.
  *
  *  This function deletes a file from the filesystem in
@@ -242,6 +573,80 @@ extern ssize_t FSAL_WriteFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t
  */
 extern int FSAL_DeleteFile( char * file_name );
 
+/** @brief Deletes a file of a directory.
+ *
+ *  This function deletes a file from the directory associated with
+ *  the specified directory handle.
+ *
+ *  @param[in] fsal_dir - the handle of the directory of the file
+ *
+ *  @param[in] file_name - the name of the file to remove
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+extern int FSAL_DeleteDirFile( FSAL_Dir_t fsal_dir, char * file_name );
+
+/** @brief Defers the writes of the calling task.
+ *
+ *  This function sets whether the writes, closes and deletes of
+ *  files requested by the calling task (or thread) from now on may
+ *  be deferred: such a call then returns once the request is queued
+ *  (the data written copied) and the request completes later, in
+ *  the order it was queued. Any other call waits for all deferred
+ *  requests to complete first. Filesystems which do not defer any
+ *  request ignore the setting.
+ *
+ *  @param[in] defer - non-zero to defer the requests, zero otherwise
+ *
+ *  @return none
+ */
+extern void FSAL_DeferWrites( int defer );
+
+/** @brief Retrieves the ticket of the last deferred write.
+ *
+ *  This function retrieves the ticket of the last request deferred
+ *  so far by any task (the tickets are numbered from 1 in the
+ *  order the requests are deferred, wrapping around, and are always
+ *  zero for filesystems which do not defer any request).
+ *
+ *  @param none
+ *
+ *  @return uint32_t - the ticket of the last deferred request
+ */
+extern uint32_t FSAL_GetWriteTicket( void );
+
+/** @brief Polls the deferred writes for completion.
+ *
+ *  This function submits the requests deferred so far and reaps
+ *  those completed, without waiting or waiting for all of them to
+ *  complete, and then retrieves the ticket up to which all requests
+ *  completed and the ticket of the oldest request which failed
+ *  since the last call (or zero if none).
+ *
+ *  @param[in] sync_type - the type of synchronization to perform:
+ *
+ *                         FSAL_SYNC_ASYNC
+ *                         FSAL_SYNC_WAIT
+ *
+ *  @param[out] completed - the ticket up to which all requests
+ *                          completed
+ *
+ *  @param[out] failed - the ticket of the oldest failed request
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                FSAL_STATUS_OK
+ *                FSAL_ERROR_FILE_ACCESS
+ *
+ */
+extern int FSAL_PollWrites( int sync_type, uint32_t * completed, uint32_t * failed );
+
 
 #endif /* __FSAL_H__ */
 
@@ -33,6 +33,19 @@
 #define DATA_QUEUE_FILE_HANDLE_LIST_MAX			PSL_FILE_HANDLE_LIST_MAX
 #define DATA_QUEUE_FILE_HANDLE_INVALID			PSL_FILE_HANDLE_INVALID
 #define DATA_QUEUE_LUT_ENTRY_SIZE				PSL_LUT_ENTRY_SIZE
+#define DATA_QUEUE_SEGMENT_COUNT				PSL_SEGMENT_COUNT
+#define DATA_QUEUE_LUT_PAGE_ENTRIES				PSL_LUT_PAGE_ENTRIES
+#define DATA_QUEUE_LUT_PAGE_COUNT				PSL_LUT_PAGE_COUNT
+#define DATA_QUEUE_PEEK_BUFFER_COUNT			PSL_PEEK_BUFFER_COUNT
+#define DATA_QUEUE_PEEK_BUFFER_SIZE				PSL_PEEK_BUFFER_SIZE
+#define DATA_QUEUE_JOURNAL_RECORD_SIZE			PSL_JOURNAL_RECORD_SIZE
+#define DATA_QUEUE_JOURNAL_RECORD_COUNT			PSL_JOURNAL_RECORD_COUNT
+#define DATA_QUEUE_STAGING_ARENA_SIZE			PSL_STAGING_ARENA_SIZE
+#define DATA_QUEUE_STAGING_BATCH_MAX			PSL_STAGING_BATCH_MAX
+#define DATA_QUEUE_ASYNC_OP_MAX					PSL_ASYNC_OP_MAX
+#define DATA_QUEUE_PACK_BUFFER_SIZE				PSL_PACK_BUFFER_SIZE
+#define DATA_QUEUE_ZERO_BLOCK_SIZE				PSL_ZERO_BLOCK_SIZE
+#define DATA_QUEUE_RECOVERY_BUFFER_SIZE			PSL_RECOVERY_BUFFER_SIZE
 
 
 /** @brief The main entry point of the data queue.
@@ -80,5 +93,219 @@ extern void * PSL_memset ( void * block, int c, size_t size );
  */
 extern void * PSL_memcpy (void *restrict to, const void *restrict from, size_t size);
 
+/** @brief Initializes a mutex.
+ *
+ *  This function initializes a mutex in the unlocked state so that
+ *  it can be used to serialize concurrent tasks (or threads).
+ *
+ *  @param[in] mutex - the reference of the mutex
+ *
+ *  @return none
+ *
+ */
+extern void PSL_MutexInit ( PSL_Mutex_t * mutex );
+
+/** @brief Locks a mutex.
+ *
+ *  This function locks a mutex, waiting for it if it is currently
+ *  locked by another task (or thread).
+ *
+ *  @param[in] mutex - the reference of the mutex
+ *
+ *  @return none
+ *
+ */
+extern void PSL_MutexLock ( PSL_Mutex_t * mutex );
+
+/** @brief Unlocks a mutex.
+ *
+ *  This function unlocks a mutex previously locked by the calling
+ *  task (or thread).
+ *
+ *  @param[in] mutex - the reference of the mutex
+ *
+ *  @return none
+ *
+ */
+extern void PSL_MutexUnlock ( PSL_Mutex_t * mutex );
+
+/** @brief Initializes an event.
+ *
+ *  This function initializes an event that a task (or thread) can
+ *  wait for while another one signals it, with no signal pending.
+ *
+ *  @param[in] event - the reference of the event
+ *
+ *  @return none
+ *
+ */
+extern void PSL_EventInit ( PSL_Event_t * event );
+
+/** @brief Waits for an event.
+ *
+ *  This function unlocks the specified mutex (locked by the caller)
+ *  and waits for the event to be signaled or for the timeout to
+ *  elapse, whichever happens first, then locks the mutex again
+ *  before it returns. It may also return early without the event
+ *  being signaled, so the caller is expected to check again what it
+ *  waited for.
+ *
+ *  @param[in] event - the reference of the event
+ *
+ *  @param[in] mutex - the reference of the mutex locked by the caller
+ *
+ *  @param[in] timeout_ms - the longest time to wait (in milliseconds)
+ *
+ *  @return int - non-zero if the timeout elapsed
+ *
+ */
+extern int PSL_EventWait ( PSL_Event_t * event, PSL_Mutex_t * mutex, uint32_t timeout_ms );
+
+/** @brief Signals an event.
+ *
+ *  This function wakes every task (or thread) currently waiting
+ *  for the event. The caller is expected to hold the mutex the
+ *  waiting tasks passed to PSL_EventWait.
+ *
+ *  @param[in] event - the reference of the event
+ *
+ *  @return none
+ *
+ */
+extern void PSL_EventBroadcast ( PSL_Event_t * event );
+
+/** @brief Runs an initialization routine once.
+ *
+ *  This function calls the specified routine the first time it is
+ *  called with a given once control, while any other task (or
+ *  thread) calling it at the same time waits for the routine to
+ *  complete; later calls return immediately.
+ *
+ *  @param[in] once - the reference of the once control, statically
+ *                    initialized to PSL_ONCE_INIT
+ *  @param[in] routine - the initialization routine
+ *
+ *  @return none
+ *
+ */
+extern void PSL_Once ( PSL_Once_t * once, void (*routine)( void ) );
+
+/** @brief Loads a value shared with an interrupt or another task.
+ *
+ *  This function atomically reads a 32-bit value, so that whatever
+ *  the writer stored before it released the value (see
+ *  PSL_AtomicStore) is visible to the caller afterwards. It never
+ *  blocks and may be called from an interrupt service routine.
+ *
+ *  @param[in] value - the reference of the shared value
+ *
+ *  @return uint32_t - the current value
+ *
+ */
+extern uint32_t PSL_AtomicLoad ( volatile uint32_t * value );
+
+/** @brief Stores a value shared with an interrupt or another task.
+ *
+ *  This function atomically writes a 32-bit value, releasing
+ *  whatever the caller stored before to the tasks (or interrupts)
+ *  loading the value afterwards. It never blocks and may be called
+ *  from an interrupt service routine.
+ *
+ *  @param[in] value - the reference of the shared value
+ *
+ *  @param[in] desired - the value to store
+ *
+ *  @return none
+ *
+ */
+extern void PSL_AtomicStore ( volatile uint32_t * value, uint32_t desired );
+
+/** @brief Replaces a value shared with an interrupt or another task.
+ *
+ *  This function atomically replaces a 32-bit value by the desired
+ *  one only if it still holds the expected one, with the ordering
+ *  of both PSL_AtomicLoad and PSL_AtomicStore. It never blocks and
+ *  may be called from an interrupt service routine.
+ *
+ *  @param[in] value - the reference of the shared value
+ *
+ *  @param[in] expected - the value expected to be replaced
+ *
+ *  @param[in] desired - the value to store
+ *
+ *  @return int - non-zero if the value was replaced
+ *
+ */
+extern int PSL_AtomicCompareExchange ( volatile uint32_t * value, uint32_t expected, uint32_t desired );
+
+/** @brief Retrieves a timestamp.
+ *
+ *  This function reads a free running timer of the platform, used
+ *  to measure the time spent in operations (in microseconds, where
+ *  only the difference between two timestamps is meaningful).
+ *
+ *  @param none
+ *
+ *  @return uint32_t - the current timestamp
+ *
+ */
+extern uint32_t PSL_GetTimestamp ( void );
+
+/** @brief Retrieves the identifier of the current boot.
+ *
+ *  This function returns a value identifying the current boot of the
+ *  system, which differs from one boot to the next (so a lock taken
+ *  during an earlier boot is known to be stale), or zero if the boot
+ *  can not be identified.
+ *
+ *  @param none
+ *
+ *  @return uint32_t - the identifier of the current boot
+ *
+ */
+extern uint32_t PSL_GetBootId ( void );
+
+/** @brief Retrieves the identifier of the current session.
+ *
+ *  This function returns a value identifying the calling process (or
+ *  whatever owns the locks taken by the data queue on the platform)
+ *  for as long as it runs during the current boot.
+ *
+ *  @param none
+ *
+ *  @return uint32_t - the identifier of the current session
+ *
+ */
+extern uint32_t PSL_GetSessionId ( void );
+
+/** @brief Checks if a session is still running.
+ *
+ *  This function determines whether the session with the specified
+ *  identifier (see PSL_GetSessionId), taken during the current boot,
+ *  is still running.
+ *
+ *  @param[in] session_id - the identifier of the session
+ *
+ *  @return int - non-zero if the session is still running
+ *
+ */
+extern int PSL_IsSessionAlive ( uint32_t session_id );
+
+/** @brief Writes to the FSAL trace.
+ *
+ *  This function appends the specified bytes (a record of the trace
+ *  or the name following it) to the FSAL trace of the platform. The
+ *  data queue engine only calls it when built with DATA_QUEUE_TRACE,
+ *  one call at a time.
+ *
+ *  @param[in] data - the reference of the bytes to be written
+ *
+ *  @param[in] length - the number of bytes to write
+ *
+ *  @return none
+ *
+ */
+extern void PSL_TraceWrite ( const uint8_t * data, size_t length );
+
 #endif /* __PSL_H__ */
 
@@ -0,0 +1,758 @@
+/**********************************************************************
+* Filename:     bench.c
+*
+* Copyright 2018, Swift Labs / TR
+*
+* Author:       Ronald Miranda / Emil Ekmecic
+*
+* Created:      October 14, 2026
+*
+* Description:  This is the Platform Software Layer or PSL specific
+*               benchmark of the data queue implementation on systems
+*               based on the Linux kernel. This file contains the main
+*               routine which runs scripted workloads against a data
+*               queue and reports their throughput, latency and bytes
+*               written per message as comma separated values (CSV).
+*
+* History
+* 14-Oct-2026   RMM      Initial code.
+**********************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "psl.h"
+#include "fsal.h"
+#include "dataqueue.h"
+
+/**
+ * Name of the data queue the workloads run against, default number
+ * of operations of each workload and default size of their entries
+ */
+#define BENCH_FIFO_NAME						"bench"
+#define BENCH_OP_COUNT						1000
+#define BENCH_ENTRY_SIZE					64
+#define BENCH_ENTRY_SIZE_MAX				1024
+
+/**
+ * Number of entries of the (full) data queue of the steady-state
+ * workload, where each enqueue evicts the head entry
+ */
+#define BENCH_STEADY_ENTRIES				64
+
+/**
+ * Watermarks (in percent) of the data queue of the maintained
+ * workload and number of its enqueues between maintenances
+ */
+#define BENCH_HIGH_WATERMARK				75
+#define BENCH_LOW_WATERMARK					50
+#define BENCH_MAINTAIN_INTERVAL				16
+
+/**
+ * Number of entries of the data queue of the recovery workload (as
+ * many as the queues recovered at start-up keep at most)
+ */
+#define BENCH_RECOVER_ENTRIES				255
+
+/**
+ * Size of the read-ahead buffer of the iteration workload
+ */
+#define BENCH_READ_AHEAD_SIZE				4096
+
+/**
+ * Number of enqueues of the asynchronous workload between polls
+ */
+#define BENCH_POLL_INTERVAL					16
+
+/**
+ * Bytes written through the FSAL since the start of the benchmark
+ * (the benchmark is linked with the FSAL write calls wrapped)
+ */
+static size_t bench_bytes_written = 0;
+
+/**
+ * Latency of each operation of the current workload (in ns)
+ */
+static uint64_t * bench_samples = NULL;
+
+/**
+ * Flags the data queue of each workload is created with
+ */
+static uint16_t bench_flags = FLAGS_RANDOM_ACCESS;
+
+/**
+ * Durability policy the data queue of each workload is opened with
+ */
+static DataQ_Durability_t bench_durability = { DURABILITY_TYPE_DEFAULT, 0, 0 };
+
+/**
+ * Payload of all entries written
+ */
+static uint8_t bench_payload[ BENCH_ENTRY_SIZE_MAX ];
+
+/**
+ * Read-ahead buffer of the iteration workload
+ */
+static uint8_t bench_read_ahead[ BENCH_READ_AHEAD_SIZE ];
+
+/**
+ * Asynchronous enqueues completed and failed in the current workload
+ */
+static size_t bench_completed = 0;
+static size_t bench_failed = 0;
+
+extern ssize_t __real_FSAL_WriteFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length );
+extern ssize_t __real_FSAL_WriteFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length );
+
+/** @brief Writes to a file while counting the bytes written.
+ *
+ *  This function wraps the FSAL call to write to a file so that
+ *  the bytes written by the data queue can be accounted for.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to write
+ *
+ *  @param[in] buffer - the location reference of the data to be
+ *                      written to the file
+ *
+ *  @param[in] length - the number of bytes to write to the file
+ *
+ *  @return int - the number of bytes actually written or a negative
+ *                error code if the operation failed
+ *
+ */
+ssize_t __wrap_FSAL_WriteFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length )
+{
+	ssize_t actual_length = __real_FSAL_WriteFile( fsal_handle, buffer, length );
+
+	if ( actual_length > 0 ) {
+		bench_bytes_written += actual_length;
+	}
+
+	return actual_length;
+}
+
+/** @brief Writes to a file at a specific position while counting
+ *         the bytes written.
+ *
+ *  This function wraps the FSAL call to write to a file at a
+ *  specific position so that the bytes written by the data queue
+ *  can be accounted for.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file
+ *                           to write
+ *
+ *  @param[in] offset - the byte offset in the file where the data
+ *                      is to be written
+ *
+ *  @param[in] buffer - the location reference of the data to be
+ *                      written to the file
+ *
+ *  @param[in] length - the number of bytes to write to the file
+ *
+ *  @return int - the number of bytes actually written or a negative
+ *                error code if the operation failed
+ *
+ */
+ssize_t __wrap_FSAL_WriteFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length )
+{
+	ssize_t actual_length = __real_FSAL_WriteFileAt( fsal_handle, offset, buffer, length );
+
+	if ( actual_length > 0 ) {
+		bench_bytes_written += actual_length;
+	}
+
+	return actual_length;
+}
+
+/** @brief Retrieves the current time.
+ *
+ *  This function retrieves the time elapsed since an unspecified
+ *  point in the past from the monotonic clock.
+ *
+ *  @param none
+ *
+ *  @return uint64_t - the current time (in ns)
+ *
+ */
+static uint64_t Bench_Now( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ((uint64_t) ts.tv_sec * 1000000000ull) + (uint64_t) ts.tv_nsec;
+}
+
+/** @brief Compares two latency samples.
+ *
+ *  This function orders latency samples for qsort().
+ *
+ *  @param[in] a - the reference of the first sample
+ *
+ *  @param[in] b - the reference of the second sample
+ *
+ *  @return int - negative, zero or positive as the first sample is
+ *                lower, equal or higher than the second one
+ *
+ */
+static int Bench_CompareSamples( const void * a, const void * b )
+{
+	uint64_t sample_a = *(const uint64_t *) a;
+	uint64_t sample_b = *(const uint64_t *) b;
+
+	return (sample_a > sample_b) - (sample_a < sample_b);
+}
+
+/** @brief Checks the status of a data queue operation.
+ *
+ *  This function aborts the benchmark if a data queue operation
+ *  it depends on failed.
+ *
+ *  @param[in] dataq_status - the status code of the operation
+ *
+ *  @param[in] operation - the name of the operation
+ *
+ *  @return none
+ *
+ */
+static void Bench_Check( int dataq_status, const char * operation )
+{
+	if ( dataq_status != CODE_STATUS_OK ) {
+		fprintf( stderr, "bench: %s failed with status %d\n", operation, dataq_status );
+		exit( 1 );
+	}
+}
+
+/** @brief Reports the results of a workload.
+ *
+ *  This function prints one CSV record with the throughput, the
+ *  p50/p99/p999 latency and the bytes written per operation of the
+ *  workload just measured.
+ *
+ *  @param[in] workload - the name of the workload
+ *
+ *  @param[in] entry_size - the size of the entries of the workload
+ *
+ *  @param[in] op_count - the number of operations measured
+ *
+ *  @param[in] elapsed - the total time of the operations (in ns)
+ *
+ *  @param[in] bytes_written - the bytes written by the operations
+ *
+ *  @return none
+ *
+ */
+static void Bench_Report( const char * workload, size_t entry_size, size_t op_count, uint64_t elapsed, size_t bytes_written )
+{
+	qsort( bench_samples, op_count, sizeof(uint64_t), Bench_CompareSamples );
+
+	printf( "%s,%zu,%zu,%.0f,%llu,%llu,%llu,%.1f\n",
+			workload, entry_size, op_count,
+			(elapsed != 0) ? ((double) op_count * 1e9 / (double) elapsed) : 0.0,
+			(unsigned long long) bench_samples[(op_count * 50) / 100],
+			(unsigned long long) bench_samples[(op_count * 99) / 100],
+			(unsigned long long) bench_samples[(op_count * 999) / 1000],
+			(double) bytes_written / (double) op_count );
+	fflush( stdout );
+}
+
+/** @brief Prepares the data queue of a workload.
+ *
+ *  This function (re)creates and opens the data queue the workload
+ *  runs against and fills it with the specified number of entries.
+ *
+ *  @param[in] max_entries - the maximum number of entries
+ *
+ *  @param[in] entry_size - the size of the entries
+ *
+ *  @param[in] fill_count - the number of entries to enqueue
+ *
+ *  @return DataQ_File_t * - the handle of the opened data queue
+ *
+ */
+static DataQ_File_t * Bench_Prepare( size_t max_entries, size_t entry_size, size_t fill_count )
+{
+	DataQ_File_t * fifo_handle = (DataQ_File_t *) 0;
+	size_t index;
+
+	DataQ_FifoDestroy( BENCH_FIFO_NAME );
+	Bench_Check( DataQ_FifoCreate( BENCH_FIFO_NAME, (uint32_t) max_entries, entry_size, 0, bench_flags ), "create" );
+	Bench_Check( DataQ_FifoOpenEx( BENCH_FIFO_NAME, ACCESS_TYPE_READ_WRITE, ACCESS_MODE_UNPACKED, &bench_durability, &fifo_handle ), "open" );
+
+	for ( index = 0; index < fill_count; index++ ) {
+		Bench_Check( DataQ_FifoEnqueue( fifo_handle, bench_payload, entry_size ), "enqueue" );
+	}
+
+	return fifo_handle;
+}
+
+/** @brief Finishes the workload on a data queue.
+ *
+ *  This function closes and destroys the data queue the workload
+ *  ran against.
+ *
+ *  @param[in] fifo_handle - the handle of the opened data queue
+ *
+ *  @return none
+ *
+ */
+static void Bench_Finish( DataQ_File_t * fifo_handle )
+{
+	Bench_Check( DataQ_FifoClose( fifo_handle ), "close" );
+	Bench_Check( DataQ_FifoDestroy( BENCH_FIFO_NAME ), "destroy" );
+}
+
+/** @brief Runs the enqueue-only workload.
+ *
+ *  This function measures enqueues into an empty data queue large
+ *  enough for all of them (so that none is evicted).
+ *
+ *  @param[in] entry_size - the size of the entries
+ *
+ *  @param[in] op_count - the number of operations to measure
+ *
+ *  @return none
+ *
+ */
+static void Bench_EnqueueOnly( size_t entry_size, size_t op_count )
+{
+	DataQ_File_t * fifo_handle = Bench_Prepare( op_count, entry_size, 0 );
+	size_t bytes_written = bench_bytes_written;
+	uint64_t elapsed = Bench_Now();
+	uint64_t start;
+	size_t index;
+
+	for ( index = 0; index < op_count; index++ ) {
+		start = Bench_Now();
+		Bench_Check( DataQ_FifoEnqueue( fifo_handle, bench_payload, entry_size ), "enqueue" );
+		bench_samples[index] = Bench_Now() - start;
+	}
+
+	elapsed = Bench_Now() - elapsed;
+	bytes_written = bench_bytes_written - bytes_written;
+	Bench_Report( "enqueue", entry_size, op_count, elapsed, bytes_written );
+	Bench_Finish( fifo_handle );
+}
+
+/** @brief Counts the completion of an asynchronous enqueue.
+ *
+ *  This function is called back by the engine once an enqueue of the
+ *  asynchronous workload completed.
+ *
+ *  @param[in] fifo_handle - the data queue of the enqueue
+ *
+ *  @param[in] status - the status or error code of the enqueue
+ *
+ *  @param[in] context - the context of the enqueue (unused)
+ *
+ *  @return none
+ *
+ */
+static void Bench_Completed( DataQ_File_t * fifo_handle, int status, void * context )
+{
+	bench_completed++;
+	if ( status != CODE_STATUS_OK ) {
+		bench_failed++;
+	}
+}
+
+/** @brief Runs the asynchronous enqueue workload.
+ *
+ *  This function measures asynchronous enqueues into an empty data
+ *  queue large enough for all of them, polling for completions every
+ *  few enqueues and waiting for all of them at the end (the samples
+ *  are of the enqueue calls only, the elapsed time includes polls).
+ *
+ *  @param[in] entry_size - the size of the entries
+ *
+ *  @param[in] op_count - the number of operations to measure
+ *
+ *  @return none
+ *
+ */
+static void Bench_EnqueueAsync( size_t entry_size, size_t op_count )
+{
+	DataQ_File_t * fifo_handle = Bench_Prepare( op_count, entry_size, 0 );
+	size_t bytes_written = bench_bytes_written;
+	uint64_t elapsed = Bench_Now();
+	uint64_t start;
+	size_t index;
+	int dataq_status;
+
+	bench_completed = 0;
+	bench_failed = 0;
+	for ( index = 0; index < op_count; index++ ) {
+		start = Bench_Now();
+		dataq_status = DataQ_FifoEnqueueAsync( fifo_handle, bench_payload, entry_size, Bench_Completed, NULL );
+		if ( dataq_status == CODE_ERROR_BUFFER_NOT_AVAIL ) {
+
+			/* wait for room to list the operation */
+			Bench_Check( DataQ_Poll( 1, NULL ), "poll" );
+			dataq_status = DataQ_FifoEnqueueAsync( fifo_handle, bench_payload, entry_size, Bench_Completed, NULL );
+		}
+		Bench_Check( dataq_status, "enqueue" );
+		bench_samples[index] = Bench_Now() - start;
+		if ( ((index + 1) % BENCH_POLL_INTERVAL) == 0 ) {
+			Bench_Check( DataQ_Poll( 0, NULL ), "poll" );
+		}
+	}
+	Bench_Check( DataQ_Poll( 1, NULL ), "poll" );
+	if ( (bench_completed != op_count) || (bench_failed != 0) ) {
+		Bench_Check( CODE_ERROR_FS_ACCESS_FAIL, "poll" );
+	}
+
+	elapsed = Bench_Now() - elapsed;
+	bytes_written = bench_bytes_written - bytes_written;
+	Bench_Report( "async_enqueue", entry_size, op_count, elapsed, bytes_written );
+	Bench_Finish( fifo_handle );
+}
+
+/** @brief Runs the steady-state workload.
+ *
+ *  This function measures enqueues into a full data queue, where
+ *  each enqueue evicts the head entry.
+ *
+ *  @param[in] entry_size - the size of the entries
+ *
+ *  @param[in] op_count - the number of operations to measure
+ *
+ *  @return none
+ *
+ */
+static void Bench_SteadyState( size_t entry_size, size_t op_count )
+{
+	DataQ_File_t * fifo_handle = Bench_Prepare( BENCH_STEADY_ENTRIES, entry_size, BENCH_STEADY_ENTRIES );
+	size_t bytes_written = bench_bytes_written;
+	uint64_t elapsed = Bench_Now();
+	uint64_t start;
+	size_t index;
+
+	for ( index = 0; index < op_count; index++ ) {
+		start = Bench_Now();
+		Bench_Check( DataQ_FifoEnqueue( fifo_handle, bench_payload, entry_size ), "enqueue" );
+		bench_samples[index] = Bench_Now() - start;
+	}
+
+	elapsed = Bench_Now() - elapsed;
+	bytes_written = bench_bytes_written - bytes_written;
+	Bench_Report( "steady_enqueue", entry_size, op_count, elapsed, bytes_written );
+	Bench_Finish( fifo_handle );
+}
+
+/** @brief Runs the maintained workload.
+ *
+ *  This function measures enqueues into the same data queue as the
+ *  steady-state workload, but trimmed down to its low watermark
+ *  between enqueues (as an idle task would, outside of the samples)
+ *  so that no enqueue has to evict the head entry itself.
+ *
+ *  @param[in] entry_size - the size of the entries
+ *
+ *  @param[in] op_count - the number of operations to measure
+ *
+ *  @return none
+ *
+ */
+static void Bench_Maintained( size_t entry_size, size_t op_count )
+{
+	DataQ_File_t * fifo_handle = Bench_Prepare( BENCH_STEADY_ENTRIES, entry_size, BENCH_STEADY_ENTRIES );
+	size_t bytes_written = bench_bytes_written;
+	uint64_t elapsed = Bench_Now();
+	uint64_t start;
+	size_t index;
+
+	Bench_Check( DataQ_FifoSetWatermarks( fifo_handle, BENCH_HIGH_WATERMARK, BENCH_LOW_WATERMARK ), "set watermarks" );
+	for ( index = 0; index < op_count; index++ ) {
+		if ( (index % BENCH_MAINTAIN_INTERVAL) == 0 ) {
+			Bench_Check( DataQ_FifoMaintain( fifo_handle, NULL ), "maintain" );
+		}
+		start = Bench_Now();
+		Bench_Check( DataQ_FifoEnqueue( fifo_handle, bench_payload, entry_size ), "enqueue" );
+		bench_samples[index] = Bench_Now() - start;
+	}
+
+	elapsed = Bench_Now() - elapsed;
+	bytes_written = bench_bytes_written - bytes_written;
+	Bench_Report( "maintained_enqueue", entry_size, op_count, elapsed, bytes_written );
+	Bench_Finish( fifo_handle );
+}
+
+/** @brief Runs the dequeue drain workload.
+ *
+ *  This function measures dequeues from a filled data queue until
+ *  it is empty.
+ *
+ *  @param[in] entry_size - the size of the entries
+ *
+ *  @param[in] op_count - the number of operations to measure
+ *
+ *  @return none
+ *
+ */
+static void Bench_DequeueDrain( size_t entry_size, size_t op_count )
+{
+	DataQ_File_t * fifo_handle = Bench_Prepare( op_count, entry_size, op_count );
+	uint8_t buffer[ BENCH_ENTRY_SIZE_MAX ];
+	size_t bytes_written = bench_bytes_written;
+	uint64_t elapsed = Bench_Now();
+	uint64_t start;
+	size_t index;
+	size_t size;
+
+	for ( index = 0; index < op_count; index++ ) {
+		size = sizeof(buffer);
+		start = Bench_Now();
+		Bench_Check( DataQ_FifoDequeue( fifo_handle, buffer, &size ), "dequeue" );
+		bench_samples[index] = Bench_Now() - start;
+	}
+
+	elapsed = Bench_Now() - elapsed;
+	bytes_written = bench_bytes_written - bytes_written;
+	Bench_Report( "dequeue_drain", entry_size, op_count, elapsed, bytes_written );
+	Bench_Finish( fifo_handle );
+}
+
+/** @brief Runs the seek and read scan workload.
+ *
+ *  This function measures seeking to each entry of a filled data
+ *  queue in turn and reading it (one sample per seek and read).
+ *
+ *  @param[in] entry_size - the size of the entries
+ *
+ *  @param[in] op_count - the number of operations to measure
+ *
+ *  @return none
+ *
+ */
+static void Bench_SeekScan( size_t entry_size, size_t op_count )
+{
+	DataQ_File_t * fifo_handle = Bench_Prepare( op_count, entry_size, op_count );
+	uint8_t buffer[ BENCH_ENTRY_SIZE_MAX ];
+	size_t bytes_written = bench_bytes_written;
+	uint64_t elapsed = Bench_Now();
+	uint64_t start;
+	size_t index;
+	size_t size;
+
+	for ( index = 0; index < op_count; index++ ) {
+		size = sizeof(buffer);
+		start = Bench_Now();
+		Bench_Check( DataQ_FifoSeek( fifo_handle, SEEK_TYPE_POSITION, (int) index ), "seek" );
+		Bench_Check( DataQ_FifoGetEntry( fifo_handle, buffer, &size ), "get entry" );
+		bench_samples[index] = Bench_Now() - start;
+	}
+
+	elapsed = Bench_Now() - elapsed;
+	bytes_written = bench_bytes_written - bytes_written;
+	Bench_Report( "seek_scan", entry_size, op_count, elapsed, bytes_written );
+	Bench_Finish( fifo_handle );
+}
+
+/** @brief Runs the iteration scan workload.
+ *
+ *  This function measures reading each entry of a filled data queue
+ *  in turn through an iterator with a read-ahead buffer (one sample
+ *  per entry read).
+ *
+ *  @param[in] entry_size - the size of the entries
+ *
+ *  @param[in] op_count - the number of operations to measure
+ *
+ *  @return none
+ *
+ */
+static void Bench_IterScan( size_t entry_size, size_t op_count )
+{
+	DataQ_File_t * fifo_handle = Bench_Prepare( op_count, entry_size, op_count );
+	uint8_t buffer[ BENCH_ENTRY_SIZE_MAX ];
+	size_t bytes_written = bench_bytes_written;
+	uint64_t elapsed = Bench_Now();
+	DataQ_Iter_t iter;
+	uint64_t start;
+	size_t index;
+	size_t size;
+
+	Bench_Check( DataQ_FifoIterBegin( fifo_handle, 0, (uint32_t) op_count, bench_read_ahead, sizeof(bench_read_ahead), &iter ), "iter begin" );
+	for ( index = 0; index < op_count; index++ ) {
+		size = sizeof(buffer);
+		start = Bench_Now();
+		Bench_Check( DataQ_FifoIterNext( &iter, buffer, &size ), "iter next" );
+		bench_samples[index] = Bench_Now() - start;
+	}
+
+	elapsed = Bench_Now() - elapsed;
+	bytes_written = bench_bytes_written - bytes_written;
+	Bench_Report( "iter_scan", entry_size, op_count, elapsed, bytes_written );
+	Bench_Finish( fifo_handle );
+}
+
+/** @brief Runs the start-up recovery workload.
+ *
+ *  This function measures the recovery of a closed data queue full of
+ *  entries (see DataQ_FifoRecover), reading the data of each entry
+ *  back (one sample per data queue recovered).
+ *
+ *  @param[in] entry_size - the size of the entries
+ *
+ *  @param[in] op_count - the number of operations to measure
+ *
+ *  @return none
+ *
+ */
+static void Bench_Recover( size_t entry_size, size_t op_count )
+{
+	DataQ_File_t * fifo_handle = Bench_Prepare( BENCH_RECOVER_ENTRIES, entry_size, BENCH_RECOVER_ENTRIES );
+	size_t bytes_written;
+	uint64_t elapsed;
+	uint64_t start;
+	size_t index;
+
+	Bench_Check( DataQ_FifoClose( fifo_handle ), "close" );
+
+	bytes_written = bench_bytes_written;
+	elapsed = Bench_Now();
+	for ( index = 0; index < op_count; index++ ) {
+		start = Bench_Now();
+		Bench_Check( DataQ_FifoRecover( BENCH_FIFO_NAME, RECOVERY_CHECK_DATA, (DataQ_Recovery_t *) 0 ), "recover" );
+		bench_samples[index] = Bench_Now() - start;
+	}
+
+	elapsed = Bench_Now() - elapsed;
+	bytes_written = bench_bytes_written - bytes_written;
+	Bench_Report( "recover", entry_size, op_count, elapsed, bytes_written );
+	Bench_Check( DataQ_FifoDestroy( BENCH_FIFO_NAME ), "destroy" );
+}
+
+/** @brief Runs the mixed producer and consumer workload.
+ *
+ *  This function measures enqueues and dequeues alternating on a
+ *  half filled data queue.
+ *
+ *  @param[in] entry_size - the size of the entries
+ *
+ *  @param[in] op_count - the number of operations to measure
+ *
+ *  @return none
+ *
+ */
+static void Bench_Mixed( size_t entry_size, size_t op_count )
+{
+	DataQ_File_t * fifo_handle = Bench_Prepare( op_count, entry_size, op_count / 2 );
+	uint8_t buffer[ BENCH_ENTRY_SIZE_MAX ];
+	size_t bytes_written = bench_bytes_written;
+	uint64_t elapsed = Bench_Now();
+	uint64_t start;
+	size_t index;
+	size_t size;
+
+	for ( index = 0; index < op_count; index++ ) {
+		size = sizeof(buffer);
+		start = Bench_Now();
+		if ( index % 2 ) {
+			Bench_Check( DataQ_FifoDequeue( fifo_handle, buffer, &size ), "dequeue" );
+		} else {
+			Bench_Check( DataQ_FifoEnqueue( fifo_handle, bench_payload, entry_size ), "enqueue" );
+		}
+		bench_samples[index] = Bench_Now() - start;
+	}
+
+	elapsed = Bench_Now() - elapsed;
+	bytes_written = bench_bytes_written - bytes_written;
+	Bench_Report( "mixed", entry_size, op_count, elapsed, bytes_written );
+	Bench_Finish( fifo_handle );
+}
+
+/** @brief Main routine of the benchmark.
+ *
+ *  This function runs all workloads and prints a CSV header line
+ *  followed by one record per workload:
+ *
+ *    bench [-n op_count] [-s entry_size] [-d durability] [-g commit_ops] [-j] [-S]
+ *
+ *  where the durability policy is one of the DURABILITY_TYPE_*
+ *  values, the number of operations of a group commit only applies
+ *  to the group commit policy, -j creates the data queues with the
+ *  metadata journal flag and -S with the segmented storage flag.
+ *
+ *  @param[in] argc - the number of command arguments
+ *
+ *  @param[in] argv - the command argument strings
+ *
+ *  @return int - the exit status code of the application
+ *
+ */
+int main( int argc, char * argv[] )
+{
+	static const size_t entry_sizes[] = { 16, 64, 256, 1024 };
+	size_t op_count = BENCH_OP_COUNT;
+	size_t entry_size = BENCH_ENTRY_SIZE;
+	size_t index;
+	int option;
+
+	while ( (option = getopt( argc, argv, "n:s:d:g:jS" )) != -1 ) {
+		switch ( option ) {
+		case 'n':
+			op_count = (size_t) strtoul( optarg, NULL, 0 );
+			break;
+		case 's':
+			entry_size = (size_t) strtoul( optarg, NULL, 0 );
+			break;
+		case 'd':
+			bench_durability.type = (int) strtol( optarg, NULL, 0 );
+			break;
+		case 'g':
+			bench_durability.commit_ops = (uint32_t) strtoul( optarg, NULL, 0 );
+			break;
+		case 'j':
+			bench_flags |= FLAGS_METADATA_JOURNAL;
+			break;
+		case 'S':
+			bench_flags |= FLAGS_SEGMENTED_STORAGE;
+			break;
+		default:
+			fprintf( stderr, "usage: %s [-n op_count] [-s entry_size] [-d durability] [-g commit_ops] [-j] [-S]\n", argv[0] );
+			return 1;
+		}
+	}
+
+	if ( (op_count < 2) || (entry_size == 0) || (entry_size > BENCH_ENTRY_SIZE_MAX) ) {
+		fprintf( stderr, "bench: op_count must be at least 2 and entry_size within 1..%d\n", BENCH_ENTRY_SIZE_MAX );
+		return 1;
+	}
+	if ( (bench_durability.type < 0) || (bench_durability.type >= DURABILITY_TYPE_MAX) ) {
+		fprintf( stderr, "bench: durability must be within 0..%d\n", DURABILITY_TYPE_MAX - 1 );
+		return 1;
+	}
+
+	bench_samples = malloc( op_count * sizeof(uint64_t) );
+	if ( bench_samples == NULL ) {
+		fprintf( stderr, "bench: out of memory\n" );
+		return 1;
+	}
+	for ( index = 0; index < sizeof(bench_payload); index++ ) {
+		bench_payload[index] = (uint8_t) index;
+	}
+
+	DataQ_InitEngine();
+
+	printf( "workload,entry_size,ops,ops_per_sec,p50_ns,p99_ns,p999_ns,bytes_written_per_op\n" );
+	for ( index = 0; index < sizeof(entry_sizes) / sizeof(entry_sizes[0]); index++ ) {
+		Bench_EnqueueOnly( entry_sizes[index], op_count );
+	}
+	Bench_EnqueueAsync( entry_size, op_count );
+	Bench_SteadyState( entry_size, op_count );
+	Bench_Maintained( entry_size, op_count );
+	Bench_DequeueDrain( entry_size, op_count );
+	Bench_SeekScan( entry_size, op_count );
+	Bench_IterScan( entry_size, op_count );
+	Bench_Mixed( entry_size, op_count );
+	Bench_Recover( entry_size, op_count );
+
+	free( bench_samples );
+
+	return 0;
+}
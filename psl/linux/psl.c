@@ -20,6 +20,11 @@
 
 #include "../../inc/psl.h"
 
+#include <time.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+
 /** @brief Fills a memory block with a specific byte value.
  *
  *  This function copies the passed byte value into each of the bytes
@@ -58,4 +63,383 @@ void * PSL_memcpy (void *restrict to, const void *restrict from, size_t size)
 	return memcpy ( to, from, size );
 }
 
+/** @brief Initializes a mutex.
+ *
+ *  This function initializes a mutex in the unlocked state so that
+ *  it can be used to serialize concurrent tasks (or threads).
+ *
+ *  @param[in] mutex - the reference of the mutex
+ *
+ *  @return none
+ *
+ */
+void PSL_MutexInit ( PSL_Mutex_t * mutex )
+{
+	pthread_mutex_init( mutex, NULL );
+}
+
+/** @brief Locks a mutex.
+ *
+ *  This function locks a mutex, waiting for it if it is currently
+ *  locked by another task (or thread).
+ *
+ *  @param[in] mutex - the reference of the mutex
+ *
+ *  @return none
+ *
+ */
+void PSL_MutexLock ( PSL_Mutex_t * mutex )
+{
+	pthread_mutex_lock( mutex );
+}
+
+/** @brief Unlocks a mutex.
+ *
+ *  This function unlocks a mutex previously locked by the calling
+ *  task (or thread).
+ *
+ *  @param[in] mutex - the reference of the mutex
+ *
+ *  @return none
+ *
+ */
+void PSL_MutexUnlock ( PSL_Mutex_t * mutex )
+{
+	pthread_mutex_unlock( mutex );
+}
+
+/** @brief Initializes an event.
+ *
+ *  This function initializes an event that a task (or thread) can
+ *  wait for while another one signals it, with no signal pending.
+ *
+ *  @param[in] event - the reference of the event
+ *
+ *  @return none
+ *
+ */
+void PSL_EventInit ( PSL_Event_t * event )
+{
+	pthread_condattr_t attr;
+
+	/* time the waits out with the monotonic clock, as for the timestamps */
+	pthread_condattr_init( &attr );
+	pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+	pthread_cond_init( event, &attr );
+	pthread_condattr_destroy( &attr );
+}
+
+/** @brief Waits for an event.
+ *
+ *  This function unlocks the specified mutex (locked by the caller)
+ *  and waits for the event to be signaled or for the timeout to
+ *  elapse, whichever happens first, then locks the mutex again
+ *  before it returns. It may also return early without the event
+ *  being signaled, so the caller is expected to check again what it
+ *  waited for.
+ *
+ *  @param[in] event - the reference of the event
+ *
+ *  @param[in] mutex - the reference of the mutex locked by the caller
+ *
+ *  @param[in] timeout_ms - the longest time to wait (in milliseconds)
+ *
+ *  @return int - non-zero if the timeout elapsed
+ *
+ */
+int PSL_EventWait ( PSL_Event_t * event, PSL_Mutex_t * mutex, uint32_t timeout_ms )
+{
+	struct timespec ts;
+
+	/* the condition takes the absolute time the wait ends at */
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	ts.tv_sec += timeout_ms / 1000u;
+	ts.tv_nsec += (long) (timeout_ms % 1000u) * 1000000L;
+	if ( ts.tv_nsec >= 1000000000L ) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000L;
+	}
+
+	return pthread_cond_timedwait( event, mutex, &ts ) != 0;
+}
+
+/** @brief Signals an event.
+ *
+ *  This function wakes every task (or thread) currently waiting
+ *  for the event. The caller is expected to hold the mutex the
+ *  waiting tasks passed to PSL_EventWait.
+ *
+ *  @param[in] event - the reference of the event
+ *
+ *  @return none
+ *
+ */
+void PSL_EventBroadcast ( PSL_Event_t * event )
+{
+	pthread_cond_broadcast( event );
+}
+
+/** @brief Runs an initialization routine once.
+ *
+ *  This function calls the specified routine the first time it is
+ *  called with a given once control, while any other task (or
+ *  thread) calling it at the same time waits for the routine to
+ *  complete; later calls return immediately.
+ *
+ *  @param[in] once - the reference of the once control, statically
+ *                    initialized to PSL_ONCE_INIT
+ *  @param[in] routine - the initialization routine
+ *
+ *  @return none
+ *
+ */
+void PSL_Once ( PSL_Once_t * once, void (*routine)( void ) )
+{
+	pthread_once( once, routine );
+}
+
+/** @brief Loads a value shared with an interrupt or another task.
+ *
+ *  This function atomically reads a 32-bit value, so that whatever
+ *  the writer stored before it released the value (see
+ *  PSL_AtomicStore) is visible to the caller afterwards. It never
+ *  blocks and may be called from an interrupt service routine.
+ *
+ *  @param[in] value - the reference of the shared value
+ *
+ *  @return uint32_t - the current value
+ *
+ */
+uint32_t PSL_AtomicLoad ( volatile uint32_t * value )
+{
+	return __atomic_load_n( value, __ATOMIC_ACQUIRE );
+}
+
+/** @brief Stores a value shared with an interrupt or another task.
+ *
+ *  This function atomically writes a 32-bit value, releasing
+ *  whatever the caller stored before to the tasks (or interrupts)
+ *  loading the value afterwards. It never blocks and may be called
+ *  from an interrupt service routine.
+ *
+ *  @param[in] value - the reference of the shared value
+ *
+ *  @param[in] desired - the value to store
+ *
+ *  @return none
+ *
+ */
+void PSL_AtomicStore ( volatile uint32_t * value, uint32_t desired )
+{
+	__atomic_store_n( value, desired, __ATOMIC_RELEASE );
+}
+
+/** @brief Replaces a value shared with an interrupt or another task.
+ *
+ *  This function atomically replaces a 32-bit value by the desired
+ *  one only if it still holds the expected one, with the ordering
+ *  of both PSL_AtomicLoad and PSL_AtomicStore. It never blocks and
+ *  may be called from an interrupt service routine.
+ *
+ *  @param[in] value - the reference of the shared value
+ *
+ *  @param[in] expected - the value expected to be replaced
+ *
+ *  @param[in] desired - the value to store
+ *
+ *  @return int - non-zero if the value was replaced
+ *
+ */
+int PSL_AtomicCompareExchange ( volatile uint32_t * value, uint32_t expected, uint32_t desired )
+{
+	return __atomic_compare_exchange_n( value, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE );
+}
+
+/** @brief Retrieves a timestamp.
+ *
+ *  This function reads a free running timer of the platform, used
+ *  to measure the time spent in operations (in microseconds, where
+ *  only the difference between two timestamps is meaningful).
+ *
+ *  @param none
+ *
+ *  @return uint32_t - the current timestamp
+ *
+ */
+uint32_t PSL_GetTimestamp ( void )
+{
+	struct timespec ts;
+
+	/* the monotonic clock is not affected by changes of the system time */
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return (uint32_t) (((uint64_t) ts.tv_sec * 1000000u) + ((uint64_t) ts.tv_nsec / 1000u));
+}
+
+/** @brief Retrieves the identifier of the current boot.
+ *
+ *  This function returns a value identifying the current boot of the
+ *  system, which differs from one boot to the next (so a lock taken
+ *  during an earlier boot is known to be stale), or zero if the boot
+ *  can not be identified.
+ *
+ *  @param none
+ *
+ *  @return uint32_t - the identifier of the current boot
+ *
+ */
+uint32_t PSL_GetBootId ( void )
+{
+	static uint32_t boot_id = 0;
+	char uuid[64];
+	ssize_t length;
+	ssize_t index;
+	int fd;
+
+	if ( boot_id != 0 ) {
+		return boot_id;
+	}
+
+	/* fold the random identifier the kernel picks at each boot (FNV-1a) */
+	fd = open( "/proc/sys/kernel/random/boot_id", O_RDONLY );
+	if ( fd < 0 ) {
+		return 0;
+	}
+	length = read( fd, uuid, sizeof(uuid) );
+	close( fd );
+	if ( length <= 0 ) {
+		return 0;
+	}
+
+	boot_id = 2166136261u;
+	for ( index = 0; index < length; index++ ) {
+		boot_id = (boot_id ^ (uint8_t) uuid[index]) * 16777619u;
+	}
+
+	return boot_id;
+}
+
+/** @brief Retrieves the identifier of the current session.
+ *
+ *  This function returns a value identifying the calling process (or
+ *  whatever owns the locks taken by the data queue on the platform)
+ *  for as long as it runs during the current boot.
+ *
+ *  @param none
+ *
+ *  @return uint32_t - the identifier of the current session
+ *
+ */
+uint32_t PSL_GetSessionId ( void )
+{
+	/* a session is a process */
+	return (uint32_t) getpid();
+}
+
+/** @brief Checks if a session is still running.
+ *
+ *  This function determines whether the session with the specified
+ *  identifier (see PSL_GetSessionId), taken during the current boot,
+ *  is still running.
+ *
+ *  @param[in] session_id - the identifier of the session
+ *
+ *  @return int - non-zero if the session is still running
+ *
+ */
+int PSL_IsSessionAlive ( uint32_t session_id )
+{
+	/* probe the process without signaling it (a process of another
+	 * user can not be signaled, but it still runs) */
+	return (kill( (pid_t) session_id, 0 ) == 0) || (errno == EPERM);
+}
+
+/**
+ * Trace file (opened by the first write to the trace, or -2 if it can
+ * not be) and the bytes of the trace still to be written to it
+ */
+static int psl_trace_fd = -1;
+static uint8_t psl_trace_buffer[ PSL_TRACE_BUFFER_SIZE ];
+static size_t psl_trace_length = 0;
+
+/** @brief Writes the buffered bytes of the FSAL trace.
+ *
+ *  This function writes the bytes of the trace still buffered to the
+ *  trace file, such as when the process exits.
+ *
+ *  @param none
+ *
+ *  @return none
+ *
+ */
+static void PSL_TraceFlush ( void )
+{
+	size_t done = 0;
+	ssize_t written;
+
+	while ( done < psl_trace_length ) {
+		written = write( psl_trace_fd, psl_trace_buffer + done, psl_trace_length - done );
+		if ( written <= 0 ) {
+			break;
+		}
+		done += (size_t) written;
+	}
+	psl_trace_length = 0;
+}
+
+/** @brief Writes to the FSAL trace.
+ *
+ *  This function appends the specified bytes (a record of the trace
+ *  or the name following it) to the FSAL trace of the platform. The
+ *  data queue engine only calls it when built with DATA_QUEUE_TRACE,
+ *  one call at a time.
+ *
+ *  The trace is written to the file named by the DATA_QUEUE_TRACE_FILE
+ *  environment variable (or PSL_TRACE_FILE in the current directory),
+ *  which is truncated by the first write of the process, through a
+ *  buffer of PSL_TRACE_BUFFER_SIZE bytes written out when it is full
+ *  and when the process exits.
+ *
+ *  @param[in] data - the reference of the bytes to be written
+ *
+ *  @param[in] length - the number of bytes to write
+ *
+ *  @return none
+ *
+ */
+void PSL_TraceWrite ( const uint8_t * data, size_t length )
+{
+	const char * file_name;
+	size_t chunk;
+
+	if ( psl_trace_fd == -1 ) {
+		file_name = getenv( "DATA_QUEUE_TRACE_FILE" );
+		psl_trace_fd = open( (file_name != NULL) ? file_name : PSL_TRACE_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+		if ( psl_trace_fd == -1 ) {
+
+			/* the trace is not written at all (and not tried again) */
+			psl_trace_fd = -2;
+		} else {
+			atexit( PSL_TraceFlush );
+		}
+	}
+	if ( psl_trace_fd < 0 ) {
+		return;
+	}
+
+	while ( length != 0 ) {
+		if ( psl_trace_length == sizeof(psl_trace_buffer) ) {
+			PSL_TraceFlush();
+		}
+		chunk = sizeof(psl_trace_buffer) - psl_trace_length;
+		if ( chunk > length ) {
+			chunk = length;
+		}
+		memcpy( psl_trace_buffer + psl_trace_length, data, chunk );
+		psl_trace_length += chunk;
+		data += chunk;
+		length -= chunk;
+	}
+}
+
 #endif /* PSL_LINUX */
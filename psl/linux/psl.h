@@ -27,6 +27,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <unistd.h>
+#include <pthread.h>
 
 /**
  * Linux specific macro definitons
@@ -34,6 +35,34 @@
 #define PSL_FILE_HANDLE_LIST_MAX				10
 #define PSL_FILE_HANDLE_INVALID					0
 #define PSL_LUT_ENTRY_SIZE						4
+#define PSL_SEGMENT_COUNT						4
+#define PSL_LUT_PAGE_ENTRIES					32
+#define PSL_LUT_PAGE_COUNT						4
+#define PSL_PEEK_BUFFER_COUNT					2
+#define PSL_PEEK_BUFFER_SIZE					1024
+#define PSL_JOURNAL_RECORD_SIZE					512
+#define PSL_JOURNAL_RECORD_COUNT				32
+#define PSL_STAGING_ARENA_SIZE					4096
+#define PSL_STAGING_BATCH_MAX					16
+#define PSL_ASYNC_OP_MAX						256
+#define PSL_PACK_BUFFER_SIZE					1024
+#define PSL_ZERO_BLOCK_SIZE						8192
+#define PSL_RECOVERY_BUFFER_SIZE				1024
+#define PSL_TRACE_FILE							"fsal.trace"
+#define PSL_TRACE_BUFFER_SIZE					4096
+
+/**
+ * Linux specific data types
+ */
+typedef pthread_mutex_t PSL_Mutex_t;
+typedef pthread_cond_t PSL_Event_t;
+typedef pthread_once_t PSL_Once_t;
+#define PSL_ONCE_INIT							PTHREAD_ONCE_INIT
+
+/**
+ * Linux specific storage class of the variables kept for each thread
+ */
+#define PSL_THREAD_LOCAL						__thread
 
 #endif /* PSL_LINUX */
 
@@ -0,0 +1,509 @@
+/**********************************************************************
+* Filename:     replay.c
+*
+* Copyright 2018, Swift Labs / TR
+*
+* Author:       Ronald Miranda / Emil Ekmecic
+*
+* Created:      October 14, 2026
+*
+* Description:  This is the Platform Software Layer or PSL specific
+*               FSAL trace replay of the data queue implementation on
+*               systems based on the Linux kernel. This file contains
+*               the main routine which re-executes the FSAL calls of a
+*               trace recorded by a data queue built with
+*               DATA_QUEUE_TRACE against the FSAL it is linked with and
+*               reports the timing of each type of call and the I/O
+*               amplification as comma separated values (CSV).
+*
+* History
+* 14-Oct-2026   RMM      Initial code.
+**********************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "psl.h"
+#include "fsal.h"
+#include "dataqueue.h"
+
+/**
+ * Maximum number of files, directories and mappings of the trace
+ * opened at the same time, and maximum length of a name of the trace
+ */
+#define REPLAY_HANDLE_MAX					256
+#define REPLAY_NAME_MAX						1024
+
+/**
+ * Stride of the stores replayed into a writable mapping before it is
+ * synchronized (so that its pages are written back)
+ */
+#define REPLAY_TOUCH_STRIDE					512
+
+/**
+ * Data structure used to bind a handle (file, directory or mapping)
+ * of the trace to the one the replay opened in its place
+ */
+typedef struct Replay_Binding {
+	uint32_t traced;
+	uintptr_t actual;
+	int writable;
+	int used;
+} Replay_Binding_t;
+
+/**
+ * Data structure used to keep the results of one type of FSAL call:
+ * the number of calls replayed, of those which failed, of those
+ * whose outcome differs from the traced one, the bytes transferred
+ * and the total time of the calls as traced (in us) and as replayed
+ * (in ns), along with the longest call replayed
+ */
+typedef struct Replay_Stats {
+	uint64_t count;
+	uint64_t errors;
+	uint64_t mismatches;
+	uint64_t bytes;
+	uint64_t traced_time;
+	uint64_t replayed_time;
+	uint64_t max_time;
+} Replay_Stats_t;
+
+/**
+ * Names of the types of records of a trace
+ */
+static const char * replay_op_names[ TRACE_OP_MAX ] = {
+	"init", "make_directory", "remove_directory", "open_directory",
+	"close_directory", "lock_directory", "unlock_directory", "list_dir_file",
+	"open_dir_file", "close_file", "sync_file", "allocate_file",
+	"read_file", "read_file_at", "write_file", "write_file_at",
+	"delete_dir_file", "map_file", "unmap_file", "map_file_writable",
+	"sync_mapped_file", "defer_writes", "get_write_ticket", "poll_writes",
+	"payload"
+};
+
+/**
+ * Files, directories and mappings of the trace currently opened
+ */
+static Replay_Binding_t replay_files[ REPLAY_HANDLE_MAX ];
+static Replay_Binding_t replay_dirs[ REPLAY_HANDLE_MAX ];
+static Replay_Binding_t replay_maps[ REPLAY_HANDLE_MAX ];
+
+/**
+ * Results of each type of record and the buffer the data of the
+ * calls is read into or written from (as large as the largest call)
+ */
+static Replay_Stats_t replay_stats[ TRACE_OP_MAX ];
+static uint8_t * replay_buffer = NULL;
+static size_t replay_buffer_size = 0;
+
+/** @brief Retrieves a timestamp.
+ *
+ *  This function reads the monotonic clock.
+ *
+ *  @param none
+ *
+ *  @return uint64_t - the current time (in ns)
+ *
+ */
+static uint64_t Replay_Now( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ((uint64_t) ts.tv_sec * 1000000000ull) + (uint64_t) ts.tv_nsec;
+}
+
+/** @brief Binds a handle of the trace.
+ *
+ *  This function binds the specified handle of the trace to the one
+ *  the replay opened in its place (a handle the trace reuses once it
+ *  is closed is bound again).
+ *
+ *  @param[in] bindings - the bindings of the type of handle
+ *
+ *  @param[in] traced - the handle of the trace
+ *
+ *  @param[in] actual - the handle of the replay
+ *
+ *  @param[in] writable - non-zero for a writable mapping
+ *
+ *  @return none
+ *
+ */
+static void Replay_Bind( Replay_Binding_t * bindings, uint32_t traced, uintptr_t actual, int writable )
+{
+	Replay_Binding_t * binding = NULL;
+	int index;
+
+	for ( index = 0; index < REPLAY_HANDLE_MAX; index++ ) {
+		if ( bindings[index].used && (bindings[index].traced == traced) ) {
+			binding = &bindings[index];
+			break;
+		}
+		if ( !bindings[index].used && (binding == NULL) ) {
+			binding = &bindings[index];
+		}
+	}
+
+	if ( binding == NULL ) {
+		fprintf( stderr, "replay: more than %d handles opened at once\n", REPLAY_HANDLE_MAX );
+		exit( 1 );
+	}
+	binding->traced = traced;
+	binding->actual = actual;
+	binding->writable = writable;
+	binding->used = 1;
+}
+
+/** @brief Looks up a handle of the trace.
+ *
+ *  This function finds the binding of the specified handle of the
+ *  trace, if it is bound.
+ *
+ *  @param[in] bindings - the bindings of the type of handle
+ *
+ *  @param[in] traced - the handle of the trace
+ *
+ *  @return Replay_Binding_t * - the binding or null if the handle is
+ *                               not bound (its opening failed)
+ *
+ */
+static Replay_Binding_t * Replay_Lookup( Replay_Binding_t * bindings, uint32_t traced )
+{
+	int index;
+
+	for ( index = 0; index < REPLAY_HANDLE_MAX; index++ ) {
+		if ( bindings[index].used && (bindings[index].traced == traced) ) {
+			return &bindings[index];
+		}
+	}
+
+	return NULL;
+}
+
+/** @brief Retrieves the buffer of a call.
+ *
+ *  This function grows the buffer the data of the calls is read into
+ *  or written from so that it holds the specified length.
+ *
+ *  @param[in] length - the length of the call
+ *
+ *  @return uint8_t * - the reference of the buffer
+ *
+ */
+static uint8_t * Replay_GetBuffer( size_t length )
+{
+	size_t index;
+
+	if ( length > replay_buffer_size ) {
+		replay_buffer = realloc( replay_buffer, length );
+		if ( replay_buffer == NULL ) {
+			fprintf( stderr, "replay: out of memory\n" );
+			exit( 1 );
+		}
+		for ( index = replay_buffer_size; index < length; index++ ) {
+			replay_buffer[index] = (uint8_t) index;
+		}
+		replay_buffer_size = length;
+	}
+
+	return replay_buffer;
+}
+
+/** @brief Replays a record of a trace.
+ *
+ *  This function makes the FSAL call of the specified record, with
+ *  the handles the replay opened in place of those of the trace, and
+ *  accounts for its time, its bytes transferred and whether its
+ *  outcome (success or failure, or the bytes transferred) differs
+ *  from the traced one. A call on a handle whose opening failed
+ *  during the replay fails without being made.
+ *
+ *  @param[in] record - the record of the trace
+ *
+ *  @param[in] name - the name following the record (terminated)
+ *
+ *  @return none
+ *
+ */
+static void Replay_Record( DataQ_Trace_Record_t * record, char * name )
+{
+	Replay_Stats_t * stats = &replay_stats[ record->op ];
+	Replay_Binding_t * file = Replay_Lookup( replay_files, record->handle );
+	Replay_Binding_t * dir = Replay_Lookup( replay_dirs, record->handle );
+	Replay_Binding_t * map = Replay_Lookup( replay_maps, record->handle );
+	FSAL_File_t fsal_handle = (file != NULL) ? (FSAL_File_t) file->actual : -1;
+	FSAL_Dir_t fsal_dir = (dir != NULL) ? (FSAL_Dir_t) dir->actual : -1;
+	const uint8_t * map_data = (map != NULL) ? (const uint8_t *) map->actual : NULL;
+	uint8_t * buffer = Replay_GetBuffer( record->length );
+	const uint8_t * mapped;
+	uint8_t * mapped_writable;
+	uint32_t completed;
+	uint32_t failed;
+	FSAL_File_t opened;
+	FSAL_Dir_t opened_dir;
+	size_t file_size;
+	size_t offset;
+	ssize_t result = FSAL_STATUS_OK;
+	uint64_t start = Replay_Now();
+	uint64_t elapsed;
+	int transfer = 0;
+
+	switch ( record->op ) {
+	case TRACE_OP_INIT:
+		FSAL_Init();
+		break;
+	case TRACE_OP_MAKE_DIRECTORY:
+		result = FSAL_MakeDirectory( name );
+		break;
+	case TRACE_OP_REMOVE_DIRECTORY:
+		result = FSAL_RemoveDirectory( name );
+		break;
+	case TRACE_OP_OPEN_DIRECTORY:
+		result = FSAL_OpenDirectory( name, &opened_dir );
+		if ( result == FSAL_STATUS_OK ) {
+			Replay_Bind( replay_dirs, record->output, (uintptr_t) opened_dir, 0 );
+		}
+		break;
+	case TRACE_OP_CLOSE_DIRECTORY:
+		result = (dir != NULL) ? FSAL_CloseDirectory( fsal_dir ) : FSAL_ERROR_DIR_ACCESS;
+		if ( dir != NULL ) {
+			dir->used = 0;
+		}
+		break;
+	case TRACE_OP_LOCK_DIRECTORY:
+		result = (dir != NULL) ? FSAL_LockDirectory( fsal_dir, (int) record->flags ) : FSAL_ERROR_DIR_ACCESS;
+		break;
+	case TRACE_OP_UNLOCK_DIRECTORY:
+		result = (dir != NULL) ? FSAL_UnlockDirectory( fsal_dir ) : FSAL_ERROR_DIR_ACCESS;
+		break;
+	case TRACE_OP_LIST_DIR_FILE:
+		result = (dir != NULL) ? FSAL_ListDirFile( fsal_dir, name, &file_size ) : FSAL_ERROR_DIR_ACCESS;
+		break;
+	case TRACE_OP_OPEN_DIR_FILE:
+		result = (dir != NULL) ? FSAL_OpenDirFile( fsal_dir, name, (int) record->flags, &opened ) : FSAL_ERROR_DIR_ACCESS;
+		if ( result == FSAL_STATUS_OK ) {
+			Replay_Bind( replay_files, record->output, (uintptr_t) opened, 0 );
+		}
+		break;
+	case TRACE_OP_CLOSE_FILE:
+		result = (file != NULL) ? FSAL_CloseFile( fsal_handle ) : FSAL_ERROR_FILE_ACCESS;
+		if ( file != NULL ) {
+			file->used = 0;
+		}
+		break;
+	case TRACE_OP_SYNC_FILE:
+		result = (file != NULL) ? FSAL_SyncFile( fsal_handle ) : FSAL_ERROR_FILE_ACCESS;
+		break;
+	case TRACE_OP_ALLOCATE_FILE:
+		result = (file != NULL) ? FSAL_AllocateFile( fsal_handle, record->length ) : FSAL_ERROR_FILE_ACCESS;
+		break;
+	case TRACE_OP_READ_FILE:
+		result = (file != NULL) ? FSAL_ReadFile( fsal_handle, buffer, record->length ) : -1;
+		transfer = 1;
+		break;
+	case TRACE_OP_READ_FILE_AT:
+		result = (file != NULL) ? FSAL_ReadFileAt( fsal_handle, record->offset, buffer, record->length ) : -1;
+		transfer = 1;
+		break;
+	case TRACE_OP_WRITE_FILE:
+		result = (file != NULL) ? FSAL_WriteFile( fsal_handle, buffer, record->length ) : -1;
+		transfer = 1;
+		break;
+	case TRACE_OP_WRITE_FILE_AT:
+		result = (file != NULL) ? FSAL_WriteFileAt( fsal_handle, record->offset, buffer, record->length ) : -1;
+		transfer = 1;
+		break;
+	case TRACE_OP_DELETE_DIR_FILE:
+		result = (dir != NULL) ? FSAL_DeleteDirFile( fsal_dir, name ) : FSAL_ERROR_DIR_ACCESS;
+		break;
+	case TRACE_OP_MAP_FILE:
+		result = (file != NULL) ? FSAL_MapFile( fsal_handle, record->offset, record->length, &mapped ) : FSAL_ERROR_FILE_ACCESS;
+		if ( result == FSAL_STATUS_OK ) {
+			Replay_Bind( replay_maps, record->output, (uintptr_t) mapped, 0 );
+		}
+		break;
+	case TRACE_OP_MAP_FILE_WRITABLE:
+		result = (file != NULL) ? FSAL_MapFileWritable( fsal_handle, record->offset, record->length, &mapped_writable ) : FSAL_ERROR_FILE_ACCESS;
+		if ( result == FSAL_STATUS_OK ) {
+			Replay_Bind( replay_maps, record->output, (uintptr_t) mapped_writable, 1 );
+		}
+		break;
+	case TRACE_OP_UNMAP_FILE:
+		result = (map != NULL) ? FSAL_UnmapFile( map_data, record->offset, record->length ) : FSAL_ERROR_FILE_ACCESS;
+		if ( map != NULL ) {
+			map->used = 0;
+		}
+		break;
+	case TRACE_OP_SYNC_MAPPED_FILE:
+
+		/* the stores into the mapping are not traced, so the synchronized
+		 * range is stored into again for its pages to be written back */
+		if ( (map != NULL) && map->writable ) {
+			for ( offset = 0; offset < record->length; offset += REPLAY_TOUCH_STRIDE ) {
+				((volatile uint8_t *) map_data)[offset] = map_data[offset];
+			}
+		}
+		result = (map != NULL) ? FSAL_SyncMappedFile( map_data, record->offset, record->length, (int) record->flags ) : FSAL_ERROR_FILE_ACCESS;
+		break;
+	case TRACE_OP_DEFER_WRITES:
+		FSAL_DeferWrites( (int) record->flags );
+		break;
+	case TRACE_OP_GET_WRITE_TICKET:
+		FSAL_GetWriteTicket();
+		break;
+	case TRACE_OP_POLL_WRITES:
+		result = FSAL_PollWrites( (int) record->flags, &completed, &failed );
+		break;
+	case TRACE_OP_PAYLOAD:
+
+		/* the payload of an entry is accounted for, not replayed */
+		result = record->length;
+		transfer = 1;
+		break;
+	}
+	elapsed = Replay_Now() - start;
+
+	stats->count++;
+	stats->traced_time += record->elapsed;
+	if ( record->op != TRACE_OP_PAYLOAD ) {
+		stats->replayed_time += elapsed;
+		if ( elapsed > stats->max_time ) {
+			stats->max_time = elapsed;
+		}
+	}
+	if ( transfer ) {
+		if ( result < 0 ) {
+			stats->errors++;
+		} else {
+			stats->bytes += (uint64_t) result;
+		}
+		if ( result != (ssize_t) record->result ) {
+			stats->mismatches++;
+		}
+	} else {
+		if ( result != FSAL_STATUS_OK ) {
+			stats->errors++;
+		}
+		if ( (result == FSAL_STATUS_OK) != (record->result == FSAL_STATUS_OK) ) {
+			stats->mismatches++;
+		}
+	}
+}
+
+/** @brief Reports the results of the replay.
+ *
+ *  This function prints one CSV record per type of FSAL call found
+ *  in the trace, with its timing as traced and as replayed, and the
+ *  total bytes touched (read and written) and written per payload
+ *  byte enqueued.
+ *
+ *  @param none
+ *
+ *  @return none
+ *
+ */
+static void Replay_Report( void )
+{
+	Replay_Stats_t * stats;
+	uint64_t payload = replay_stats[ TRACE_OP_PAYLOAD ].bytes;
+	uint64_t read = replay_stats[ TRACE_OP_READ_FILE ].bytes + replay_stats[ TRACE_OP_READ_FILE_AT ].bytes;
+	uint64_t written = replay_stats[ TRACE_OP_WRITE_FILE ].bytes + replay_stats[ TRACE_OP_WRITE_FILE_AT ].bytes;
+	int op;
+
+	printf( "operation,count,errors,mismatches,bytes,traced_us,replayed_us,replayed_avg_ns,replayed_max_ns\n" );
+	for ( op = 0; op < TRACE_OP_PAYLOAD; op++ ) {
+		stats = &replay_stats[op];
+		if ( stats->count == 0 ) {
+			continue;
+		}
+		printf( "%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n", replay_op_names[op],
+				(unsigned long long) stats->count, (unsigned long long) stats->errors,
+				(unsigned long long) stats->mismatches, (unsigned long long) stats->bytes,
+				(unsigned long long) stats->traced_time, (unsigned long long) (stats->replayed_time / 1000),
+				(unsigned long long) (stats->replayed_time / stats->count), (unsigned long long) stats->max_time );
+	}
+
+	printf( "\npayload_entries,payload_bytes,bytes_read,bytes_written,write_amplification,io_amplification\n" );
+	printf( "%llu,%llu,%llu,%llu,%.2f,%.2f\n",
+			(unsigned long long) replay_stats[ TRACE_OP_PAYLOAD ].count, (unsigned long long) payload,
+			(unsigned long long) read, (unsigned long long) written,
+			(payload != 0) ? ((double) written / (double) payload) : 0.0,
+			(payload != 0) ? ((double) (read + written) / (double) payload) : 0.0 );
+}
+
+/** @brief Main routine of the replay.
+ *
+ *  This function replays the trace specified on the command line, in
+ *  the current directory, as fast as the FSAL allows (the time between
+ *  the calls is not replayed), and reports its results:
+ *
+ *    replay trace_file
+ *
+ *  The data read or written is not traced, so the calls transfer
+ *  arbitrary bytes of the traced lengths, and the trace has to start
+ *  on a filesystem in the state the replay starts on (such as empty,
+ *  with the data queues created by the trace itself) for the calls to
+ *  succeed as they did.
+ *
+ *  @param[in] argc - the number of command arguments
+ *
+ *  @param[in] argv - the command argument strings
+ *
+ *  @return int - the exit status code of the application
+ *
+ */
+int main( int argc, char * argv[] )
+{
+	static char name[ REPLAY_NAME_MAX + 1 ];
+	DataQ_Trace_Record_t record;
+	size_t name_length;
+	size_t records = 0;
+	FILE * file;
+
+	if ( argc != 2 ) {
+		fprintf( stderr, "usage: %s trace_file\n", argv[0] );
+		return 1;
+	}
+
+	file = fopen( argv[1], "rb" );
+	if ( file == NULL ) {
+		fprintf( stderr, "replay: can not open %s\n", argv[1] );
+		return 1;
+	}
+
+	while ( fread( &record, sizeof(record), 1, file ) == 1 ) {
+
+		/* a trace starts with the record of FSAL_Init */
+		if ( (records == 0) &&
+			 ((record.op != TRACE_OP_INIT) || (record.offset != TRACE_MAGIC) || (record.length != TRACE_VERSION)) ) {
+			fprintf( stderr, "replay: %s is not an FSAL trace of version %d\n", argv[1], TRACE_VERSION );
+			return 1;
+		}
+		if ( record.op >= TRACE_OP_MAX ) {
+			fprintf( stderr, "replay: unknown record %u at record %zu\n", record.op, records );
+			return 1;
+		}
+
+		/* the names too long to be kept are cut short */
+		name_length = (record.name_length > REPLAY_NAME_MAX) ? REPLAY_NAME_MAX : record.name_length;
+		if ( (fread( name, 1, name_length, file ) != name_length) ||
+			 (fseek( file, (long) (record.name_length - name_length), SEEK_CUR ) != 0) ) {
+			fprintf( stderr, "replay: truncated record %zu\n", records );
+			break;
+		}
+		name[name_length] = '\0';
+
+		Replay_Record( &record, name );
+		records++;
+	}
+	fclose( file );
+
+	Replay_Report();
+	free( replay_buffer );
+
+	return 0;
+}
@@ -0,0 +1,325 @@
+/**********************************************************************
+* Filename:     stack.c
+*
+* Copyright 2018, Swift Labs / TR
+*
+* Author:       Ronald Miranda / Emil Ekmecic
+*
+* Created:      October 14, 2026
+*
+* Description:  This is the Platform Software Layer or PSL specific
+*               stack usage report of the data queue implementation on
+*               systems based on the Linux kernel. This file contains
+*               the main routine which reads the call graphs the
+*               compiler wrote along with the objects of the data queue
+*               (-fcallgraph-info=su) and reports the worst-case stack
+*               depth of each function of the API as comma separated
+*               values (CSV).
+*
+* History
+* 14-Oct-2026   RMM      Initial code.
+**********************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/**
+ * Maximum length of a line of a call graph
+ */
+#define STACK_LINE_MAX						4096
+
+/**
+ * Stack usage of a function whose frame is not known (a function out
+ * of the call graphs, such as one of the C library or the filesystem,
+ * an indirect call or a frame of a dynamic size) and of a function
+ * whose worst-case depth is still being determined (so a recursion is
+ * detected)
+ */
+#define STACK_UNKNOWN						-1
+#define STACK_VISITING						-2
+
+/**
+ * Data structure used to keep a function of the call graphs: its
+ * title (the name of a global function, or the name prefixed with
+ * the source file of a static one), the size of its frame, whether
+ * it is defined by the first call graph, its worst-case depth and
+ * whether it may recurse, the last pass that visited it, and the
+ * indexes of its callees
+ */
+typedef struct Stack_Node {
+	char * title;
+	long frame;
+	int api;
+	long depth;
+	int recursive;
+	int visited;
+	int * callees;
+	int callee_count;
+} Stack_Node_t;
+
+/**
+ * Functions of the call graphs
+ */
+static Stack_Node_t * stack_nodes = NULL;
+static int stack_node_count = 0;
+
+/** @brief Finds a function of the call graphs.
+ *
+ *  This function looks up the function with the specified title and
+ *  adds it (with an unknown frame) if it is not listed yet.
+ *
+ *  @param[in] title - the title of the function
+ *
+ *  @return int - the index of the function
+ *
+ */
+static int Stack_FindNode( const char * title )
+{
+	int index;
+
+	for ( index = 0; index < stack_node_count; index++ ) {
+		if ( strcmp( stack_nodes[index].title, title ) == 0 ) {
+			return index;
+		}
+	}
+
+	stack_nodes = realloc( stack_nodes, (stack_node_count + 1) * sizeof(Stack_Node_t) );
+	if ( stack_nodes == NULL ) {
+		fprintf( stderr, "stack: out of memory\n" );
+		exit( 1 );
+	}
+	memset( &stack_nodes[index], 0, sizeof(Stack_Node_t) );
+	stack_nodes[index].title = strdup( title );
+	stack_nodes[index].frame = STACK_UNKNOWN;
+	stack_nodes[index].depth = STACK_UNKNOWN;
+	stack_node_count++;
+
+	return index;
+}
+
+/** @brief Extracts a quoted field of a line of a call graph.
+ *
+ *  This function copies the quoted value following the specified
+ *  field name on a line of a call graph.
+ *
+ *  @param[in] line - the line of the call graph
+ *
+ *  @param[in] field - the name of the field (with its colon)
+ *
+ *  @param[out] value - the reference where the value is copied
+ *
+ *  @return int - non-zero if the line has the field
+ *
+ */
+static int Stack_GetField( const char * line, const char * field, char * value )
+{
+	const char * start = strstr( line, field );
+	const char * end;
+
+	if ( start == NULL ) {
+		return 0;
+	}
+	start = strchr( start + strlen( field ), '"' );
+	if ( (start == NULL) || ((end = strchr( start + 1, '"' )) == NULL) ) {
+		return 0;
+	}
+	memcpy( value, start + 1, end - start - 1 );
+	value[ end - start - 1 ] = '\0';
+
+	return 1;
+}
+
+/** @brief Reads a call graph.
+ *
+ *  This function adds the functions and calls of the specified call
+ *  graph (in the VCG format the compiler writes) to those already
+ *  read, along with the frame of each function it defines.
+ *
+ *  @param[in] file_name - the name of the call graph file
+ *
+ *  @param[in] api - non-zero if the global functions defined by the
+ *                   call graph are to be reported
+ *
+ *  @return none
+ *
+ */
+static void Stack_ReadGraph( const char * file_name, int api )
+{
+	static char line[ STACK_LINE_MAX ];
+	static char source[ STACK_LINE_MAX ];
+	static char target[ STACK_LINE_MAX ];
+	static char label[ STACK_LINE_MAX ];
+	Stack_Node_t * node;
+	FILE * file = fopen( file_name, "r" );
+	char * bytes;
+	int index;
+
+	if ( file == NULL ) {
+		fprintf( stderr, "stack: can not open %s\n", file_name );
+		exit( 1 );
+	}
+
+	while ( fgets( line, sizeof(line), file ) != NULL ) {
+
+		if ( (strncmp( line, "node:", 5 ) == 0) && Stack_GetField( line, "title:", source ) &&
+			 Stack_GetField( line, "label:", label ) ) {
+
+			/* a function defined by the call graph has its frame in its label
+			 * (a frame of a dynamic size is left unknown unless it is bounded) */
+			index = Stack_FindNode( source );
+			bytes = strstr( label, " bytes (" );
+			if ( (bytes != NULL) && ((strstr( bytes, "dynamic)" ) == NULL)) ) {
+				while ( (bytes > label) && (bytes[-1] >= '0') && (bytes[-1] <= '9') ) {
+					bytes--;
+				}
+				node = &stack_nodes[index];
+				node->frame = strtol( bytes, NULL, 10 );
+				node->api = api && (strchr( source, ':' ) == NULL);
+			}
+
+		} else if ( (strncmp( line, "edge:", 5 ) == 0) && Stack_GetField( line, "sourcename:", source ) &&
+					Stack_GetField( line, "targetname:", target ) ) {
+
+			/* a call of one function by another */
+			index = Stack_FindNode( target );
+			node = &stack_nodes[ Stack_FindNode( source ) ];
+			node->callees = realloc( node->callees, (node->callee_count + 1) * sizeof(int) );
+			if ( node->callees == NULL ) {
+				fprintf( stderr, "stack: out of memory\n" );
+				exit( 1 );
+			}
+			node->callees[ node->callee_count++ ] = index;
+		}
+	}
+
+	fclose( file );
+}
+
+/** @brief Determines the worst-case stack depth of a function.
+ *
+ *  This function determines the deepest stack the specified function
+ *  may take along with the functions it calls (leaving out the frames
+ *  of the functions out of the call graphs) and whether it may recurse
+ *  (in which case its depth is that of a single pass).
+ *
+ *  @param[in] index - the index of the function
+ *
+ *  @return none
+ *
+ */
+static void Stack_GetDepth( int index )
+{
+	Stack_Node_t * node = &stack_nodes[index];
+	Stack_Node_t * callee;
+	long depth = 0;
+	int call;
+
+	if ( node->depth != STACK_UNKNOWN ) {
+		if ( node->depth == STACK_VISITING ) {
+			node->recursive = 1;
+		}
+		return;
+	}
+
+	/* a function out of the call graphs takes an unknown stack */
+	if ( node->frame == STACK_UNKNOWN ) {
+		node->depth = 0;
+		return;
+	}
+
+	node->depth = STACK_VISITING;
+	for ( call = 0; call < node->callee_count; call++ ) {
+		callee = &stack_nodes[ node->callees[call] ];
+		Stack_GetDepth( node->callees[call] );
+		if ( callee->depth == STACK_VISITING ) {
+			node->recursive = 1;
+			continue;
+		}
+		if ( callee->depth > depth ) {
+			depth = callee->depth;
+		}
+		node->recursive |= callee->recursive;
+	}
+	node->depth = node->frame + depth;
+}
+
+/** @brief Counts the functions out of the call graphs a function
+ *         may call.
+ *
+ *  This function counts the distinct functions out of the call graphs
+ *  (whose frames the worst-case depth leaves out) the specified
+ *  function may call, directly or not, skipping the functions already
+ *  visited by the same pass.
+ *
+ *  @param[in] index - the index of the function
+ *
+ *  @param[in] pass - the number of the pass
+ *
+ *  @return int - the number of functions out of the call graphs
+ *
+ */
+static int Stack_CountExternal( int index, int pass )
+{
+	Stack_Node_t * node = &stack_nodes[index];
+	int count = 0;
+	int call;
+
+	if ( node->visited == pass ) {
+		return 0;
+	}
+	node->visited = pass;
+
+	if ( node->frame == STACK_UNKNOWN ) {
+		return 1;
+	}
+
+	for ( call = 0; call < node->callee_count; call++ ) {
+		count += Stack_CountExternal( node->callees[call], pass );
+	}
+
+	return count;
+}
+
+/** @brief Runs the stack usage report.
+ *
+ *  This function reads the call graphs specified on the command line
+ *  (the first one being that of the data queue, whose global functions
+ *  make the API) and reports the worst-case stack depth of each
+ *  function of the API, the number of functions out of the call graphs
+ *  (whose frames that depth leaves out) it may call and whether it may
+ *  recurse.
+ *
+ *  @param[in] argc - the number of command line arguments
+ *
+ *  @param[in] argv - the command line arguments
+ *
+ *  @return int - the exit status of the report
+ *
+ */
+int main( int argc, char * argv[] )
+{
+	Stack_Node_t * node;
+	int pass = 0;
+	int index;
+
+	if ( argc < 2 ) {
+		fprintf( stderr, "usage: %s dataqueue.ci [other.ci ...]\n", argv[0] );
+		return 1;
+	}
+
+	for ( index = 1; index < argc; index++ ) {
+		Stack_ReadGraph( argv[index], index == 1 );
+	}
+
+	printf( "function,stack_bytes,external_calls,recursive\n" );
+	for ( index = 0; index < stack_node_count; index++ ) {
+		node = &stack_nodes[index];
+		if ( node->api ) {
+			Stack_GetDepth( index );
+			printf( "%s,%ld,%d,%s\n", node->title, node->depth, Stack_CountExternal( index, ++pass ), node->recursive ? "yes" : "no" );
+		}
+	}
+
+	return 0;
+}
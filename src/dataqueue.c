@@ -21,602 +21,8104 @@
 
 #include "dataqueue.h"
 
+/**
+ * Maximum size of the file name of an entry (the hexadecimal
+ * digits of a 32-bit reference count)
+ */
+#define DATAQ_REFERENCE_SIZE_MAX	8
+
+/**
+ * Size of one page of the cached LUT which must hold the largest
+ * LUT entry of any of the supported LUT versions and size of the
+ * bit map used to track which entries of a page changed since the
+ * last commit
+ */
+#define DATAQ_LUT_PAGE_SIZE			(DATA_QUEUE_LUT_PAGE_ENTRIES * sizeof(DataQ_LUT_Record_t))
+#define DATAQ_LUT_PAGE_DIRTY_MAP_SIZE	((DATA_QUEUE_LUT_PAGE_ENTRIES + 7) / 8)
+
+/**
+ * Prefix of the name of the file a named cursor is kept in and
+ * maximum size of that file name
+ */
+#define DATAQ_CURSOR_FILE_PREFIX	".cur_"
+#define DATAQ_CURSOR_FILE_NAME_MAX	(sizeof(DATAQ_CURSOR_FILE_PREFIX) - 1 + CURSOR_NAME_MAX)
+
+/**
+ * First LUT offset of a page of the cached LUT holding nothing
+ */
+#define DATAQ_LUT_PAGE_INVALID		0xFFFFFFFF
+
+/**
+ * Size of a changed LUT entry within a record of the metadata
+ * journal (its LUT offset followed by the LUT entry), number of
+ * them a record holds and number of records a commit of all the
+ * cached pages may take, along with a checkpoint record
+ */
+#define DATAQ_JOURNAL_SLOT_SIZE( fifo_state )	(sizeof(uint32_t) + (fifo_state)->lut_entry_size)
+#define DATAQ_JOURNAL_SLOT_MAX( fifo_state )	((DATA_QUEUE_JOURNAL_RECORD_SIZE - sizeof(DataQ_Journal_Record_t)) / DATAQ_JOURNAL_SLOT_SIZE( fifo_state ))
+#define DATAQ_JOURNAL_COMMIT_MAX( fifo_state )	((((DATA_QUEUE_LUT_PAGE_COUNT * DATA_QUEUE_LUT_PAGE_ENTRIES) + DATAQ_JOURNAL_SLOT_MAX( fifo_state ) - 1) / DATAQ_JOURNAL_SLOT_MAX( fifo_state )) + 1)
+
+/**
+ * Flags of the data queues whose entries are kept at an offset
+ * within a file shared by several of them, and name of the ring
+ * file of a data queue created with the fixed record flag
+ */
+#define DATAQ_SHARED_STORAGE		(FLAGS_SEGMENTED_STORAGE | FLAGS_FIXED_RECORD)
+#define DATAQ_RING_FILE_NAME		".ring"
+
+/**
+ * Flags of the data queues whose entries are rewritten in place by
+ * the enqueues reusing their room (in the ring file or within a
+ * preallocated segment, which is never deleted and created again)
+ */
+#define DATAQ_IN_PLACE_STORAGE		(FLAGS_FIXED_RECORD | FLAGS_PREALLOCATE)
+
+/**
+ * Size of a record of a data queue created with the fixed record
+ * flag: the maximum entry size of the data queue, unless the build
+ * sets it so that the record I/O is sized at compile time
+ */
+#if defined( DATA_QUEUE_FIXED_RECORD_SIZE )
+#define DATAQ_RECORD_SIZE( fifo_hdr )	((size_t) DATA_QUEUE_FIXED_RECORD_SIZE)
+#else
+#define DATAQ_RECORD_SIZE( fifo_hdr )	((size_t) (fifo_hdr)->max_entry_size)
+#endif
+
+/**
+ * Msync policy of the metadata mapped into memory (if not set
+ * by the build)
+ */
+#if !defined( DATA_QUEUE_MSYNC_POLICY )
+#define DATA_QUEUE_MSYNC_POLICY		MSYNC_POLICY_ASYNC
+#endif
+
 /**
  * List of currently opened data queues
  */
 static DataQ_File_t DataQ_FileHandleList[ DATA_QUEUE_FILE_HANDLE_LIST_MAX ] = { { { DATA_QUEUE_FILE_HANDLE_INVALID } } };
 
-/** @brief Performs initialization of the first-in, first-out (FIFO)
- *         data queue engine
- *
- *  This function initializes the data queue engine including the
- *  underlying filesystem abstraction layer.
- *
- *  @param none
- *
- *  @return none
- */
-void DataQ_InitEngine( void )
-{
-	/* call the underlying filesystem abstraction layer */
-	FSAL_Init();
+/**
+ * Data structure used to keep a page (a run of adjacent LUT
+ * entries) of the LUT of an opened data queue in memory, along
+ * with the entries changed since they were last stored into the
+ * LUT file and since they were last journaled
+ */
+typedef struct DataQ_LUT_Page {
+	uint32_t first;
+	uint32_t last_used;
+	uint8_t dirty[ DATAQ_LUT_PAGE_DIRTY_MAP_SIZE ];
+	uint8_t unlogged[ DATAQ_LUT_PAGE_DIRTY_MAP_SIZE ];
+	uint8_t entries[ DATAQ_LUT_PAGE_SIZE ];
+} DataQ_LUT_Page_t;
+
+/**
+ * Data structure used to keep the metadata of an opened data
+ * queue cached in memory for the lifetime of its handle (only
+ * a few pages of the LUT are kept, so a LUT of any size never
+ * has to be held in memory as a whole, even when the header and
+ * LUT files are mapped into memory to be read and written through
+ * the mappings), along
+ * with its durability policy and the number of operations and
+ * appended entries not committed yet under that policy, and the
+ * sequence number of the next record of the metadata journal and
+ * the number of records written since the last checkpoint (and
+ * whether the next commit must make a checkpoint, or the sequence
+ * number of the oldest record replayed for a handle with read-only
+ * access, which leaves the LUT file as it is), whether the LUT
+ * file lags behind the journal until the next checkpoint (the
+ * changed entries of a page dropped from the cache being only
+ * journaled) and the number of records journaled ahead of the
+ * commit in progress, and the 'seek' pointer of the handle (the cursor) along with the name of
+ * the file it is kept in, if it is a named cursor, and whether it
+ * moved since it was last stored there, and the watermarks the data
+ * queue is trimmed by
+ */
+typedef struct DataQ_State {
+	FSAL_Dir_t dir;
+	DataQ_Hdr_t hdr;
+	size_t lut_entry_size;
+	uint32_t lut_clock;
+	DataQ_LUT_Page_t lut_pages[ DATA_QUEUE_LUT_PAGE_COUNT ];
+	uint8_t * hdr_map;
+	size_t hdr_map_size;
+	uint8_t * lut_map;
+	size_t lut_map_size;
+	DataQ_Durability_t durability;
+	uint32_t pending_ops;
+	uint32_t pending_since;
+	uint32_t pending_entries;
+	uint32_t journal_sequence;
+	uint32_t journal_records;
+	int journal_checkpoint;
+	uint32_t journal_oldest;
+	int journal_deferred;
+	uint32_t journal_continued;
+	int read_only;
+	uint32_t seek_lut_offs;
+	char cursor[ DATAQ_CURSOR_FILE_NAME_MAX + 1 ];
+	int cursor_dirty;
+	uint8_t high_watermark;
+	uint8_t low_watermark;
+} DataQ_State_t;
+
+/**
+ * List of cached metadata of the currently opened data queues
+ * (indexed the same as the list of currently opened data queues)
+ */
+static DataQ_State_t DataQ_FileStateList[ DATA_QUEUE_FILE_HANDLE_LIST_MAX ];
+
+/**
+ * Pool of bounce buffers backing the views of peeked entries
+ * when the filesystem does not support memory mapped files (or
+ * the entries are packed or rewritten in place)
+ */
+static uint8_t DataQ_PeekBufferPool[ DATA_QUEUE_PEEK_BUFFER_COUNT ][ DATA_QUEUE_PEEK_BUFFER_SIZE ];
+static uint8_t DataQ_PeekBufferUsed[ DATA_QUEUE_PEEK_BUFFER_COUNT ];
+
+/**
+ * Buffer holding the record of the metadata journal being written
+ * or replayed
+ */
+static uint8_t DataQ_JournalBuffer[ DATA_QUEUE_JOURNAL_RECORD_SIZE ];
+
+/**
+ * Block of zeroes the LUT file of a new data queue is written from
+ * (constant, so it may be kept along with the code)
+ */
+static const uint8_t DataQ_ZeroBlock[ DATA_QUEUE_ZERO_BLOCK_SIZE ] = { 0 };
+
+/**
+ * Buffer the data of the entries is read back through by the
+ * recovery of a data queue (serialized with any other operation on
+ * the list of opened data queues)
+ */
+static uint8_t DataQ_RecoveryBuffer[ DATA_QUEUE_RECOVERY_BUFFER_SIZE ];
+
+/**
+ * Minimum length of a match of the codec of packed entries, number
+ * of bits of the hash of the 4-byte string at a position of the data
+ * being packed and that hash (and the 4-byte string, little endian)
+ */
+#define DATAQ_PACK_MATCH_MIN		4
+#define DATAQ_PACK_HASH_BITS		8
+#define DATAQ_PACK_READ32( p )		((uint32_t) (p)[0] | ((uint32_t) (p)[1] << 8) | ((uint32_t) (p)[2] << 16) | ((uint32_t) (p)[3] << 24))
+#define DATAQ_PACK_HASH( p )		((DATAQ_PACK_READ32( p ) * 2654435761u) >> (32 - DATAQ_PACK_HASH_BITS))
+
+/**
+ * Buffer holding the packed data of the entry being enqueued or read
+ * (see ACCESS_MODE_BINARY_PACKED) and the hash table of the positions
+ * of the last strings seen while packing it
+ */
+static uint8_t DataQ_PackBuffer[ DATA_QUEUE_PACK_BUFFER_SIZE ];
+static uint16_t DataQ_PackTable[ 1 << DATAQ_PACK_HASH_BITS ];
+
+/**
+ * Size of the header of an entry staged into a staging ring (its
+ * size) and size of the ring an entry takes (its size rounded up
+ * to a multiple of 4 plus the header, so a header never wraps)
+ */
+#define DATAQ_STAGING_HDR_SIZE		sizeof(uint32_t)
+#define DATAQ_STAGING_RECORD_SIZE( size )	(DATAQ_STAGING_HDR_SIZE + ((uint32_t) ((size) + 3) & ~3u))
+
+/**
+ * Data structure used to keep the staging ring of an opened data
+ * queue: the part of the staging arena it takes, its overflow
+ * policy and the size of the largest entry it takes, the free
+ * running byte counts staged (only written by whoever stages the
+ * entries) and drained (written by the draining task, or by whoever
+ * stages the entries when it drops the oldest ones) whose difference
+ * is the part of the ring in use, the high-water mark and the
+ * number of dropped entries (only written by whoever stages them),
+ * and the batch of entries being drained (kept here rather than on
+ * the stack of the draining task, which holds the lock of the data
+ * queue while it uses them)
+ */
+typedef struct DataQ_Staging {
+	uint8_t * ring;
+	uint32_t ring_size;
+	uint32_t max_entry_size;
+	int overflow;
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	volatile uint32_t high_water;
+	volatile uint32_t dropped;
+	const void * batch_data[ DATA_QUEUE_STAGING_BATCH_MAX ];
+	size_t batch_sizes[ DATA_QUEUE_STAGING_BATCH_MAX ];
+} DataQ_Staging_t;
+
+/**
+ * Staging rings of the currently opened data queues (indexed the
+ * same as the list of currently opened data queues) and the arena
+ * they are taken from
+ */
+static DataQ_Staging_t DataQ_StagingList[ DATA_QUEUE_FILE_HANDLE_LIST_MAX ];
+static uint32_t DataQ_StagingArena[ DATA_QUEUE_STAGING_ARENA_SIZE / sizeof(uint32_t) ];
+
+/**
+ * Whether a ticket of the requests deferred by the FSAL precedes
+ * another (the tickets wrap around)
+ */
+#define DATAQ_TICKET_BEFORE( a, b )	((int32_t) ((a) - (b)) < 0)
+
+/**
+ * Data structure used to keep an asynchronous operation until the
+ * requests the FSAL deferred for it complete: the data queue, the
+ * completion callback along with its context and the ticket of the
+ * last request deferred once the operation was done (the requests of
+ * the operation precede it, along with those of other operations)
+ */
+typedef struct DataQ_Async {
+	DataQ_File_t * fifo_handle;
+	DataQ_Callback_t callback;
+	void * context;
+	uint32_t last_ticket;
+} DataQ_Async_t;
+
+/**
+ * Asynchronous operations in the order they were listed (a ring of
+ * which the oldest one and the number of operations are kept), the
+ * number of operations started but not listed yet, the ticket up to
+ * which the requests deferred by the FSAL completed and the ticket
+ * of the oldest failed one not accounted for yet (or zero)
+ */
+static DataQ_Async_t DataQ_AsyncList[ DATA_QUEUE_ASYNC_OP_MAX ];
+static uint32_t DataQ_AsyncFirst = 0;
+static uint32_t DataQ_AsyncCount = 0;
+static uint32_t DataQ_AsyncStarted = 0;
+static uint32_t DataQ_AsyncCompleted = 0;
+static uint32_t DataQ_AsyncFailed = 0;
+
+/**
+ * Mutexes serializing the tasks (or threads) using the engine: one
+ * for each of the currently opened data queues (indexed the same as
+ * the list of opened data queues) held for the whole of an operation
+ * on it, so that operations on separate data queues run in parallel,
+ * and one for each of the list of opened data queues, the packing
+ * buffer, the pool of bounce buffers and the journal buffer; when more
+ * than one is held, they are taken in the order listed (all of them
+ * are initialized once, by the first call to DataQ_InitEngine), while
+ * the one of the asynchronous operations is never held along with any
+ * other
+ */
+static PSL_Mutex_t DataQ_ListMutex;
+static PSL_Mutex_t DataQ_QueueMutex[ DATA_QUEUE_FILE_HANDLE_LIST_MAX ];
+static PSL_Mutex_t DataQ_PackMutex;
+static PSL_Mutex_t DataQ_PoolMutex;
+static PSL_Mutex_t DataQ_JournalMutex;
+static PSL_Mutex_t DataQ_AsyncMutex;
+static PSL_Once_t DataQ_InitOnce = PSL_ONCE_INIT;
+
+/**
+ * Events signaled whenever entries are enqueued into one of the
+ * currently opened data queues (indexed the same as the list of
+ * opened data queues), waited for along with the mutex of the data
+ * queue, and the longest single wait on one of them (so that the
+ * time spent waiting is measured with timestamps that do not wrap
+ * around meanwhile)
+ */
+static PSL_Event_t DataQ_QueueEvent[ DATA_QUEUE_FILE_HANDLE_LIST_MAX ];
+#define DATAQ_WAIT_SLICE_MAX		60000
+
+#if defined( DATA_QUEUE_STATS )
+
+/**
+ * Statistics of each of the currently opened data queues (indexed
+ * the same as the list of opened data queues) and the statistics
+ * of the data queue the engine currently operates on, to which the
+ * FSAL calls and the engine counters are accounted (none while no
+ * opened data queue is operated on); the latter is kept for each
+ * task (or thread) of its own
+ */
+static DataQ_Stats_t DataQ_FileStatsList[ DATA_QUEUE_FILE_HANDLE_LIST_MAX ];
+static PSL_THREAD_LOCAL DataQ_Stats_t * DataQ_StatsTarget = (DataQ_Stats_t *) 0;
+
+#define DATAQ_STATS_TARGET( stats )		( DataQ_StatsTarget = (stats) )
+#define DATAQ_STATS_COUNT( counter )	do { if ( DataQ_StatsTarget != (DataQ_Stats_t *) 0 ) DataQ_StatsTarget->counter++; } while ( 0 )
+
+/** @brief Accounts for an FSAL call.
+ *
+ *  This function updates the statistics of the specified type of
+ *  FSAL call of the data queue the engine currently operates on.
+ *
+ *  @param[in] call_type - the type of the FSAL call
+ *
+ *  @param[in] start - the timestamp taken before the call
+ *
+ *  @param[in] failed - non-zero if the call did not succeed
+ *
+ *  @param[in] bytes - the number of bytes read or written by the call
+ *
+ *  @return none
+ */
+static void DataQ_StatsRecord( int call_type, uint32_t start, int failed, ssize_t bytes )
+{
+	uint32_t elapsed = PSL_GetTimestamp() - start;
+	DataQ_Call_Stats_t * call_stats;
+
+	if ( DataQ_StatsTarget == (DataQ_Stats_t *) 0 ) {
+		return;
+	}
+
+	call_stats = &DataQ_StatsTarget->fsal[call_type];
+	call_stats->count++;
+	call_stats->total_time += elapsed;
+	if ( elapsed > call_stats->max_time ) {
+		call_stats->max_time = elapsed;
+	}
+	if ( failed ) {
+		call_stats->errors++;
+	} else if ( bytes > 0 ) {
+		call_stats->bytes += (uint64_t) bytes;
+	}
+}
+
+/**
+ * Instrumented FSAL calls, each making the FSAL call of the same
+ * name and accounting for it (inline, so that the ones unused in
+ * the current configuration raise no warnings)
+ */
+static inline int DataQ_Stats_MakeDirectory( char * dir_name )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_MakeDirectory( dir_name );
+	DataQ_StatsRecord( STATS_FSAL_DIRECTORY, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Stats_RemoveDirectory( char * dir_name )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_RemoveDirectory( dir_name );
+	DataQ_StatsRecord( STATS_FSAL_DIRECTORY, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Stats_OpenDirectory( char * dir_name, FSAL_Dir_t * fsal_dir )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_OpenDirectory( dir_name, fsal_dir );
+	DataQ_StatsRecord( STATS_FSAL_DIRECTORY, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Stats_CloseDirectory( FSAL_Dir_t fsal_dir )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_CloseDirectory( fsal_dir );
+	DataQ_StatsRecord( STATS_FSAL_DIRECTORY, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Stats_LockDirectory( FSAL_Dir_t fsal_dir, int lock_type )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_LockDirectory( fsal_dir, lock_type );
+	DataQ_StatsRecord( STATS_FSAL_LOCK, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Stats_UnlockDirectory( FSAL_Dir_t fsal_dir )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_UnlockDirectory( fsal_dir );
+	DataQ_StatsRecord( STATS_FSAL_LOCK, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Stats_ListDirFile( FSAL_Dir_t fsal_dir, char * file_name, size_t * file_size )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_ListDirFile( fsal_dir, file_name, file_size );
+	DataQ_StatsRecord( STATS_FSAL_LIST_FILE, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Stats_OpenDirFile( FSAL_Dir_t fsal_dir, char * file_name, int flags, FSAL_File_t * fsal_handle )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_OpenDirFile( fsal_dir, file_name, flags, fsal_handle );
+	DataQ_StatsRecord( STATS_FSAL_OPEN_FILE, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Stats_CloseFile( FSAL_File_t fsal_handle )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_CloseFile( fsal_handle );
+	DataQ_StatsRecord( STATS_FSAL_CLOSE_FILE, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Stats_SyncFile( FSAL_File_t fsal_handle )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_SyncFile( fsal_handle );
+	DataQ_StatsRecord( STATS_FSAL_SYNC_FILE, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Stats_AllocateFile( FSAL_File_t fsal_handle, size_t length )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_AllocateFile( fsal_handle, length );
+	DataQ_StatsRecord( STATS_FSAL_ALLOCATE_FILE, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+static inline ssize_t DataQ_Stats_ReadFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length )
+{
+	uint32_t start = PSL_GetTimestamp();
+	ssize_t actual_length = FSAL_ReadFile( fsal_handle, buffer, length );
+	DataQ_StatsRecord( STATS_FSAL_READ_FILE, start, actual_length < 0, actual_length );
+	return actual_length;
+}
+
+static inline ssize_t DataQ_Stats_ReadFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length )
+{
+	uint32_t start = PSL_GetTimestamp();
+	ssize_t actual_length = FSAL_ReadFileAt( fsal_handle, offset, buffer, length );
+	DataQ_StatsRecord( STATS_FSAL_READ_FILE, start, actual_length < 0, actual_length );
+	return actual_length;
+}
+
+static inline ssize_t DataQ_Stats_WriteFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length )
+{
+	uint32_t start = PSL_GetTimestamp();
+	ssize_t actual_length = FSAL_WriteFile( fsal_handle, buffer, length );
+	DataQ_StatsRecord( STATS_FSAL_WRITE_FILE, start, actual_length < 0, actual_length );
+	return actual_length;
+}
+
+static inline ssize_t DataQ_Stats_WriteFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length )
+{
+	uint32_t start = PSL_GetTimestamp();
+	ssize_t actual_length = FSAL_WriteFileAt( fsal_handle, offset, buffer, length );
+	DataQ_StatsRecord( STATS_FSAL_WRITE_FILE, start, actual_length < 0, actual_length );
+	return actual_length;
+}
+
+static inline int DataQ_Stats_DeleteDirFile( FSAL_Dir_t fsal_dir, char * file_name )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_DeleteDirFile( fsal_dir, file_name );
+	DataQ_StatsRecord( STATS_FSAL_DELETE_FILE, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Stats_MapFile( FSAL_File_t fsal_handle, size_t offset, size_t length, const uint8_t ** data )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_MapFile( fsal_handle, offset, length, data );
+	DataQ_StatsRecord( STATS_FSAL_MAP_FILE, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Stats_UnmapFile( const uint8_t * data, size_t offset, size_t length )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_UnmapFile( data, offset, length );
+	DataQ_StatsRecord( STATS_FSAL_MAP_FILE, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Stats_MapFileWritable( FSAL_File_t fsal_handle, size_t offset, size_t length, uint8_t ** data )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_MapFileWritable( fsal_handle, offset, length, data );
+	DataQ_StatsRecord( STATS_FSAL_MAP_FILE, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Stats_SyncMappedFile( const uint8_t * data, size_t offset, size_t length, int sync_type )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_SyncMappedFile( data, offset, length, sync_type );
+	DataQ_StatsRecord( STATS_FSAL_MAP_FILE, start, fsal_status != FSAL_STATUS_OK, 0 );
+	return fsal_status;
+}
+
+/* route the FSAL calls of the engine through the instrumented calls */
+#define FSAL_MakeDirectory			DataQ_Stats_MakeDirectory
+#define FSAL_RemoveDirectory		DataQ_Stats_RemoveDirectory
+#define FSAL_OpenDirectory			DataQ_Stats_OpenDirectory
+#define FSAL_CloseDirectory			DataQ_Stats_CloseDirectory
+#define FSAL_LockDirectory			DataQ_Stats_LockDirectory
+#define FSAL_UnlockDirectory		DataQ_Stats_UnlockDirectory
+#define FSAL_ListDirFile			DataQ_Stats_ListDirFile
+#define FSAL_OpenDirFile			DataQ_Stats_OpenDirFile
+#define FSAL_CloseFile				DataQ_Stats_CloseFile
+#define FSAL_SyncFile				DataQ_Stats_SyncFile
+#define FSAL_AllocateFile			DataQ_Stats_AllocateFile
+#define FSAL_ReadFile				DataQ_Stats_ReadFile
+#define FSAL_ReadFileAt				DataQ_Stats_ReadFileAt
+#define FSAL_WriteFile				DataQ_Stats_WriteFile
+#define FSAL_WriteFileAt			DataQ_Stats_WriteFileAt
+#define FSAL_DeleteDirFile			DataQ_Stats_DeleteDirFile
+#define FSAL_MapFile				DataQ_Stats_MapFile
+#define FSAL_UnmapFile				DataQ_Stats_UnmapFile
+#define FSAL_MapFileWritable		DataQ_Stats_MapFileWritable
+#define FSAL_SyncMappedFile			DataQ_Stats_SyncMappedFile
+
+#else
+
+/* without statistics nothing is accounted for */
+#define DATAQ_STATS_TARGET( stats )
+#define DATAQ_STATS_COUNT( counter )
+
+#endif /* DATA_QUEUE_STATS */
+
+#if defined( DATA_QUEUE_TRACE )
+
+/**
+ * Mutex serializing the records of the FSAL trace (taken around the
+ * FSAL calls of any task, whatever else it holds, so nothing is ever
+ * locked after it) and the timestamp of the start of the FSAL call
+ * recorded last, which the next record is timed from
+ */
+static PSL_Mutex_t DataQ_TraceMutex;
+static uint32_t DataQ_TraceTimestamp = 0;
+
+/* the identifier of a mapping in the trace */
+#define DATAQ_TRACE_ID( data )			( (uint32_t) (uintptr_t) (data) )
+
+/** @brief Records an FSAL call into the trace.
+ *
+ *  This function writes the record of an FSAL call just made, along
+ *  with the name of its file or directory, if any, to the trace (see
+ *  PSL_TraceWrite).
+ *
+ *  @param[in] op - the type of the record
+ *
+ *  @param[in] start - the timestamp taken before the call
+ *
+ *  @param[in] handle - the file, directory or mapping of the call
+ *
+ *  @param[in] offset - the offset of the call
+ *
+ *  @param[in] length - the length of the call
+ *
+ *  @param[in] flags - the flags (or type) of the call
+ *
+ *  @param[in] result - the status code or bytes transferred
+ *
+ *  @param[in] output - the handle, size, mapping or count returned
+ *
+ *  @param[in] name - the name of the file or directory or null
+ *
+ *  @return none
+ */
+static void DataQ_TraceRecord( int op, uint32_t start, uint32_t handle, size_t offset, size_t length, uint32_t flags, int32_t result, uint32_t output, const char * name )
+{
+	DataQ_Trace_Record_t record;
+	size_t name_length = (name != (const char *) 0) ? strlen( name ) : 0;
+
+	record.elapsed = PSL_GetTimestamp() - start;
+	record.handle = handle;
+	record.offset = (uint32_t) offset;
+	record.length = (uint32_t) length;
+	record.flags = flags;
+	record.result = result;
+	record.output = output;
+	record.op = (uint8_t) op;
+	record.reserved = 0;
+	record.name_length = (uint16_t) ((name_length > 0xFFFF) ? 0xFFFF : name_length);
+
+	PSL_MutexLock( &DataQ_TraceMutex );
+	record.delta = (int32_t) (start - DataQ_TraceTimestamp);
+	DataQ_TraceTimestamp = start;
+	PSL_TraceWrite( (const uint8_t *) &record, sizeof(record) );
+	if ( record.name_length != 0 ) {
+		PSL_TraceWrite( (const uint8_t *) name, record.name_length );
+	}
+	PSL_MutexUnlock( &DataQ_TraceMutex );
+}
+
+/**
+ * Traced FSAL calls, each making the FSAL call of the same name (or
+ * its instrumented call, with statistics) and recording it (inline,
+ * so that the ones unused in the current configuration raise no
+ * warnings)
+ */
+static inline void DataQ_Trace_Init( void )
+{
+	uint32_t start = PSL_GetTimestamp();
+	FSAL_Init();
+	DataQ_TraceTimestamp = start;
+	DataQ_TraceRecord( TRACE_OP_INIT, start, 0, TRACE_MAGIC, TRACE_VERSION, 0, FSAL_STATUS_OK, 0, (const char *) 0 );
+}
+
+static inline int DataQ_Trace_MakeDirectory( char * dir_name )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_MakeDirectory( dir_name );
+	DataQ_TraceRecord( TRACE_OP_MAKE_DIRECTORY, start, 0, 0, 0, 0, fsal_status, 0, dir_name );
+	return fsal_status;
+}
+
+static inline int DataQ_Trace_RemoveDirectory( char * dir_name )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_RemoveDirectory( dir_name );
+	DataQ_TraceRecord( TRACE_OP_REMOVE_DIRECTORY, start, 0, 0, 0, 0, fsal_status, 0, dir_name );
+	return fsal_status;
+}
+
+static inline int DataQ_Trace_OpenDirectory( char * dir_name, FSAL_Dir_t * fsal_dir )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_OpenDirectory( dir_name, fsal_dir );
+	DataQ_TraceRecord( TRACE_OP_OPEN_DIRECTORY, start, 0, 0, 0, 0, fsal_status,
+					   (fsal_status == FSAL_STATUS_OK) ? (uint32_t) *fsal_dir : 0, dir_name );
+	return fsal_status;
+}
+
+static inline int DataQ_Trace_CloseDirectory( FSAL_Dir_t fsal_dir )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_CloseDirectory( fsal_dir );
+	DataQ_TraceRecord( TRACE_OP_CLOSE_DIRECTORY, start, (uint32_t) fsal_dir, 0, 0, 0, fsal_status, 0, (const char *) 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Trace_LockDirectory( FSAL_Dir_t fsal_dir, int lock_type )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_LockDirectory( fsal_dir, lock_type );
+	DataQ_TraceRecord( TRACE_OP_LOCK_DIRECTORY, start, (uint32_t) fsal_dir, 0, 0, (uint32_t) lock_type, fsal_status, 0, (const char *) 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Trace_UnlockDirectory( FSAL_Dir_t fsal_dir )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_UnlockDirectory( fsal_dir );
+	DataQ_TraceRecord( TRACE_OP_UNLOCK_DIRECTORY, start, (uint32_t) fsal_dir, 0, 0, 0, fsal_status, 0, (const char *) 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Trace_ListDirFile( FSAL_Dir_t fsal_dir, char * file_name, size_t * file_size )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_ListDirFile( fsal_dir, file_name, file_size );
+	DataQ_TraceRecord( TRACE_OP_LIST_DIR_FILE, start, (uint32_t) fsal_dir, 0, 0, 0, fsal_status,
+					   (fsal_status == FSAL_STATUS_OK) ? (uint32_t) *file_size : 0, file_name );
+	return fsal_status;
+}
+
+static inline int DataQ_Trace_OpenDirFile( FSAL_Dir_t fsal_dir, char * file_name, int flags, FSAL_File_t * fsal_handle )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_OpenDirFile( fsal_dir, file_name, flags, fsal_handle );
+	DataQ_TraceRecord( TRACE_OP_OPEN_DIR_FILE, start, (uint32_t) fsal_dir, 0, 0, (uint32_t) flags, fsal_status,
+					   (fsal_status == FSAL_STATUS_OK) ? (uint32_t) *fsal_handle : 0, file_name );
+	return fsal_status;
+}
+
+static inline int DataQ_Trace_CloseFile( FSAL_File_t fsal_handle )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_CloseFile( fsal_handle );
+	DataQ_TraceRecord( TRACE_OP_CLOSE_FILE, start, (uint32_t) fsal_handle, 0, 0, 0, fsal_status, 0, (const char *) 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Trace_SyncFile( FSAL_File_t fsal_handle )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_SyncFile( fsal_handle );
+	DataQ_TraceRecord( TRACE_OP_SYNC_FILE, start, (uint32_t) fsal_handle, 0, 0, 0, fsal_status, 0, (const char *) 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Trace_AllocateFile( FSAL_File_t fsal_handle, size_t length )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_AllocateFile( fsal_handle, length );
+	DataQ_TraceRecord( TRACE_OP_ALLOCATE_FILE, start, (uint32_t) fsal_handle, 0, length, 0, fsal_status, 0, (const char *) 0 );
+	return fsal_status;
+}
+
+static inline ssize_t DataQ_Trace_ReadFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length )
+{
+	uint32_t start = PSL_GetTimestamp();
+	ssize_t actual_length = FSAL_ReadFile( fsal_handle, buffer, length );
+	DataQ_TraceRecord( TRACE_OP_READ_FILE, start, (uint32_t) fsal_handle, 0, length, 0, (int32_t) actual_length, 0, (const char *) 0 );
+	return actual_length;
+}
+
+static inline ssize_t DataQ_Trace_ReadFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length )
+{
+	uint32_t start = PSL_GetTimestamp();
+	ssize_t actual_length = FSAL_ReadFileAt( fsal_handle, offset, buffer, length );
+	DataQ_TraceRecord( TRACE_OP_READ_FILE_AT, start, (uint32_t) fsal_handle, offset, length, 0, (int32_t) actual_length, 0, (const char *) 0 );
+	return actual_length;
+}
+
+static inline ssize_t DataQ_Trace_WriteFile( FSAL_File_t fsal_handle, uint8_t * buffer, size_t length )
+{
+	uint32_t start = PSL_GetTimestamp();
+	ssize_t actual_length = FSAL_WriteFile( fsal_handle, buffer, length );
+	DataQ_TraceRecord( TRACE_OP_WRITE_FILE, start, (uint32_t) fsal_handle, 0, length, 0, (int32_t) actual_length, 0, (const char *) 0 );
+	return actual_length;
+}
+
+static inline ssize_t DataQ_Trace_WriteFileAt( FSAL_File_t fsal_handle, size_t offset, uint8_t * buffer, size_t length )
+{
+	uint32_t start = PSL_GetTimestamp();
+	ssize_t actual_length = FSAL_WriteFileAt( fsal_handle, offset, buffer, length );
+	DataQ_TraceRecord( TRACE_OP_WRITE_FILE_AT, start, (uint32_t) fsal_handle, offset, length, 0, (int32_t) actual_length, 0, (const char *) 0 );
+	return actual_length;
+}
+
+static inline int DataQ_Trace_DeleteDirFile( FSAL_Dir_t fsal_dir, char * file_name )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_DeleteDirFile( fsal_dir, file_name );
+	DataQ_TraceRecord( TRACE_OP_DELETE_DIR_FILE, start, (uint32_t) fsal_dir, 0, 0, 0, fsal_status, 0, file_name );
+	return fsal_status;
+}
+
+static inline int DataQ_Trace_MapFile( FSAL_File_t fsal_handle, size_t offset, size_t length, const uint8_t ** data )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_MapFile( fsal_handle, offset, length, data );
+	DataQ_TraceRecord( TRACE_OP_MAP_FILE, start, (uint32_t) fsal_handle, offset, length, 0, fsal_status,
+					   (fsal_status == FSAL_STATUS_OK) ? DATAQ_TRACE_ID( *data ) : 0, (const char *) 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Trace_UnmapFile( const uint8_t * data, size_t offset, size_t length )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_UnmapFile( data, offset, length );
+	DataQ_TraceRecord( TRACE_OP_UNMAP_FILE, start, DATAQ_TRACE_ID( data ), offset, length, 0, fsal_status, 0, (const char *) 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Trace_MapFileWritable( FSAL_File_t fsal_handle, size_t offset, size_t length, uint8_t ** data )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_MapFileWritable( fsal_handle, offset, length, data );
+	DataQ_TraceRecord( TRACE_OP_MAP_FILE_WRITABLE, start, (uint32_t) fsal_handle, offset, length, 0, fsal_status,
+					   (fsal_status == FSAL_STATUS_OK) ? DATAQ_TRACE_ID( *data ) : 0, (const char *) 0 );
+	return fsal_status;
+}
+
+static inline int DataQ_Trace_SyncMappedFile( const uint8_t * data, size_t offset, size_t length, int sync_type )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_SyncMappedFile( data, offset, length, sync_type );
+	DataQ_TraceRecord( TRACE_OP_SYNC_MAPPED_FILE, start, DATAQ_TRACE_ID( data ), offset, length, (uint32_t) sync_type, fsal_status, 0, (const char *) 0 );
+	return fsal_status;
+}
+
+static inline void DataQ_Trace_DeferWrites( int defer )
+{
+	uint32_t start = PSL_GetTimestamp();
+	FSAL_DeferWrites( defer );
+	DataQ_TraceRecord( TRACE_OP_DEFER_WRITES, start, 0, 0, 0, (uint32_t) defer, FSAL_STATUS_OK, 0, (const char *) 0 );
+}
+
+static inline uint32_t DataQ_Trace_GetWriteTicket( void )
+{
+	uint32_t start = PSL_GetTimestamp();
+	uint32_t ticket = FSAL_GetWriteTicket();
+	DataQ_TraceRecord( TRACE_OP_GET_WRITE_TICKET, start, 0, 0, 0, 0, FSAL_STATUS_OK, ticket, (const char *) 0 );
+	return ticket;
+}
+
+static inline int DataQ_Trace_PollWrites( int sync_type, uint32_t * completed, uint32_t * failed )
+{
+	uint32_t start = PSL_GetTimestamp();
+	int fsal_status = FSAL_PollWrites( sync_type, completed, failed );
+	DataQ_TraceRecord( TRACE_OP_POLL_WRITES, start, 0, 0, *failed, (uint32_t) sync_type, fsal_status, *completed, (const char *) 0 );
+	return fsal_status;
+}
+
+/* route the FSAL calls of the engine through the traced calls */
+#undef FSAL_MakeDirectory
+#undef FSAL_RemoveDirectory
+#undef FSAL_OpenDirectory
+#undef FSAL_CloseDirectory
+#undef FSAL_LockDirectory
+#undef FSAL_UnlockDirectory
+#undef FSAL_ListDirFile
+#undef FSAL_OpenDirFile
+#undef FSAL_CloseFile
+#undef FSAL_SyncFile
+#undef FSAL_AllocateFile
+#undef FSAL_ReadFile
+#undef FSAL_ReadFileAt
+#undef FSAL_WriteFile
+#undef FSAL_WriteFileAt
+#undef FSAL_DeleteDirFile
+#undef FSAL_MapFile
+#undef FSAL_UnmapFile
+#undef FSAL_MapFileWritable
+#undef FSAL_SyncMappedFile
+#define FSAL_Init					DataQ_Trace_Init
+#define FSAL_MakeDirectory			DataQ_Trace_MakeDirectory
+#define FSAL_RemoveDirectory		DataQ_Trace_RemoveDirectory
+#define FSAL_OpenDirectory			DataQ_Trace_OpenDirectory
+#define FSAL_CloseDirectory			DataQ_Trace_CloseDirectory
+#define FSAL_LockDirectory			DataQ_Trace_LockDirectory
+#define FSAL_UnlockDirectory		DataQ_Trace_UnlockDirectory
+#define FSAL_ListDirFile			DataQ_Trace_ListDirFile
+#define FSAL_OpenDirFile			DataQ_Trace_OpenDirFile
+#define FSAL_CloseFile				DataQ_Trace_CloseFile
+#define FSAL_SyncFile				DataQ_Trace_SyncFile
+#define FSAL_AllocateFile			DataQ_Trace_AllocateFile
+#define FSAL_ReadFile				DataQ_Trace_ReadFile
+#define FSAL_ReadFileAt				DataQ_Trace_ReadFileAt
+#define FSAL_WriteFile				DataQ_Trace_WriteFile
+#define FSAL_WriteFileAt			DataQ_Trace_WriteFileAt
+#define FSAL_DeleteDirFile			DataQ_Trace_DeleteDirFile
+#define FSAL_MapFile				DataQ_Trace_MapFile
+#define FSAL_UnmapFile				DataQ_Trace_UnmapFile
+#define FSAL_MapFileWritable		DataQ_Trace_MapFileWritable
+#define FSAL_SyncMappedFile			DataQ_Trace_SyncMappedFile
+#define FSAL_DeferWrites			DataQ_Trace_DeferWrites
+#define FSAL_GetWriteTicket			DataQ_Trace_GetWriteTicket
+#define FSAL_PollWrites				DataQ_Trace_PollWrites
+
+/* record the payload of an entry enqueued into the trace */
+#define DATAQ_TRACE_PAYLOAD( queue, size )	DataQ_TraceRecord( TRACE_OP_PAYLOAD, PSL_GetTimestamp(), (uint32_t) (queue), 0, (size), 0, CODE_STATUS_OK, 0, (const char *) 0 )
+
+#else
+
+/* without the trace nothing is recorded */
+#define DATAQ_TRACE_PAYLOAD( queue, size )
+
+#endif /* DATA_QUEUE_TRACE */
+
+/** @brief Retrieves the cached state of an opened data queue.
+ *
+ *  This function looks up the specified fifo handle in the list
+ *  of currently opened data queues and returns the cached state
+ *  associated with it.
+ *
+ *  @param[in] fifo_handle - the reference of the data queue
+ *
+ *  @return DataQ_State_t* - the reference of the cached state or
+ *                           null if the fifo handle is not listed
+ */
+static DataQ_State_t * DataQ_GetState( DataQ_File_t * fifo_handle )
+{
+	int index;
+
+	/* a valid fifo handle references one data queue on the list */
+	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX; index++ ) {
+		if( fifo_handle == &DataQ_FileHandleList[index] ) {
+			DATAQ_STATS_TARGET( &DataQ_FileStatsList[index] );
+			return &DataQ_FileStateList[index];
+		}
+	}
+
+	/* can not find the handle */
+	return (DataQ_State_t *) 0;
+}
+
+/** @brief Locks an opened data queue.
+ *
+ *  This function looks up the specified fifo handle in the list
+ *  of currently opened data queues and locks the mutex associated
+ *  with it, waiting for any other task (or thread) operating on the
+ *  same data queue to finish.
+ *
+ *  @param[in] fifo_handle - the reference of the data queue
+ *
+ *  @return PSL_Mutex_t* - the reference of the locked mutex or null
+ *                         if the fifo handle is not listed
+ */
+static PSL_Mutex_t * DataQ_LockQueue( DataQ_File_t * fifo_handle )
+{
+	int index;
+
+	/* a valid fifo handle references one data queue on the list */
+	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX; index++ ) {
+		if( fifo_handle == &DataQ_FileHandleList[index] ) {
+			PSL_MutexLock( &DataQ_QueueMutex[index] );
+			return &DataQ_QueueMutex[index];
+		}
+	}
+
+	/* can not find the handle (the operation then fails on it) */
+	return (PSL_Mutex_t *) 0;
+}
+
+/** @brief Unlocks an opened data queue.
+ *
+ *  This function unlocks the mutex of a data queue previously
+ *  locked by DataQ_LockQueue, if any.
+ *
+ *  @param[in] fifo_mutex - the reference of the locked mutex or null
+ *
+ *  @return none
+ */
+static void DataQ_UnlockQueue( PSL_Mutex_t * fifo_mutex )
+{
+	if ( fifo_mutex != (PSL_Mutex_t *) 0 ) {
+		PSL_MutexUnlock( fifo_mutex );
+	}
+}
+
+/** @brief Retrieves the size of one LUT entry of a data queue.
+ *
+ *  This function determines the size of one LUT entry from the
+ *  LUT version and the storage mode the data queue was created
+ *  with (a data queue created with the fixed record flag has no
+ *  LUT entry at all).
+ *
+ *  @param[in] fifo_hdr - the reference of the header
+ *
+ *  @return size_t - the size of one LUT entry
+ */
+static size_t DataQ_GetLUTEntrySize( DataQ_Hdr_t * fifo_hdr )
+{
+	if ( fifo_hdr->flags & FLAGS_FIXED_RECORD ) {
+		return 0;
+	}
+
+	if ( fifo_hdr->lut_version != LUT_VERSION_LEGACY ) {
+		return sizeof(DataQ_LUT_Record_t);
+	}
+
+	if ( fifo_hdr->flags & FLAGS_SEGMENTED_STORAGE ) {
+		return sizeof(DataQ_LUT_Segment_t);
+	}
+
+	return sizeof(DataQ_LUT_Entry_t);
+}
+
+/** @brief Writes back a part of the metadata mapped into memory.
+ *
+ *  This function synchronizes the specified header or LUT mapping
+ *  with its file as set by the msync policy the library is built
+ *  with: not at all (the filesystem writes it back on its own), by
+ *  scheduling the write, or by waiting for the write to complete.
+ *
+ *  @param[in] map - the location of the mapped metadata
+ *
+ *  @param[in] map_size - the size of the mapped metadata
+ *
+ *  @param[in] sync_type - the type of synchronization to perform
+ *                         regardless of the msync policy (or -1 to
+ *                         follow the msync policy)
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_SyncMap( uint8_t * map, size_t map_size, int sync_type )
+{
+	/* follow the msync policy unless told otherwise */
+	if ( sync_type == -1 ) {
+		if ( DATA_QUEUE_MSYNC_POLICY == MSYNC_POLICY_NONE ) {
+			return CODE_STATUS_OK;
+		}
+		sync_type = (DATA_QUEUE_MSYNC_POLICY == MSYNC_POLICY_SYNC) ? FSAL_SYNC_WAIT : FSAL_SYNC_ASYNC;
+	}
+
+	if ( FSAL_SyncMappedFile( map, 0, map_size, sync_type ) != FSAL_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Determines how the metadata of a data queue is synchronized.
+ *
+ *  This function returns the type of synchronization of the metadata
+ *  mapped into memory: waiting for the storage media if the durability
+ *  policy of the data queue synchronizes what it writes, or following
+ *  the msync policy otherwise.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @return int - the type of synchronization (-1 for the msync policy)
+ */
+static int DataQ_GetSyncType( DataQ_State_t * fifo_state )
+{
+	return (fifo_state->durability.type == DURABILITY_TYPE_DEFAULT) ? -1 : FSAL_SYNC_WAIT;
+}
+
+/** @brief Stores the changed LUT entries of a cached LUT page.
+ *
+ *  This function writes the LUT entries of the page that changed
+ *  since the last commit into the (already opened) LUT file of the
+ *  data queue, or into the LUT file mapped into memory. Runs of
+ *  adjacent changed entries are coalesced into one positional write
+ *  and unchanged entries are never rewritten.
+ *  With the metadata journal flag, the changed entries not journaled
+ *  yet are left (still changed) to the next checkpoint, so the LUT
+ *  file only ever holds changes already journaled.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fifo_lut_page - the reference of the cached LUT page
+ *
+ *  @param[in] fsal_handle - the handle of the opened LUT file (unused
+ *                          if the LUT file is mapped into memory)
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_StoreLUTPage( DataQ_State_t * fifo_state, DataQ_LUT_Page_t * fifo_lut_page, FSAL_File_t fsal_handle )
+{
+	uint8_t changed[ DATAQ_LUT_PAGE_DIRTY_MAP_SIZE ];
+	uint32_t run_first;
+	uint32_t run_last;
+	uint32_t page_entries = DATA_QUEUE_LUT_PAGE_ENTRIES;
+	int byte;
+
+	/* the last page may be cut short by the end of the LUT */
+	if ( (fifo_state->hdr.max_entries - fifo_lut_page->first) < page_entries ) {
+		page_entries = fifo_state->hdr.max_entries - fifo_lut_page->first;
+	}
+
+	/* determine the changed entries to write (those of a journaled fifo
+	 * only once journaled) */
+	for ( byte = 0; byte < DATAQ_LUT_PAGE_DIRTY_MAP_SIZE; byte++ ) {
+		changed[byte] = fifo_lut_page->dirty[byte];
+		if ( fifo_state->hdr.flags & FLAGS_METADATA_JOURNAL ) {
+			changed[byte] &= (uint8_t) ~fifo_lut_page->unlogged[byte];
+		}
+	}
+
+	/* determine the first changed entry, if any */
+	for ( run_first = 0; run_first < page_entries; run_first++ ) {
+		if ( changed[ run_first / 8 ] & (1 << (run_first % 8)) ) {
+			break;
+		}
+	}
+
+	while ( run_first < page_entries ) {
+
+		/* extend the run over the adjacent changed entries */
+		for ( run_last = run_first + 1; run_last < page_entries; run_last++ ) {
+			if ( (changed[ run_last / 8 ] & (1 << (run_last % 8))) == 0 ) {
+				break;
+			}
+		}
+
+		/* write the run of changed entries at their offset in the LUT file */
+		if ( fifo_state->lut_map != (uint8_t *) 0 ) {
+			PSL_memcpy(
+				fifo_state->lut_map + ((size_t)(fifo_lut_page->first + run_first) * fifo_state->lut_entry_size),
+				fifo_lut_page->entries + (run_first * fifo_state->lut_entry_size),
+				(run_last - run_first) * fifo_state->lut_entry_size );
+		} else if ( FSAL_WriteFileAt(
+				fsal_handle,
+				(size_t)(fifo_lut_page->first + run_first) * fifo_state->lut_entry_size,
+				fifo_lut_page->entries + (run_first * fifo_state->lut_entry_size),
+				(run_last - run_first) * fifo_state->lut_entry_size) < 0 ) {
+
+			/* file system access error */
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+
+		/* look for the next run of changed entries */
+		for ( run_first = run_last; run_first < page_entries; run_first++ ) {
+			if ( changed[ run_first / 8 ] & (1 << (run_first % 8)) ) {
+				break;
+			}
+		}
+	}
+
+	/* the changed entries written are committed */
+	for ( byte = 0; byte < DATAQ_LUT_PAGE_DIRTY_MAP_SIZE; byte++ ) {
+		fifo_lut_page->dirty[byte] &= (uint8_t) ~changed[byte];
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Stores the cached LUT of a data queue.
+ *
+ *  This function writes the cached LUT entries that changed since the
+ *  last commit, whatever page they are kept in, back to the LUT file
+ *  of the data queue (or to the LUT file mapped into memory, which is
+ *  then written back as the msync policy sets, so the mapping only
+ *  ever holds committed changes).
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_StoreLUT( DataQ_State_t * fifo_state )
+{
+	FSAL_File_t fsal_handle = -1;
+	DataQ_LUT_Page_t * fifo_lut_page;
+	int dataq_status = CODE_STATUS_OK;
+	int index;
+	int byte;
+
+	for ( index = 0; index < DATA_QUEUE_LUT_PAGE_COUNT; index++ ) {
+
+		fifo_lut_page = &fifo_state->lut_pages[index];
+
+		/* skip the pages holding nothing */
+		if ( fifo_lut_page->first == DATAQ_LUT_PAGE_INVALID ) {
+			continue;
+		}
+
+		/* skip the pages without any changed entry */
+		for ( byte = 0; byte < DATAQ_LUT_PAGE_DIRTY_MAP_SIZE; byte++ ) {
+			if ( fifo_lut_page->dirty[byte] != 0 ) {
+				break;
+			}
+		}
+		if ( byte == DATAQ_LUT_PAGE_DIRTY_MAP_SIZE ) {
+			continue;
+		}
+
+		/* open the LUT file associated with the fifo for in-place updates
+		 * (only once, when the first changed page is found), unless it is
+		 * mapped into memory */
+		if ( (fsal_handle == -1) && (fifo_state->lut_map == (uint8_t *) 0) &&
+			 (FSAL_OpenDirFile(fifo_state->dir, ".lut", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+
+		/* write the changed entries of the page */
+		DATAQ_STATS_COUNT( lut_page_stores );
+		dataq_status = DataQ_StoreLUTPage( fifo_state, fifo_lut_page, fsal_handle );
+		if ( dataq_status != CODE_STATUS_OK ) {
+			break;
+		}
+	}
+
+	/* write back the LUT file mapped into memory */
+	if ( fifo_state->lut_map != (uint8_t *) 0 ) {
+		if ( dataq_status != CODE_STATUS_OK ) {
+			return dataq_status;
+		}
+		return DataQ_SyncMap( fifo_state->lut_map, fifo_state->lut_map_size, DataQ_GetSyncType( fifo_state ) );
+	}
+
+	/* nothing to write back */
+	if ( fsal_handle == -1 ) {
+		return CODE_STATUS_OK;
+	}
+
+	/* synchronize the LUT file if the durability policy asks for it */
+	if ( (dataq_status == CODE_STATUS_OK) &&
+		 (fifo_state->durability.type != DURABILITY_TYPE_DEFAULT) &&
+		 (FSAL_SyncFile(fsal_handle) != FSAL_STATUS_OK) ) {
+		dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* done updating the LUT file */
+	if ( (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+		 (dataq_status != CODE_STATUS_OK) ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Updates the CRC32 of a block of data with more data.
+ *
+ *  This function computes the standard (reflected, 0xEDB88320
+ *  polynomial) CRC32 of a block of data made of the data the
+ *  specified CRC32 was computed over followed by the specified data,
+ *  so that the CRC32 of a large block can be computed piece by
+ *  piece. It is computed bitwise so that no lookup table is kept in
+ *  memory.
+ *
+ *  @param[in] crc - the CRC32 of the data before (zero if none)
+ *
+ *  @param[in] data - the reference of the data
+ *
+ *  @param[in] size - the size of the data
+ *
+ *  @return uint32_t - the CRC32 of the whole data
+ */
+static uint32_t DataQ_UpdateCRC32( uint32_t crc, const void * data, size_t size )
+{
+	const uint8_t * bytes = (const uint8_t *) data;
+	int bit;
+
+	crc = ~crc;
+	while ( size-- > 0 ) {
+		crc ^= *bytes++;
+		for ( bit = 0; bit < 8; bit++ ) {
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+		}
+	}
+
+	return ~crc;
+}
+
+/** @brief Computes the CRC32 of a block of data.
+ *
+ *  This function computes the standard CRC32 of the specified data
+ *  (see DataQ_UpdateCRC32).
+ *
+ *  @param[in] data - the reference of the data
+ *
+ *  @param[in] size - the size of the data
+ *
+ *  @return uint32_t - the CRC32 of the data
+ */
+static uint32_t DataQ_ComputeCRC32( const void * data, size_t size )
+{
+	return DataQ_UpdateCRC32( 0, data, size );
+}
+
+/** @brief Reads a record of the metadata journal of a data queue.
+ *
+ *  This function reads the record kept in the specified slot of the
+ *  (already opened) journal file of the data queue into the journal
+ *  buffer and checks it: its magic number, its size against the LUT
+ *  entries it holds and its CRC32.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fsal_handle - the handle of the opened journal file
+ *
+ *  @param[in] slot - the slot of the record within the journal file
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ */
+static int DataQ_ReadJournal( DataQ_State_t * fifo_state, FSAL_File_t fsal_handle, uint32_t slot )
+{
+	DataQ_Journal_Record_t * fifo_record = (DataQ_Journal_Record_t *) DataQ_JournalBuffer;
+	ssize_t read_size;
+	uint32_t crc;
+
+	/* a slot never written (or cut short) holds no record */
+	read_size = FSAL_ReadFileAt( fsal_handle, (size_t) slot * DATA_QUEUE_JOURNAL_RECORD_SIZE, DataQ_JournalBuffer, DATA_QUEUE_JOURNAL_RECORD_SIZE );
+	if ( (read_size < (ssize_t) sizeof(DataQ_Journal_Record_t)) ||
+		 (fifo_record->magic != JOURNAL_MAGIC) ||
+		 (fifo_record->size > (size_t) read_size) ||
+		 (fifo_record->size != (sizeof(DataQ_Journal_Record_t) + (fifo_record->slot_count * (sizeof(uint32_t) + fifo_state->lut_entry_size)))) ) {
+		return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+	}
+
+	/* a record torn by a power loss does not match its CRC32 */
+	crc = fifo_record->crc;
+	fifo_record->crc = 0;
+	if ( DataQ_ComputeCRC32( DataQ_JournalBuffer, fifo_record->size ) != crc ) {
+		return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+	}
+	fifo_record->crc = crc;
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Applies the metadata journal to a cached LUT page.
+ *
+ *  This function updates the specified page, just filled from the
+ *  LUT file of a data queue created with the metadata journal flag,
+ *  with the LUT entries of the page changed by the records the LUT
+ *  file does not hold yet: those replayed when the data queue was
+ *  opened with read-only access (such a handle leaves the LUT file
+ *  to the next writer checkpoint), or, for a handle with write access
+ *  that dropped changed pages from its cache, those written since the
+ *  last checkpoint (along with those journaled ahead of the commit in
+ *  progress).
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fifo_lut_page - the reference of the cached page
+ *
+ *  @param[in] page_entries - the number of LUT entries of the page
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_OverlayJournal( DataQ_State_t * fifo_state, DataQ_LUT_Page_t * fifo_lut_page, uint32_t page_entries )
+{
+	FSAL_File_t fsal_handle = -1;
+	DataQ_Journal_Record_t * fifo_record = (DataQ_Journal_Record_t *) DataQ_JournalBuffer;
+	uint32_t sequence;
+	uint32_t lut_offs;
+	uint8_t * slot;
+	uint32_t oldest = fifo_state->journal_oldest;
+	int dataq_status = CODE_STATUS_OK;
+	int index;
+
+	/* a handle with write access applies the records written since the last checkpoint */
+	if ( fifo_state->read_only == 0 ) {
+		oldest = fifo_state->journal_sequence - fifo_state->journal_records;
+	}
+
+	/* no record to apply */
+	if ( (oldest == 0) || (oldest == fifo_state->journal_sequence) ) {
+		return CODE_STATUS_OK;
+	}
+
+	PSL_MutexLock( &DataQ_JournalMutex );
+
+	if ( FSAL_OpenDirFile(fifo_state->dir, ".journal", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS ) {
+		PSL_MutexUnlock( &DataQ_JournalMutex );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* apply the records in order, so the newest change of an entry is kept */
+	for ( sequence = oldest; sequence < fifo_state->journal_sequence; sequence++ ) {
+
+		if ( (DataQ_ReadJournal( fifo_state, fsal_handle, sequence % DATA_QUEUE_JOURNAL_RECORD_COUNT ) != CODE_STATUS_OK) ||
+			 (fifo_record->sequence != sequence) ) {
+			dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+			break;
+		}
+
+		/* copy the changed LUT entries that fall within the page */
+		slot = DataQ_JournalBuffer + sizeof(DataQ_Journal_Record_t);
+		for ( index = 0; index < fifo_record->slot_count; index++ ) {
+			PSL_memcpy( &lut_offs, slot, sizeof(uint32_t) );
+			if ( (lut_offs >= fifo_lut_page->first) && (lut_offs < (fifo_lut_page->first + page_entries)) ) {
+				PSL_memcpy( fifo_lut_page->entries + ((lut_offs - fifo_lut_page->first) * fifo_state->lut_entry_size), slot + sizeof(uint32_t), fifo_state->lut_entry_size );
+			}
+			slot += DATAQ_JOURNAL_SLOT_SIZE( fifo_state );
+		}
+	}
+
+	FSAL_CloseFile( fsal_handle );
+	PSL_MutexUnlock( &DataQ_JournalMutex );
+
+	return dataq_status;
+}
+
+/** @brief Checks whether a cached LUT page holds changes not committed.
+ *
+ *  This function tells whether any of the LUT entries of the specified
+ *  cached page changed since they were last written to the LUT file.
+ *
+ *  @param[in] fifo_lut_page - the reference of the cached page
+ *
+ *  @return int - non-zero if the page holds changes not committed
+ */
+static int DataQ_IsPageDirty( DataQ_LUT_Page_t * fifo_lut_page )
+{
+	int index;
+
+	for ( index = 0; index < DATAQ_LUT_PAGE_DIRTY_MAP_SIZE; index++ ) {
+		if ( fifo_lut_page->dirty[index] != 0 ) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/** @brief Checks whether a cached LUT page holds changes not journaled.
+ *
+ *  This function tells whether any of the LUT entries of the specified
+ *  cached page changed since they were last journaled (which only
+ *  matters for a data queue created with the metadata journal flag).
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fifo_lut_page - the reference of the cached page
+ *
+ *  @return int - non-zero if the page holds changes not journaled
+ */
+static int DataQ_IsPageUnlogged( DataQ_State_t * fifo_state, DataQ_LUT_Page_t * fifo_lut_page )
+{
+	int index;
+
+	if ( (fifo_state->hdr.flags & FLAGS_METADATA_JOURNAL) == 0 ) {
+		return 0;
+	}
+
+	for ( index = 0; index < DATAQ_LUT_PAGE_DIRTY_MAP_SIZE; index++ ) {
+		if ( fifo_lut_page->unlogged[index] != 0 ) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/** @brief Stores a header into the header file of a data queue.
+ *
+ *  This function writes the specified header to the header (or
+ *  metadata) file of the data queue and, if it succeeds,
+ *  updates the cached header with it. A data queue created with
+ *  the first header version keeps its header in that version.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fifo_hdr - the reference of the header to store
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_StoreHeader( DataQ_State_t * fifo_state, DataQ_Hdr_t * fifo_hdr )
+{
+	FSAL_File_t fsal_handle = -1;
+	DataQ_Hdr_v1_t fifo_hdr_v1;
+	void * hdr_data = fifo_hdr;
+	size_t hdr_size = sizeof(DataQ_Hdr_t);
+
+	/* narrow the header down to the first version if needed */
+	if ( fifo_hdr->hdr_version == HDR_VERSION_1 ) {
+		PSL_memset( &fifo_hdr_v1, 0, sizeof(DataQ_Hdr_v1_t) );
+		fifo_hdr_v1.flash_size = fifo_hdr->flash_size;
+		fifo_hdr_v1.max_flash_size = fifo_hdr->max_flash_size;
+		fifo_hdr_v1.max_entry_size = fifo_hdr->max_entry_size;
+		fifo_hdr_v1.max_entries = (uint8_t) fifo_hdr->max_entries;
+		fifo_hdr_v1.num_of_entries = (uint8_t) fifo_hdr->num_of_entries;
+		fifo_hdr_v1.head_lut_offs = (uint8_t) fifo_hdr->head_lut_offs;
+		fifo_hdr_v1.tail_lut_offs = (uint8_t) fifo_hdr->tail_lut_offs;
+		fifo_hdr_v1.seek_lut_offs = (uint8_t) fifo_hdr->seek_lut_offs;
+		fifo_hdr_v1.lut_version = fifo_hdr->lut_version;
+		fifo_hdr_v1.reference_count = (uint16_t) fifo_hdr->reference_count;
+		fifo_hdr_v1.flags = fifo_hdr->flags;
+		hdr_data = &fifo_hdr_v1;
+		hdr_size = sizeof(DataQ_Hdr_v1_t);
+	}
+
+	if ( fifo_state->hdr_map != (uint8_t *) 0 ) {
+
+		/* store the header in place into the header file mapped into memory */
+		if ( hdr_size > fifo_state->hdr_map_size ) {
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+		PSL_memcpy( fifo_state->hdr_map, hdr_data, hdr_size );
+		if ( DataQ_SyncMap( fifo_state->hdr_map, fifo_state->hdr_map_size, DataQ_GetSyncType( fifo_state ) ) != CODE_STATUS_OK ) {
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+
+	/* update the header (or metadata) file associated with the fifo */
+	} else if ( (FSAL_OpenDirFile(fifo_state->dir, ".header", FSAL_FLAGS_BINARY | FSAL_FLAGS_WRITE_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+		 (FSAL_WriteFile(fsal_handle, (uint8_t *)hdr_data, hdr_size) < 0) ||
+		 ((fifo_state->durability.type != DURABILITY_TYPE_DEFAULT) && (FSAL_SyncFile(fsal_handle) != FSAL_STATUS_OK)) ||
+		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+		/* file system access error */
+		if ( fsal_handle != -1 )
+			FSAL_CloseFile( fsal_handle );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	DATAQ_STATS_COUNT( header_stores );
+
+	/* keep the cached header in sync with the header file */
+	if ( fifo_hdr != &fifo_state->hdr ) {
+		PSL_memcpy( &fifo_state->hdr, fifo_hdr, sizeof(DataQ_Hdr_t) );
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Writes a record into the metadata journal of a data queue.
+ *
+ *  This function seals the record held in the journal buffer (of the
+ *  specified size) with the next sequence number and its CRC32 and
+ *  writes it into its slot of the journal file of the data queue,
+ *  synchronizing the journal file if the durability policy asks for
+ *  it.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] size - the size of the record
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_WriteJournal( DataQ_State_t * fifo_state, uint32_t size )
+{
+	FSAL_File_t fsal_handle = -1;
+	DataQ_Journal_Record_t * fifo_record = (DataQ_Journal_Record_t *) DataQ_JournalBuffer;
+	uint32_t slot = fifo_state->journal_sequence % DATA_QUEUE_JOURNAL_RECORD_COUNT;
+
+	/* seal the record */
+	fifo_record->magic = JOURNAL_MAGIC;
+	fifo_record->sequence = fifo_state->journal_sequence;
+	fifo_record->size = size;
+	fifo_record->crc = 0;
+	fifo_record->crc = DataQ_ComputeCRC32( DataQ_JournalBuffer, size );
+
+	/* write the record into its slot of the journal file associated with the fifo */
+	if ( (FSAL_OpenDirFile(fifo_state->dir, ".journal", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+		 (FSAL_WriteFileAt(fsal_handle, (size_t) slot * DATA_QUEUE_JOURNAL_RECORD_SIZE, DataQ_JournalBuffer, size) < 0) ||
+		 ((fifo_state->durability.type != DURABILITY_TYPE_DEFAULT) && (FSAL_SyncFile(fsal_handle) != FSAL_STATUS_OK)) ||
+		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+		/* file system access error */
+		if ( fsal_handle != -1 )
+			FSAL_CloseFile( fsal_handle );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	DATAQ_STATS_COUNT( journal_stores );
+	fifo_state->journal_sequence++;
+	fifo_state->journal_records++;
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Applies the metadata journal to the LUT file of a data queue.
+ *
+ *  This function writes the LUT entries changed by the records written
+ *  since the last checkpoint of a data queue created with the metadata
+ *  journal flag into its LUT file (in order, so the newest change of an
+ *  entry is kept), as the changed entries of the pages dropped from the
+ *  cache since then were only journaled. The LUT file is synchronized
+ *  if the durability policy asks for it.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_ApplyJournal( DataQ_State_t * fifo_state )
+{
+	FSAL_File_t fsal_handle = -1;
+	FSAL_File_t fsal_lut_handle = -1;
+	DataQ_Journal_Record_t * fifo_record = (DataQ_Journal_Record_t *) DataQ_JournalBuffer;
+	uint32_t sequence;
+	uint32_t lut_offs;
+	uint8_t * slot;
+	int dataq_status = CODE_STATUS_OK;
+	int index;
+
+	if ( (FSAL_OpenDirFile(fifo_state->dir, ".journal", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+		 (FSAL_OpenDirFile(fifo_state->dir, ".lut", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE, &fsal_lut_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+		/* file system access error */
+		if ( fsal_handle != -1 )
+			FSAL_CloseFile( fsal_handle );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	for ( sequence = fifo_state->journal_sequence - fifo_state->journal_records; sequence < fifo_state->journal_sequence; sequence++ ) {
+
+		if ( (DataQ_ReadJournal( fifo_state, fsal_handle, sequence % DATA_QUEUE_JOURNAL_RECORD_COUNT ) != CODE_STATUS_OK) ||
+			 (fifo_record->sequence != sequence) ) {
+			dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+			break;
+		}
+
+		/* write the changed LUT entries into the LUT file */
+		slot = DataQ_JournalBuffer + sizeof(DataQ_Journal_Record_t);
+		for ( index = 0; index < fifo_record->slot_count; index++ ) {
+			PSL_memcpy( &lut_offs, slot, sizeof(uint32_t) );
+			if ( (lut_offs >= fifo_state->hdr.max_entries) ||
+				 (FSAL_WriteFileAt(fsal_lut_handle, (size_t) lut_offs * fifo_state->lut_entry_size, slot + sizeof(uint32_t), fifo_state->lut_entry_size) < 0) ) {
+				dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+				break;
+			}
+			slot += DATAQ_JOURNAL_SLOT_SIZE( fifo_state );
+		}
+		if ( dataq_status != CODE_STATUS_OK ) {
+			break;
+		}
+	}
+
+	/* the LUT file is synchronized before the checkpoint relies on it */
+	if ( (dataq_status == CODE_STATUS_OK) &&
+		 (fifo_state->durability.type != DURABILITY_TYPE_DEFAULT) &&
+		 (FSAL_SyncFile(fsal_lut_handle) != FSAL_STATUS_OK) ) {
+		dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+	}
+	FSAL_CloseFile( fsal_lut_handle );
+	FSAL_CloseFile( fsal_handle );
+
+	return dataq_status;
+}
+
+/** @brief Checkpoints the metadata journal of a data queue.
+ *
+ *  This function brings the LUT and header files of a data queue
+ *  created with the metadata journal flag up to date with the records
+ *  written since the last checkpoint (if changed pages were dropped
+ *  from the cache since then), the cached LUT entries (all of them
+ *  already journaled, or already replayed into the LUT file, as no
+ *  record may be journaled ahead of a commit in progress) and the
+ *  specified header, and then writes a checkpoint record holding the
+ *  header, from which on the journal is replayed. Until the checkpoint
+ *  record is written, the records written since the last checkpoint
+ *  are replayed over whatever reached the LUT file.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fifo_hdr - the reference of the header to checkpoint
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_CheckpointJournal( DataQ_State_t * fifo_state, DataQ_Hdr_t * fifo_hdr )
+{
+	DataQ_Journal_Record_t * fifo_record = (DataQ_Journal_Record_t *) DataQ_JournalBuffer;
+	uint32_t journal_records = fifo_state->journal_records;
+
+	/* bring the LUT and header files up to date */
+	if ( (fifo_state->journal_deferred && (DataQ_ApplyJournal( fifo_state ) != CODE_STATUS_OK)) ||
+		 (DataQ_StoreLUT( fifo_state ) != CODE_STATUS_OK) ||
+		 (DataQ_StoreHeader( fifo_state, fifo_hdr ) != CODE_STATUS_OK) ) {
+		fifo_state->journal_checkpoint = 1;
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* restart the journal from there */
+	PSL_memset( fifo_record, 0, sizeof(DataQ_Journal_Record_t) );
+	fifo_record->flags = JOURNAL_FLAGS_CHECKPOINT;
+	PSL_memcpy( &fifo_record->hdr, fifo_hdr, sizeof(DataQ_Hdr_t) );
+	fifo_state->journal_records = 0;
+	if ( DataQ_WriteJournal( fifo_state, sizeof(DataQ_Journal_Record_t) ) != CODE_STATUS_OK ) {
+
+		/* the records written since the last checkpoint are still replayed */
+		fifo_state->journal_records = journal_records;
+		fifo_state->journal_checkpoint = 1;
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	fifo_state->journal_checkpoint = 0;
+	fifo_state->journal_deferred = 0;
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Counts the cached LUT entries changed but not journaled.
+ *
+ *  This function counts the LUT entries of the specified cached page
+ *  (or of all the cached pages) changed since they were last journaled.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fifo_lut_page - the reference of the cached page, or
+ *                             none for all the cached pages
+ *
+ *  @return uint32_t - the number of LUT entries not journaled
+ */
+static uint32_t DataQ_CountUnlogged( DataQ_State_t * fifo_state, DataQ_LUT_Page_t * fifo_lut_page )
+{
+	uint32_t slot_count = 0;
+	int index;
+	int entry;
+
+	for ( index = 0; index < DATA_QUEUE_LUT_PAGE_COUNT; index++ ) {
+		if ( (fifo_state->lut_pages[index].first == DATAQ_LUT_PAGE_INVALID) ||
+			 ((fifo_lut_page != (DataQ_LUT_Page_t *) 0) && (fifo_lut_page != &fifo_state->lut_pages[index])) ) {
+			continue;
+		}
+		for ( entry = 0; entry < DATA_QUEUE_LUT_PAGE_ENTRIES; entry++ ) {
+			if ( fifo_state->lut_pages[index].unlogged[ entry / 8 ] & (1 << (entry % 8)) ) {
+				slot_count++;
+			}
+		}
+	}
+
+	return slot_count;
+}
+
+/** @brief Journals the cached LUT entries changed but not journaled.
+ *
+ *  This function writes the LUT entries of the specified cached page
+ *  (or of all the cached pages) changed since they were last journaled
+ *  into the journal of a data queue created with the metadata journal
+ *  flag, in as many records as they need (one at least), each of them
+ *  holding the specified header. All the records but the last one are
+ *  flagged as continued, the last one being given the specified flags.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fifo_hdr - the reference of the header to journal
+ *
+ *  @param[in] fifo_lut_page - the reference of the cached page, or
+ *                             none for all the cached pages
+ *
+ *  @param[in] flags - the flags of the last record
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_LogLUTPages( DataQ_State_t * fifo_state, DataQ_Hdr_t * fifo_hdr, DataQ_LUT_Page_t * fifo_lut_page, uint16_t flags )
+{
+	DataQ_Journal_Record_t * fifo_record = (DataQ_Journal_Record_t *) DataQ_JournalBuffer;
+	DataQ_LUT_Page_t * fifo_log_page;
+	uint32_t slot_size = DATAQ_JOURNAL_SLOT_SIZE( fifo_state );
+	uint32_t slot_max = DATAQ_JOURNAL_SLOT_MAX( fifo_state );
+	uint32_t lut_offs;
+	uint8_t * slot = DataQ_JournalBuffer + sizeof(DataQ_Journal_Record_t);
+	int index;
+	int entry;
+
+	PSL_memset( fifo_record, 0, sizeof(DataQ_Journal_Record_t) );
+
+	/* journal the LUT entries changed since the last record */
+	for ( index = 0; index < DATA_QUEUE_LUT_PAGE_COUNT; index++ ) {
+
+		fifo_log_page = &fifo_state->lut_pages[index];
+		if ( (fifo_log_page->first == DATAQ_LUT_PAGE_INVALID) ||
+			 ((fifo_lut_page != (DataQ_LUT_Page_t *) 0) && (fifo_lut_page != fifo_log_page)) ) {
+			continue;
+		}
+
+		for ( entry = 0; entry < DATA_QUEUE_LUT_PAGE_ENTRIES; entry++ ) {
+			if ( (fifo_log_page->unlogged[ entry / 8 ] & (1 << (entry % 8))) == 0 ) {
+				continue;
+			}
+
+			/* the record is full, so more records follow for the same commit */
+			if ( fifo_record->slot_count == slot_max ) {
+				fifo_record->flags = JOURNAL_FLAGS_CONTINUED;
+				PSL_memcpy( &fifo_record->hdr, fifo_hdr, sizeof(DataQ_Hdr_t) );
+				if ( DataQ_WriteJournal( fifo_state, sizeof(DataQ_Journal_Record_t) + (fifo_record->slot_count * slot_size) ) != CODE_STATUS_OK ) {
+					return CODE_ERROR_FS_ACCESS_FAIL;
+				}
+				PSL_memset( fifo_record, 0, sizeof(DataQ_Journal_Record_t) );
+				slot = DataQ_JournalBuffer + sizeof(DataQ_Journal_Record_t);
+			}
+
+			lut_offs = fifo_log_page->first + entry;
+			PSL_memcpy( slot, &lut_offs, sizeof(uint32_t) );
+			PSL_memcpy( slot + sizeof(uint32_t), fifo_log_page->entries + (entry * fifo_state->lut_entry_size), fifo_state->lut_entry_size );
+			slot += slot_size;
+			fifo_record->slot_count++;
+		}
+	}
+
+	/* write the last record, holding the header */
+	fifo_record->flags = flags;
+	PSL_memcpy( &fifo_record->hdr, fifo_hdr, sizeof(DataQ_Hdr_t) );
+	if ( DataQ_WriteJournal( fifo_state, sizeof(DataQ_Journal_Record_t) + (fifo_record->slot_count * slot_size) ) != CODE_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* the changed LUT entries are journaled */
+	for ( index = 0; index < DATA_QUEUE_LUT_PAGE_COUNT; index++ ) {
+		if ( (fifo_lut_page == (DataQ_LUT_Page_t *) 0) || (fifo_lut_page == &fifo_state->lut_pages[index]) ) {
+			PSL_memset( fifo_state->lut_pages[index].unlogged, 0, sizeof(fifo_state->lut_pages[index].unlogged) );
+		}
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Journals a cached LUT page ahead of the commit in progress.
+ *
+ *  This function journals the LUT entries of the specified cached page
+ *  changed since they were last journaled, in records flagged as
+ *  continued (which are only replayed along with the last record of
+ *  the commit they belong to), so the page can be dropped from the
+ *  cache of a data queue created with the metadata journal flag
+ *  without its changes reaching the LUT file. The changes committed so
+ *  far are checkpointed before the first page is journaled ahead of a
+ *  commit (unless operations await their commit under the durability
+ *  policy), so the commit has the whole ring of records, which must
+ *  keep room for the rest of the commit and for its checkpoint record:
+ *  if it does not, the commit is too large for the journal and fails.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fifo_lut_page - the reference of the cached page
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_LogLUTPage( DataQ_State_t * fifo_state, DataQ_LUT_Page_t * fifo_lut_page )
+{
+	uint32_t slot_max = DATAQ_JOURNAL_SLOT_MAX( fifo_state );
+	uint32_t records = (DataQ_CountUnlogged( fifo_state, fifo_lut_page ) + slot_max - 1) / slot_max;
+	uint32_t records_max = DATAQ_JOURNAL_COMMIT_MAX( fifo_state );
+	int dataq_status = CODE_STATUS_OK;
+
+	PSL_MutexLock( &DataQ_JournalMutex );
+
+	/* leave the whole ring to the commit by checkpointing the changes
+	 * committed so far (which the cached header holds as long as no
+	 * operation awaits its commit) */
+	if ( (fifo_state->journal_records > 1) &&
+		 (fifo_state->journal_continued == 0) &&
+		 (fifo_state->pending_ops == 0) ) {
+		dataq_status = DataQ_CheckpointJournal( fifo_state, &fifo_state->hdr );
+	}
+
+	/* the records of the page (and the rest of the commit) must not
+	 * overwrite the records written since the last checkpoint */
+	if ( (dataq_status == CODE_STATUS_OK) &&
+		 ((fifo_state->journal_records + records + records_max) > DATA_QUEUE_JOURNAL_RECORD_COUNT) ) {
+		dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	if ( dataq_status == CODE_STATUS_OK ) {
+		dataq_status = DataQ_LogLUTPages( fifo_state, &fifo_state->hdr, fifo_lut_page, JOURNAL_FLAGS_CONTINUED );
+		if ( dataq_status == CODE_STATUS_OK ) {
+			fifo_state->journal_continued += records;
+		}
+	}
+
+	/* the next commit cannot rely on the records written so far */
+	if ( dataq_status != CODE_STATUS_OK ) {
+		fifo_state->journal_checkpoint = 1;
+	}
+
+	PSL_MutexUnlock( &DataQ_JournalMutex );
+
+	return dataq_status;
+}
+
+/** @brief Retrieves a cached LUT entry.
+ *
+ *  This function returns the location of the specified LUT entry
+ *  within the cached LUT. If no cached page holds the LUT entry, the
+ *  least recently used page is reused (after committing the changed
+ *  entries, if any) and filled from the LUT file. The changed entries
+ *  of a page of a data queue created with the metadata journal flag
+ *  never reach the LUT file before they are journaled: they are
+ *  journaled ahead of the commit in progress instead, and the page is
+ *  filled again from the LUT file and the journal until the next
+ *  checkpoint. The location is only valid until the next LUT entry is
+ *  retrieved.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] lut_offs - the offset of the LUT entry
+ *
+ *  @param[in] dirty - non-zero if the LUT entry is to be changed,
+ *                     so that it is written back on the next commit
+ *
+ *  @param[out] fifo_lut_entry - the reference where the location of
+ *                               the cached LUT entry is set
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_GetLUTEntry( DataQ_State_t * fifo_state, uint32_t lut_offs, int dirty, uint8_t ** fifo_lut_entry )
+{
+	FSAL_File_t fsal_handle = -1;
+	DataQ_LUT_Page_t * fifo_lut_page = (DataQ_LUT_Page_t *) 0;
+	uint32_t page_first = lut_offs - (lut_offs % DATA_QUEUE_LUT_PAGE_ENTRIES);
+	uint32_t page_entries = DATA_QUEUE_LUT_PAGE_ENTRIES;
+	int index;
+
+	/* look for the cached page holding the LUT entry, keeping track of
+	 * the least recently used page in case none does (preferring the
+	 * pages whose changed entries are all journaled already) */
+	for ( index = 0; index < DATA_QUEUE_LUT_PAGE_COUNT; index++ ) {
+		if ( fifo_state->lut_pages[index].first == page_first ) {
+			fifo_lut_page = &fifo_state->lut_pages[index];
+			break;
+		}
+		if ( (fifo_lut_page == (DataQ_LUT_Page_t *) 0) ||
+			 (DataQ_IsPageUnlogged( fifo_state, fifo_lut_page ) > DataQ_IsPageUnlogged( fifo_state, &fifo_state->lut_pages[index] )) ||
+			 ((DataQ_IsPageUnlogged( fifo_state, fifo_lut_page ) == DataQ_IsPageUnlogged( fifo_state, &fifo_state->lut_pages[index] )) &&
+			  (fifo_state->lut_pages[index].last_used < fifo_lut_page->last_used)) ) {
+			fifo_lut_page = &fifo_state->lut_pages[index];
+		}
+	}
+
+	if ( fifo_lut_page->first == page_first ) {
+		DATAQ_STATS_COUNT( lut_cache_hits );
+	} else {
+		DATAQ_STATS_COUNT( lut_cache_misses );
+
+		if ( (fifo_state->hdr.flags & FLAGS_METADATA_JOURNAL) && (fifo_state->read_only == 0) ) {
+
+			/* journal the changed entries of the page not journaled yet
+			 * and drop the page, leaving the LUT file to the next checkpoint */
+			if ( DataQ_IsPageUnlogged( fifo_state, fifo_lut_page ) &&
+				 (DataQ_LogLUTPage( fifo_state, fifo_lut_page ) != CODE_STATUS_OK) ) {
+				return CODE_ERROR_FS_ACCESS_FAIL;
+			}
+			if ( DataQ_IsPageDirty( fifo_lut_page ) ) {
+				fifo_state->journal_deferred = 1;
+			}
+			PSL_memset( fifo_lut_page->dirty, 0, sizeof(fifo_lut_page->dirty) );
+
+		/* commit the changed entries before the page is reused */
+		} else {
+			PSL_memset( fifo_lut_page->unlogged, 0, sizeof(fifo_lut_page->unlogged) );
+			if ( (fifo_lut_page->first != DATAQ_LUT_PAGE_INVALID) &&
+				 (DataQ_StoreLUT( fifo_state ) != CODE_STATUS_OK) ) {
+				return CODE_ERROR_FS_ACCESS_FAIL;
+			}
+		}
+
+		/* the last page may be cut short by the end of the LUT */
+		if ( (fifo_state->hdr.max_entries - page_first) < page_entries ) {
+			page_entries = fifo_state->hdr.max_entries - page_first;
+		}
+
+		/* fill the page from the LUT file associated with the fifo (or from
+		 * its mapping, which only holds committed changes) */
+		fifo_lut_page->first = DATAQ_LUT_PAGE_INVALID;
+		PSL_memset( fifo_lut_page->entries, 0, sizeof(fifo_lut_page->entries) );
+		if ( fifo_state->lut_map != (uint8_t *) 0 ) {
+			PSL_memcpy( fifo_lut_page->entries, fifo_state->lut_map + ((size_t) page_first * fifo_state->lut_entry_size), page_entries * fifo_state->lut_entry_size );
+		} else if ( (FSAL_OpenDirFile(fifo_state->dir, ".lut", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+			 (FSAL_ReadFileAt(fsal_handle, (size_t) page_first * fifo_state->lut_entry_size, fifo_lut_page->entries, page_entries * fifo_state->lut_entry_size) < 0) ||
+			 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+			/* file system access error */
+			if ( fsal_handle != -1 )
+				FSAL_CloseFile( fsal_handle );
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+		fifo_lut_page->first = page_first;
+
+		/* the changes still journaled only are applied over the LUT file */
+		if ( (fifo_state->read_only || fifo_state->journal_deferred) &&
+			 (DataQ_OverlayJournal( fifo_state, fifo_lut_page, page_entries ) != CODE_STATUS_OK) ) {
+			fifo_lut_page->first = DATAQ_LUT_PAGE_INVALID;
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+	}
+
+	/* keep the most recently used pages cached */
+	fifo_lut_page->last_used = ++fifo_state->lut_clock;
+
+	/* flag the LUT entry so that it is written back (and journaled) on the next commit */
+	index = lut_offs - page_first;
+	if ( dirty ) {
+		fifo_lut_page->dirty[ index / 8 ] |= (uint8_t)(1 << (index % 8));
+		fifo_lut_page->unlogged[ index / 8 ] |= (uint8_t)(1 << (index % 8));
+	}
+
+	*fifo_lut_entry = fifo_lut_page->entries + (index * fifo_state->lut_entry_size);
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Retrieves a cached LUT entry as a LUT record.
+ *
+ *  This function copies the specified LUT entry out of the cached LUT
+ *  into a LUT record whatever the LUT version of the data queue is.
+ *  The fields a legacy LUT entry does not keep are cleared, so the
+ *  version of such a record is always the legacy LUT version (and
+ *  its length is only known in segmented storage mode). The record
+ *  of a data queue created with the fixed record flag is made up
+ *  from the LUT offset, as such a data queue keeps no LUT.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] lut_offs - the offset of the LUT entry
+ *
+ *  @param[out] fifo_lut_record - the reference where the LUT record
+ *                                is copied
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_GetLUTRecord( DataQ_State_t * fifo_state, uint32_t lut_offs, DataQ_LUT_Record_t * fifo_lut_record )
+{
+	DataQ_LUT_Segment_t fifo_lut_segment;
+	uint8_t * fifo_lut_entry;
+
+	/* a fixed record is located by its LUT offset alone (and keeps
+	 * neither its size, which is the record size, nor its CRC32) */
+	if ( fifo_state->hdr.flags & FLAGS_FIXED_RECORD ) {
+		PSL_memset( fifo_lut_record, 0, sizeof(DataQ_LUT_Record_t) );
+		fifo_lut_record->version = LUT_VERSION_LEGACY;
+		fifo_lut_record->offset = lut_offs * DATAQ_RECORD_SIZE( &fifo_state->hdr );
+		fifo_lut_record->length = DATAQ_RECORD_SIZE( &fifo_state->hdr );
+		return CODE_STATUS_OK;
+	}
+
+	if ( DataQ_GetLUTEntry( fifo_state, lut_offs, 0, &fifo_lut_entry ) != CODE_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* the LUT entry is already a LUT record */
+	if ( fifo_state->hdr.lut_version != LUT_VERSION_LEGACY ) {
+		PSL_memcpy( fifo_lut_record, fifo_lut_entry, sizeof(DataQ_LUT_Record_t) );
+		return CODE_STATUS_OK;
+	}
+
+	/* convert the legacy LUT entry of the storage mode */
+	PSL_memset( fifo_lut_record, 0, sizeof(DataQ_LUT_Record_t) );
+	if ( fifo_state->hdr.flags & FLAGS_SEGMENTED_STORAGE ) {
+		PSL_memcpy( &fifo_lut_segment, fifo_lut_entry, sizeof(DataQ_LUT_Segment_t) );
+		fifo_lut_record->segment = fifo_lut_segment.segment;
+		fifo_lut_record->offset = fifo_lut_segment.offset;
+		fifo_lut_record->length = fifo_lut_segment.length;
+	} else {
+		PSL_memcpy( fifo_lut_record->reference, fifo_lut_entry, DATA_QUEUE_LUT_ENTRY_SIZE );
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Sets a cached LUT entry from a LUT record.
+ *
+ *  This function copies the LUT record into the specified LUT entry
+ *  of the cached LUT (keeping only the fields a legacy LUT entry
+ *  has, if the data queue was created with the legacy LUT version)
+ *  and marks the LUT entry as changed. Nothing is kept for a data
+ *  queue created with the fixed record flag.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] lut_offs - the offset of the LUT entry
+ *
+ *  @param[in] fifo_lut_record - the reference of the LUT record
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_SetLUTRecord( DataQ_State_t * fifo_state, uint32_t lut_offs, DataQ_LUT_Record_t * fifo_lut_record )
+{
+	DataQ_LUT_Segment_t fifo_lut_segment;
+	uint8_t * fifo_lut_entry;
+
+	/* there is no LUT entry to keep a fixed record in */
+	if ( fifo_state->hdr.flags & FLAGS_FIXED_RECORD ) {
+		return CODE_STATUS_OK;
+	}
+
+	if ( DataQ_GetLUTEntry( fifo_state, lut_offs, 1, &fifo_lut_entry ) != CODE_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	if ( fifo_state->hdr.lut_version != LUT_VERSION_LEGACY ) {
+		PSL_memcpy( fifo_lut_entry, fifo_lut_record, sizeof(DataQ_LUT_Record_t) );
+	} else if ( fifo_state->hdr.flags & FLAGS_SEGMENTED_STORAGE ) {
+		fifo_lut_segment.segment = fifo_lut_record->segment;
+		fifo_lut_segment.offset = fifo_lut_record->offset;
+		fifo_lut_segment.length = fifo_lut_record->length;
+		PSL_memcpy( fifo_lut_entry, &fifo_lut_segment, sizeof(DataQ_LUT_Segment_t) );
+	} else {
+		PSL_memcpy( fifo_lut_entry, fifo_lut_record->reference, DATA_QUEUE_LUT_ENTRY_SIZE );
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Packs the length of a run beyond its 4-bit field.
+ *
+ *  This function appends the part of the length of a run of literals
+ *  or of a match that does not fit into its field of the token of a
+ *  sequence (of 15 or more), as a series of bytes which are added up
+ *  and ended by a byte below 255.
+ *
+ *  @param[out] packed - the reference of the packed data
+ *
+ *  @param[in] packed_size - the size of the packed data so far
+ *
+ *  @param[in] packed_max - the maximum size of the packed data
+ *
+ *  @param[in] length - the part of the length beyond the field
+ *
+ *  @return size_t - the size of the packed data, or zero if it
+ *                   would exceed the maximum size
+ */
+static size_t DataQ_PackLength( uint8_t * packed, size_t packed_size, size_t packed_max, size_t length )
+{
+	while ( length >= 255 ) {
+		if ( packed_size >= packed_max ) {
+			return 0;
+		}
+		packed[packed_size++] = 255;
+		length -= 255;
+	}
+	if ( packed_size >= packed_max ) {
+		return 0;
+	}
+	packed[packed_size++] = (uint8_t) length;
+
+	return packed_size;
+}
+
+/** @brief Packs a sequence of literals followed by a match.
+ *
+ *  This function appends a sequence to the packed data: a token with
+ *  the length of the literals (upper 4 bits) and of the match minus
+ *  its minimum length (lower 4 bits), the rest of the length of the
+ *  literals, the literals, and then the offset of the match back into
+ *  the unpacked data (16 bits, little endian) and the rest of its
+ *  length, unless the sequence is the last one (with no match).
+ *
+ *  @param[out] packed - the reference of the packed data
+ *
+ *  @param[in] packed_size - the size of the packed data so far
+ *
+ *  @param[in] packed_max - the maximum size of the packed data
+ *
+ *  @param[in] literals - the reference of the literals
+ *
+ *  @param[in] literal_length - the number of literals
+ *
+ *  @param[in] match_length - the length of the match (or zero for
+ *                            the last sequence)
+ *
+ *  @param[in] match_offset - the offset of the match
+ *
+ *  @return size_t - the size of the packed data, or zero if it
+ *                   would exceed the maximum size
+ */
+static size_t DataQ_PackSequence( uint8_t * packed, size_t packed_size, size_t packed_max, const uint8_t * literals,
+								  size_t literal_length, size_t match_length, size_t match_offset )
+{
+	size_t token = packed_size++;
+
+	if ( packed_size > packed_max ) {
+		return 0;
+	}
+	packed[token] = (uint8_t) (((literal_length < 15) ? literal_length : 15) << 4);
+	if ( (literal_length >= 15) &&
+		 ((packed_size = DataQ_PackLength( packed, packed_size, packed_max, literal_length - 15 )) == 0) ) {
+		return 0;
+	}
+
+	/* copy the literals as they are */
+	if ( literal_length > (packed_max - packed_size) ) {
+		return 0;
+	}
+	PSL_memcpy( &packed[packed_size], literals, literal_length );
+	packed_size += literal_length;
+
+	if ( match_length != 0 ) {
+
+		/* refer back to the match */
+		match_length -= DATAQ_PACK_MATCH_MIN;
+		packed[token] |= (uint8_t) ((match_length < 15) ? match_length : 15);
+		if ( (packed_max - packed_size) < 2 ) {
+			return 0;
+		}
+		packed[packed_size++] = (uint8_t) (match_offset & 0xFF);
+		packed[packed_size++] = (uint8_t) (match_offset >> 8);
+		if ( (match_length >= 15) &&
+			 ((packed_size = DataQ_PackLength( packed, packed_size, packed_max, match_length - 15 )) == 0) ) {
+			return 0;
+		}
+	}
+
+	return packed_size;
+}
+
+/** @brief Packs the data of an entry.
+ *
+ *  This function encodes the data of an entry with a byte-oriented
+ *  LZ77 codec of the LZ4 family: the size of the data (as a base-128
+ *  varint) followed by sequences of literals and matches of at least
+ *  4 bytes found back in the data through a small hash table of the
+ *  positions of the last 4-byte strings seen (matches are searched
+ *  greedily, so the codec favours speed and a small footprint over
+ *  the ratio, which suits the repetitive layout of most entries).
+ *  The caller holds the mutex of the packing buffer, whose hash table
+ *  is used.
+ *
+ *  @param[in] data - the reference of the data to be packed
+ *
+ *  @param[in] size - the size of the data to be packed (at most
+ *                    65535 bytes)
+ *
+ *  @param[out] packed - the reference where the packed data is set
+ *
+ *  @param[in] packed_max - the maximum size of the packed data
+ *
+ *  @return size_t - the size of the packed data, or zero if it
+ *                   would exceed the maximum size
+ */
+static size_t DataQ_PackEntry( const uint8_t * data, size_t size, uint8_t * packed, size_t packed_max )
+{
+	size_t packed_size = 0;
+	size_t position = 0;
+	size_t anchor = 0;
+	size_t candidate;
+	size_t match_length;
+	size_t value = size;
+	uint32_t hash;
+
+	/* the unpacked size leads the packed data */
+	do {
+		if ( packed_size >= packed_max ) {
+			return 0;
+		}
+		packed[packed_size++] = (uint8_t) ((value & 0x7F) | ((value > 0x7F) ? 0x80 : 0));
+		value >>= 7;
+	} while ( value != 0 );
+
+	PSL_memset( DataQ_PackTable, 0, sizeof(DataQ_PackTable) );
+	while ( (position + DATAQ_PACK_MATCH_MIN) <= size ) {
+
+		/* look up the last position of the string at the current one */
+		hash = DATAQ_PACK_HASH( &data[position] );
+		candidate = DataQ_PackTable[hash];
+		DataQ_PackTable[hash] = (uint16_t) position;
+		if ( (candidate >= position) ||
+			 (DATAQ_PACK_READ32( &data[candidate] ) != DATAQ_PACK_READ32( &data[position] )) ) {
+			position++;
+			continue;
+		}
+
+		/* extend the match as far as it goes */
+		match_length = DATAQ_PACK_MATCH_MIN;
+		while ( ((position + match_length) < size) && (data[candidate + match_length] == data[position + match_length]) ) {
+			match_length++;
+		}
+
+		packed_size = DataQ_PackSequence( packed, packed_size, packed_max, &data[anchor], position - anchor, match_length, position - candidate );
+		if ( packed_size == 0 ) {
+			return 0;
+		}
+		position += match_length;
+		anchor = position;
+	}
+
+	/* the last literals end the packed data */
+	return DataQ_PackSequence( packed, packed_size, packed_max, &data[anchor], size - anchor, 0, 0 );
+}
+
+/** @brief Unpacks the length of a run beyond its 4-bit field.
+ *
+ *  This function adds up the bytes which follow a field of the token
+ *  of a sequence set to 15 (see DataQ_PackLength).
+ *
+ *  @param[in] packed - the reference of the packed data
+ *
+ *  @param[in] packed_size - the size of the packed data
+ *
+ *  @param[in,out] index - the reference of the position within the
+ *                         packed data, which is moved past the bytes
+ *
+ *  @param[in,out] length - the reference of the length, to which the
+ *                          bytes are added
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ */
+static int DataQ_UnpackLength( const uint8_t * packed, size_t packed_size, size_t * index, size_t * length )
+{
+	uint8_t value;
+
+	do {
+		if ( *index >= packed_size ) {
+			return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+		}
+		value = packed[(*index)++];
+		*length += value;
+	} while ( value == 255 );
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Unpacks the data of an entry.
+ *
+ *  This function decodes the data of an entry packed by
+ *  DataQ_PackEntry, checking every length and offset against the
+ *  bounds of the packed and unpacked data so that corrupt packed
+ *  data is never decoded past them.
+ *
+ *  @param[in] packed - the reference of the packed data
+ *
+ *  @param[in] packed_size - the size of the packed data
+ *
+ *  @param[out] data - the reference where the data is to be copied
+ *
+ *  @param[in,out] size - the reference of the maximum size that can
+ *                        be copied, which is then set to the size of
+ *                        the entry
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ */
+static int DataQ_UnpackEntry( const uint8_t * packed, size_t packed_size, void * data, size_t * size )
+{
+	uint8_t * bytes = (uint8_t *) data;
+	size_t unpacked_size = 0;
+	size_t index = 0;
+	size_t length;
+	size_t offset;
+	size_t position = 0;
+	uint8_t token;
+	int shift;
+
+	/* the unpacked size leads the packed data */
+	for ( shift = 0; ; shift += 7 ) {
+		if ( (index >= packed_size) || (shift > 28) ) {
+			return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+		}
+		unpacked_size |= (size_t) (packed[index] & 0x7F) << shift;
+		if ( (packed[index++] & 0x80) == 0 ) {
+			break;
+		}
+	}
+
+	/* size the caller's buffer up front */
+	if ( *size < unpacked_size ) {
+		*size = unpacked_size;
+		return CODE_ERROR_BUFFER_TOO_SMALL;
+	}
+
+	for ( ;; ) {
+		if ( index >= packed_size ) {
+			return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+		}
+		token = packed[index++];
+
+		/* copy the literals */
+		length = token >> 4;
+		if ( (length == 15) && (DataQ_UnpackLength( packed, packed_size, &index, &length ) != CODE_STATUS_OK) ) {
+			return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+		}
+		if ( (length > (packed_size - index)) || (length > (unpacked_size - position)) ) {
+			return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+		}
+		PSL_memcpy( &bytes[position], &packed[index], length );
+		index += length;
+		position += length;
+
+		/* the last sequence has no match */
+		if ( position == unpacked_size ) {
+			break;
+		}
+
+		/* copy the match (byte by byte, as it may overlap itself) */
+		if ( (packed_size - index) < 2 ) {
+			return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+		}
+		offset = packed[index] | ((size_t) packed[index + 1] << 8);
+		index += 2;
+		length = token & 15;
+		if ( (length == 15) && (DataQ_UnpackLength( packed, packed_size, &index, &length ) != CODE_STATUS_OK) ) {
+			return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+		}
+		length += DATAQ_PACK_MATCH_MIN;
+		if ( (offset == 0) || (offset > position) || (length > (unpacked_size - position)) ) {
+			return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+		}
+		while ( length-- > 0 ) {
+			bytes[position] = bytes[position - offset];
+			position++;
+		}
+	}
+
+	/* nothing is to follow the last sequence */
+	if ( index != packed_size ) {
+		return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+	}
+
+	/* set the size of the unpacked data */
+	*size = unpacked_size;
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Unmaps the metadata of a data queue from memory.
+ *
+ *  This function waits for the header and LUT mappings of the data
+ *  queue, if any, to be written back to their files (unless the msync
+ *  policy is to leave it to the filesystem) and unmaps them.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_UnmapState( DataQ_State_t * fifo_state )
+{
+	int dataq_status = CODE_STATUS_OK;
+
+	if ( fifo_state->hdr_map != (uint8_t *) 0 ) {
+		if ( ((DATA_QUEUE_MSYNC_POLICY != MSYNC_POLICY_NONE) &&
+			  (DataQ_SyncMap( fifo_state->hdr_map, fifo_state->hdr_map_size, FSAL_SYNC_WAIT ) != CODE_STATUS_OK)) ||
+			 (FSAL_UnmapFile( fifo_state->hdr_map, 0, fifo_state->hdr_map_size ) != FSAL_STATUS_OK) ) {
+			dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+		}
+		fifo_state->hdr_map = (uint8_t *) 0;
+	}
+
+	if ( fifo_state->lut_map != (uint8_t *) 0 ) {
+		if ( ((DATA_QUEUE_MSYNC_POLICY != MSYNC_POLICY_NONE) &&
+			  (DataQ_SyncMap( fifo_state->lut_map, fifo_state->lut_map_size, FSAL_SYNC_WAIT ) != CODE_STATUS_OK)) ||
+			 (FSAL_UnmapFile( fifo_state->lut_map, 0, fifo_state->lut_map_size ) != FSAL_STATUS_OK) ) {
+			dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+		}
+		fifo_state->lut_map = (uint8_t *) 0;
+	}
+
+	return dataq_status;
+}
+
+/** @brief Maps the metadata of a data queue into memory.
+ *
+ *  This function maps the header (or metadata) file and the LUT file
+ *  of the data queue into memory, so that the cached state is filled
+ *  from and committed to the mappings instead of reading and writing
+ *  the files (the cached LUT pages keep the changes not committed yet,
+ *  so that they are dropped as usual when an operation fails). It
+ *  does nothing unless the library is built with mapped metadata
+ *  and the filesystem supports files mapped for writing, in which
+ *  case the files keep being read and written as usual (as they
+ *  are for a data queue created with the metadata journal flag).
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_MapState( DataQ_State_t * fifo_state )
+{
+#if defined( DATA_QUEUE_MAPPED_METADATA )
+	FSAL_File_t fsal_handle = -1;
+
+	/* the metadata journal is written instead of the header and LUT files */
+	if ( fifo_state->hdr.flags & FLAGS_METADATA_JOURNAL ) {
+		return CODE_STATUS_OK;
+	}
+
+	/* map the header (or metadata) file associated with the fifo */
+	if ( (FSAL_ListDirFile(fifo_state->dir, ".header", &fifo_state->hdr_map_size) == FSAL_ERROR_FILE_ACCESS) ||
+		 (FSAL_OpenDirFile(fifo_state->dir, ".header", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+		 (FSAL_MapFileWritable(fsal_handle, 0, fifo_state->hdr_map_size, &fifo_state->hdr_map) != FSAL_STATUS_OK) ||
+		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+		/* keep reading and writing the files */
+		if ( fsal_handle != -1 )
+			FSAL_CloseFile( fsal_handle );
+		DataQ_UnmapState( fifo_state );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* map the LUT file associated with the fifo (if it keeps one) */
+	fsal_handle = -1;
+	if ( fifo_state->hdr.flags & FLAGS_FIXED_RECORD ) {
+		return CODE_STATUS_OK;
+	}
+	if ( (FSAL_ListDirFile(fifo_state->dir, ".lut", &fifo_state->lut_map_size) == FSAL_ERROR_FILE_ACCESS) ||
+		 (fifo_state->lut_map_size < ((size_t) fifo_state->hdr.max_entries * fifo_state->lut_entry_size)) ||
+		 (FSAL_OpenDirFile(fifo_state->dir, ".lut", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+		 (FSAL_MapFileWritable(fsal_handle, 0, fifo_state->lut_map_size, &fifo_state->lut_map) != FSAL_STATUS_OK) ||
+		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+		/* keep reading and writing the files */
+		if ( fsal_handle != -1 )
+			FSAL_CloseFile( fsal_handle );
+		DataQ_UnmapState( fifo_state );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+#endif /* DATA_QUEUE_MAPPED_METADATA */
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Commits the metadata of a data queue through its journal.
+ *
+ *  This function commits the specified header along with the cached
+ *  LUT entries changed since the last record by writing them into
+ *  the journal of a data queue created with the metadata journal
+ *  flag, in as many records as they need (all but the last one of
+ *  them flagged as continued, so that the commit is only replayed
+ *  once its last record is written, along with the records journaled
+ *  ahead of it as changed pages were dropped from the cache). A checkpoint is then made if
+ *  a checkpoint is due or if the ring of records would no longer
+ *  keep room for the records of the largest commit (and for its
+ *  checkpoint record) after this one, so the LUT and header files
+ *  are only ever written with changes already journaled. If it
+ *  succeeds, the cached header is updated with the specified header.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fifo_hdr - the reference of the header to commit
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_StoreJournal( DataQ_State_t * fifo_state, DataQ_Hdr_t * fifo_hdr )
+{
+	uint32_t slot_max = DATAQ_JOURNAL_SLOT_MAX( fifo_state );
+	uint32_t slot_count = DataQ_CountUnlogged( fifo_state, (DataQ_LUT_Page_t *) 0 );
+	uint32_t records_max = DATAQ_JOURNAL_COMMIT_MAX( fifo_state );
+	uint32_t records;
+	int checkpoint;
+
+	/* the changes take as many records as they need (one at least, for the header) */
+	records = (slot_count == 0) ? 1 : ((slot_count + slot_max - 1) / slot_max);
+	checkpoint = (fifo_state->journal_checkpoint != 0) ||
+				 ((fifo_state->journal_records + records + records_max) > DATA_QUEUE_JOURNAL_RECORD_COUNT);
+
+	/* the records of this commit (and its checkpoint record) must not
+	 * overwrite the records written since the last checkpoint */
+	if ( (fifo_state->journal_records + records + checkpoint) > DATA_QUEUE_JOURNAL_RECORD_COUNT ) {
+		fifo_state->journal_checkpoint = 1;
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* journal the LUT entries changed since the last record */
+	if ( DataQ_LogLUTPages( fifo_state, fifo_hdr, (DataQ_LUT_Page_t *) 0, 0 ) != CODE_STATUS_OK ) {
+
+		/* the next commit cannot rely on the records written so far */
+		fifo_state->journal_checkpoint = 1;
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* the records journaled ahead of the commit are committed along with it */
+	fifo_state->journal_continued = 0;
+
+	/* the committed changes can now reach the LUT and header files */
+	if ( checkpoint && (DataQ_CheckpointJournal( fifo_state, fifo_hdr ) != CODE_STATUS_OK) ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* keep the cached header in sync with the journal */
+	if ( fifo_hdr != &fifo_state->hdr ) {
+		PSL_memcpy( &fifo_state->hdr, fifo_hdr, sizeof(DataQ_Hdr_t) );
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Replays the metadata journal of a data queue.
+ *
+ *  This function looks for the newest valid record of the journal
+ *  file of a data queue created with the metadata journal flag that
+ *  ends a commit (the records of a commit cut short by a power loss
+ *  are left out) and walks back to the last checkpoint (or as far as
+ *  the records follow each other), then applies the records from
+ *  there on: the changed LUT entries are written into the LUT file
+ *  and the header of the newest record replaces the cached header.
+ *  Unless the newest record is a checkpoint, a checkpoint is then
+ *  made, so that the whole ring of records is left to the next
+ *  commits. Replaying the same records again leaves the same files,
+ *  so a replay interrupted by a power loss is simply made again. A
+ *  handle with read-only access writes nothing: the changed LUT
+ *  entries are applied to the cached LUT pages as they are filled
+ *  (see DataQ_OverlayJournal) and no checkpoint is made.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_ReplayJournal( DataQ_State_t * fifo_state )
+{
+	FSAL_File_t fsal_handle = -1;
+	FSAL_File_t fsal_lut_handle = -1;
+	DataQ_Journal_Record_t * fifo_record = (DataQ_Journal_Record_t *) DataQ_JournalBuffer;
+	uint32_t sequences[ DATA_QUEUE_JOURNAL_RECORD_COUNT ];
+	uint16_t flags[ DATA_QUEUE_JOURNAL_RECORD_COUNT ];
+	uint32_t newest = 0;
+	uint32_t oldest;
+	uint32_t sequence;
+	uint32_t lut_offs;
+	uint8_t * slot;
+	int dataq_status = CODE_STATUS_OK;
+	int index;
+
+	/* without any record, the next commit makes a checkpoint */
+	fifo_state->journal_sequence = 1;
+	fifo_state->journal_records = 0;
+	fifo_state->journal_checkpoint = 1;
+
+	/* a missing journal file holds no record */
+	if ( FSAL_OpenDirFile(fifo_state->dir, ".journal", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS ) {
+		return CODE_STATUS_OK;
+	}
+
+	/* scan the ring for the valid records and the newest of them */
+	for ( index = 0; index < DATA_QUEUE_JOURNAL_RECORD_COUNT; index++ ) {
+		sequences[index] = 0;
+		flags[index] = 0;
+		if ( DataQ_ReadJournal( fifo_state, fsal_handle, index ) == CODE_STATUS_OK ) {
+			sequences[index] = fifo_record->sequence;
+			flags[index] = fifo_record->flags;
+			if ( fifo_record->sequence > newest ) {
+				newest = fifo_record->sequence;
+			}
+		}
+	}
+
+	/* leave out the records of a commit whose last record was never written */
+	while ( (newest != 0) &&
+			(flags[ newest % DATA_QUEUE_JOURNAL_RECORD_COUNT ] & JOURNAL_FLAGS_CONTINUED) ) {
+		newest = ((newest > 1) && (sequences[ (newest - 1) % DATA_QUEUE_JOURNAL_RECORD_COUNT ] == (newest - 1))) ? (newest - 1) : 0;
+	}
+
+	if ( newest == 0 ) {
+		FSAL_CloseFile( fsal_handle );
+		return CODE_STATUS_OK;
+	}
+
+	/* walk back to the last checkpoint as long as the records follow each other */
+	oldest = newest;
+	while ( ((flags[ oldest % DATA_QUEUE_JOURNAL_RECORD_COUNT ] & JOURNAL_FLAGS_CHECKPOINT) == 0) &&
+			(oldest > 1) &&
+			(sequences[ (oldest - 1) % DATA_QUEUE_JOURNAL_RECORD_COUNT ] == (oldest - 1)) ) {
+		oldest--;
+	}
+
+	/* apply the records from the oldest one on */
+	for ( sequence = oldest; sequence <= newest; sequence++ ) {
+
+		if ( DataQ_ReadJournal( fifo_state, fsal_handle, sequence % DATA_QUEUE_JOURNAL_RECORD_COUNT ) != CODE_STATUS_OK ) {
+			dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+			break;
+		}
+
+		/* write the changed LUT entries into the LUT file (opened only once),
+		 * unless the handle only reads the data queue */
+		slot = DataQ_JournalBuffer + sizeof(DataQ_Journal_Record_t);
+		for ( index = 0; (index < fifo_record->slot_count) && (fifo_state->read_only == 0); index++ ) {
+			PSL_memcpy( &lut_offs, slot, sizeof(uint32_t) );
+			if ( ((fsal_lut_handle == -1) &&
+				  (FSAL_OpenDirFile(fifo_state->dir, ".lut", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE, &fsal_lut_handle) == FSAL_ERROR_FILE_ACCESS)) ||
+				 (lut_offs >= fifo_record->hdr.max_entries) ||
+				 (FSAL_WriteFileAt(fsal_lut_handle, (size_t) lut_offs * fifo_state->lut_entry_size, slot + sizeof(uint32_t), fifo_state->lut_entry_size) < 0) ) {
+				dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+				break;
+			}
+			slot += sizeof(uint32_t) + fifo_state->lut_entry_size;
+		}
+		if ( dataq_status != CODE_STATUS_OK ) {
+			break;
+		}
+
+		/* the header of the newest record describes the data queue */
+		PSL_memcpy( &fifo_state->hdr, &fifo_record->hdr, sizeof(DataQ_Hdr_t) );
+	}
+
+	/* done replaying the journal (the LUT file is synchronized before
+	 * the checkpoint relies on it, if the durability policy asks for it) */
+	if ( fsal_lut_handle != -1 ) {
+		if ( (dataq_status == CODE_STATUS_OK) &&
+			 (fifo_state->durability.type != DURABILITY_TYPE_DEFAULT) &&
+			 (FSAL_SyncFile(fsal_lut_handle) != FSAL_STATUS_OK) ) {
+			dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+		}
+		FSAL_CloseFile( fsal_lut_handle );
+	}
+	FSAL_CloseFile( fsal_handle );
+
+	/* carry on after the newest record (over the records left out) */
+	fifo_state->journal_sequence = newest + 1;
+	fifo_state->journal_records = newest - oldest + 1;
+	if ( flags[ oldest % DATA_QUEUE_JOURNAL_RECORD_COUNT ] & JOURNAL_FLAGS_CHECKPOINT ) {
+		fifo_state->journal_checkpoint = 0;
+	}
+
+	/* the records are applied to the cached LUT pages of a handle with
+	 * read-only access as they are filled */
+	if ( fifo_state->read_only ) {
+		fifo_state->journal_oldest = oldest;
+		return dataq_status;
+	}
+
+	/* the LUT file now holds the changes replayed, so restart the journal from there */
+	if ( (dataq_status == CODE_STATUS_OK) &&
+		 ((flags[ newest % DATA_QUEUE_JOURNAL_RECORD_COUNT ] & JOURNAL_FLAGS_CHECKPOINT) == 0) ) {
+		dataq_status = DataQ_CheckpointJournal( fifo_state, &fifo_state->hdr );
+	}
+
+	return dataq_status;
+}
+
+/** @brief Loads the metadata of a data queue into its cached state.
+ *
+ *  This function reads the header (or metadata) file from the
+ *  directory of the data queue into its cached state (converting a
+ *  header of the first version) and drops all the cached LUT pages,
+ *  which are then filled from the LUT file on demand, along with
+ *  any change not committed yet. The metadata journal, if any, is
+ *  then replayed.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_LoadState( DataQ_State_t * fifo_state )
+{
+	FSAL_File_t fsal_handle = -1;
+	int dataq_status;
+	FSAL_Dir_t fsal_dir = fifo_state->dir;
+	uint8_t * hdr_map = fifo_state->hdr_map;
+	size_t hdr_map_size = fifo_state->hdr_map_size;
+	uint8_t * lut_map = fifo_state->lut_map;
+	size_t lut_map_size = fifo_state->lut_map_size;
+	DataQ_Durability_t durability = fifo_state->durability;
+	uint32_t seek_lut_offs = fifo_state->seek_lut_offs;
+	int cursor_dirty = fifo_state->cursor_dirty;
+	int read_only = fifo_state->read_only;
+	uint8_t high_watermark = fifo_state->high_watermark;
+	uint8_t low_watermark = fifo_state->low_watermark;
+	char cursor[ DATAQ_CURSOR_FILE_NAME_MAX + 1 ];
+	DataQ_Hdr_v1_t fifo_hdr_v1;
+	ssize_t read_size;
+	int index;
+
+	/* start from a clean cache (but keep the directory, the mapped
+	 * metadata, the durability policy, the access, the cursor and the
+	 * watermarks of the fifo), dropping the changes not committed yet */
+	PSL_memcpy( cursor, fifo_state->cursor, sizeof(cursor) );
+	PSL_memset( fifo_state, 0, sizeof(DataQ_State_t) );
+	fifo_state->dir = fsal_dir;
+	fifo_state->durability = durability;
+	fifo_state->seek_lut_offs = seek_lut_offs;
+	fifo_state->cursor_dirty = cursor_dirty;
+	fifo_state->read_only = read_only;
+	fifo_state->high_watermark = high_watermark;
+	fifo_state->low_watermark = low_watermark;
+	PSL_memcpy( fifo_state->cursor, cursor, sizeof(cursor) );
+	fifo_state->hdr_map = hdr_map;
+	fifo_state->hdr_map_size = hdr_map_size;
+	fifo_state->lut_map = lut_map;
+	fifo_state->lut_map_size = lut_map_size;
+	for ( index = 0; index < DATA_QUEUE_LUT_PAGE_COUNT; index++ ) {
+		fifo_state->lut_pages[index].first = DATAQ_LUT_PAGE_INVALID;
+	}
+
+	if ( hdr_map != (uint8_t *) 0 ) {
+
+		/* the header file is mapped into memory */
+		read_size = (hdr_map_size < sizeof(DataQ_Hdr_t)) ? (ssize_t) hdr_map_size : (ssize_t) sizeof(DataQ_Hdr_t);
+		PSL_memcpy( &fifo_state->hdr, hdr_map, read_size );
+
+	/* open and read the header (or metadata) file associated with the fifo */
+	} else if ( (FSAL_OpenDirFile(fifo_state->dir, ".header", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+		 ((read_size = FSAL_ReadFile(fsal_handle, (uint8_t *)&fifo_state->hdr, sizeof(DataQ_Hdr_t))) < 0) ||
+		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+		/* file system access error */
+		if ( fsal_handle != -1 )
+			FSAL_CloseFile( fsal_handle );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* a header without the magic number is of the first version */
+	if ( (read_size != sizeof(DataQ_Hdr_t)) ||
+		 (fifo_state->hdr.magic != HDR_MAGIC) ) {
+
+		if ( read_size < sizeof(DataQ_Hdr_v1_t) ) {
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+
+		/* widen the header of the first version */
+		PSL_memcpy( &fifo_hdr_v1, &fifo_state->hdr, sizeof(DataQ_Hdr_v1_t) );
+		PSL_memset( &fifo_state->hdr, 0, sizeof(DataQ_Hdr_t) );
+		fifo_state->hdr.hdr_version = HDR_VERSION_1;
+		fifo_state->hdr.lut_version = fifo_hdr_v1.lut_version;
+		fifo_state->hdr.flags = fifo_hdr_v1.flags;
+		fifo_state->hdr.flash_size = fifo_hdr_v1.flash_size;
+		fifo_state->hdr.max_flash_size = fifo_hdr_v1.max_flash_size;
+		fifo_state->hdr.max_entry_size = fifo_hdr_v1.max_entry_size;
+		fifo_state->hdr.max_entries = fifo_hdr_v1.max_entries;
+		fifo_state->hdr.num_of_entries = fifo_hdr_v1.num_of_entries;
+		fifo_state->hdr.head_lut_offs = fifo_hdr_v1.head_lut_offs;
+		fifo_state->hdr.tail_lut_offs = fifo_hdr_v1.tail_lut_offs;
+		fifo_state->hdr.seek_lut_offs = fifo_hdr_v1.seek_lut_offs;
+		fifo_state->hdr.reference_count = fifo_hdr_v1.reference_count;
+	}
+
+	/* the LUT version and the storage mode determine the layout of the LUT file */
+	fifo_state->lut_entry_size = DataQ_GetLUTEntrySize( &fifo_state->hdr );
+
+	/* the metadata journal holds the changes committed since the last checkpoint */
+	if ( fifo_state->hdr.flags & FLAGS_METADATA_JOURNAL ) {
+		PSL_MutexLock( &DataQ_JournalMutex );
+		dataq_status = DataQ_ReplayJournal( fifo_state );
+		PSL_MutexUnlock( &DataQ_JournalMutex );
+		return dataq_status;
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Shares the cached state of a data queue opened for reading.
+ *
+ *  This function sets up the cached state of a new handle with
+ *  read-only access from the cached state of a handle of this process
+ *  already reading the same data queue: the header and the LUT pages
+ *  cached by that handle (along with the replayed journal records they
+ *  rely on) are taken over instead of being loaded and replayed again,
+ *  as the data queue does not change while it is opened for reading.
+ *  The directory, the mapped metadata, the durability policy, the
+ *  cursor and the watermarks of the new handle are left as they are.
+ *
+ *  @param[in] fifo_state - the reference of the new cached state
+ *
+ *  @param[in] fifo_shared_state - the reference of the cached state
+ *                                 of the handle already reading
+ *
+ *  @return none
+ */
+static void DataQ_ShareState( DataQ_State_t * fifo_state, DataQ_State_t * fifo_shared_state )
+{
+	PSL_memcpy( &fifo_state->hdr, &fifo_shared_state->hdr, sizeof(DataQ_Hdr_t) );
+	fifo_state->lut_entry_size = fifo_shared_state->lut_entry_size;
+	fifo_state->lut_clock = fifo_shared_state->lut_clock;
+	PSL_memcpy( fifo_state->lut_pages, fifo_shared_state->lut_pages, sizeof(fifo_state->lut_pages) );
+
+	/* nothing is committed through a handle with read-only access */
+	fifo_state->pending_ops = 0;
+	fifo_state->pending_since = 0;
+	fifo_state->pending_entries = 0;
+
+	fifo_state->journal_sequence = fifo_shared_state->journal_sequence;
+	fifo_state->journal_records = fifo_shared_state->journal_records;
+	fifo_state->journal_checkpoint = fifo_shared_state->journal_checkpoint;
+	fifo_state->journal_oldest = fifo_shared_state->journal_oldest;
+	fifo_state->journal_deferred = 0;
+	fifo_state->journal_continued = 0;
+}
+
+/** @brief Retrieves the LUT offset of the cursor of a data queue.
+ *
+ *  This function returns the LUT offset the 'seek' pointer (the
+ *  cursor) of the fifo handle is positioned at, or the LUT offset of
+ *  the 'head' end if the cursor no longer lies between the 'head'
+ *  and 'tail' ends (the entry it was positioned at was evicted).
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @return uint32_t - the LUT offset of the cursor
+ */
+static uint32_t DataQ_GetCursor( DataQ_State_t * fifo_state )
+{
+	DataQ_Hdr_t * fifo_hdr = &fifo_state->hdr;
+	uint32_t position;
+
+	/* position of the cursor in relative to the head offset */
+	position = (fifo_state->seek_lut_offs + fifo_hdr->max_entries - fifo_hdr->head_lut_offs) % fifo_hdr->max_entries;
+	if ( (fifo_state->seek_lut_offs >= fifo_hdr->max_entries) ||
+		 (position >= fifo_hdr->num_of_entries) ) {
+		return fifo_hdr->head_lut_offs;
+	}
+
+	return fifo_state->seek_lut_offs;
+}
+
+/** @brief Retrieves the reference count of the entry at the 'head'
+ *         end of a data queue.
+ *
+ *  This function returns the reference count the entry at the 'head'
+ *  end of the data queue was enqueued with (the entries in between
+ *  the 'head' and 'tail' ends are numbered consecutively), or the one
+ *  the next entry will be enqueued with if the data queue is empty.
+ *
+ *  @param[in] fifo_hdr - the reference of the header
+ *
+ *  @return uint32_t - the reference count of the head entry
+ */
+static uint32_t DataQ_GetHeadReference( DataQ_Hdr_t * fifo_hdr )
+{
+	return fifo_hdr->reference_count - fifo_hdr->num_of_entries + 1;
+}
+
+/** @brief Retrieves the reference count of an entry of a data queue.
+ *
+ *  This function returns the reference count the entry at the
+ *  specified LUT offset (in between the 'head' and 'tail' ends) was
+ *  enqueued with, counting on from the one of the head entry.
+ *
+ *  @param[in] fifo_hdr - the reference of the header
+ *
+ *  @param[in] lut_offs - the LUT offset of the entry
+ *
+ *  @return uint32_t - the reference count of the entry
+ */
+static uint32_t DataQ_GetEntryReference( DataQ_Hdr_t * fifo_hdr, uint32_t lut_offs )
+{
+	return DataQ_GetHeadReference( fifo_hdr ) +
+		(lut_offs + fifo_hdr->max_entries - fifo_hdr->head_lut_offs) % fifo_hdr->max_entries;
+}
+
+/** @brief Loads a named cursor of a data queue.
+ *
+ *  This function positions the cursor of the fifo handle at the
+ *  entry whose reference count is kept in the cursor file named in
+ *  the cached state. If the cursor file does not exist yet, or the
+ *  entry was evicted since the cursor was stored, the cursor is set
+ *  to the 'head' end of the data queue.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_LoadCursor( DataQ_State_t * fifo_state )
+{
+	FSAL_File_t fsal_handle = -1;
+	DataQ_Hdr_t * fifo_hdr = &fifo_state->hdr;
+	uint32_t reference_count;
+	uint32_t position;
+	size_t file_size;
+
+	/* a cursor not stored yet starts at the head end */
+	fifo_state->seek_lut_offs = fifo_hdr->head_lut_offs;
+	fifo_state->cursor_dirty = 0;
+	if ( FSAL_ListDirFile( fifo_state->dir, fifo_state->cursor, &file_size ) == FSAL_ERROR_FILE_ACCESS ) {
+		return CODE_STATUS_OK;
+	}
+
+	/* open and read the cursor file */
+	if ( (FSAL_OpenDirFile(fifo_state->dir, fifo_state->cursor, FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+		 (FSAL_ReadFile(fsal_handle, (uint8_t *)&reference_count, sizeof(reference_count)) != sizeof(reference_count)) ||
+		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+		/* file system access error */
+		if ( fsal_handle != -1 )
+			FSAL_CloseFile( fsal_handle );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* locate the entry in relative to the head entry (a header of the
+	 * first version only keeps 16 bits of the reference count) */
+	position = reference_count - DataQ_GetHeadReference( fifo_hdr );
+	if ( fifo_hdr->hdr_version == HDR_VERSION_1 ) {
+		position &= 0xFFFF;
+	}
+	if ( position < fifo_hdr->num_of_entries ) {
+		fifo_state->seek_lut_offs = (fifo_hdr->head_lut_offs + position) % fifo_hdr->max_entries;
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Stores a named cursor of a data queue.
+ *
+ *  This function writes the reference count of the entry the cursor
+ *  of the fifo handle is positioned at into the cursor file named in
+ *  the cached state, if the cursor moved since it was last stored
+ *  (a cursor that is not named is never stored), synchronizing the
+ *  cursor file if the durability policy asks for it.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_StoreCursor( DataQ_State_t * fifo_state )
+{
+	FSAL_File_t fsal_handle = -1;
+	DataQ_Hdr_t * fifo_hdr = &fifo_state->hdr;
+	uint32_t reference_count;
+
+	/* nothing to store */
+	if ( (fifo_state->cursor[0] == '\0') || (fifo_state->cursor_dirty == 0) ) {
+		return CODE_STATUS_OK;
+	}
+
+	/* the cursor is kept as the reference count of its entry, which
+	 * stays valid however far the head end moves in the meantime */
+	reference_count = DataQ_GetEntryReference( fifo_hdr, DataQ_GetCursor( fifo_state ) );
+
+	/* create or update the cursor file */
+	if ( (FSAL_OpenDirFile(fifo_state->dir, fifo_state->cursor, FSAL_FLAGS_BINARY | FSAL_FLAGS_CREATE | FSAL_FLAGS_WRITE_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+		 (FSAL_WriteFile(fsal_handle, (uint8_t *)&reference_count, sizeof(reference_count)) < 0) ||
+		 ((fifo_state->durability.type != DURABILITY_TYPE_DEFAULT) && (FSAL_SyncFile(fsal_handle) != FSAL_STATUS_OK)) ||
+		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+		/* file system access error */
+		if ( fsal_handle != -1 )
+			FSAL_CloseFile( fsal_handle );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	fifo_state->cursor_dirty = 0;
+	return CODE_STATUS_OK;
+}
+
+/** @brief Retrieves the file name associated with a LUT record.
+ *
+ *  This function copies, terminated, the file name of the entry
+ *  described by the LUT record: the hexadecimal digits of its 32-bit
+ *  reference count with the sequence LUT version, or its reference
+ *  string with any other LUT version.
+ *
+ *  @param[in] fifo_hdr - the reference of the header
+ *
+ *  @param[in] fifo_lut_record - the reference of the LUT record
+ *
+ *  @param[out] fifo_lut_entry_reference - the reference where the file
+ *                                         name of the entry is copied
+ *
+ *  @return none
+ */
+static void DataQ_GetReference( DataQ_Hdr_t * fifo_hdr, DataQ_LUT_Record_t * fifo_lut_record, char * fifo_lut_entry_reference )
+{
+	uint32_t reference_count;
+
+	if ( fifo_hdr->lut_version == LUT_VERSION_SEQUENCE ) {
+
+		/* convert the reference count kept by the LUT record into hexadecimal digits */
+		PSL_memcpy( &reference_count, fifo_lut_record->reference, sizeof(reference_count) );
+		for ( int index = 0; index < DATAQ_REFERENCE_SIZE_MAX; index++ ) {
+			fifo_lut_entry_reference[ DATAQ_REFERENCE_SIZE_MAX - index - 1] = "0123456789ABCDEF"[ (reference_count >> (index * 4)) & 0xF ];
+		}
+		fifo_lut_entry_reference[DATAQ_REFERENCE_SIZE_MAX] = '\0';
+		return;
+	}
+
+	/* copy the LUT record reference array and terminate to make it a string */
+	PSL_memcpy( fifo_lut_entry_reference, fifo_lut_record->reference, DATA_QUEUE_LUT_ENTRY_SIZE);
+	fifo_lut_entry_reference[DATA_QUEUE_LUT_ENTRY_SIZE] = '\0';
+}
+
+/** @brief Converts a reference count into a LUT record.
+ *
+ *  This function sets the reference of a LUT record from the
+ *  reference count (kept as it is with the sequence LUT version or
+ *  converted as a revolving reference string otherwise) and copies,
+ *  terminated, the file name associated with the entry.
+ *
+ *  @param[in] fifo_hdr - the reference of the header
+ *
+ *  @param[in] reference_count - the reference count of the entry
+ *
+ *  @param[out] fifo_lut_record - the reference of the LUT record
+ *
+ *  @param[out] fifo_lut_entry_reference - the reference where the file
+ *                                         name of the entry is copied
+ *
+ *  @return none
+ */
+static void DataQ_MakeReference( DataQ_Hdr_t * fifo_hdr, uint32_t reference_count, DataQ_LUT_Record_t * fifo_lut_record, char * fifo_lut_entry_reference )
+{
+	if ( fifo_hdr->lut_version == LUT_VERSION_SEQUENCE ) {
+
+		/* keep the whole reference count in the LUT record */
+		PSL_memcpy( fifo_lut_record->reference, &reference_count, sizeof(reference_count) );
+
+	} else {
+
+		/* set the LUT record reference by converting reference count  as a revolving reference string */
+		for ( int base10 = 1, index = 0; index < sizeof(fifo_lut_record->reference); base10 *= 10, index++ ) {
+			fifo_lut_record->reference[ DATA_QUEUE_LUT_ENTRY_SIZE - index - 1] = '0' + ((reference_count % (base10 * 10)) / base10);
+		}
+	}
+
+	/* copy the file name associated with the entry */
+	DataQ_GetReference( fifo_hdr, fifo_lut_record, fifo_lut_entry_reference );
+}
+
+/** @brief Converts a segment number into a segment file name.
+ *
+ *  This function builds the name of the file holding the specified
+ *  segment of a data queue created with the segmented storage flag.
+ *  The name is a fixed prefix followed by the segment number.
+ *
+ *  @param[in] segment - the segment number
+ *
+ *  @param[out] fifo_segment_reference - the reference where the file
+ *                                       name of the segment is copied
+ *
+ *  @return none
+ */
+static void DataQ_MakeSegmentReference( uint32_t segment, char * fifo_segment_reference )
+{
+	/* prefix the segment files so they never collide with the entry files */
+	fifo_segment_reference[0] = 'S';
+
+	/* convert the segment number into the remaining digits of the name */
+	for ( int base10 = 1, index = 0; index < DATA_QUEUE_LUT_ENTRY_SIZE - 1; base10 *= 10, index++ ) {
+		fifo_segment_reference[ DATA_QUEUE_LUT_ENTRY_SIZE - index - 1] = '0' + ((segment % (base10 * 10)) / base10);
+	}
+
+	/* terminate to make it a string */
+	fifo_segment_reference[DATA_QUEUE_LUT_ENTRY_SIZE] = '\0';
+}
+
+/** @brief Retrieves the name of the file shared by entries.
+ *
+ *  This function builds the name of the file holding the specified
+ *  LUT record of a data queue whose entries are kept at an offset
+ *  within a shared file: the ring file of a data queue created with
+ *  the fixed record flag, or otherwise the segment file of the entry.
+ *
+ *  @param[in] fifo_hdr - the reference of the header
+ *
+ *  @param[in] fifo_lut_record - the reference of the LUT record
+ *
+ *  @param[out] fifo_storage_reference - the reference where the file
+ *                                       name is copied
+ *
+ *  @return none
+ */
+static void DataQ_MakeStorageReference( DataQ_Hdr_t * fifo_hdr, DataQ_LUT_Record_t * fifo_lut_record, char * fifo_storage_reference )
+{
+	if ( fifo_hdr->flags & FLAGS_FIXED_RECORD ) {
+		PSL_memcpy( fifo_storage_reference, DATAQ_RING_FILE_NAME, sizeof(DATAQ_RING_FILE_NAME) );
+		return;
+	}
+
+	DataQ_MakeSegmentReference( fifo_lut_record->segment, fifo_storage_reference );
+}
+
+/** @brief Retrieves the size of one segment of a data queue.
+ *
+ *  This function determines the fixed size of the segment files of a
+ *  data queue created with the segmented storage flag. The maximum
+ *  flash size is shared evenly by the segments, although a segment
+ *  always holds at least one entry of the maximum entry size.
+ *
+ *  @param[in] fifo_hdr - the reference of the header
+ *
+ *  @return size_t - the size of one segment
+ */
+static size_t DataQ_GetSegmentSize( DataQ_Hdr_t * fifo_hdr )
+{
+	size_t segment_size;
+
+	/* share the maximum flash size evenly by the segments */
+	segment_size = (fifo_hdr->max_flash_size + DATA_QUEUE_SEGMENT_COUNT - 1) / DATA_QUEUE_SEGMENT_COUNT;
+
+	/* but make sure the largest entry fits into one segment */
+	if ( segment_size < fifo_hdr->max_entry_size ) {
+		segment_size = fifo_hdr->max_entry_size;
+	}
+
+	return segment_size;
+}
+
+/** @brief Evicts the oldest entry of a data queue.
+ *
+ *  This function invalidates the cached LUT entry at the 'head' end
+ *  of the data queue and accounts for it in the specified header. The
+ *  file associated with the entry is deleted or, for a data queue
+ *  created with the segmented storage flag, the segment file is
+ *  deleted once the 'head' end moves past the segment (unless it was
+ *  preallocated, in which case it is kept to be overwritten). The
+ *  record of a data queue created with the fixed record flag is simply
+ *  left to be overwritten. Neither the LUT file nor the header file is
+ *  updated - the caller commits both once it is done changing the
+ *  data queue.
+ *
+ *  The flash size of the entry is taken from its LUT record, so the
+ *  file associated with the entry is only listed for a data queue
+ *  created with the legacy LUT version (which does not keep it).
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fifo_hdr - the reference of the working header
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_ENTRY_NOT_LISTED
+ */
+static int DataQ_EvictHead( DataQ_State_t * fifo_state, DataQ_Hdr_t * fifo_hdr )
+{
+	DataQ_LUT_Record_t fifo_lut_record;
+	DataQ_LUT_Record_t fifo_lut_next_record;
+	char fifo_lut_entry_reference[DATAQ_REFERENCE_SIZE_MAX + 1];
+	size_t file_size;
+
+	/* adjust the cursor of the handle if it is set to the head end of the
+	 * data queue (wrapping around if the seek reach the end of the queue) */
+	if ( fifo_state->seek_lut_offs == fifo_hdr->head_lut_offs ) {
+		fifo_state->seek_lut_offs = (fifo_state->seek_lut_offs + 1) % fifo_hdr->max_entries;
+	}
+
+	/* the flash size of the current head is kept in its LUT record */
+	if ( DataQ_GetLUTRecord( fifo_state, fifo_hdr->head_lut_offs, &fifo_lut_record ) != CODE_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+	file_size = fifo_lut_record.length;
+
+	if ( (fifo_hdr->flags & DATAQ_SHARED_STORAGE) == 0 ) {
+
+		/* retrieve the file name associated with the current head */
+		DataQ_GetReference( fifo_hdr, &fifo_lut_record, fifo_lut_entry_reference );
+
+		/* retrieve the flash size of the current head (a legacy LUT entry does not keep it) */
+		if ( (fifo_lut_record.version == LUT_VERSION_LEGACY) &&
+			 (FSAL_ListDirFile( fifo_state->dir, fifo_lut_entry_reference, &file_size ) == FSAL_ERROR_FILE_ACCESS) ) {
+			return CODE_ERROR_QUEUE_ENTRY_NOT_LISTED;
+		}
+
+		/* delete the file */
+		FSAL_DeleteDirFile( fifo_state->dir, fifo_lut_entry_reference );
+	}
+
+	/* remove the oldest entry by invalidating the LUT entry indicated by the
+	 * head offset and then incrementing the head offset (wrapping around if the
+	 * the head reach the end of the queue)
+	 */
+	PSL_memset( &fifo_lut_next_record, 0, sizeof(fifo_lut_next_record) );
+	if ( DataQ_SetLUTRecord( fifo_state, fifo_hdr->head_lut_offs, &fifo_lut_next_record ) != CODE_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+	fifo_hdr->head_lut_offs = (fifo_hdr->head_lut_offs + 1) % fifo_hdr->max_entries;
+
+	/* decrement entry counter */
+	fifo_hdr->num_of_entries--;
+
+	/* decrement flash size */
+	fifo_hdr->flash_size -= file_size;
+
+	if ( (fifo_hdr->flags & (FLAGS_SEGMENTED_STORAGE | FLAGS_PREALLOCATE)) == FLAGS_SEGMENTED_STORAGE ) {
+
+		/* determine if the new head lives in another segment */
+		if ( (fifo_hdr->num_of_entries != 0) &&
+			 (DataQ_GetLUTRecord( fifo_state, fifo_hdr->head_lut_offs, &fifo_lut_next_record ) != CODE_STATUS_OK) ) {
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+
+		/* reclaim the whole segment once the head moved past it */
+		if ( (fifo_hdr->num_of_entries == 0) ||
+			 (fifo_lut_next_record.segment != fifo_lut_record.segment) ) {
+			DataQ_MakeSegmentReference( fifo_lut_record.segment, fifo_lut_entry_reference );
+			FSAL_DeleteDirFile( fifo_state->dir, fifo_lut_entry_reference );
+		}
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Appends data to the current segment of a data queue.
+ *
+ *  This function writes the data right after the entry at the 'tail'
+ *  end of a data queue created with the segmented storage flag. If
+ *  the data does not fit into the remaining space of that segment,
+ *  it is written at the beginning of the next segment (wrapping around
+ *  the set of segments) after evicting the oldest entries still kept
+ *  in it. A segment is created when its first entry is appended unless
+ *  all of the segments were preallocated by the creation of the data
+ *  queue.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fifo_hdr - the reference of the working header
+ *
+ *  @param[in] data - the reference of the data to be appended
+ *
+ *  @param[in] size - the size of the data to be appended
+ *
+ *  @param[out] fifo_lut_record - the reference where the location
+ *                                of the appended data is set
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_AppendSegment( DataQ_State_t * fifo_state, DataQ_Hdr_t * fifo_hdr, const void * data, size_t size, DataQ_LUT_Record_t * fifo_lut_record )
+{
+	FSAL_File_t fsal_handle = -1;
+	int fsal_flags = FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE;
+	DataQ_LUT_Record_t fifo_lut_tail_record;
+	DataQ_LUT_Record_t fifo_lut_head_record;
+	char fifo_segment_reference[DATA_QUEUE_LUT_ENTRY_SIZE + 1];
+
+	/* an empty fifo has no segment left so start with the first one */
+	fifo_lut_record->segment = 0;
+	fifo_lut_record->offset = 0;
+
+	if ( fifo_hdr->num_of_entries != 0 ) {
+
+		/* append right after the current tail */
+		if ( DataQ_GetLUTRecord( fifo_state, fifo_hdr->tail_lut_offs, &fifo_lut_tail_record ) != CODE_STATUS_OK ) {
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+		fifo_lut_record->segment = fifo_lut_tail_record.segment;
+		fifo_lut_record->offset = fifo_lut_tail_record.offset + fifo_lut_tail_record.length;
+
+		/* move on to the next segment if the data does not fit */
+		if ( (fifo_lut_record->offset + size) > DataQ_GetSegmentSize(fifo_hdr) ) {
+
+			fifo_lut_record->segment = (fifo_lut_record->segment + 1) % DATA_QUEUE_SEGMENT_COUNT;
+			fifo_lut_record->offset = 0;
+
+			/* reclaim the next segment if the oldest entries are still kept in it */
+			while ( fifo_hdr->num_of_entries != 0 ) {
+
+				if ( DataQ_GetLUTRecord( fifo_state, fifo_hdr->head_lut_offs, &fifo_lut_head_record ) != CODE_STATUS_OK ) {
+					return CODE_ERROR_FS_ACCESS_FAIL;
+				}
+				if ( fifo_lut_head_record.segment != fifo_lut_record->segment ) {
+					break;
+				}
+
+				DATAQ_STATS_COUNT( evictions );
+				if ( DataQ_EvictHead( fifo_state, fifo_hdr ) != CODE_STATUS_OK ) {
+					return CODE_ERROR_FS_ACCESS_FAIL;
+				}
+			}
+		}
+	}
+
+	/* a segment is created when its first entry is appended (a preallocated
+	 * one is kept along with its storage, so it must not be truncated) */
+	if ( (fifo_lut_record->offset == 0) && ((fifo_hdr->flags & FLAGS_PREALLOCATE) == 0) ) {
+		fsal_flags |= FSAL_FLAGS_CREATE;
+	}
+
+	/* write the data at its offset within the segment file */
+	DataQ_MakeSegmentReference( fifo_lut_record->segment, fifo_segment_reference );
+	if ( (FSAL_OpenDirFile(fifo_state->dir, fifo_segment_reference, fsal_flags, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+		 (FSAL_WriteFileAt(fsal_handle, fifo_lut_record->offset, (uint8_t *)data, size) < 0) ||
+		 ((fifo_state->durability.type == DURABILITY_TYPE_SYNC) && (FSAL_SyncFile(fsal_handle) != FSAL_STATUS_OK)) ||
+		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+		/* file system access error */
+		if ( fsal_handle != -1 )
+			FSAL_CloseFile( fsal_handle );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Appends an entry to a data queue.
+ *
+ *  This function writes the data into a new file associated with
+ *  the next reference (or into the current segment for a data queue
+ *  created with the segmented storage flag), adds the entry at the
+ *  'tail' end of the cached LUT and accounts for it in the specified
+ *  header. The caller must have made room for the entry beforehand
+ *  and commits the LUT file and the header file once it is done
+ *  changing the data queue. The data is synchronized with the storage
+ *  media right away with the sync durability policy, or on the next
+ *  commit with the deferred ones.
+ *
+ *  The LUT record of the entry keeps the size and the CRC32 of the
+ *  data (unless the data queue was created with the legacy LUT
+ *  version) along with its reference, which names no file in
+ *  segmented storage but still tells the entry apart. If the entry
+ *  is to be packed, the data is stored packed as long as that takes
+ *  less room (the LUT record then keeps the packed size along with
+ *  the encoding, and the CRC32 of the data as enqueued), and the
+ *  oldest entries are evicted as needed to make room for it on flash,
+ *  now that the room it takes is known.
+ *
+ *  A data queue created with the fixed record flag rather has the
+ *  record (of the record size) written into its slot of the ring
+ *  file, without any LUT entry, CRC32 or packing.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fifo_hdr - the reference of the working header
+ *
+ *  @param[in] data - the reference of the data to be appended
+ *
+ *  @param[in] size - the size of the data to be appended
+ *
+ *  @param[in] packed - non-zero to pack the data (it is stored as
+ *                      it is with the legacy LUT version, which does
+ *                      not keep the encoding)
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_ENTRY_NOT_LISTED
+ */
+static int DataQ_AppendEntry( DataQ_State_t * fifo_state, DataQ_Hdr_t * fifo_hdr, const void * data, size_t size, int packed )
+{
+	FSAL_File_t fsal_handle = -1;
+	DataQ_LUT_Record_t fifo_lut_record;
+	char fifo_lut_entry_reference[DATAQ_REFERENCE_SIZE_MAX + 1];
+	uint32_t lut_offs;
+	size_t packed_size = 0;
+	int dataq_status = CODE_STATUS_OK;
+
+	if ( fifo_hdr->flags & FLAGS_FIXED_RECORD ) {
+
+		/* the record goes into the slot next to the tail (or into the
+		 * tail slot itself if the fifo is empty) */
+		lut_offs = fifo_hdr->tail_lut_offs;
+		if ( (fifo_hdr->num_of_entries != 0) ||
+			 (fifo_hdr->head_lut_offs != fifo_hdr->tail_lut_offs) ) {
+			lut_offs = (lut_offs + 1) % fifo_hdr->max_entries;
+		}
+
+		/* overwrite the slot of the ring file in place */
+		if ( (FSAL_OpenDirFile(fifo_state->dir, DATAQ_RING_FILE_NAME, FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+			 (FSAL_WriteFileAt(fsal_handle, lut_offs * DATAQ_RECORD_SIZE( fifo_hdr ), (uint8_t *)data, DATAQ_RECORD_SIZE( fifo_hdr )) < 0) ||
+			 ((fifo_state->durability.type == DURABILITY_TYPE_SYNC) && (FSAL_SyncFile(fsal_handle) != FSAL_STATUS_OK)) ||
+			 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+			/* file system access error */
+			if ( fsal_handle != -1 )
+				FSAL_CloseFile( fsal_handle );
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+
+		/* account for the record (there is no LUT entry to set) */
+		fifo_hdr->reference_count++;
+		fifo_hdr->tail_lut_offs = lut_offs;
+		fifo_hdr->num_of_entries++;
+		fifo_hdr->flash_size += DATAQ_RECORD_SIZE( fifo_hdr );
+		fifo_state->pending_entries++;
+
+		return CODE_STATUS_OK;
+	}
+
+	/* describe the new entry */
+	PSL_memset( &fifo_lut_record, 0, sizeof(fifo_lut_record) );
+	fifo_lut_record.version = fifo_hdr->lut_version;
+	fifo_lut_record.length = size;
+	fifo_lut_record.crc = DataQ_ComputeCRC32( data, size );
+
+	/* convert the next reference count into the LUT record */
+	DataQ_MakeReference( fifo_hdr, fifo_hdr->reference_count + 1, &fifo_lut_record, fifo_lut_entry_reference );
+
+	/* pack the data if it takes less room that way (the packing buffer
+	 * stays locked until the packed data is written) */
+	if ( (packed != 0) && (fifo_hdr->lut_version != LUT_VERSION_LEGACY) &&
+		 (size <= DATA_QUEUE_PACK_BUFFER_SIZE) && (size <= 0xFFFF) ) {
+
+		PSL_MutexLock( &DataQ_PackMutex );
+		packed_size = DataQ_PackEntry( (const uint8_t *) data, size, DataQ_PackBuffer, size - 1 );
+		if ( packed_size != 0 ) {
+			fifo_lut_record.encoding = ENCODING_TYPE_PACKED;
+			fifo_lut_record.length = packed_size;
+			data = DataQ_PackBuffer;
+			size = packed_size;
+		} else {
+			PSL_MutexUnlock( &DataQ_PackMutex );
+		}
+	}
+
+	/* make room on flash for the data as it is stored (the caller
+	 * already did unless the entry is to be packed) */
+	while ( (fifo_hdr->num_of_entries > 0) &&
+			((fifo_hdr->flash_size + size) > fifo_hdr->max_flash_size) ) {
+
+		/* remove the oldest entry */
+		DATAQ_STATS_COUNT( evictions );
+		dataq_status = DataQ_EvictHead( fifo_state, fifo_hdr );
+		if ( dataq_status != CODE_STATUS_OK ) {
+			break;
+		}
+	}
+
+	if ( dataq_status != CODE_STATUS_OK ) {
+
+		/* nothing is appended */
+
+	} else if ( fifo_hdr->flags & FLAGS_SEGMENTED_STORAGE ) {
+
+		/* append the enqueued data into the current segment */
+		if ( DataQ_AppendSegment( fifo_state, fifo_hdr, data, size, &fifo_lut_record ) != CODE_STATUS_OK ) {
+			dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+		}
+
+	} else {
+
+		/* create a new file to contain the enqueued data */
+		if ( (FSAL_OpenDirFile(fifo_state->dir, fifo_lut_entry_reference, FSAL_FLAGS_BINARY | FSAL_FLAGS_WRITE_ONLY | FSAL_FLAGS_CREATE, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+			 (FSAL_WriteFile(fsal_handle, (uint8_t *)data, size) < 0) ||
+			 ((fifo_state->durability.type == DURABILITY_TYPE_SYNC) && (FSAL_SyncFile(fsal_handle) != FSAL_STATUS_OK)) ||
+			 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+			/* file system access error */
+			if ( fsal_handle != -1 )
+				FSAL_CloseFile( fsal_handle );
+			dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+		}
+	}
+
+	/* the packed data is no longer needed */
+	if ( packed_size != 0 ) {
+		PSL_MutexUnlock( &DataQ_PackMutex );
+	}
+
+	if ( dataq_status != CODE_STATUS_OK ) {
+		return dataq_status;
+	}
+
+	/* increment reference count */
+	fifo_hdr->reference_count++;
+
+	/* determine if fifo is empty */
+	if ( (fifo_hdr->num_of_entries == 0) &&
+		 (fifo_hdr->head_lut_offs == fifo_hdr->tail_lut_offs)  ) {
+
+		/* add the new entry by copying the LUT entry indicated either by the head or tail offset */
+		if ( DataQ_SetLUTRecord( fifo_state, fifo_hdr->tail_lut_offs, &fifo_lut_record ) != CODE_STATUS_OK ) {
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+
+	} else {
+
+		/* add the new entry by incrementing the tail offset (wrapping around if the
+		 * tail reach the end of the queue) and copying the LUT entry indicated by
+		 * the new tail offset (the tail only moves once the LUT entry is set, so
+		 * whatever was already done can still be committed)
+		 */
+		if ( DataQ_SetLUTRecord( fifo_state, (fifo_hdr->tail_lut_offs + 1) % fifo_hdr->max_entries, &fifo_lut_record ) != CODE_STATUS_OK ) {
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+		fifo_hdr->tail_lut_offs = (fifo_hdr->tail_lut_offs + 1) % fifo_hdr->max_entries;
+	}
+
+	/* increment entry counter */
+	fifo_hdr->num_of_entries++;
+
+	/* increment flash size */
+	fifo_hdr->flash_size += size;
+
+	/* keep track of the data to synchronize on the next commit */
+	fifo_state->pending_entries++;
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Synchronizes the entries appended since the last commit.
+ *
+ *  This function synchronizes with the storage media the files (or
+ *  the segments or the ring file, each only once) of the entries
+ *  appended to the data
+ *  queue since the last commit that are still kept in it, walking
+ *  back from the 'tail' end of the data queue.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fifo_hdr - the reference of the working header
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_SyncEntries( DataQ_State_t * fifo_state, DataQ_Hdr_t * fifo_hdr )
+{
+	FSAL_File_t fsal_handle;
+	DataQ_LUT_Record_t fifo_lut_record;
+	char fifo_lut_entry_reference[DATAQ_REFERENCE_SIZE_MAX + 1];
+	uint32_t lut_offs = fifo_hdr->tail_lut_offs;
+	uint32_t segment = DATAQ_LUT_PAGE_INVALID;
+	uint32_t count;
+
+	/* the entries evicted since then are gone anyway */
+	count = fifo_state->pending_entries;
+	if ( count > fifo_hdr->num_of_entries ) {
+		count = fifo_hdr->num_of_entries;
+	}
+
+	for ( ; count > 0; count-- ) {
+
+		if ( DataQ_GetLUTRecord( fifo_state, lut_offs, &fifo_lut_record ) != CODE_STATUS_OK ) {
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+
+		/* step back to the previous entry (wrapping around the LUT) */
+		lut_offs = (lut_offs + fifo_hdr->max_entries - 1) % fifo_hdr->max_entries;
+
+		if ( fifo_hdr->flags & DATAQ_SHARED_STORAGE ) {
+
+			/* synchronize each segment (or the ring file) only once */
+			if ( fifo_lut_record.segment == segment ) {
+				continue;
+			}
+			segment = fifo_lut_record.segment;
+			DataQ_MakeStorageReference( fifo_hdr, &fifo_lut_record, fifo_lut_entry_reference );
+
+		} else {
+
+			/* retrieve the file name associated with the entry */
+			DataQ_GetReference( fifo_hdr, &fifo_lut_record, fifo_lut_entry_reference );
+		}
+
+		/* synchronize the file associated with the entry */
+		fsal_handle = -1;
+		if ( (FSAL_OpenDirFile(fifo_state->dir, fifo_lut_entry_reference, FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+			 (FSAL_SyncFile(fsal_handle) != FSAL_STATUS_OK) ||
+			 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+			/* file system access error */
+			if ( fsal_handle != -1 )
+				FSAL_CloseFile( fsal_handle );
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Flushes the changes made to a data queue.
+ *
+ *  This function commits the changes kept in the cached state of the
+ *  data queue: it synchronizes the entries appended since the last
+ *  commit (with the deferred durability policies), then stores the
+ *  changed LUT entries and finally the specified header, the header
+ *  being the last one written so that it only refers to entries and
+ *  LUT entries already stored (or journals both with one record for
+ *  a data queue created with the metadata journal flag).
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fifo_hdr - the reference of the header to commit
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_FlushState( DataQ_State_t * fifo_state, DataQ_Hdr_t * fifo_hdr )
+{
+	int dataq_status;
+
+	if ( (fifo_state->durability.type == DURABILITY_TYPE_GROUP) ||
+		 (fifo_state->durability.type == DURABILITY_TYPE_WRITE_BACK) ) {
+		if ( DataQ_SyncEntries( fifo_state, fifo_hdr ) != CODE_STATUS_OK ) {
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+	}
+
+	if ( fifo_state->hdr.flags & FLAGS_METADATA_JOURNAL ) {
+
+		/* write one record into the metadata journal associated with the fifo */
+		PSL_MutexLock( &DataQ_JournalMutex );
+		dataq_status = DataQ_StoreJournal( fifo_state, fifo_hdr );
+		PSL_MutexUnlock( &DataQ_JournalMutex );
+		if ( dataq_status != CODE_STATUS_OK ) {
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+
+	/* update the LUT file and then the header (or metadata) file associated with the fifo */
+	} else if ( (DataQ_StoreLUT( fifo_state ) != CODE_STATUS_OK) ||
+		 (DataQ_StoreHeader( fifo_state, fifo_hdr ) != CODE_STATUS_OK) ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* nothing is left to commit */
+	fifo_state->pending_ops = 0;
+	fifo_state->pending_entries = 0;
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Commits the changes of an operation on a data queue.
+ *
+ *  This function accounts for an operation that changed the data
+ *  queue (as described by the specified header) under its durability
+ *  policy. The changes are flushed right away unless the policy
+ *  defers them, in which case the header is only kept in the cached
+ *  state until the group commit is due (either enough operations
+ *  were made or enough time elapsed since the first one) or the data
+ *  queue is flushed.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] fifo_hdr - the reference of the working header
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_CommitState( DataQ_State_t * fifo_state, DataQ_Hdr_t * fifo_hdr )
+{
+	DataQ_Durability_t * durability = &fifo_state->durability;
+	uint32_t now;
+
+	if ( (durability->type == DURABILITY_TYPE_GROUP) ||
+		 (durability->type == DURABILITY_TYPE_WRITE_BACK) ) {
+
+		/* the cached state carries the changes until they are committed */
+		if ( fifo_hdr != &fifo_state->hdr ) {
+			PSL_memcpy( &fifo_state->hdr, fifo_hdr, sizeof(DataQ_Hdr_t) );
+		}
+
+		/* the group starts with the first uncommitted operation */
+		now = PSL_GetTimestamp();
+		if ( fifo_state->pending_ops == 0 ) {
+			fifo_state->pending_since = now;
+		}
+		fifo_state->pending_ops++;
+
+		/* keep deferring unless the group commit is due */
+		if ( (durability->type == DURABILITY_TYPE_WRITE_BACK) ||
+			 (((durability->commit_ops == 0) || (fifo_state->pending_ops < durability->commit_ops)) &&
+			  ((durability->commit_time == 0) || ((now - fifo_state->pending_since) < (durability->commit_time * 1000)))) ) {
+			return CODE_STATUS_OK;
+		}
+	}
+
+	return DataQ_FlushState( fifo_state, fifo_hdr );
+}
+
+/** @brief Discards entries at the 'head' end of a data queue.
+ *
+ *  This function removes the specified number of the oldest entries
+ *  of a data queue (deleting their files, or their segments once the
+ *  'head' end moved past them, and taking their sizes kept in the
+ *  LUT off the flash size) without reading them, and then commits
+ *  the LUT and the header (or metadata) once for all of them.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] count - the number of entries to be discarded (at most
+ *                     the number of entries of the data queue)
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_DiscardEntries( DataQ_State_t * fifo_state, uint32_t count )
+{
+	DataQ_Hdr_t fifo_hdr;
+	uint32_t index;
+
+	/* work on a copy of the cached header (or metadata) of the fifo */
+	PSL_memcpy( &fifo_hdr, &fifo_state->hdr, sizeof(DataQ_Hdr_t) );
+
+	/* remove the oldest entries (the files and the LUT entries) */
+	for ( index = 0; index < count; index++ ) {
+		if ( DataQ_EvictHead( fifo_state, &fifo_hdr ) != CODE_STATUS_OK ) {
+
+			/* resynchronize the cached LUT with the LUT file */
+			DataQ_LoadState( fifo_state );
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+		DATAQ_STATS_COUNT( discards );
+	}
+
+	/* commit the LUT and the header (or metadata) under the durability policy */
+	if ( DataQ_CommitState( fifo_state, &fifo_hdr ) != CODE_STATUS_OK ) {
+
+		/* resynchronize the cached state with the files */
+		DataQ_LoadState( fifo_state );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Determines if a data queue is above a watermark.
+ *
+ *  This function compares both the number of entries and the flash
+ *  size of the data queue described by the specified header with the
+ *  specified percentage of its capacity.
+ *
+ *  @param[in] fifo_hdr - the reference of the header
+ *
+ *  @param[in] watermark - the percentage of the capacity
+ *
+ *  @return int - non-zero if either is above the watermark
+ */
+static int DataQ_IsAboveWatermark( DataQ_Hdr_t * fifo_hdr, uint8_t watermark )
+{
+	return ( (((uint64_t) fifo_hdr->num_of_entries * 100) > ((uint64_t) fifo_hdr->max_entries * watermark)) ||
+			 (((uint64_t) fifo_hdr->flash_size * 100) > ((uint64_t) fifo_hdr->max_flash_size * watermark)) );
+}
+
+/** @brief Checks an entry of a data queue against its storage.
+ *
+ *  This function checks that the file keeping the specified entry
+ *  (the file of its own, or its segment or ring file in shared
+ *  storage) is listed and keeps the whole of the entry as its LUT
+ *  record describes it. With RECOVERY_CHECK_DATA, the data of the
+ *  entry is also read back, one piece at a time through the recovery
+ *  buffer, and checked against the CRC32 its LUT record keeps (only
+ *  the LUT records of the record or sequence LUT version keep one,
+ *  a fixed record keeps none, and the CRC32 of a packed entry covers
+ *  its unpacked data, so the data of such an entry is not read back).
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] lut_offs - the offset of the LUT entry
+ *
+ *  @param[in] check - the type of check of the entry
+ *
+ *  @param[out] entry_size - the reference where the flash size of
+ *                           the entry is set
+ *
+ *  @param[out] bytes_checked - the reference of the number of bytes
+ *                              read back, which is incremented
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_ENTRY_NOT_LISTED
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ */
+static int DataQ_CheckEntry( DataQ_State_t * fifo_state, uint32_t lut_offs, int check, size_t * entry_size, uint32_t * bytes_checked )
+{
+	FSAL_File_t fsal_handle = -1;
+	DataQ_LUT_Record_t fifo_lut_record;
+	char fifo_lut_entry_reference[DATAQ_REFERENCE_SIZE_MAX + 1];
+	size_t file_size;
+	size_t offset = 0;
+	size_t done;
+	size_t chunk;
+	ssize_t read_size;
+	uint32_t crc = 0;
+	int dataq_status = CODE_STATUS_OK;
+
+	if ( DataQ_GetLUTRecord( fifo_state, lut_offs, &fifo_lut_record ) != CODE_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* locate the file keeping the entry */
+	if ( fifo_state->hdr.flags & DATAQ_SHARED_STORAGE ) {
+		DataQ_MakeStorageReference( &fifo_state->hdr, &fifo_lut_record, fifo_lut_entry_reference );
+		offset = fifo_lut_record.offset;
+	} else {
+		DataQ_GetReference( &fifo_state->hdr, &fifo_lut_record, fifo_lut_entry_reference );
+	}
+	if ( FSAL_ListDirFile( fifo_state->dir, fifo_lut_entry_reference, &file_size ) == FSAL_ERROR_FILE_ACCESS ) {
+		return CODE_ERROR_QUEUE_ENTRY_NOT_LISTED;
+	}
+
+	/* an entry kept in a file of its own is as large as the file, unless
+	 * its LUT record keeps its size (a legacy LUT entry does not) */
+	if ( ((fifo_state->hdr.flags & DATAQ_SHARED_STORAGE) == 0) &&
+		 (fifo_lut_record.version == LUT_VERSION_LEGACY) ) {
+		fifo_lut_record.length = file_size;
+	}
+	*entry_size = fifo_lut_record.length;
+
+	/* the file must keep the whole of the entry (and nothing else,
+	 * unless the file is shared) */
+	if ( (fifo_lut_record.length == 0) ||
+		 ((offset + fifo_lut_record.length) > file_size) ||
+		 (((fifo_state->hdr.flags & DATAQ_SHARED_STORAGE) == 0) && (file_size != fifo_lut_record.length)) ) {
+		return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+	}
+
+	/* only the data of an entry whose LUT record keeps its CRC32 is read back */
+	if ( (check != RECOVERY_CHECK_DATA) ||
+		 (fifo_lut_record.version == LUT_VERSION_LEGACY) ||
+		 (fifo_lut_record.encoding != ENCODING_TYPE_NONE) ) {
+		return CODE_STATUS_OK;
+	}
+
+	/* stream the data through the recovery buffer (whatever its size) */
+	if ( FSAL_OpenDirFile(fifo_state->dir, fifo_lut_entry_reference, FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+	for ( done = 0; done < fifo_lut_record.length; done += chunk ) {
+
+		chunk = fifo_lut_record.length - done;
+		if ( chunk > sizeof(DataQ_RecoveryBuffer) ) {
+			chunk = sizeof(DataQ_RecoveryBuffer);
+		}
+
+		read_size = FSAL_ReadFileAt( fsal_handle, offset + done, DataQ_RecoveryBuffer, chunk );
+		if ( read_size < 0 ) {
+			dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+			break;
+		}
+		if ( (size_t) read_size != chunk ) {
+			dataq_status = CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+			break;
+		}
+		crc = DataQ_UpdateCRC32( crc, DataQ_RecoveryBuffer, chunk );
+		*bytes_checked += chunk;
+	}
+	FSAL_CloseFile( fsal_handle );
+
+	/* check the integrity of the data */
+	if ( (dataq_status == CODE_STATUS_OK) && (crc != fifo_lut_record.crc) ) {
+		dataq_status = CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+	}
+
+	return dataq_status;
+}
+
+/** @brief Drops an entry of a data queue which can not be kept.
+ *
+ *  This function deletes the file of its own the specified entry is
+ *  kept in, if any (the file may well be missing), and invalidates
+ *  its cached LUT entry. The segment or ring file of an entry kept
+ *  in shared storage is left to be overwritten. The header is not
+ *  updated - the caller commits it once it is done dropping entries.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] lut_offs - the offset of the LUT entry
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_DropEntry( DataQ_State_t * fifo_state, uint32_t lut_offs )
+{
+	DataQ_LUT_Record_t fifo_lut_record;
+	char fifo_lut_entry_reference[DATAQ_REFERENCE_SIZE_MAX + 1];
+
+	if ( DataQ_GetLUTRecord( fifo_state, lut_offs, &fifo_lut_record ) != CODE_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* delete the file of the entry, if there is one */
+	if ( (fifo_state->hdr.flags & DATAQ_SHARED_STORAGE) == 0 ) {
+		DataQ_GetReference( &fifo_state->hdr, &fifo_lut_record, fifo_lut_entry_reference );
+		FSAL_DeleteDirFile( fifo_state->dir, fifo_lut_entry_reference );
+	}
+
+	/* invalidate the LUT entry */
+	PSL_memset( &fifo_lut_record, 0, sizeof(fifo_lut_record) );
+	return DataQ_SetLUTRecord( fifo_state, lut_offs, &fifo_lut_record );
+}
+
+/** @brief Checks whether an entry of a data queue follows another one.
+ *
+ *  This function checks whether the specified LUT record describes the
+ *  entry enqueued with the specified reference count, right after the
+ *  entry described by the previous LUT record (if any). A LUT record
+ *  keeping the reference of its entry must keep that reference count
+ *  (none is kept by a legacy LUT entry in segmented storage, by a LUT
+ *  record of a data queue created before segmented entries kept one,
+ *  or by a fixed record, and a header of the first version only keeps
+ *  16 bits of the reference count, so it is not checked then). An entry
+ *  kept in a segment must lie right after the previous entry, either
+ *  within the same segment or at the start of the next one.
+ *
+ *  @param[in] fifo_hdr - the reference of the header
+ *
+ *  @param[in] reference_count - the reference count of the entry
+ *
+ *  @param[in] fifo_lut_record - the reference of the LUT record
+ *
+ *  @param[in] fifo_lut_prev_record - the reference of the LUT record of
+ *                                    the previous entry, or null
+ *
+ *  @param[in] strict - non-zero to only accept an entry told apart by
+ *                      its reference or as lying right after the
+ *                      previous entry within the same segment
+ *
+ *  @return int - non-zero if the entry follows the previous one
+ */
+static int DataQ_IsNextEntry( DataQ_Hdr_t * fifo_hdr, uint32_t reference_count, DataQ_LUT_Record_t * fifo_lut_record,
+							  DataQ_LUT_Record_t * fifo_lut_prev_record, int strict )
+{
+	DataQ_LUT_Record_t fifo_lut_next_record;
+	char fifo_lut_entry_reference[DATAQ_REFERENCE_SIZE_MAX + 1];
+	size_t reference_size = DATA_QUEUE_LUT_ENTRY_SIZE;
+	size_t index;
+	int checked = 0;
+
+	if ( fifo_hdr->lut_version == LUT_VERSION_SEQUENCE ) {
+		reference_size = sizeof(uint32_t);
+	}
+
+	/* a LUT record without a reference keeps it cleared */
+	for ( index = 0; (index < reference_size) && (fifo_lut_record->reference[index] == 0); index++ ) {
+	}
+	if ( (index < reference_size) && (fifo_hdr->hdr_version != HDR_VERSION_1) ) {
+		DataQ_MakeReference( fifo_hdr, reference_count, &fifo_lut_next_record, fifo_lut_entry_reference );
+		if ( memcmp( fifo_lut_record->reference, fifo_lut_next_record.reference, reference_size ) != 0 ) {
+			return 0;
+		}
+		checked = 1;
+	}
+
+	/* an entry kept in a segment lies right after the previous one */
+	if ( (fifo_hdr->flags & FLAGS_SEGMENTED_STORAGE) && (fifo_lut_prev_record != (DataQ_LUT_Record_t *) 0) ) {
+		if ( (fifo_lut_record->segment == fifo_lut_prev_record->segment) &&
+			 (fifo_lut_record->offset == (fifo_lut_prev_record->offset + fifo_lut_prev_record->length)) ) {
+			return 1;
+		}
+		if ( (fifo_lut_record->segment != ((fifo_lut_prev_record->segment + 1) % DATA_QUEUE_SEGMENT_COUNT)) ||
+			 (fifo_lut_record->offset != 0) ) {
+			return 0;
+		}
+	}
+
+	return (strict == 0) || checked;
+}
+
+/** @brief Checks the entries of a data queue and repairs it.
+ *
+ *  This function streams once through the entries of a data queue
+ *  from the 'head' end, checking each of them against its storage
+ *  (see DataQ_CheckEntry) and against the entry kept before it (see
+ *  DataQ_IsNextEntry), and drops the entries which can not be kept:
+ *  those missing, corrupt or out of sequence before a sound one, as
+ *  left by an eviction torn by a failure, and every one from the
+ *  first entry which can not be kept after a sound one, as left by a
+ *  torn enqueue. Sound entries following such a gap of cleared LUT
+ *  records up to the 'tail' end are kept instead of the entries before
+ *  the gap, which a torn eviction left (the LUT records of an eviction
+ *  spanning several LUT pages are not stored from the 'head' end on).
+ *  A full data queue whose LUT was stored one enqueue
+ *  ahead of its header keeps the entry enqueued last at the 'head'
+ *  end, in place of the one it evicted: that enqueue is completed by
+ *  moving both ends on before the entries are checked. The number of
+ *  entries (as located by the 'head' and 'tail' ends) and the flash
+ *  size of the header are set from the entries kept and the LUT and
+ *  header (or metadata) are committed if anything changed.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] check - the type of check of the entries
+ *
+ *  @param[in,out] report - the reference of the report of the
+ *                          recovery, which is updated
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ */
+static int DataQ_CheckEntries( DataQ_State_t * fifo_state, int check, DataQ_Recovery_t * report )
+{
+	DataQ_Hdr_t fifo_hdr;
+	DataQ_LUT_Record_t fifo_lut_record;
+	DataQ_LUT_Record_t fifo_lut_prev_record;
+	DataQ_LUT_Record_t fifo_lut_cleared_record;
+	uint32_t lut_offs;
+	uint32_t position;
+	uint32_t count = 0;
+	uint32_t dropped = 0;
+	uint32_t kept = 0;
+	uint32_t truncated_dropped = 0;
+	uint32_t truncated_kept = 0;
+	size_t flash_size = 0;
+	size_t truncated_flash_size = 0;
+	size_t entry_size;
+	int advanced = 0;
+	int evicted = 1;
+	int dataq_status;
+
+	/* work on a copy of the cached header (or metadata) of the fifo */
+	PSL_memcpy( &fifo_hdr, &fifo_state->hdr, sizeof(DataQ_Hdr_t) );
+
+	/* the entries can not be located by a header torn beyond repair */
+	if ( (fifo_hdr.max_entries == 0) ||
+		 (fifo_hdr.head_lut_offs >= fifo_hdr.max_entries) ||
+		 (fifo_hdr.tail_lut_offs >= fifo_hdr.max_entries) ||
+		 (fifo_hdr.num_of_entries > fifo_hdr.max_entries) ) {
+		return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+	}
+
+	/* the entries of a fifo which is not empty lie from the head end
+	 * to the tail end */
+	if ( fifo_hdr.num_of_entries != 0 ) {
+		count = ((fifo_hdr.tail_lut_offs + fifo_hdr.max_entries - fifo_hdr.head_lut_offs) % fifo_hdr.max_entries) + 1;
+	}
+
+	/* the entry at the head end of a full fifo may be the one enqueued
+	 * right after the tail end, the header of that enqueue being torn */
+	if ( (count == fifo_hdr.max_entries) && (count > 1) ) {
+		if ( (DataQ_GetLUTRecord( fifo_state, fifo_hdr.head_lut_offs, &fifo_lut_record ) != CODE_STATUS_OK) ||
+			 (DataQ_GetLUTRecord( fifo_state, fifo_hdr.tail_lut_offs, &fifo_lut_prev_record ) != CODE_STATUS_OK) ) {
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+		if ( DataQ_IsNextEntry( &fifo_hdr, DataQ_GetHeadReference( &fifo_hdr ) + count, &fifo_lut_record, &fifo_lut_prev_record, 1 ) ) {
+			fifo_hdr.tail_lut_offs = fifo_hdr.head_lut_offs;
+			fifo_hdr.head_lut_offs = (fifo_hdr.head_lut_offs + 1) % fifo_hdr.max_entries;
+			fifo_hdr.reference_count++;
+			advanced = 1;
+		}
+	}
+
+	/* stream through the entries once from the head end */
+	PSL_memset( &fifo_lut_cleared_record, 0, sizeof(DataQ_LUT_Record_t) );
+	for ( position = 0; position < count; position++ ) {
+
+		lut_offs = (fifo_hdr.head_lut_offs + position) % fifo_hdr.max_entries;
+		dataq_status = DataQ_CheckEntry( fifo_state, lut_offs, check, &entry_size, &report->bytes_checked );
+		report->entries_checked++;
+
+		/* an entry out of sequence with the entry kept before it was
+		 * left by a torn commit as well */
+		if ( dataq_status == CODE_STATUS_OK ) {
+			if ( DataQ_GetLUTRecord( fifo_state, lut_offs, &fifo_lut_record ) != CODE_STATUS_OK ) {
+				return CODE_ERROR_FS_ACCESS_FAIL;
+			}
+			if ( DataQ_IsNextEntry( &fifo_hdr, DataQ_GetHeadReference( &fifo_hdr ) + position, &fifo_lut_record,
+									(kept != 0) ? &fifo_lut_prev_record : (DataQ_LUT_Record_t *) 0, 0 ) == 0 ) {
+				dataq_status = CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+			}
+		}
+
+		if ( dataq_status == CODE_STATUS_OK ) {
+			if ( kept == 0 ) {
+				dropped = position;
+			}
+			PSL_memcpy( &fifo_lut_prev_record, &fifo_lut_record, sizeof(DataQ_LUT_Record_t) );
+			flash_size += entry_size;
+			kept++;
+			continue;
+		}
+		if ( dataq_status == CODE_ERROR_FS_ACCESS_FAIL ) {
+			return dataq_status;
+		}
+
+		/* the first entry which can not be kept after a sound one is
+		 * where a torn enqueue truncates the fifo, unless sound entries
+		 * follow it up to the tail end (see below) */
+		if ( (kept != 0) && (truncated_kept == 0) ) {
+			truncated_dropped = dropped;
+			truncated_kept = kept;
+			truncated_flash_size = flash_size;
+		}
+		kept = 0;
+		flash_size = 0;
+
+		/* an eviction clears the LUT records of the entries it drops */
+		if ( truncated_kept != 0 ) {
+			if ( DataQ_GetLUTRecord( fifo_state, lut_offs, &fifo_lut_record ) != CODE_STATUS_OK ) {
+				return CODE_ERROR_FS_ACCESS_FAIL;
+			}
+			if ( memcmp( &fifo_lut_record, &fifo_lut_cleared_record, sizeof(DataQ_LUT_Record_t) ) != 0 ) {
+				evicted = 0;
+			}
+		}
+	}
+
+	/* sound entries up to the tail end after gaps of cleared LUT records
+	 * are kept, the gaps being left by a torn eviction (whose LUT records
+	 * are stored page by page rather than from the head end on) along
+	 * with the entries before them, otherwise the fifo is truncated at
+	 * its first gap */
+	if ( (kept == 0) || (evicted == 0) ) {
+		dropped = count;
+		if ( truncated_kept != 0 ) {
+			dropped = truncated_dropped;
+			kept = truncated_kept;
+			flash_size = truncated_flash_size;
+		}
+	}
+
+	/* nothing to repair if the header is consistent with the entries */
+	if ( (advanced == 0) &&
+		 (kept == count) &&
+		 (fifo_hdr.num_of_entries == count) &&
+		 (fifo_hdr.flash_size == flash_size) ) {
+		return CODE_STATUS_OK;
+	}
+
+	/* drop the entries which can not be kept at either end */
+	for ( position = 0; position < count; position++ ) {
+		if ( ((position < dropped) || (position >= (dropped + kept))) &&
+			 (DataQ_DropEntry( fifo_state, (fifo_hdr.head_lut_offs + position) % fifo_hdr.max_entries ) != CODE_STATUS_OK) ) {
+
+			/* resynchronize the cached LUT with the LUT file */
+			DataQ_LoadState( fifo_state );
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+	}
+	report->entries_dropped += count - kept;
+
+	/* the entries kept lie from the head end on, where the entries
+	 * dropped at the tail end give their references back */
+	if ( count != 0 ) {
+		fifo_hdr.reference_count -= count - dropped - kept;
+		fifo_hdr.head_lut_offs = (fifo_hdr.head_lut_offs + dropped) % fifo_hdr.max_entries;
+		fifo_hdr.tail_lut_offs = fifo_hdr.head_lut_offs;
+		if ( kept != 0 ) {
+			fifo_hdr.tail_lut_offs = (fifo_hdr.head_lut_offs + kept - 1) % fifo_hdr.max_entries;
+		}
+	}
+	fifo_hdr.num_of_entries = kept;
+	fifo_hdr.flash_size = flash_size;
+
+	/* commit the repaired LUT and header (or metadata) right away */
+	if ( DataQ_FlushState( fifo_state, &fifo_hdr ) != CODE_STATUS_OK ) {
+
+		/* resynchronize the cached state with the files */
+		DataQ_LoadState( fifo_state );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+	report->repaired = 1;
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Reads an entry of a data queue.
+ *
+ *  This function copies the data of the specified LUT entry from the
+ *  file associated with the entry (or from its segment for a data
+ *  queue created with the segmented storage flag, or from its slot of
+ *  the ring file for one created with the fixed record flag).
+ *
+ *  If the LUT record keeps the size of the entry, the caller's buffer
+ *  is checked against it up front and, if the buffer is too small,
+ *  the size of the entry is set without reading anything. If the LUT
+ *  record also keeps the CRC32 of the entry, the copied data is then
+ *  checked against it. A packed entry is read into the packing buffer
+ *  first and unpacked from there into the caller's buffer.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in] lut_offs - the offset of the LUT entry to be read
+ *
+ *  @param[out] data - the reference where the data is to be copied
+ *
+ *  @param[in,out] size - the reference of the maximum size that can
+ *                        be copied, which is then set to the size of
+ *                        the entry
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ */
+static int DataQ_ReadEntry( DataQ_State_t * fifo_state, uint32_t lut_offs, void * data, size_t * size )
+{
+	FSAL_File_t fsal_handle = -1;
+	ssize_t read_size;
+	DataQ_LUT_Record_t fifo_lut_record;
+	char fifo_lut_entry_reference[DATAQ_REFERENCE_SIZE_MAX + 1];
+	uint8_t * read_data = (uint8_t *) data;
+	size_t read_length;
+	int dataq_status;
+
+	if ( DataQ_GetLUTRecord( fifo_state, lut_offs, &fifo_lut_record ) != CODE_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	if ( fifo_lut_record.encoding != ENCODING_TYPE_NONE ) {
+
+		/* a packed entry is never larger than the packing buffer */
+		if ( fifo_lut_record.length > DATA_QUEUE_PACK_BUFFER_SIZE ) {
+			return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+		}
+
+		/* read the packed data into the packing buffer (kept locked until it is unpacked) */
+		PSL_MutexLock( &DataQ_PackMutex );
+		read_data = DataQ_PackBuffer;
+		read_length = fifo_lut_record.length;
+
+	} else if ( (fifo_lut_record.version != LUT_VERSION_LEGACY) ||
+				(fifo_state->hdr.flags & DATAQ_SHARED_STORAGE) ) {
+
+		/* size the caller's buffer up front if the entry size is known */
+
+		if ( *size < fifo_lut_record.length ) {
+			*size = fifo_lut_record.length;
+			return CODE_ERROR_BUFFER_TOO_SMALL;
+		}
+
+		/* never read past the entry */
+		*size = fifo_lut_record.length;
+		read_length = *size;
+
+	} else {
+
+		/* read as much as the caller's buffer holds */
+		read_length = *size;
+	}
+
+	if ( fifo_state->hdr.flags & DATAQ_SHARED_STORAGE ) {
+
+		/* the entry is kept within its segment (or its slot of the ring file) */
+		DataQ_MakeStorageReference( &fifo_state->hdr, &fifo_lut_record, fifo_lut_entry_reference );
+
+		/* extract the data at its offset within the shared file */
+		if ( (FSAL_OpenDirFile(fifo_state->dir, fifo_lut_entry_reference, FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+			 ((read_size = FSAL_ReadFileAt(fsal_handle, fifo_lut_record.offset, read_data, read_length)) < 0) ||
+			 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+			/* file system access error */
+			if ( fsal_handle != -1 )
+				FSAL_CloseFile( fsal_handle );
+			read_size = -1;
+		}
+
+	} else {
+
+		/* retrieve the file name associated with the entry */
+		DataQ_GetReference( &fifo_state->hdr, &fifo_lut_record, fifo_lut_entry_reference );
+
+		/* extract the data from the file as indicated by the reference */
+		if ( (FSAL_OpenDirFile(fifo_state->dir, fifo_lut_entry_reference, FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+			 ((read_size = FSAL_ReadFile(fsal_handle, read_data, read_length)) < 0) ||
+			 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+			/* file system access error */
+			if ( fsal_handle != -1 )
+				FSAL_CloseFile( fsal_handle );
+			read_size = -1;
+		}
+	}
+
+	if ( fifo_lut_record.encoding != ENCODING_TYPE_NONE ) {
+
+		/* unpack the whole of the packed data into the caller's buffer */
+		dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+		if ( read_size >= 0 ) {
+			dataq_status = CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+			if ( (size_t) read_size == fifo_lut_record.length ) {
+				dataq_status = DataQ_UnpackEntry( DataQ_PackBuffer, fifo_lut_record.length, data, size );
+			}
+		}
+		PSL_MutexUnlock( &DataQ_PackMutex );
+
+		if ( dataq_status != CODE_STATUS_OK ) {
+			return dataq_status;
+		}
+
+		/* check the integrity of the unpacked data */
+		if ( DataQ_ComputeCRC32( data, *size ) != fifo_lut_record.crc ) {
+			return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+		}
+
+		return CODE_STATUS_OK;
+	}
+
+	if ( read_size < 0 ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* check the integrity of the copied data if its LUT record allows it */
+	if ( (fifo_lut_record.version != LUT_VERSION_LEGACY) &&
+		 (((size_t) read_size != fifo_lut_record.length) ||
+		  (DataQ_ComputeCRC32( data, fifo_lut_record.length ) != fifo_lut_record.crc)) ) {
+		return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+	}
+
+	/* set the size of the copied data */
+	*size = (size_t) read_size;
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Reads an entry of a data queue through a read-ahead buffer.
+ *
+ *  This function copies the data of the specified LUT entry of a data
+ *  queue created with the segmented storage (or fixed record) flag
+ *  from the read-ahead buffer of the iterator. If the buffer does not
+ *  hold the entry, it is first refilled with one read of the segment
+ *  (or ring file) of the entry, which covers the entry and as many of
+ *  the following entries of the range of the iterator as lie further
+ *  on in the same file and fit into the buffer.
+ *  An entry larger than the buffer is read as usual, and a packed one
+ *  is unpacked straight from the buffer.
+ *
+ *  @param[in] fifo_state - the reference of the cached state
+ *
+ *  @param[in,out] iter - the reference of the iterator
+ *
+ *  @param[in] lut_offs - the offset of the LUT entry to be read
+ *
+ *  @param[out] data - the reference where the data is to be copied
+ *
+ *  @param[in,out] size - the reference of the maximum size that can
+ *                        be copied, which is then set to the size of
+ *                        the entry
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ */
+static int DataQ_ReadAhead( DataQ_State_t * fifo_state, DataQ_Iter_t * iter, uint32_t lut_offs, void * data, size_t * size )
+{
+	FSAL_File_t fsal_handle = -1;
+	DataQ_Hdr_t * fifo_hdr = &fifo_state->hdr;
+	DataQ_LUT_Record_t fifo_lut_record;
+	DataQ_LUT_Record_t fifo_lut_next_record;
+	char fifo_segment_reference[DATAQ_REFERENCE_SIZE_MAX + 1];
+	uint32_t next_lut_offs = lut_offs;
+	uint32_t index;
+	size_t end;
+	ssize_t read_size;
+	int dataq_status;
+
+	if ( DataQ_GetLUTRecord( fifo_state, lut_offs, &fifo_lut_record ) != CODE_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* size the caller's buffer up front (a packed entry is sized as it is unpacked) */
+	if ( (fifo_lut_record.encoding == ENCODING_TYPE_NONE) && (*size < fifo_lut_record.length) ) {
+		*size = fifo_lut_record.length;
+		return CODE_ERROR_BUFFER_TOO_SMALL;
+	}
+
+	/* an entry larger than the read-ahead buffer is read as usual */
+	if ( fifo_lut_record.length > iter->buffer_size ) {
+		return DataQ_ReadEntry( fifo_state, lut_offs, data, size );
+	}
+
+	/* refill the buffer unless it holds the entry (and no entry was
+	 * enqueued since it was filled, which may have reused the segment) */
+	if ( (iter->buffer_reference != fifo_hdr->reference_count) ||
+		 (iter->buffer_segment != fifo_lut_record.segment) ||
+		 (fifo_lut_record.offset < iter->buffer_offset) ||
+		 (fifo_lut_record.offset + fifo_lut_record.length > iter->buffer_offset + iter->buffer_length) ) {
+
+		/* cover the following entries of the range as long as they lie
+		 * further on in the same segment and fit into the buffer */
+		end = fifo_lut_record.offset + fifo_lut_record.length;
+		for ( index = 1; index < iter->remaining; index++ ) {
+			next_lut_offs = (next_lut_offs + 1) % fifo_hdr->max_entries;
+			if ( (DataQ_GetLUTRecord( fifo_state, next_lut_offs, &fifo_lut_next_record ) != CODE_STATUS_OK) ||
+				 (fifo_lut_next_record.segment != fifo_lut_record.segment) ||
+				 (fifo_lut_next_record.offset < end) ||
+				 (fifo_lut_next_record.offset + fifo_lut_next_record.length - fifo_lut_record.offset > iter->buffer_size) ) {
+				break;
+			}
+			end = fifo_lut_next_record.offset + fifo_lut_next_record.length;
+		}
+
+		/* read the covered part of the segment file in one go */
+		iter->buffer_length = 0;
+		DataQ_MakeStorageReference( fifo_hdr, &fifo_lut_record, fifo_segment_reference );
+		if ( (FSAL_OpenDirFile(fifo_state->dir, fifo_segment_reference, FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+			 ((read_size = FSAL_ReadFileAt(fsal_handle, fifo_lut_record.offset, iter->buffer, end - fifo_lut_record.offset)) < 0) ||
+			 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+			/* file system access error */
+			if ( fsal_handle != -1 )
+				FSAL_CloseFile( fsal_handle );
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+		iter->buffer_length = (size_t) read_size;
+		iter->buffer_reference = fifo_hdr->reference_count;
+		iter->buffer_segment = fifo_lut_record.segment;
+		iter->buffer_offset = fifo_lut_record.offset;
+
+		/* the segment file ends short of the entry */
+		if ( iter->buffer_length < fifo_lut_record.length ) {
+			return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+		}
+	}
+
+	if ( fifo_lut_record.encoding != ENCODING_TYPE_NONE ) {
+
+		/* unpack the data out of the buffer */
+		dataq_status = DataQ_UnpackEntry( &iter->buffer[ fifo_lut_record.offset - iter->buffer_offset ], fifo_lut_record.length, data, size );
+		if ( dataq_status != CODE_STATUS_OK ) {
+			return dataq_status;
+		}
+
+	} else {
+
+		/* copy the data out of the buffer and set its size */
+		PSL_memcpy( data, &iter->buffer[ fifo_lut_record.offset - iter->buffer_offset ], fifo_lut_record.length );
+		*size = fifo_lut_record.length;
+	}
+
+	/* check the integrity of the copied data if its LUT record allows it */
+	if ( (fifo_lut_record.version != LUT_VERSION_LEGACY) &&
+		 (DataQ_ComputeCRC32( data, *size ) != fifo_lut_record.crc) ) {
+		return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Releases the memory backing a view of an entry.
+ *
+ *  This function hands the bounce buffer backing the view back to the
+ *  pool, or unmaps the part of the file mapped for the view, and then
+ *  invalidates the view.
+ *
+ *  @param[in] view - the reference of the view
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_ReleaseView( DataQ_View_t * view )
+{
+	int dataq_status = CODE_STATUS_OK;
+
+	if ( view->buffer >= 0 ) {
+
+		/* the bounce buffer is available again */
+		PSL_MutexLock( &DataQ_PoolMutex );
+		DataQ_PeekBufferUsed[ view->buffer ] = 0;
+		PSL_MutexUnlock( &DataQ_PoolMutex );
+
+	} else if ( FSAL_UnmapFile( (const uint8_t *) view->data, view->offset, view->size ) != FSAL_STATUS_OK ) {
+
+		/* file system access error */
+		dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	view->data = (const void *) 0;
+	view->buffer = -1;
+
+	return dataq_status;
+}
+
+/** @brief Claims a bounce buffer backing a view of an entry.
+ *
+ *  This function claims one of the pool of bounce buffers which is
+ *  available, as long as it is large enough for the size of the view,
+ *  and sets the view to it.
+ *
+ *  @param[in,out] view - the reference of the view
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_BUFFER_NOT_AVAIL
+ */
+static int DataQ_ClaimView( DataQ_View_t * view )
+{
+	int dataq_status = CODE_ERROR_BUFFER_TOO_SMALL;
+	int index;
+
+	if ( view->size <= DATA_QUEUE_PEEK_BUFFER_SIZE ) {
+		dataq_status = CODE_ERROR_BUFFER_NOT_AVAIL;
+		PSL_MutexLock( &DataQ_PoolMutex );
+		for ( index = 0; index < DATA_QUEUE_PEEK_BUFFER_COUNT; index++ ) {
+			if ( DataQ_PeekBufferUsed[index] == 0 ) {
+				DataQ_PeekBufferUsed[index] = 1;
+				view->buffer = index;
+				view->data = DataQ_PeekBufferPool[index];
+				dataq_status = CODE_STATUS_OK;
+				break;
+			}
+		}
+		PSL_MutexUnlock( &DataQ_PoolMutex );
+	}
+
+	return dataq_status;
+}
+
+/** @brief Unpacks a packed entry into a view.
+ *
+ *  This function reads the packed data of the viewed entry from the
+ *  opened file holding it into the packing buffer and unpacks it into
+ *  a bounce buffer claimed for the view (a packed entry can not be
+ *  mapped straight from its file), setting the size of the view to
+ *  the size of the unpacked data.
+ *
+ *  @param[in] fsal_handle - the handle associated to the file holding
+ *                           the entry
+ *
+ *  @param[in,out] view - the reference of the view
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_BUFFER_NOT_AVAIL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ */
+static int DataQ_UnpackView( FSAL_File_t fsal_handle, DataQ_View_t * view )
+{
+	size_t packed_size = view->record.length;
+	size_t size;
+	int dataq_status;
+
+	/* a packed entry is never larger than the packing buffer */
+	if ( packed_size > DATA_QUEUE_PACK_BUFFER_SIZE ) {
+		return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+	}
+
+	PSL_MutexLock( &DataQ_PackMutex );
+	if ( FSAL_ReadFileAt( fsal_handle, view->offset, DataQ_PackBuffer, packed_size ) != (ssize_t) packed_size ) {
+
+		/* file system access error */
+		dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+
+	} else {
+
+		/* determine the unpacked size first (an entry is never empty) */
+		view->size = 0;
+		dataq_status = DataQ_UnpackEntry( DataQ_PackBuffer, packed_size, (void *) 0, &view->size );
+		if ( dataq_status == CODE_ERROR_BUFFER_TOO_SMALL ) {
+			dataq_status = DataQ_ClaimView( view );
+		} else {
+			dataq_status = CODE_ERROR_QUEUE_ENTRY_CORRUPT;
+		}
+
+		/* and unpack the entry into the bounce buffer */
+		if ( dataq_status == CODE_STATUS_OK ) {
+			size = view->size;
+			dataq_status = DataQ_UnpackEntry( DataQ_PackBuffer, packed_size, DataQ_PeekBufferPool[ view->buffer ], &size );
+			if ( dataq_status != CODE_STATUS_OK ) {
+				DataQ_ReleaseView( view );
+			}
+		}
+	}
+	PSL_MutexUnlock( &DataQ_PackMutex );
+
+	return dataq_status;
+}
+
+#if !defined( DATA_QUEUE_NATIVE_LOCK )
+/** @brief Creates a lock file of a data queue.
+ *
+ *  This function creates the specified lock file of a data queue
+ *  with a single user, naming the boot and the session the lock is
+ *  taken in (so that the recovery of the data queue can tell a
+ *  stale lock apart).
+ *
+ *  @param[in] fsal_dir - the directory of the data queue
+ *
+ *  @param[in] lock_name - the name of the lock file
+ *
+ *  @return int - the status or error code of the filesystem layer
+ */
+static int DataQ_CreateLock( FSAL_Dir_t fsal_dir, char * lock_name )
+{
+	FSAL_File_t fsal_handle = -1;
+	DataQ_Lock_t fifo_lock;
+	int fsal_status;
+
+	PSL_memset( &fifo_lock, 0, sizeof(fifo_lock) );
+	fifo_lock.users = 1;
+	fifo_lock.boot_id = PSL_GetBootId();
+	fifo_lock.session_id = PSL_GetSessionId();
+
+	fsal_status = FSAL_OpenDirFile( fsal_dir, lock_name, FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE | FSAL_FLAGS_CREATE, &fsal_handle );
+	if ( fsal_status == FSAL_STATUS_OK ) {
+		if ( FSAL_WriteFile(fsal_handle, (uint8_t *)&fifo_lock, sizeof(fifo_lock)) != sizeof(fifo_lock) ) {
+			fsal_status = FSAL_ERROR_FILE_ACCESS;
+		}
+		FSAL_CloseFile( fsal_handle );
+	}
+
+	return fsal_status;
+}
+#endif
+
+/** @brief Acquires the lock of a data queue.
+ *
+ *  This function locks the data queue for the specified access type
+ *  so that concurrent access by at least 2 separate processes is
+ *  synchronized: any number of processes may hold a read-only lock
+ *  at the same time while a write-only or read/write lock is held
+ *  by a single process only.
+ *
+ *  With DATA_QUEUE_NATIVE_LOCK defined, the lock is a shared or an
+ *  exclusive lock of the directory provided by the filesystem layer
+ *  (which is also released if the process terminates). Otherwise
+ *  the lock is represented by lock files: the read-only lock file
+ *  starts with a byte value counting its users while the write-only
+ *  and read/write lock files are created with a single user, each of
+ *  them naming the boot and the session its first user took it in.
+ *
+ *  @param[in] fsal_dir - the directory of the data queue
+ *
+ *  @param[in] access - the access type the data queue is opened for
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_QUEUE_IS_BUSY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_AcquireLock( FSAL_Dir_t fsal_dir, int access )
+{
+	DATAQ_STATS_COUNT( lock_operations );
+
+#if defined( DATA_QUEUE_NATIVE_LOCK )
+	int fsal_status;
+
+	/* readers share the data queue while a writer needs it exclusively */
+	fsal_status = FSAL_LockDirectory( fsal_dir, (access == ACCESS_TYPE_READ_ONLY) ? FSAL_LOCK_SHARED : FSAL_LOCK_EXCLUSIVE );
+	if ( fsal_status == FSAL_ERROR_DIR_LOCKED ) {
+		return CODE_ERROR_QUEUE_IS_BUSY;
+	}
+
+	if ( fsal_status != FSAL_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	return CODE_STATUS_OK;
+#else
+	FSAL_File_t fsal_handle = -1;
+	size_t file_size;
+	int fsal_flags = FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE;
+	int fsal_status = FSAL_ERROR_FILE_ACCESS;
+	uint8_t users = 1;
+
+	/* check if fifo is already opened by another process by listing lock files */
+	if ( (FSAL_ListDirFile( fsal_dir, ".wolock", &file_size ) == FSAL_STATUS_OK) ||
+		 (FSAL_ListDirFile( fsal_dir, ".rwlock", &file_size ) == FSAL_STATUS_OK) ) {
+
+		/* fifo is already opened by another process with at least write access */
+		return CODE_ERROR_QUEUE_IS_BUSY;
+
+	} else if ( (FSAL_ListDirFile( fsal_dir, ".rolock", &file_size ) == FSAL_STATUS_OK) &&
+			    (access != ACCESS_TYPE_READ_ONLY) ) {
+
+		/**
+		 *  fifo is already opened by another process with read-only
+		 * access but write access is required
+		 */
+		return CODE_ERROR_QUEUE_IS_BUSY;
+
+	}
+
+	/* create the appropriate lock file */
+	if ( access == ACCESS_TYPE_READ_ONLY ) {
+
+		/* determine if another process is currently using the data queue */
+		if ( FSAL_ListDirFile( fsal_dir, ".rolock", &file_size ) == FSAL_ERROR_FILE_ACCESS ) {
+
+			/* this process is first user so create the lock file (with
+			 * the default user count set to 1) */
+			fsal_status = DataQ_CreateLock( fsal_dir, ".rolock" );
+
+		} else {
+
+			/* another process is first user so modify the lock file instead */
+			if ( FSAL_OpenDirFile(fsal_dir, ".rolock", fsal_flags, &fsal_handle) == FSAL_STATUS_OK ) {
+
+				/* read the current number of users from the lock file */
+				if ( FSAL_ReadFile(fsal_handle, (uint8_t *)&users, sizeof(users)) == sizeof(users) ) {
+
+					/* increment the number of users */
+					users++;
+
+					/* write the updated current number of users back over the old one */
+					if ( FSAL_WriteFileAt(fsal_handle, 0, (uint8_t *)&users, sizeof(users)) == sizeof(users) )
+						fsal_status = FSAL_STATUS_OK;
+				}
+
+				/* done modifying the lock file */
+				FSAL_CloseFile( fsal_handle );
+			}
+		}
+
+	} else if ( access == ACCESS_TYPE_WRITE_ONLY ) {
+
+		/* create the write-only lock file (user count assumed only one) */
+		fsal_status = DataQ_CreateLock( fsal_dir, ".wolock" );
+
+	} else {
+
+		/* create the read/write lock file (user count assumed only one) */
+		fsal_status = DataQ_CreateLock( fsal_dir, ".rwlock" );
+
+	}
+
+	/* check if appropriate lock file is added */
+	if ( fsal_status != FSAL_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	return CODE_STATUS_OK;
+#endif
+}
+
+/** @brief Releases the lock of a data queue.
+ *
+ *  This function releases the lock previously acquired for the
+ *  specified access type. For a read-only lock file, the byte value
+ *  counting its users is decremented by one and the lock file is
+ *  deleted once the count reaches zero. All other lock files are
+ *  deleted immediately as only one user is allowed at a time.
+ *
+ *  @param[in] fsal_dir - the directory of the data queue
+ *
+ *  @param[in] access - the access type the data queue was opened for
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_ReleaseLock( FSAL_Dir_t fsal_dir, int access )
+{
+	DATAQ_STATS_COUNT( lock_operations );
+
+#if defined( DATA_QUEUE_NATIVE_LOCK )
+	/* release the shared or exclusive lock of the directory */
+	if ( FSAL_UnlockDirectory( fsal_dir ) != FSAL_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	return CODE_STATUS_OK;
+#else
+	FSAL_File_t fsal_handle = -1;
+	int fsal_flags = FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE;
+	int fsal_status = FSAL_ERROR_FILE_ACCESS;
+	uint8_t users = 0;
+
+	if ( access == ACCESS_TYPE_READ_ONLY ) {
+
+		/* locate the read-only lock file associated with the data queue */
+		if ( FSAL_OpenDirFile(fsal_dir, ".rolock", fsal_flags, &fsal_handle) == FSAL_STATUS_OK ) {
+
+			/* read the current number of users from the lock file */
+			if ( FSAL_ReadFile(fsal_handle, (uint8_t *)&users, sizeof(users)) == sizeof(users) ) {
+
+				/* decrement the number of users */
+				users--;
+
+				/* write the updated current number of users back over the old one */
+				if ( FSAL_WriteFileAt(fsal_handle, 0, (uint8_t *)&users, sizeof(users)) == sizeof(users) )
+					fsal_status = FSAL_STATUS_OK;
+			}
+
+			/* done modifying the lock file */
+			FSAL_CloseFile( fsal_handle );
+
+			/* determine if no other processes are using the data queue */
+			if ( users == 0 ) {
+
+				/* delete the lock file */
+				fsal_status = FSAL_DeleteDirFile( fsal_dir, ".rolock" );
+			}
+		}
+
+	} else if ( access == ACCESS_TYPE_WRITE_ONLY ) {
+
+		/* delete the write-only lock file (only one user allowed) */
+		fsal_status = FSAL_DeleteDirFile( fsal_dir, ".wolock" );
+
+	} else {
+
+		/* delete the read/write lock file (only one user allowed) */
+		fsal_status = FSAL_DeleteDirFile( fsal_dir, ".rwlock" );
+
+	}
+
+	/* check if appropriate lock file is updated and/or deleted */
+	if ( fsal_status != FSAL_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	return CODE_STATUS_OK;
+#endif
+}
+
+/** @brief Checks if a data queue is locked by any process.
+ *
+ *  This function determines whether the lock of the data queue is
+ *  currently held, for any access type, by any process.
+ *
+ *  @param[in] fsal_dir - the directory of the data queue
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_QUEUE_IS_BUSY
+ */
+static int DataQ_ProbeLock( FSAL_Dir_t fsal_dir )
+{
+	DATAQ_STATS_COUNT( lock_operations );
+
+#if defined( DATA_QUEUE_NATIVE_LOCK )
+	/* the exclusive lock is only granted if nobody holds any lock */
+	if ( FSAL_LockDirectory( fsal_dir, FSAL_LOCK_EXCLUSIVE ) != FSAL_STATUS_OK ) {
+		return CODE_ERROR_QUEUE_IS_BUSY;
+	}
+
+	FSAL_UnlockDirectory( fsal_dir );
+
+	return CODE_STATUS_OK;
+#else
+	size_t file_size;
+
+	/* check if fifo is opened by another process by listing lock files */
+	if ( (FSAL_ListDirFile( fsal_dir, ".rolock", &file_size ) == FSAL_STATUS_OK) ||
+	     (FSAL_ListDirFile( fsal_dir, ".wolock", &file_size ) == FSAL_STATUS_OK) ||
+		 (FSAL_ListDirFile( fsal_dir, ".rwlock", &file_size ) == FSAL_STATUS_OK) ) {
+		return CODE_ERROR_QUEUE_IS_BUSY;
+	}
+
+	return CODE_STATUS_OK;
+#endif
+}
+
+/** @brief Clears the stale locks of a data queue.
+ *
+ *  This function deletes the lock files of a data queue left behind
+ *  by the sessions which are gone: the lock files taken during an
+ *  earlier boot, the write-only and read/write lock files taken by a
+ *  session which is no longer running (the users of a read-only lock
+ *  file are not named) and the lock files which do not name their
+ *  boot and session. With DATA_QUEUE_NATIVE_LOCK defined, the locks
+ *  go away along with the sessions holding them, so nothing is left
+ *  to clear.
+ *
+ *  @param[in] fsal_dir - the directory of the data queue
+ *
+ *  @param[out] cleared - the reference of the number of lock files
+ *                        cleared, which is incremented
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_QUEUE_IS_BUSY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_ClearStaleLocks( FSAL_Dir_t fsal_dir, uint32_t * cleared )
+{
+#if defined( DATA_QUEUE_NATIVE_LOCK )
+	return CODE_STATUS_OK;
+#else
+	static char * lock_names[] = { ".rolock", ".wolock", ".rwlock" };
+	FSAL_File_t fsal_handle = -1;
+	DataQ_Lock_t fifo_lock;
+	ssize_t read_size;
+	size_t file_size;
+	int dataq_status = CODE_STATUS_OK;
+	int index;
+
+	for ( index = 0; index < (int) (sizeof(lock_names) / sizeof(lock_names[0])); index++ ) {
+
+		/* nothing to clear if the lock file does not exist */
+		if ( FSAL_ListDirFile( fsal_dir, lock_names[index], &file_size ) == FSAL_ERROR_FILE_ACCESS ) {
+			continue;
+		}
+
+		/* read the boot and the session the lock was taken in */
+		read_size = -1;
+		if ( FSAL_OpenDirFile(fsal_dir, lock_names[index], FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_STATUS_OK ) {
+			read_size = FSAL_ReadFile( fsal_handle, (uint8_t *)&fifo_lock, sizeof(fifo_lock) );
+			FSAL_CloseFile( fsal_handle );
+		}
+		if ( read_size < 0 ) {
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+
+		/* keep the lock of a session which may still be running */
+		if ( ((size_t) read_size == sizeof(fifo_lock)) &&
+			 (fifo_lock.boot_id == PSL_GetBootId()) &&
+			 ((index == 0) || PSL_IsSessionAlive( fifo_lock.session_id )) ) {
+			dataq_status = CODE_ERROR_QUEUE_IS_BUSY;
+			continue;
+		}
+
+		/* delete the stale lock file */
+		if ( FSAL_DeleteDirFile( fsal_dir, lock_names[index] ) != FSAL_STATUS_OK ) {
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+		(*cleared)++;
+	}
+
+	return dataq_status;
+#endif
+}
+
+/** @brief Initializes the mutexes of the engine.
+ *
+ *  This function initializes the mutexes serializing the tasks (or
+ *  threads) using the engine, the events of the data queues and the
+ *  underlying filesystem abstraction layer, once, at the first call
+ *  to DataQ_InitEngine.
+ *
+ *  @param none
+ *
+ *  @return none
+ */
+static void DataQ_InitOnceRoutine( void )
+{
+	int index;
+
+	PSL_MutexInit( &DataQ_ListMutex );
+	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX; index++ ) {
+		PSL_MutexInit( &DataQ_QueueMutex[index] );
+		PSL_EventInit( &DataQ_QueueEvent[index] );
+	}
+	PSL_MutexInit( &DataQ_PackMutex );
+	PSL_MutexInit( &DataQ_PoolMutex );
+	PSL_MutexInit( &DataQ_JournalMutex );
+	PSL_MutexInit( &DataQ_AsyncMutex );
+#if defined( DATA_QUEUE_TRACE )
+	PSL_MutexInit( &DataQ_TraceMutex );
+#endif /* DATA_QUEUE_TRACE */
+
+	/* call the underlying filesystem abstraction layer */
+	FSAL_Init();
+}
+
+/** @brief Performs initialization of the first-in, first-out (FIFO)
+ *         data queue engine
+ *
+ *  This function initializes the data queue engine including the
+ *  underlying filesystem abstraction layer. The engine is initialized
+ *  only once even if more tasks (or threads) call this function,
+ *  after which all of them may use the engine at the same time:
+ *  operations on separate data queues run in parallel while the
+ *  operations on the same data queue are serialized. After a system
+ *  failure, each data queue may then be recovered (see
+ *  DataQ_FifoRecover) before it is opened.
+ *
+ *  @param none
+ *
+ *  @return none
+ */
+void DataQ_InitEngine( void )
+{
+	/* nothing is accounted to any data queue */
+	DATAQ_STATS_TARGET( (DataQ_Stats_t *) 0 );
+
+	/* initialize the engine only once whichever task calls first */
+	PSL_Once( &DataQ_InitOnce, DataQ_InitOnceRoutine );
+}
+
+/** @brief Creates a first-in, first-out (FIFO) data queue.
+ *
+ *  This function creates a specific type of data queue where first
+ *  data in is also the first data out. In nominal scenario, the
+ *  operation sets up the associated metadata and lookup table with
+ *  an empty (although pre-allocated) data queue.
+ *
+ *  By default, each entry is stored in a file of its own. With the
+ *  segmented storage flag, the entries are rather appended into a
+ *  rotating set of fixed-size segment files and a segment is deleted
+ *  as a whole once the 'head' end moves past it.
+ *
+ *  The data queue is created with the second header version, whose
+ *  32-bit offsets and reference count are not limited to 255 entries
+ *  (each entry file is then named after the hexadecimal digits of its
+ *  reference count). Its LUT is only ever cached a few pages at a
+ *  time, so a large LUT is never held in memory as a whole.
+ *
+ *  With the metadata journal flag, a change to the data queue is
+ *  committed by writing one record (the header and the changed LUT
+ *  entries, or as many records as these entries need) into the next
+ *  slots of a ring of fixed-size records kept in a journal file,
+ *  instead of rewriting both the LUT and header files. These files
+ *  are only brought up to date with changes already journaled, by a
+ *  checkpoint made before the ring runs out of room, and opening the
+ *  data queue replays the records written since the last checkpoint,
+ *  skipping a record torn by a power loss (along with the records of
+ *  a commit cut short). The changed LUT entries of a commit that spill
+ *  out of the cached LUT pages are journaled ahead of it, so a commit
+ *  may change at most as many LUT entries as the ring of records holds
+ *  (DATA_QUEUE_JOURNAL_RECORD_COUNT records, less the room kept for
+ *  the cached pages), beyond which it fails.
+ *
+ *  With the fixed record flag, every entry is exactly the maximum
+ *  entry size and the entries are kept in the slots of one ring file
+ *  preallocated for all of them, the slot of an entry being its LUT
+ *  offset. No LUT file is kept (nor any file created or deleted once
+ *  the data queue is created), the oldest entry is overwritten in
+ *  place once the data queue is full and the maximum flash size is
+ *  that of the ring file. This flag may not be combined with the
+ *  segmented storage flag, and the library may be built with the
+ *  record size set (DATA_QUEUE_FIXED_RECORD_SIZE) so that the size
+ *  of the record I/O is a compile-time constant, in which case it
+ *  must be the maximum entry size.
+ *
+ *  With the preallocate flag, the storage of the entries is reserved
+ *  up front (contiguously where the filesystem allows it): every
+ *  segment file of a data queue created with the segmented storage
+ *  flag is allocated to the segment size and then reused in place
+ *  rather than deleted and created again, as is the ring file of one
+ *  created with the fixed record flag. The flag may not be used for
+ *  a data queue keeping each entry in a file of its own.
+ *
+ *  @param[in] fifo_name - the reference by which the data queue is
+ *                         identified
+ *
+ *  @param[in] max_entries - the maximum allowable entries for the
+ *                           data queue to be created (if zero, 255
+ *                           entries are allowed)
+ *
+ *  @param[in] max_entry_size - the maximum allowable size of one
+ *                              data queue entry
+ *
+ *  @param[in] max_flash_size - the maximum allowable flash size for
+ *                              the data queue to be created
+ *
+ *  @param[in] flags - the bit mask information of the characteristics
+ *                     specific to the data queue:
+ *
+ *                     FLAGS_MESSAGE_LOG
+ *                     FLAGS_RANDOM_ACCESS
+ *                     FLAGS_SEGMENTED_STORAGE
+ *                     FLAGS_METADATA_JOURNAL
+ *                     FLAGS_FIXED_RECORD
+ *                     FLAGS_PREALLOCATE
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_QUEUE_EXISTS
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_FifoCreate( char * fifo_name, uint32_t max_entries, size_t max_entry_size, size_t max_flash_size, uint16_t flags )
+{
+	DataQ_Hdr_t fifo_hdr = {
+		.magic = HDR_MAGIC,
+		.hdr_version = HDR_VERSION_2,
+		.flash_size = 0,
+		.max_flash_size = max_flash_size,
+		.max_entry_size = max_entry_size,
+		.max_entries = max_entries,
+		.num_of_entries = 0,
+		.head_lut_offs = 0,
+		.tail_lut_offs = 0,
+		.seek_lut_offs = 0,
+		.lut_version = LUT_VERSION_SEQUENCE,
+		.reference_count = 0,
+		.flags = flags,
+	};
+	size_t fifo_lut_entry_size = DataQ_GetLUTEntrySize( &fifo_hdr );
+	char fifo_segment_reference[DATA_QUEUE_LUT_ENTRY_SIZE + 1];
+	FSAL_File_t fsal_handle = -1;
+	FSAL_Dir_t fsal_dir = -1;
+	int fsal_flags = FSAL_FLAGS_CREATE | FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE;
+	size_t lut_size;
+	size_t offset;
+	size_t chunk;
+	uint32_t index;
+
+	/* nothing is accounted to any data queue */
+	DATAQ_STATS_TARGET( (DataQ_Stats_t *) 0 );
+
+	/* check mandatory arguments for NULL pointers */
+	if ( fifo_name == (char *) 0 ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* check mandatory arguments for invalid values:
+	 *  - at least max_entries or max_flash_size must
+	 *    indicate the maximum size of the data queue
+	 *  - max_entry_size must be set
+	 *  - the storage reserved with the preallocate flag
+	 *    is that of the segment files or the ring file
+	 */
+	if ( ((max_entries == 0) && (max_flash_size == 0)) ||
+		 ( max_entry_size == 0 ) ||
+		 ((flags & FLAGS_PREALLOCATE) && ((flags & DATAQ_SHARED_STORAGE) == 0)) ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* adjust maximum entries if not specified */
+	if ( fifo_hdr.max_entries == 0 ) {
+		fifo_hdr.max_entries = 0xFF;
+	}
+
+	/* adjust maximum flash size if not specified */
+	if ( fifo_hdr.max_flash_size == 0 ) {
+		fifo_hdr.max_flash_size = fifo_hdr.max_entries * max_entry_size;
+	}
+
+	if ( flags & FLAGS_FIXED_RECORD ) {
+
+		/* the records are neither segmented nor of another size than the
+		 * record size, and the ring file holding them is within reach of
+		 * a 32-bit offset */
+		if ( (flags & FLAGS_SEGMENTED_STORAGE) ||
+			 (max_entry_size != DATAQ_RECORD_SIZE( &fifo_hdr )) ||
+			 (max_entry_size > (0xFFFFFFFF / fifo_hdr.max_entries)) ) {
+			return CODE_ERROR_INVALID_ARG;
+		}
+
+		/* the ring file holds exactly the maximum number of records */
+		fifo_hdr.max_flash_size = fifo_hdr.max_entries * max_entry_size;
+	}
+
+	/* check if data queue already exists */
+	if ( FSAL_OpenDirectory(fifo_name, &fsal_dir) == FSAL_STATUS_OK ) {
+
+		/* data queue exists so return back and exit */
+		FSAL_CloseDirectory( fsal_dir );
+		return CODE_ERROR_QUEUE_EXISTS;
+	}
+
+	/* create (and open) the directory associated with the fifo */
+	if ( (FSAL_MakeDirectory(fifo_name) == FSAL_ERROR_DIR_ACCESS) ||
+		 (FSAL_OpenDirectory(fifo_name, &fsal_dir) == FSAL_ERROR_DIR_ACCESS) ) {
+
+		/* file system access error */
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* create the header (or metadata) file associated with the fifo */
+	if ( (FSAL_OpenDirFile(fsal_dir, ".header", fsal_flags, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+		 (FSAL_WriteFile(fsal_handle, (uint8_t *)&fifo_hdr, sizeof(fifo_hdr)) < 0) ||
+		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+		/* delete the previously created directory */
+		FSAL_CloseDirectory( fsal_dir );
+		FSAL_RemoveDirectory( fifo_name );
+
+		/* file system access error */
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* create the (empty) metadata journal file associated with the fifo, if any */
+	if ( (flags & FLAGS_METADATA_JOURNAL) &&
+		 ((FSAL_OpenDirFile(fsal_dir, ".journal", fsal_flags, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+		  (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS)) ) {
+
+		/* delete the previously created directory */
+		FSAL_CloseDirectory( fsal_dir );
+		FSAL_RemoveDirectory( fifo_name );
+
+		/* file system access error */
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* create the ring file associated with the fifo instead of a LUT file,
+	 * allocated up front for all of its records */
+	if ( flags & FLAGS_FIXED_RECORD ) {
+
+		fsal_handle = -1;
+		if ( (FSAL_OpenDirFile(fsal_dir, DATAQ_RING_FILE_NAME, fsal_flags, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+			 (FSAL_AllocateFile(fsal_handle, fifo_hdr.max_flash_size) != FSAL_STATUS_OK) ||
+			 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+			/* delete the previously created directory */
+			if ( fsal_handle != -1 )
+				FSAL_CloseFile( fsal_handle );
+			FSAL_CloseDirectory( fsal_dir );
+			FSAL_RemoveDirectory( fifo_name );
+
+			/* file system access error */
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+
+		/* ring file fully allocated */
+		FSAL_CloseDirectory( fsal_dir );
+
+		/* operation succeeded */
+		return CODE_STATUS_OK;
+	}
+
+	/* create every segment file associated with the fifo, allocated up
+	 * front to the segment size, if the storage is to be preallocated */
+	for ( index = 0; (flags & FLAGS_PREALLOCATE) && (index < DATA_QUEUE_SEGMENT_COUNT); index++ ) {
+
+		fsal_handle = -1;
+		DataQ_MakeSegmentReference( index, fifo_segment_reference );
+		if ( (FSAL_OpenDirFile(fsal_dir, fifo_segment_reference, fsal_flags, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
+			 (FSAL_AllocateFile(fsal_handle, DataQ_GetSegmentSize( &fifo_hdr )) != FSAL_STATUS_OK) ||
+			 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+
+			/* delete the previously created directory */
+			if ( fsal_handle != -1 )
+				FSAL_CloseFile( fsal_handle );
+			FSAL_CloseDirectory( fsal_dir );
+			FSAL_RemoveDirectory( fifo_name );
+
+			/* file system access error */
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+	}
+
+	/* create the lut file associated with the fifo */
+	if ( FSAL_OpenDirFile(fsal_dir, ".lut", fsal_flags, &fsal_handle) == FSAL_STATUS_OK ) {
+
+		/* pre-populate the lut with max number of (invalid) entries, all
+		 * written at once unless the lut is larger than the zero block */
+		lut_size = (size_t) fifo_hdr.max_entries * fifo_lut_entry_size;
+		for ( offset = 0; offset < lut_size; offset += chunk ) {
+
+			chunk = lut_size - offset;
+			if ( chunk > sizeof(DataQ_ZeroBlock) ) {
+				chunk = sizeof(DataQ_ZeroBlock);
+			}
+
+			if ( FSAL_WriteFile(
+					fsal_handle,
+					(uint8_t *)DataQ_ZeroBlock,
+					chunk) < 0 ) {
+
+				/* at least one write operation failed */
+				FSAL_CloseFile( fsal_handle );
+
+				/* delete the previously created directory */
+				FSAL_CloseDirectory( fsal_dir );
+				FSAL_RemoveDirectory( fifo_name );
+
+				/* file system access error */
+				return CODE_ERROR_FS_ACCESS_FAIL;
+			}
+		}
+
+		/* lut file fully initialized */
+		FSAL_CloseFile( fsal_handle );
+		FSAL_CloseDirectory( fsal_dir );
+
+		/* operation succeeded */
+		return CODE_STATUS_OK;
+	}
+
+	/* delete the previously created file and directory */
+	FSAL_CloseDirectory( fsal_dir );
+	FSAL_RemoveDirectory( fifo_name );
+
+	/* file system access error */
+	return CODE_ERROR_FS_ACCESS_FAIL;
+}
+
+/** @brief Destroys a first-in, first-out (FIFO) data queue with its
+ *         lock held.
+ *
+ *  This function implements DataQ_FifoDestroy (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoDestroyLocked( char * fifo_name )
+{
+	FSAL_Dir_t fsal_dir = -1;
+	int index;
+
+	/* nothing is accounted to any data queue */
+	DATAQ_STATS_TARGET( (DataQ_Stats_t *) 0 );
+
+	/* check mandatory arguments for NULL pointers */
+	if ( fifo_name == (char *) 0 ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* check if folder associated with data queue is present by opening it */
+	if ( FSAL_OpenDirectory( fifo_name, &fsal_dir ) == FSAL_ERROR_DIR_ACCESS ) {
+		/* data queue does not exist so do nothing */
+		return CODE_STATUS_OK;
+	}
+
+	/* check if fifo is opened by this process */
+	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX; index++ ) {
+
+		/* locate the fifo name in the currently opened queue list */
+		if( (DataQ_FileHandleList[index].handle != DATA_QUEUE_FILE_HANDLE_INVALID) &&
+			(strcmp(fifo_name, DataQ_FileHandleList[index].name) == 0) ) {
+
+			/* fifo is still opened and maybe busy */
+			FSAL_CloseDirectory( fsal_dir );
+			return CODE_ERROR_QUEUE_IS_BUSY;
+		}
+	}
+
+	/* check if fifo is opened by another process */
+	if ( DataQ_ProbeLock( fsal_dir ) != CODE_STATUS_OK ) {
+
+		/* fifo is still opened by another and maybe busy */
+		FSAL_CloseDirectory( fsal_dir );
+		return CODE_ERROR_QUEUE_IS_BUSY;
+
+	}
+
+	/* delete the folder (all files within) associated with data queue */
+	FSAL_CloseDirectory( fsal_dir );
+	FSAL_RemoveDirectory( fifo_name );
+
+	/* operation succeeded */
+	return CODE_STATUS_OK;
+}
+
+/** @brief Destroys a first-in, first-out (FIFO) data queue.
+ *
+ *  This function destroys a specified data queue and frees up all
+ *  allocated resources associated with it. If the data queue does
+ *  not exist, it does not do anything and considers a successful
+ *  operation. If the data queue is currently opened at least by
+ *  one process, then operation will fail and the error code is set
+ *  to busy to indicate a retry can be done.
+ *
+ *  @param[in] fifo_name - the reference of the data queue to be
+ *                         destroyed
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_QUEUE_IS_BUSY
+ *
+ */
+int DataQ_FifoDestroy( char * fifo_name )
+{
+	int dataq_status;
+
+	/* serialize the operation with any other on the list of opened data queues */
+	PSL_MutexLock( &DataQ_ListMutex );
+	dataq_status = DataQ_FifoDestroyLocked( fifo_name );
+	PSL_MutexUnlock( &DataQ_ListMutex );
+
+	return dataq_status;
+}
+
+/** @brief Opens a first-in, first-out (FIFO) data queue for
+ *         access.
+ *
+ *  This function opens a specified data queue for access as
+ *  specified by the type of access (read-only, write-only or
+ *  read and write) and mode of access (normal or unpacked, or
+ *  binary or packed). If the operation succeeded, the output
+ *  parameter is updated with the fifo handle.
+ *
+ *  The entries enqueued through a handle opened with the binary
+ *  packed mode are packed with a small LZ77 codec before they are
+ *  written, as long as that takes less room (and the entry fits into
+ *  the packing buffer), so that fewer bytes are written and the flash
+ *  size of the data queue accounts for the packed size. The encoding
+ *  is kept in the LUT record of each entry, so that any handle reads
+ *  back the data as it was enqueued whatever its mode; a data queue
+ *  created with the legacy LUT version keeps no encoding and always
+ *  stores the data as it is.
+ *
+ *  The header of the data queue is loaded once into a state
+ *  block cached for the lifetime of the fifo handle, along with
+ *  the pages of the LUT as they are needed, and all other
+ *  operations on the handle work on that cache (writing it back
+ *  only when the data queue changes). A data queue created with
+ *  the first header version is opened as well and keeps its
+ *  header in that version. The
+ *  directory of the data queue is likewise resolved once and
+ *  all files are accessed in relative to it, so the current
+ *  directory is never changed.
+ *
+ *  If the data queue is already opened by this process, it
+ *  checks if the current access type and mode match the new
+ *  one - if it does, the function updates the output parameter
+ *  with the already opened fifo handle and considers a successful
+ *  operation; otherwise, the function considers a failed operation.
+ *  A data queue opened for read-only access is the exception: each
+ *  read-only open gets a fifo handle of its own (whatever its mode),
+ *  with its own cursor, sharing the header and LUT cached by the
+ *  readers already opened, so every reader scans the data queue at
+ *  its own pace and closes its own fifo handle.
+ *
+ *  If the data queue is already opened by another process, the
+ *  function checks if the fifo is opened for read-only access.
+ *  If it does, the passed access parameter should also be read
+ *  only so the operation can proceed. In all other conditions,
+ *  the function considers a failed operation and the error code
+ *  is set to busy to indicate a retry can be done.
+ *
+ *  In nominal case, the function will create lock files so that
+ *  concurrent access to the data queue by at least 2 separate
+ *  processes are synchronized and would not result to data queue
+ *  corruption. If the access type is read-only, the associated
+ *  lock file is either 1) created (if no other process has opened
+ *  the data queue) and write a byte value representing the number
+ *  of users the data queue have (in this case, it will be 1); or
+ *  2) opened (if there is at least another process that has the
+ *  data queue opened) and had the current byte value incremented
+ *  by one. For all other access type (write-only and read/write),
+ *  the associated lock files are created empty because only one
+ *  user is allowed for such access types. When the library is built
+ *  with DATA_QUEUE_NATIVE_LOCK, a shared (read-only) or exclusive
+ *  lock is instead taken on the data queue directory through the
+ *  FSAL and no lock file is created.
+ *
+ *  The lock is taken once and held by the fifo handle until the
+ *  fifo is closed; the other operations trust the handle and do
+ *  not probe the lock again.
+ *
+ *
+ *  @param[in] fifo_name - the reference of the data queue to be
+ *                         accessed
+ *
+ *  @param[in] access - the access type to be performed on the data
+ *                      data queue:
+ *
+ *						ACCESS_TYPE_READ_ONLY
+ *						ACCESS_TYPE_WRITE_ONLY
+ *						ACCESS_TYPE_READ_WRITE
+ *
+ *  @param[in] mode - the access mode to be considered on the data
+ *                    data queue:
+ *
+ *					  ACCESS_MODE_UNPACKED
+ *					  ACCESS_MODE_BINARY_PACKED
+ *
+ *  @param[out] fifo_handle - the reference where the pointer to the
+ *                            fifo handle is copied.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_QUEUE_MISSING
+ *                CODE_ERROR_QUEUE_OPENED
+ *                CODE_ERROR_QUEUE_IS_BUSY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_HANDLE_NOT_AVAIL
+ *
+ */
+int DataQ_FifoOpen( char * fifo_name, int access, int mode, DataQ_File_t ** fifo_handle )
+{
+	/* open the data queue with the default durability policy */
+	return DataQ_FifoOpenEx( fifo_name, access, mode, (DataQ_Durability_t *) 0, fifo_handle );
+}
+
+
+/** @brief Opens a first-in, first-out (FIFO) data queue with its lock
+ *         held.
+ *
+ *  This function implements DataQ_FifoOpenEx (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoOpenExLocked( char * fifo_name, int access, int mode, DataQ_Durability_t * durability, DataQ_File_t ** fifo_handle )
+{
+	FSAL_Dir_t fsal_dir = -1;
+	int dataq_status;
+	int shared = DATA_QUEUE_FILE_HANDLE_LIST_MAX;
+	int index;
+
+	/* nothing is accounted to any data queue until a handle is assigned */
+	DATAQ_STATS_TARGET( (DataQ_Stats_t *) 0 );
+
+	/* check mandatory arguments for NULL pointers */
+	if ( ( fifo_name == (char *) 0 ) || ( fifo_handle == (DataQ_File_t **) 0 ) ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* check mandatory arguments for invalid values */
+	if ( ( access >= ACCESS_TYPE_MAX ) || ( mode >= ACCESS_MODE_MAX ) ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* check optional arguments for invalid values */
+	if ( ( durability != (DataQ_Durability_t *) 0 ) &&
+		 ( ( durability->type < 0 ) || ( durability->type >= DURABILITY_TYPE_MAX ) ) ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* check if folder associated with data queue is present by opening it (this
+	 * resolves the directory once for all later operations on the fifo) */
+	if ( FSAL_OpenDirectory( fifo_name, &fsal_dir ) == FSAL_ERROR_DIR_ACCESS ) {
+		return CODE_ERROR_QUEUE_MISSING;
+	}
+
+	/* check if fifo is already opened by this process */
+	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX; index++ ) {
+
+		/* locate the fifo name in the currently opened queue list */
+		if( (DataQ_FileHandleList[index].handle != DATA_QUEUE_FILE_HANDLE_INVALID) &&
+			(strcmp(fifo_name, DataQ_FileHandleList[index].name) == 0) ) {
+
+			/* each reader gets a handle (and a cursor) of its own, sharing the
+			 * cached header and LUT of the readers already opened */
+			if ( (access == ACCESS_TYPE_READ_ONLY) &&
+				 (DataQ_FileHandleList[index].access == ACCESS_TYPE_READ_ONLY) ) {
+				shared = index;
+				break;
+			}
+
+			/* found an active fifo handle */
+			if ( (access == DataQ_FileHandleList[index].access) &&
+				 (mode == DataQ_FileHandleList[index].mode) ) {
+
+				/* fifo is already opened with the correct access parameters */
+				*fifo_handle = &DataQ_FileHandleList[index];
+				FSAL_CloseDirectory( fsal_dir );
+				return CODE_STATUS_OK;
+			}
+
+			/* fifo is already opened but with different access parameters */
+			FSAL_CloseDirectory( fsal_dir );
+			return CODE_ERROR_QUEUE_OPENED;
+		}
+	}
+
+	/* get a valid fifo handle */
+	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX; index++ ) {
+
+		/* locate an available fifo handle from the opened queue list */
+		if( DataQ_FileHandleList[index].handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+			break;
+		}
+	}
+
+	/* check if there are no more available handles */
+	if ( index == DATA_QUEUE_FILE_HANDLE_LIST_MAX ) {
+		FSAL_CloseDirectory( fsal_dir );
+		return CODE_ERROR_HANDLE_NOT_AVAIL;
+	}
+
+#if defined( DATA_QUEUE_STATS )
+	/* start the statistics of the handle afresh */
+	PSL_memset( &DataQ_FileStatsList[index], 0, sizeof(DataQ_Stats_t) );
+	DATAQ_STATS_TARGET( &DataQ_FileStatsList[index] );
+#endif
+
+	/* lock the data queue for the requested access type */
+	dataq_status = DataQ_AcquireLock( fsal_dir, access );
+	if ( dataq_status != CODE_STATUS_OK ) {
+		FSAL_CloseDirectory( fsal_dir );
+		return dataq_status;
+	}
+
+	/* set the durability policy of the handle */
+	PSL_memset( &DataQ_FileStateList[index].durability, 0, sizeof(DataQ_Durability_t) );
+	if ( durability != (DataQ_Durability_t *) 0 ) {
+		PSL_memcpy( &DataQ_FileStateList[index].durability, durability, sizeof(DataQ_Durability_t) );
+	}
+
+	/* the handle starts with a cursor that is not named */
+	DataQ_FileStateList[index].cursor[0] = '\0';
+	DataQ_FileStateList[index].cursor_dirty = 0;
+
+	/* and without any watermarks */
+	DataQ_FileStateList[index].high_watermark = 0;
+	DataQ_FileStateList[index].low_watermark = 0;
+
+	/* load the header and LUT once into the cached state of the handle
+	 * (a handle with read-only access never writes them), unless another
+	 * reader of this process already holds them */
+	DataQ_FileStateList[index].dir = fsal_dir;
+	DataQ_FileStateList[index].read_only = (access == ACCESS_TYPE_READ_ONLY);
+	if ( shared != DATA_QUEUE_FILE_HANDLE_LIST_MAX ) {
+		PSL_MutexLock( &DataQ_QueueMutex[shared] );
+		DataQ_ShareState( &DataQ_FileStateList[index], &DataQ_FileStateList[shared] );
+		PSL_MutexUnlock( &DataQ_QueueMutex[shared] );
+	} else if ( DataQ_LoadState( &DataQ_FileStateList[index] ) != CODE_STATUS_OK ) {
+		DataQ_ReleaseLock( fsal_dir, access );
+		FSAL_CloseDirectory( fsal_dir );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* the records of a fixed record fifo are of the record size the
+	 * library is built with */
+	if ( (DataQ_FileStateList[index].hdr.flags & FLAGS_FIXED_RECORD) &&
+		 (DataQ_FileStateList[index].hdr.max_entry_size != DATAQ_RECORD_SIZE( &DataQ_FileStateList[index].hdr )) ) {
+		DataQ_ReleaseLock( fsal_dir, access );
+		FSAL_CloseDirectory( fsal_dir );
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* position the cursor of the handle at the head end */
+	DataQ_FileStateList[index].seek_lut_offs = DataQ_FileStateList[index].hdr.head_lut_offs;
+
+	/* use the header and LUT files through memory if they can be mapped into
+	 * memory (otherwise they are read and written as usual) */
+	DataQ_MapState( &DataQ_FileStateList[index] );
+
+	/* fill in the available fifo handle (offset by one since a zero
+	 * handle value marks an available entry) */
+	DataQ_FileHandleList[index].handle = index + 1;
+	DataQ_FileHandleList[index].access = access;
+	DataQ_FileHandleList[index].mode = mode;
+	strncpy( DataQ_FileHandleList[index].name,
+			fifo_name,
+			sizeof(DataQ_FileHandleList[index].name) );
+
+	/* store the fifo handle pointer to the output parameter */
+	*fifo_handle = &DataQ_FileHandleList[index];
+
+	/* operation succeeded (the directory stays open until the fifo is closed) */
+	return CODE_STATUS_OK;
+}
+
+/** @brief Opens a first-in, first-out (FIFO) data queue for
+ *         access with a durability policy.
+ *
+ *  This function opens a specified data queue the same way as
+ *  DataQ_FifoOpen and sets the durability policy of the fifo
+ *  handle, which determines when the changes made through the
+ *  handle are committed to the LUT and header (or metadata) files
+ *  and when the files are synchronized with the storage media:
+ *
+ *  - DURABILITY_TYPE_DEFAULT commits the changes of every operation
+ *    and leaves the synchronization to the filesystem (this is the
+ *    policy of a data queue opened with DataQ_FifoOpen);
+ *  - DURABILITY_TYPE_SYNC commits the changes of every operation
+ *    and synchronizes the files written before the operation
+ *    returns;
+ *  - DURABILITY_TYPE_GROUP keeps the changes in the cached state
+ *    and commits and synchronizes them once the specified number
+ *    of operations is reached or the specified time has elapsed
+ *    since the first uncommitted operation (checked on every
+ *    operation, there is no timer);
+ *  - DURABILITY_TYPE_WRITE_BACK keeps the changes in the cached
+ *    state until DataQ_FifoFlush or DataQ_FifoClose is called,
+ *    which commit and synchronize them.
+ *
+ *  With the last two policies, the operations made since the last
+ *  commit are lost if the system fails before the next one, and
+ *  the data queue as seen by other processes only changes when a
+ *  commit is made. If the data queue is already opened by this
+ *  process (other than for read-only access, see DataQ_FifoOpen),
+ *  the durability policy of the fifo handle is left as it is.
+ *
+ *  @param[in] fifo_name - the reference of the data queue to be
+ *                         accessed
+ *
+ *  @param[in] access - the access type to be performed on the data
+ *                      data queue (see DataQ_FifoOpen)
+ *
+ *  @param[in] mode - the access mode to be considered on the data
+ *                    data queue (see DataQ_FifoOpen)
+ *
+ *  @param[in] durability - the reference of the durability policy
+ *                          or NULL for DURABILITY_TYPE_DEFAULT
+ *
+ *  @param[out] fifo_handle - the reference where the pointer to the
+ *                            fifo handle is copied.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_QUEUE_MISSING
+ *                CODE_ERROR_QUEUE_OPENED
+ *                CODE_ERROR_QUEUE_IS_BUSY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_FifoOpenEx( char * fifo_name, int access, int mode, DataQ_Durability_t * durability, DataQ_File_t ** fifo_handle )
+{
+	int dataq_status;
+
+	/* serialize the operation with any other on the list of opened data queues */
+	PSL_MutexLock( &DataQ_ListMutex );
+	dataq_status = DataQ_FifoOpenExLocked( fifo_name, access, mode, durability, fifo_handle );
+	PSL_MutexUnlock( &DataQ_ListMutex );
+
+	return dataq_status;
+}
+
+
+/** @brief Closes a first-in, first-out (FIFO) data queue with its
+ *         lock held.
+ *
+ *  This function implements DataQ_FifoClose (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoCloseLocked( DataQ_File_t * fifo_handle )
+{
+	int dataq_status = CODE_STATUS_OK;
+	int index;
+
+	/* check mandatory arguments for NULL pointers */
+	if ( fifo_handle == (DataQ_File_t *) 0 ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* check if fifo is actually opened by this process */
+	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX; index++ ) {
+
+		/* locate the fifo handle in the currently opened queue list */
+		if( (fifo_handle == &DataQ_FileHandleList[index]) &&
+			(fifo_handle->handle != DATA_QUEUE_FILE_HANDLE_INVALID) ) {
+			DATAQ_STATS_TARGET( &DataQ_FileStatsList[index] );
+
+			/* commit the changes still deferred under the durability policy */
+			if ( (DataQ_FileStateList[index].pending_ops != 0) &&
+				 (DataQ_FlushState( &DataQ_FileStateList[index], &DataQ_FileStateList[index].hdr ) != CODE_STATUS_OK) ) {
+				dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+			}
+
+			/* store the named cursor if it moved */
+			if ( DataQ_StoreCursor( &DataQ_FileStateList[index] ) != CODE_STATUS_OK ) {
+				dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+			}
+
+			/* write back and unmap the metadata mapped into memory, if any */
+			if ( DataQ_UnmapState( &DataQ_FileStateList[index] ) != CODE_STATUS_OK ) {
+				dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+			}
+
+			/* unlock the data queue for the access type it was opened for */
+			if ( DataQ_ReleaseLock( DataQ_FileStateList[index].dir, fifo_handle->access ) != CODE_STATUS_OK ) {
+				dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+			}
+
+			/* release the staging ring, if any, and whatever it still holds */
+			PSL_memset( &DataQ_StagingList[index], 0, sizeof(DataQ_Staging_t) );
+
+			/* release the directory associated with the data queue */
+			FSAL_CloseDirectory( DataQ_FileStateList[index].dir );
+			DataQ_FileStateList[index].dir = -1;
+
+			/* invalidate the handle for reuse */
+			memset( &DataQ_FileHandleList[index], DATA_QUEUE_FILE_HANDLE_INVALID, sizeof(DataQ_File_t) );
+
+			/* wake the tasks (or threads) waiting for entries (they find it closed) */
+			PSL_EventBroadcast( &DataQ_QueueEvent[index] );
+
+			/* found the handle so stop looking */
+			break;
+		}
+	}
+
+	/* check if the changes are committed and the lock is released */
+	if ( dataq_status != CODE_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* operation succeeded */
+	return CODE_STATUS_OK;
+}
+
+/** @brief Closes a first-in, first-out (FIFO) data queue for
+ *         access.
+ *
+ *  This function closes a specified data queue previously opened
+ *  for access. If the data queue is already closed, it does not
+ *  do anything and considers a successful operation. If the data
+ *  queue is missing, it returns an error code.
+ *
+ *  In nominal case, the function checks for the lock files as
+ *  indications of data queues opened by other processes. If
+ *  the lock file associated to a fifo that has been opened
+ *  with read-only exists, this function will read a byte value
+ *  (corresponds to the number of current user) and decrement
+ *  it by one. If the result is a zero value, the lock file
+ *  is deleted. For all other lock files (write-only or read
+ *  write access types), the lock file is deleted immediately
+ *  as such access types only allows one user at a time. Only the
+ *  lock file matching the access type of the fifo handle is
+ *  updated. When the library is built with DATA_QUEUE_NATIVE_LOCK,
+ *  the directory lock taken by the open is released instead.
+ *
+ *  The changes not yet committed under the durability policy of
+ *  the fifo handle are committed and synchronized first, and the
+ *  named cursor of the fifo handle, if any, is stored if it moved.
+ *  The staging ring of the fifo handle, if any, is released along
+ *  with the entries it still holds (see DataQ_FifoDrain).
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           closed
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_FifoClose( DataQ_File_t * fifo_handle )
+{
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the list of opened data
+	 * queues and on the same data queue (always locked in this order) */
+	PSL_MutexLock( &DataQ_ListMutex );
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoCloseLocked( fifo_handle );
+	DataQ_UnlockQueue( fifo_mutex );
+	PSL_MutexUnlock( &DataQ_ListMutex );
+
+	return dataq_status;
+}
+
+/** @brief Recovers a first-in, first-out (FIFO) data queue at
+ *         start-up with the list lock held.
+ *
+ *  This function implements DataQ_FifoRecover (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the list of opened
+ *  data queues.
+ */
+static int DataQ_FifoRecoverLocked( char * fifo_name, int check, DataQ_Recovery_t * report )
+{
+	DataQ_Recovery_t fifo_report;
+	DataQ_File_t * fifo_handle;
+	DataQ_State_t * fifo_state;
+	PSL_Mutex_t * fifo_mutex;
+	FSAL_Dir_t fsal_dir = -1;
+	uint32_t start = PSL_GetTimestamp();
+	int dataq_status;
+	int index;
+
+	/* nothing is accounted to any data queue */
+	DATAQ_STATS_TARGET( (DataQ_Stats_t *) 0 );
+
+	/* check mandatory arguments for NULL pointers and the check type */
+	if ( (fifo_name == (char *) 0) || (check < 0) || (check >= RECOVERY_CHECK_MAX) ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+	PSL_memset( &fifo_report, 0, sizeof(fifo_report) );
+
+	/* a data queue opened by this process is in use, not left behind */
+	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX; index++ ) {
+		if( (DataQ_FileHandleList[index].handle != DATA_QUEUE_FILE_HANDLE_INVALID) &&
+			(strcmp(fifo_name, DataQ_FileHandleList[index].name) == 0) ) {
+			return CODE_ERROR_QUEUE_OPENED;
+		}
+	}
+
+	/* check if folder associated with data queue is present by opening it */
+	if ( FSAL_OpenDirectory( fifo_name, &fsal_dir ) == FSAL_ERROR_DIR_ACCESS ) {
+		return CODE_ERROR_QUEUE_MISSING;
+	}
+
+	/* clear the lock files left behind by the sessions which are gone */
+	dataq_status = DataQ_ClearStaleLocks( fsal_dir, &fifo_report.locks_cleared );
+	FSAL_CloseDirectory( fsal_dir );
+
+	/* open the data queue for exclusive access (which also replays its
+	 * metadata journal, if any) and check its entries */
+	if ( dataq_status == CODE_STATUS_OK ) {
+		dataq_status = DataQ_FifoOpenExLocked( fifo_name, ACCESS_TYPE_READ_WRITE, ACCESS_MODE_UNPACKED,
+											   (DataQ_Durability_t *) 0, &fifo_handle );
+	}
+	if ( dataq_status == CODE_STATUS_OK ) {
+		fifo_mutex = DataQ_LockQueue( fifo_handle );
+		fifo_state = DataQ_GetState( fifo_handle );
+		dataq_status = DataQ_CheckEntries( fifo_state, check, &fifo_report );
+		if ( (DataQ_FifoCloseLocked( fifo_handle ) != CODE_STATUS_OK) && (dataq_status == CODE_STATUS_OK) ) {
+			dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+		}
+		DataQ_UnlockQueue( fifo_mutex );
+	}
+
+	/* report the recovery, whatever its outcome */
+	fifo_report.elapsed_time = PSL_GetTimestamp() - start;
+	if ( report != (DataQ_Recovery_t *) 0 ) {
+		PSL_memcpy( report, &fifo_report, sizeof(fifo_report) );
+	}
+
+	return dataq_status;
+}
+
+/** @brief Recovers a first-in, first-out (FIFO) data queue at
+ *         start-up.
+ *
+ *  This function brings a data queue back to a consistent state
+ *  after the system failed (such as on a power loss) while the data
+ *  queue was in use. It is meant to be called at start-up for each
+ *  data queue, right after DataQ_InitEngine and before the data
+ *  queue is opened (the engine does not know which data queues are
+ *  kept on the filesystem).
+ *
+ *  The lock files left behind by the sessions which are gone are
+ *  cleared first: a lock file is stale if it was taken during an
+ *  earlier boot, or for write access by a session which is no
+ *  longer running (see PSL_GetBootId and PSL_IsSessionAlive), or if
+ *  it does not name its boot and session (as left by an earlier
+ *  version of the library). A data queue still locked otherwise is
+ *  busy. When the library is built with DATA_QUEUE_NATIVE_LOCK, the
+ *  locks go away along with the sessions holding them, so there is
+ *  nothing to clear.
+ *
+ *  The header (or metadata, once its journal is replayed) is then
+ *  checked against the LUT and the storage of the entries, streaming
+ *  through the entries once from the 'head' end: each entry must be
+ *  listed with the size its LUT record keeps (within its segment or
+ *  ring file in shared storage) and, with RECOVERY_CHECK_DATA, its
+ *  data must match the CRC32 its LUT record keeps (read back through
+ *  a buffer of DATA_QUEUE_RECOVERY_BUFFER_SIZE bytes whatever the
+ *  size of the entries; a fixed record keeps no CRC32 and the CRC32
+ *  of a packed entry covers its unpacked data, so only their size is
+ *  checked). Each entry must also follow on from the one before it:
+ *  the reference its LUT record keeps (if any) must be the reference
+ *  of its position, and an entry in segmented storage must lie right
+ *  after the previous entry within its segment or at the start of the
+ *  next one. The entries missing, corrupt or out of sequence at the
+ *  'head' end, as left by a torn eviction, are dropped, while the
+ *  first such entry after a sound one, as left by a torn enqueue,
+ *  truncates the data queue there, unless its LUT record is cleared
+ *  and sound entries follow it up to the 'tail' end: the gap was then
+ *  left by a torn eviction (whose LUT records are not stored from the
+ *  'head' end on) and the entries before it are dropped instead. A
+ *  full data queue whose LUT was
+ *  committed one enqueue ahead of its header keeps the entry enqueued
+ *  last at the 'head' end, and that enqueue is completed instead.
+ *  The number of entries and the flash size are then set from the
+ *  entries kept and the repaired header and LUT are committed. A
+ *  header which can not locate the entries is beyond repair (the
+ *  data queue has to be destroyed and created again).
+ *
+ *  The time the recovery takes is bounded by the size of the data
+ *  queue: the lock files, the header and LUT files and one listing
+ *  per entry with RECOVERY_CHECK_METADATA, plus one open and one read
+ *  per DATA_QUEUE_RECOVERY_BUFFER_SIZE bytes of each entry with
+ *  RECOVERY_CHECK_DATA. The time it actually took is reported.
+ *
+ *
+ *  @param[in] fifo_name - the reference of the data queue to be
+ *                         recovered
+ *
+ *  @param[in] check - the type of check of the entries:
+ *
+ *                     RECOVERY_CHECK_METADATA
+ *                     RECOVERY_CHECK_DATA
+ *
+ *  @param[out] report - the reference where the report of the
+ *                       recovery is copied (may be null)
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_QUEUE_MISSING
+ *                CODE_ERROR_QUEUE_OPENED
+ *                CODE_ERROR_QUEUE_IS_BUSY
+ *                CODE_ERROR_HANDLE_NOT_AVAIL
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ *
+ */
+int DataQ_FifoRecover( char * fifo_name, int check, DataQ_Recovery_t * report )
+{
+	int dataq_status;
+
+	/* serialize the operation with any other on the list of opened data queues */
+	PSL_MutexLock( &DataQ_ListMutex );
+	dataq_status = DataQ_FifoRecoverLocked( fifo_name, check, report );
+	PSL_MutexUnlock( &DataQ_ListMutex );
+
+	return dataq_status;
+}
+
+
+/** @brief Flushes a first-in, first-out (FIFO) data queue with its
+ *         lock held.
+ *
+ *  This function implements DataQ_FifoFlush (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoFlushLocked( DataQ_File_t * fifo_handle )
+{
+	DataQ_State_t * fifo_state;
+
+	/* check mandatory arguments for NULL pointers */
+	if ( fifo_handle == (DataQ_File_t *) 0 ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
+	}
+
+	/* check if fifo is still opened (the cached state is only valid while it is) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
+
+	/* store the named cursor if it moved */
+	if ( DataQ_StoreCursor( fifo_state ) != CODE_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* nothing to commit */
+	if ( fifo_state->pending_ops == 0 ) {
+		return CODE_STATUS_OK;
+	}
+
+	/* commit the changes kept in the cached state */
+	if ( DataQ_FlushState( fifo_state, &fifo_state->hdr ) != CODE_STATUS_OK ) {
+
+		/* resynchronize the cached state with the files */
+		DataQ_LoadState( fifo_state );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* operation succeeded */
+	return CODE_STATUS_OK;
+}
+
+/** @brief Flushes a first-in, first-out (FIFO) data queue.
+ *
+ *  This function commits the changes made through the specified
+ *  fifo handle that are not yet committed under its durability
+ *  policy and synchronizes the files written with the storage
+ *  media (the files are only synchronized with a policy other than
+ *  DURABILITY_TYPE_DEFAULT). The named cursor of the fifo handle,
+ *  if any, is stored as well if it moved. If there is nothing to
+ *  commit, it does not do anything and considers a successful
+ *  operation.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           flushed
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_FifoFlush( DataQ_File_t * fifo_handle )
+{
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoFlushLocked( fifo_handle );
+	DataQ_UnlockQueue( fifo_mutex );
+
+	return dataq_status;
+}
+
+
+/** @brief Enqueues an entry into the specified first-in, first-out
+ *         (FIFO) data queue.
+ *
+ *  This function enqueues or inserts a new entry into the specified
+ *  data queue. For a FIFO type of queue, insertion happens on the
+ *  'tail' end only (where the youngest entry can be found) and not
+ *  anywhere else. If the data queue is full, then the oldest entry
+ *  in the queue, located in the 'head' end, is removed from the queue
+ *  before the new entry is inserted.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the enqueue operation.
+ *
+ *  @param[in] data - the reference of the data to be enqueued.
+ *
+ *  @param[in] size - the size of the data to be enqueued.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_READ_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_ENTRY_NOT_LISTED
+ *
+ */
+int DataQ_FifoEnqueue( DataQ_File_t * fifo_handle, void * data, size_t size )
+{
+	const void * batch_data = data;
+
+	/* check mandatory arguments for NULL pointers */
+	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( data == (void *) 0 ) ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* a single entry is enqueued as a batch of one */
+	return DataQ_FifoEnqueueBatch( fifo_handle, &batch_data, &size, 1 );
+}
+
+
+/** @brief Enqueues a batch of entries into a data queue with its lock
+ *         held.
+ *
+ *  This function implements DataQ_FifoEnqueueBatch (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoEnqueueBatchLocked( DataQ_File_t * fifo_handle, const void ** data, const size_t * sizes, size_t count )
+{
+	size_t batch_size = 0;
+	size_t batch_first;
+	DataQ_State_t * fifo_state;
+	DataQ_Hdr_t fifo_hdr;
+	int dataq_status = CODE_STATUS_OK;
+	size_t index;
+
+	/* check mandatory arguments for NULL pointers */
+	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( data == (const void **) 0 ) || ( sizes == (const size_t *) 0 ) ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* check mandatory arguments for invalid values */
+	if ( count == 0 ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	for ( index = 0; index < count; index++ ) {
+		if ( ( data[index] == (const void *) 0 ) || ( sizes[index] == 0 ) ) {
+			return CODE_ERROR_INVALID_ARG;
+		}
+	}
+
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
+	}
+
+	/* check if write access is allowed */
+	if ( ( fifo_handle->access != ACCESS_TYPE_WRITE_ONLY ) &&
+		 ( fifo_handle->access != ACCESS_TYPE_READ_WRITE ) ) {
+		return CODE_ERROR_QUEUE_READ_ONLY;
+	}
+
+	/* check if fifo is still opened (the lock taken when the fifo was
+	 * opened is trusted so no lock file is probed here) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
+
+	/* work on a copy of the cached header (or metadata) of the fifo */
+	PSL_memcpy( &fifo_hdr, &fifo_state->hdr, sizeof(DataQ_Hdr_t) );
+
+	/* validate the entry size of the data to be enqueued */
+	for ( index = 0; index < count; index++ ) {
+		if ( (sizes[index] > fifo_hdr.max_entry_size) ||
+			 (sizes[index] > fifo_hdr.max_flash_size) ||
+			 ((fifo_hdr.flags & FLAGS_FIXED_RECORD) && (sizes[index] != DATAQ_RECORD_SIZE( &fifo_hdr ))) ) {
+
+			/* data size is bigger that what is allowed */
+			return CODE_ERROR_INVALID_ARG;
+		}
+	}
+
+	/* determine the youngest part of the batch that fits into the fifo
+	 * by itself (anything older would be removed by the batch anyway) */
+	for ( batch_first = count; batch_first > 0; batch_first-- ) {
+		if ( ((count - batch_first + 1) > fifo_hdr.max_entries) ||
+			 ((batch_size + sizes[batch_first - 1]) > fifo_hdr.max_flash_size) ) {
+			break;
+		}
+		batch_size += sizes[batch_first - 1];
+	}
+
+	/* dropped entries still consume their references */
+	fifo_hdr.reference_count += batch_first;
+
+	/* the room a packed entry takes on flash is only known once it is
+	 * packed, so that room is made as each of them is appended */
+	if ( fifo_handle->mode == ACCESS_MODE_BINARY_PACKED ) {
+		batch_size = 0;
+	}
+
+	/* determine if fifo would be maxed out by the batch in terms either of
+	 * the number of entries allowed or the flash size allowed and make room
+	 * for the whole batch
+	 */
+	while ( (fifo_hdr.num_of_entries > 0) &&
+			(((fifo_hdr.num_of_entries + (count - batch_first)) > fifo_hdr.max_entries) ||
+			 ((fifo_hdr.flash_size + batch_size) > fifo_hdr.max_flash_size)) ) {
+
+		/* remove the oldest entry */
+		DATAQ_STATS_COUNT( evictions );
+		dataq_status = DataQ_EvictHead( fifo_state, &fifo_hdr );
+		if ( dataq_status != CODE_STATUS_OK ) {
+
+			/* resynchronize the cached LUT with the LUT file */
+			DataQ_LoadState( fifo_state );
+			return dataq_status;
+		}
+	}
+
+	/* write the batch at the tail end of the fifo */
+	for ( index = batch_first; index < count; index++ ) {
+		dataq_status = DataQ_AppendEntry( fifo_state, &fifo_hdr, data[index], sizes[index], fifo_handle->mode == ACCESS_MODE_BINARY_PACKED );
+		if ( dataq_status != CODE_STATUS_OK ) {
+
+			/* commit whatever was already done */
+			break;
+		}
+		DATAQ_STATS_COUNT( enqueues );
+		DATAQ_TRACE_PAYLOAD( fifo_state - DataQ_FileStateList, sizes[index] );
+	}
+
+	/* commit the LUT and the header (or metadata) under the durability policy */
+	if ( DataQ_CommitState( fifo_state, &fifo_hdr ) != CODE_STATUS_OK ) {
+
+		/* resynchronize the cached state with the files */
+		DataQ_LoadState( fifo_state );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* wake the tasks (or threads) waiting for entries */
+	PSL_EventBroadcast( &DataQ_QueueEvent[ fifo_state - DataQ_FileStateList ] );
+
+	/* operation completed */
+	return dataq_status;
+}
+
+/** @brief Enqueues a batch of entries into the specified first-in,
+ *         first-out (FIFO) data queue.
+ *
+ *  This function enqueues or inserts new entries into the specified
+ *  data queue, in the order given, as if each of them were enqueued
+ *  individually. The oldest entries are removed from the 'head' end
+ *  of the queue to make room for the whole batch in one go (entries
+ *  at the front of a batch that does not fit the queue by itself are
+ *  dropped without being written), all payloads are written, and the
+ *  LUT and header (or metadata) files are then updated only once.
+ *
+ *  If writing one of the payloads fails, the entries preceding it
+ *  stay enqueued (and committed) and the error code is returned.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the enqueue operation.
+ *
+ *  @param[in] data - the references of the data to be enqueued.
+ *
+ *  @param[in] sizes - the sizes of the data to be enqueued.
+ *
+ *  @param[in] count - the number of data to be enqueued.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_READ_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_ENTRY_NOT_LISTED
+ *
+ */
+int DataQ_FifoEnqueueBatch( DataQ_File_t * fifo_handle, const void ** data, const size_t * sizes, size_t count )
+{
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoEnqueueBatchLocked( fifo_handle, data, sizes, count );
+	DataQ_UnlockQueue( fifo_mutex );
+
+	return dataq_status;
+}
+
+
+/** @brief Enqueues an entry into the specified first-in, first-out
+ *         (FIFO) data queue asynchronously.
+ *
+ *  This function enqueues a new entry into the specified data queue
+ *  as DataQ_FifoEnqueue does, except that the writes, closes and
+ *  deletes of files it requests from a filesystem deferring requests
+ *  (FSAL_LINUX_URING) are only queued, to be submitted along with
+ *  those of the other operations, so that the function returns
+ *  without waiting for them. The operation completes once all of
+ *  them did, when DataQ_Poll calls the specified callback with the
+ *  status of the operation (the callback is called by the first
+ *  poll for filesystems which never defer requests).
+ *
+ *  The entry is enqueued into the cached state of the data queue
+ *  right away so that any later operation on it sees the entry. If
+ *  a deferred request fails, the operation it belongs to and those
+ *  completing after it (until no operation is left in flight) fail,
+ *  and the cached state of their data queues is read back from their
+ *  files then.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the enqueue operation.
+ *
+ *  @param[in] data - the reference of the data to be enqueued.
+ *
+ *  @param[in] size - the size of the data to be enqueued.
+ *
+ *  @param[in] callback - the function called once the operation
+ *                        completed
+ *
+ *  @param[in] context - the reference passed to the callback
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_READ_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_ENTRY_NOT_LISTED
+ *                CODE_ERROR_BUFFER_NOT_AVAIL
+ *
+ */
+int DataQ_FifoEnqueueAsync( DataQ_File_t * fifo_handle, void * data, size_t size, DataQ_Callback_t callback, void * context )
+{
+	const void * batch_data = data;
+	PSL_Mutex_t * fifo_mutex;
+	DataQ_Async_t * async;
+	uint32_t last_ticket;
+	int dataq_status;
+
+	/* check mandatory arguments for NULL pointers */
+	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( data == (void *) 0 ) || ( callback == (DataQ_Callback_t) 0 ) ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* reserve the room to list the operation until it completes */
+	PSL_MutexLock( &DataQ_AsyncMutex );
+	if ( (DataQ_AsyncCount + DataQ_AsyncStarted) >= DATA_QUEUE_ASYNC_OP_MAX ) {
+		PSL_MutexUnlock( &DataQ_AsyncMutex );
+		return CODE_ERROR_BUFFER_NOT_AVAIL;
+	}
+	DataQ_AsyncStarted++;
+	PSL_MutexUnlock( &DataQ_AsyncMutex );
+
+	/* enqueue the entry as a batch of one with the FSAL requests deferred */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	FSAL_DeferWrites( 1 );
+	dataq_status = DataQ_FifoEnqueueBatchLocked( fifo_handle, &batch_data, &size, 1 );
+	FSAL_DeferWrites( 0 );
+	last_ticket = FSAL_GetWriteTicket();
+	DataQ_UnlockQueue( fifo_mutex );
+
+	/* list the operation until the requests deferred so far complete */
+	PSL_MutexLock( &DataQ_AsyncMutex );
+	DataQ_AsyncStarted--;
+	if ( dataq_status == CODE_STATUS_OK ) {
+		async = &DataQ_AsyncList[ (DataQ_AsyncFirst + DataQ_AsyncCount) % DATA_QUEUE_ASYNC_OP_MAX ];
+		async->fifo_handle = fifo_handle;
+		async->callback = callback;
+		async->context = context;
+		async->last_ticket = last_ticket;
+		DataQ_AsyncCount++;
+	}
+	PSL_MutexUnlock( &DataQ_AsyncMutex );
+
+	return dataq_status;
+}
+
+/** @brief Polls the asynchronous operations for completion.
+ *
+ *  This function submits the requests the asynchronous operations
+ *  on any data queue deferred so far and calls the callback of each
+ *  operation whose requests completed, in the order the operations
+ *  were started (see DataQ_FifoEnqueueAsync). Optionally, it waits
+ *  for all the operations started so far to complete. The callbacks
+ *  are called without any lock held by the engine, so they may
+ *  operate on the data queues.
+ *
+ *
+ *  @param[in] wait - non-zero to wait for all the operations started
+ *                    so far to complete
+ *
+ *  @param[out] count - the number of operations completed (may be
+ *                      null)
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_Poll( int wait, size_t * count )
+{
+	DataQ_State_t * fifo_state;
+	PSL_Mutex_t * fifo_mutex;
+	DataQ_Async_t async;
+	uint32_t completed;
+	uint32_t failed;
+	size_t polled = 0;
+	int dataq_status;
+	int fsal_status;
+
+	/* submit the deferred requests and reap those completed */
+	fsal_status = FSAL_PollWrites( wait ? FSAL_SYNC_WAIT : FSAL_SYNC_ASYNC, &completed, &failed );
+
+	PSL_MutexLock( &DataQ_AsyncMutex );
+	if ( DATAQ_TICKET_BEFORE( DataQ_AsyncCompleted, completed ) ) {
+		DataQ_AsyncCompleted = completed;
+	}
+	if ( (failed != 0) && ((DataQ_AsyncFailed == 0) || DATAQ_TICKET_BEFORE( failed, DataQ_AsyncFailed )) ) {
+		DataQ_AsyncFailed = failed;
+	}
+
+	/* complete the operations in order, as long as their requests did */
+	while ( (DataQ_AsyncCount > 0) &&
+			!DATAQ_TICKET_BEFORE( DataQ_AsyncCompleted, DataQ_AsyncList[ DataQ_AsyncFirst ].last_ticket ) ) {
+		async = DataQ_AsyncList[ DataQ_AsyncFirst ];
+		DataQ_AsyncFirst = (DataQ_AsyncFirst + 1) % DATA_QUEUE_ASYNC_OP_MAX;
+		DataQ_AsyncCount--;
+
+		/* any operation completing after a failed request fails too */
+		dataq_status = CODE_STATUS_OK;
+		if ( (DataQ_AsyncFailed != 0) && !DATAQ_TICKET_BEFORE( async.last_ticket, DataQ_AsyncFailed ) ) {
+			dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+		}
+		PSL_MutexUnlock( &DataQ_AsyncMutex );
+
+		if ( dataq_status != CODE_STATUS_OK ) {
+
+			/* resynchronize the cached state with the files */
+			fifo_mutex = DataQ_LockQueue( async.fifo_handle );
+			fifo_state = DataQ_GetState( async.fifo_handle );
+			if ( (fifo_state != (DataQ_State_t *) 0) &&
+				 (async.fifo_handle->handle != DATA_QUEUE_FILE_HANDLE_INVALID) ) {
+				DataQ_LoadState( fifo_state );
+			}
+			DataQ_UnlockQueue( fifo_mutex );
+		}
+
+		async.callback( async.fifo_handle, dataq_status, async.context );
+		polled++;
+
+		PSL_MutexLock( &DataQ_AsyncMutex );
+	}
+
+	/* a failed request is accounted for once no operation is in flight */
+	if ( (DataQ_AsyncCount == 0) && (DataQ_AsyncStarted == 0) ) {
+		DataQ_AsyncFailed = 0;
+	}
+	PSL_MutexUnlock( &DataQ_AsyncMutex );
+
+	if ( count != (size_t *) 0 ) {
+		*count = polled;
+	}
+
+	/* check if the deferred requests were submitted */
+	if ( fsal_status != FSAL_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* operation succeeded */
+	return CODE_STATUS_OK;
+}
+
+
+/** @brief Dequeues an entry from a data queue with its lock held.
+ *
+ *  This function implements DataQ_FifoDequeue (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoDequeueLocked( DataQ_File_t * fifo_handle, void * data, size_t * size )
+{
+	DataQ_State_t * fifo_state;
+	DataQ_Hdr_t fifo_hdr;
+	int dataq_status;
+
+	/* check mandatory arguments for NULL pointers */
+	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( data == (void *) 0 ) || ( size == (size_t *) 0 ) ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
+	}
+
+	/* check if write access is allowed */
+	if ( ( fifo_handle->access != ACCESS_TYPE_WRITE_ONLY ) &&
+		 ( fifo_handle->access != ACCESS_TYPE_READ_WRITE ) ) {
+		return CODE_ERROR_QUEUE_READ_ONLY;
+	}
+
+	/* check if fifo is still opened (the lock taken when the fifo was
+	 * opened is trusted so no lock file is probed here) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
+
+	/* work on a copy of the cached header (or metadata) of the fifo */
+	PSL_memcpy( &fifo_hdr, &fifo_state->hdr, sizeof(DataQ_Hdr_t) );
+
+	/* determine if fifo is empty (the head offset is left one past the
+	 * tail offset once the last entry is dequeued, so only the entry
+	 * counter is reliable here) */
+	if ( fifo_hdr.num_of_entries == 0 ) {
+
+		/* nothing to return */
+		return CODE_ERROR_QUEUE_IS_EMPTY;
+
+	}
+
+	/* copy the dequeued data and set its size (a corrupt entry is still
+	 * removed so that it does not stall the fifo) */
+	dataq_status = DataQ_ReadEntry( fifo_state, fifo_hdr.head_lut_offs, data, size );
+	if ( (dataq_status != CODE_STATUS_OK) &&
+		 (dataq_status != CODE_ERROR_QUEUE_ENTRY_CORRUPT) ) {
+		return dataq_status;
+	}
+
+	/* remove the oldest entry (the file and the LUT entry) */
+	if ( DataQ_EvictHead( fifo_state, &fifo_hdr ) != CODE_STATUS_OK ) {
+
+		/* resynchronize the cached LUT with the LUT file */
+		DataQ_LoadState( fifo_state );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* commit the LUT and the header (or metadata) under the durability policy */
+	if ( DataQ_CommitState( fifo_state, &fifo_hdr ) != CODE_STATUS_OK ) {
+
+		/* resynchronize the cached state with the files */
+		DataQ_LoadState( fifo_state );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+	DATAQ_STATS_COUNT( dequeues );
+
+	/* operation completed */
+	return dataq_status;
+}
+
+/** @brief Dequeues an entry from the specified first-in, first-out
+ *         (FIFO) data queue.
+ *
+ *  This function dequeues or removes a new entry on the specified
+ *  data queue. For a FIFO type of queue, deletion happens on the
+ *  'head' end only (where the oldest entry can be found) and not
+ *  anywhere else. On successful operation, the contents and size
+ *  of the data removed from the queue is copied into the non-null
+ *  output parameters. The queue needs to have at least one entry
+ *  for the operation to succeed.
+ *
+ *  If the buffer is smaller than the entry, nothing is dequeued
+ *  and the size is set to the size of the entry. If the entry
+ *  fails its integrity check, it is still removed (so that it does
+ *  not stall the queue) and the error code is returned.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           access for the dequeue operation.
+ *
+ *  @param[out] data - if not null, the reference where the data to be
+ *                     dequeued is to be copied (otherwise, it is not
+ *                     copied).
+ *
+ *  @param[in,out] size - if not null, the reference of the size of
+ *                        the buffer, which is then set to the data
+ *                        size of the data to be dequeued (otherwise,
+ *                        it is not set).
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_READ_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ *
+ */
+int DataQ_FifoDequeue( DataQ_File_t * fifo_handle, void * data, size_t * size )
+{
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoDequeueLocked( fifo_handle, data, size );
+	DataQ_UnlockQueue( fifo_mutex );
+
+	return dataq_status;
+}
+
+
+/** @brief Discards entries from a data queue with its lock held.
+ *
+ *  This function implements DataQ_FifoDiscard (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoDiscardLocked( DataQ_File_t * fifo_handle, uint32_t count )
+{
+	DataQ_State_t * fifo_state;
+
+	/* check mandatory arguments for NULL pointers */
+	if ( fifo_handle == (DataQ_File_t *) 0 ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
+	}
+
+	/* check if write access is allowed */
+	if ( ( fifo_handle->access != ACCESS_TYPE_WRITE_ONLY ) &&
+		 ( fifo_handle->access != ACCESS_TYPE_READ_WRITE ) ) {
+		return CODE_ERROR_QUEUE_READ_ONLY;
+	}
+
+	/* check if fifo is still opened (the lock taken when the fifo was
+	 * opened is trusted so no lock file is probed here) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
+
+	/* determine if fifo is empty (the head offset is left one past the
+	 * tail offset once the last entry is dequeued, so only the entry
+	 * counter is reliable here) */
+	if ( fifo_state->hdr.num_of_entries == 0 ) {
+
+		/* nothing to discard */
+		return CODE_ERROR_QUEUE_IS_EMPTY;
+
+	}
+
+	/* discard at most all entries of the fifo */
+	if ( count > fifo_state->hdr.num_of_entries ) {
+		count = fifo_state->hdr.num_of_entries;
+	}
+
+	/* nothing to discard */
+	if ( count == 0 ) {
+		return CODE_STATUS_OK;
+	}
+
+	/* remove the entries and commit once */
+	return DataQ_DiscardEntries( fifo_state, count );
+}
+
+/** @brief Discards entries from the specified first-in, first-out
+ *         (FIFO) data queue.
+ *
+ *  This function removes the specified number of the oldest entries
+ *  from the 'head' end of the specified data queue, as if each of
+ *  them were dequeued, but without reading them: their files (or
+ *  their segments, once the 'head' end moved past them) are deleted,
+ *  their sizes kept in the LUT are taken off the flash size and the
+ *  LUT and header (or metadata) files are then updated only once. If
+ *  the data queue has fewer entries, all of them are discarded.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the discard operation.
+ *
+ *  @param[in] count - the number of entries to be discarded.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_READ_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_FifoDiscard( DataQ_File_t * fifo_handle, uint32_t count )
+{
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoDiscardLocked( fifo_handle, count );
+	DataQ_UnlockQueue( fifo_mutex );
+
+	return dataq_status;
+}
+
+
+/** @brief Discards entries from a data queue up to a reference with
+ *         its lock held.
+ *
+ *  This function implements DataQ_FifoDiscardUntil (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoDiscardUntilLocked( DataQ_File_t * fifo_handle, uint32_t reference )
+{
+	DataQ_State_t * fifo_state;
+	DataQ_Hdr_t * fifo_hdr;
+	uint32_t position;
+	uint32_t mask = 0xFFFFFFFF;
+
+	/* check mandatory arguments for NULL pointers */
+	if ( fifo_handle == (DataQ_File_t *) 0 ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
+	}
+
+	/* check if write access is allowed */
+	if ( ( fifo_handle->access != ACCESS_TYPE_WRITE_ONLY ) &&
+		 ( fifo_handle->access != ACCESS_TYPE_READ_WRITE ) ) {
+		return CODE_ERROR_QUEUE_READ_ONLY;
+	}
+
+	/* check if fifo is still opened (the lock taken when the fifo was
+	 * opened is trusted so no lock file is probed here) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
+
+	fifo_hdr = &fifo_state->hdr;
+
+	/* determine if fifo is empty (the head offset is left one past the
+	 * tail offset once the last entry is dequeued, so only the entry
+	 * counter is reliable here) */
+	if ( fifo_hdr->num_of_entries == 0 ) {
+
+		/* nothing to discard */
+		return CODE_ERROR_QUEUE_IS_EMPTY;
+
+	}
+
+	/* locate the entry in relative to the head entry (a header of the
+	 * first version only keeps 16 bits of the reference count) */
+	if ( fifo_hdr->hdr_version == HDR_VERSION_1 ) {
+		mask = 0xFFFF;
+	}
+	position = (reference - DataQ_GetHeadReference( fifo_hdr )) & mask;
+	if ( position >= fifo_hdr->num_of_entries ) {
+
+		/* the entry is already removed (it lies before the head end) */
+		if ( position > (mask >> 1) ) {
+			return CODE_STATUS_OK;
+		}
+
+		/* the entry is not enqueued yet */
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* remove the entries up to and including it and commit once */
+	return DataQ_DiscardEntries( fifo_state, position + 1 );
+}
+
+/** @brief Discards entries from the specified first-in, first-out
+ *         (FIFO) data queue up to a reference.
+ *
+ *  This function removes the oldest entries from the 'head' end of
+ *  the specified data queue up to and including the entry enqueued
+ *  with the specified reference count, the same way as
+ *  DataQ_FifoDiscard. The entries of a data queue are numbered in
+ *  the order they are enqueued, starting at 1 (a data queue created
+ *  with the first header version only keeps 16 bits of it). If the
+ *  entry is already removed, it does not do anything and considers
+ *  a successful operation.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the discard operation.
+ *
+ *  @param[in] reference - the reference count of the last entry to
+ *                         be discarded.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_READ_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_FifoDiscardUntil( DataQ_File_t * fifo_handle, uint32_t reference )
+{
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoDiscardUntilLocked( fifo_handle, reference );
+	DataQ_UnlockQueue( fifo_mutex );
+
+	return dataq_status;
+}
+
+
+/** @brief Sets the watermarks of a data queue with its lock held.
+ *
+ *  This function implements DataQ_FifoSetWatermarks (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoSetWatermarksLocked( DataQ_File_t * fifo_handle, uint8_t high, uint8_t low )
+{
+	DataQ_State_t * fifo_state;
+
+	/* check mandatory arguments for NULL pointers */
+	if ( fifo_handle == (DataQ_File_t *) 0 ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* check mandatory arguments for invalid values:
+	 *  - the high watermark is at most the whole capacity
+	 *  - the low watermark is below the high watermark
+	 *    (both are zero if the watermarks are removed)
+	 */
+	if ( (high > 100) ||
+		 ((high != 0) && (low >= high)) ||
+		 ((high == 0) && (low != 0)) ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
+	}
+
+	/* check if fifo is still opened (the lock taken when the fifo was
+	 * opened is trusted so no lock file is probed here) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
+
+	/* keep the watermarks for the lifetime of the handle */
+	fifo_state->high_watermark = high;
+	fifo_state->low_watermark = low;
+
+	/* operation succeeded */
+	return CODE_STATUS_OK;
+}
+
+/** @brief Sets the watermarks of the specified first-in, first-out
+ *         (FIFO) data queue.
+ *
+ *  This function sets the high and low watermarks DataQ_FifoMaintain
+ *  trims the data queue by, as percentages of its capacity (both of
+ *  the maximum number of entries and of the maximum flash size). The
+ *  watermarks are kept by the fifo handle; a fifo handle is opened
+ *  without them, in which case DataQ_FifoMaintain does not trim
+ *  anything and the entries are only evicted by the enqueue that
+ *  finds the data queue full.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the set watermarks operation.
+ *
+ *  @param[in] high - the percentage of the capacity above which the
+ *                    data queue is trimmed (at most 100, or zero to
+ *                    remove the watermarks).
+ *
+ *  @param[in] low - the percentage of the capacity the data queue is
+ *                   trimmed down to (below the high watermark, or
+ *                   zero along with it).
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_CLOSED
+ *
+ */
+int DataQ_FifoSetWatermarks( DataQ_File_t * fifo_handle, uint8_t high, uint8_t low )
+{
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoSetWatermarksLocked( fifo_handle, high, low );
+	DataQ_UnlockQueue( fifo_mutex );
+
+	return dataq_status;
+}
+
+
+/** @brief Maintains a data queue with its lock held.
+ *
+ *  This function implements DataQ_FifoMaintain (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoMaintainLocked( DataQ_File_t * fifo_handle, uint32_t * count )
+{
+	DataQ_State_t * fifo_state;
+	DataQ_Hdr_t fifo_hdr;
+	uint32_t trimmed = 0;
+
+	/* check mandatory arguments for NULL pointers */
+	if ( fifo_handle == (DataQ_File_t *) 0 ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* nothing is removed yet */
+	if ( count != (uint32_t *) 0 ) {
+		*count = 0;
+	}
+
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
+	}
+
+	/* check if write access is allowed */
+	if ( ( fifo_handle->access != ACCESS_TYPE_WRITE_ONLY ) &&
+		 ( fifo_handle->access != ACCESS_TYPE_READ_WRITE ) ) {
+		return CODE_ERROR_QUEUE_READ_ONLY;
+	}
+
+	/* check if fifo is still opened (the lock taken when the fifo was
+	 * opened is trusted so no lock file is probed here) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
+
+	/* nothing to trim unless the fifo is above its high watermark */
+	if ( (fifo_state->high_watermark == 0) ||
+		 (DataQ_IsAboveWatermark( &fifo_state->hdr, fifo_state->high_watermark ) == 0) ) {
+		return CODE_STATUS_OK;
+	}
+
+	/* work on a copy of the cached header (or metadata) of the fifo */
+	PSL_memcpy( &fifo_hdr, &fifo_state->hdr, sizeof(DataQ_Hdr_t) );
+
+	/* remove the oldest entries down to the low watermark */
+	while ( (fifo_hdr.num_of_entries > 0) &&
+			DataQ_IsAboveWatermark( &fifo_hdr, fifo_state->low_watermark ) ) {
+		if ( DataQ_EvictHead( fifo_state, &fifo_hdr ) != CODE_STATUS_OK ) {
+
+			/* resynchronize the cached LUT with the LUT file */
+			DataQ_LoadState( fifo_state );
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+		DATAQ_STATS_COUNT( trims );
+		trimmed++;
+	}
+
+	/* commit the LUT and the header (or metadata) under the durability policy */
+	if ( DataQ_CommitState( fifo_state, &fifo_hdr ) != CODE_STATUS_OK ) {
+
+		/* resynchronize the cached state with the files */
+		DataQ_LoadState( fifo_state );
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	/* report the number of entries removed */
+	if ( count != (uint32_t *) 0 ) {
+		*count = trimmed;
+	}
+
+	/* operation completed */
+	return CODE_STATUS_OK;
+}
+
+/** @brief Maintains the specified first-in, first-out (FIFO) data
+ *         queue.
+ *
+ *  This function is meant to be called when the system is idle so
+ *  that the enqueues rarely have to evict the oldest entries of a
+ *  full data queue themselves: if either the number of entries or
+ *  the flash size of the data queue is above the high watermark set
+ *  by DataQ_FifoSetWatermarks, the oldest entries are removed from
+ *  the 'head' end of the data queue (the same way as with
+ *  DataQ_FifoDiscard) until both are back at or below the low
+ *  watermark, and the LUT and header (or metadata) files are then
+ *  updated only once. Otherwise it does not do anything and considers
+ *  a successful operation.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the maintain operation.
+ *
+ *  @param[out] count - the reference where the number of entries
+ *                      removed is to be stored (optional).
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_READ_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_FifoMaintain( DataQ_File_t * fifo_handle, uint32_t * count )
+{
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoMaintainLocked( fifo_handle, count );
+	DataQ_UnlockQueue( fifo_mutex );
+
+	return dataq_status;
+}
+
+
+/** @brief Seeks to an entry from a data queue with its lock held.
+ *
+ *  This function implements DataQ_FifoSeek (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoSeekLocked( DataQ_File_t * fifo_handle, int seek_type, int position )
+{
+	DataQ_State_t * fifo_state;
+	DataQ_Hdr_t fifo_hdr;
+	uint32_t sequence;
+
+	/* check mandatory arguments for NULL pointers */
+	if ( fifo_handle == (DataQ_File_t *) 0 )  {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* check mandatory arguments for invalid values */
+	if ( seek_type >= SEEK_TYPE_MAX ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
+
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
+	}
+
+	/* at least read access is allowed */
+	if ( fifo_handle->access == ACCESS_TYPE_WRITE_ONLY ) {
+		return CODE_ERROR_QUEUE_WRITE_ONLY;
+	}
+
+	/* check if fifo is still opened (the lock taken when the fifo was
+	 * opened is trusted so no lock file is probed here) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
+
+	/* work on a copy of the cached header (or metadata) of the fifo */
+	PSL_memcpy( &fifo_hdr, &fifo_state->hdr, sizeof(DataQ_Hdr_t) );
+
+	/* determine if fifo is seekable */
+	if ( (fifo_hdr.flags & FLAGS_RANDOM_ACCESS) == 0 ) {
+		return CODE_ERROR_QUEUE_NOT_SEEKABLE;
+	}
+
+	/* determine if fifo is empty (the head offset is left one past the
+	 * tail offset once the last entry is dequeued, so only the entry
+	 * counter is reliable here) */
+	if ( fifo_hdr.num_of_entries == 0 ) {
+
+		/* nothing to return */
+		return CODE_ERROR_QUEUE_IS_EMPTY;
+
+	}
+
+	/* locate the entry enqueued with the sequence number (its reference
+	 * count) in relative to the head entry, as the entries in between
+	 * are numbered consecutively (a header of the first version only
+	 * keeps 16 bits of the reference count) */
+	if ( seek_type == SEEK_TYPE_SEQUENCE ) {
+		sequence = (uint32_t) position - DataQ_GetHeadReference( &fifo_hdr );
+		if ( fifo_hdr.hdr_version == HDR_VERSION_1 ) {
+			sequence &= 0xFFFF;
+		}
+		if ( sequence >= fifo_hdr.num_of_entries ) {
+			return CODE_ERROR_INVALID_SEEK;
+		}
+		position = (int) sequence;
+	}
+
+	/* determine if seek position is outside the range */
+	if ( position >= fifo_hdr.num_of_entries ) {
+		return CODE_ERROR_INVALID_SEEK;
+	}
+
+	/* perform seek operation */
+	if ( seek_type == SEEK_TYPE_HEAD ) {
+
+		/* set seek offset to current head offset in the LUT entry */
+		fifo_state->seek_lut_offs = fifo_hdr.head_lut_offs;
+
+	} else if ( seek_type == SEEK_TYPE_TAIL ) {
+
+		/* set seek offset to current tail offset in the LUT entry */
+		fifo_state->seek_lut_offs = fifo_hdr.tail_lut_offs;
+
+	} else {
+
+		/* set seek offset to anywhere between head and tail offsets
+		 * in relative to the head offset in the LUT entry (the entry
+		 * located by sequence number included)
+		 */
+		fifo_state->seek_lut_offs = (fifo_hdr.head_lut_offs + position) % fifo_hdr.max_entries;
+	}
+
+	/* the cursor only lives in the cached state of the handle (a named
+	 * cursor is stored lazily), so nothing is written here */
+	fifo_state->cursor_dirty = 1;
+
+	/* operation succeeded */
+	return CODE_STATUS_OK;
 }
 
-/** @brief Creates a first-in, first-out (FIFO) data queue.
+/** @brief Seeks to an entry from the specified first-in, first-out
+ *         (FIFO) data queue.
  *
- *  This function creates a specific type of data queue where first
- *  data in is also the first data out. In nominal scenario, the
- *  operation sets up the associated metadata and lookup table with
- *  an empty (although pre-allocated) data queue.
+ *  This function sets the current position of the 'seek' pointer
+ *  to a particular entry from the specified data queue. The seek
+ *  operation can be either seek to the 'head' end, seek to the
+ *  'tail' end, or seek to a specific position between 'head' and
+ *  'tail' ends. The data queue should be seekable and should have
+ *  at least one entry for the operation to succeed.
  *
- *  @param[in] fifo_name - the reference by which the data queue is
- *                         identified
+ *  A position shifts as entries are removed from the 'head' end, so
+ *  a reader resuming where it left off seeks by sequence number
+ *  instead: the reference count the entry was enqueued with (see
+ *  DataQ_FifoDiscardUntil and DataQ_FifoGetEntryEx). The entries
+ *  between the 'head' and 'tail' ends are numbered consecutively,
+ *  so the entry is located without reading anything from the
+ *  storage media. If it was already removed (or not enqueued yet),
+ *  CODE_ERROR_INVALID_SEEK is returned.
  *
- *  @param[in] max_entries - the maximum allowable entries for the
- *                           data queue to be created
+ *  The 'seek' pointer (the cursor) belongs to the fifo handle and
+ *  only lives in its cached state, so seeking never writes to the
+ *  storage media and every process reading the data queue has a
+ *  cursor of its own. The cursor starts at the 'head' end when the
+ *  data queue is opened, unless a named cursor is set with
+ *  DataQ_FifoSetCursor.
  *
- *  @param[in] max_entry_size - the maximum allowable size of one
- *                              data queue entry
  *
- *  @param[in] max_flash_size - the maximum allowable flash size for
- *                              the data queue to be created
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the seek operation.
  *
- *  @param[in] flags - the bit mask information of the characteristics
- *                     specific to the data queue:
+ *  @param[in] seek_type - the type of seek to be performed:
  *
- *                     FLAGS_MESSAGE_LOG
- *                     FLAGS_RANDOM_ACCESS
+ *                         SEEK_TYPE_HEAD
+ *                         SEEK_TYPE_TAIL
+ *                         SEEK_TYPE_POSITION
+ *                         SEEK_TYPE_SEQUENCE
+ *
+ *  @param[in] position - if SEEK_TYPE_POSITION is specified as the
+ *                        seek type, the position where the 'seek'
+ *                        pointer would be set, or, if
+ *                        SEEK_TYPE_SEQUENCE is specified, the
+ *                        sequence number of the entry it would be
+ *                        set to (as a 32-bit value); otherwise, this
+ *                        parameter is ignored.
  *
  *  @return int - the status or error code of the operation after
  *                the call:
  *
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
- *                CODE_ERROR_QUEUE_EXISTS
- *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_INVALID_SEEK
+ *                CODE_ERROR_QUEUE_WRITE_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_QUEUE_NOT_SEEKABLE
  *
  */
-int DataQ_FifoCreate( char * fifo_name, uint8_t max_entries, size_t max_entry_size, size_t max_flash_size, uint16_t flags )
+int DataQ_FifoSeek( DataQ_File_t * fifo_handle, int seek_type, int position )
 {
-	DataQ_Hdr_t fifo_hdr = {
-		.flash_size = 0,
-		.max_flash_size = max_flash_size,
-		.max_entry_size = max_entry_size,
-		.max_entries = max_entries,
-		.num_of_entries = 0,
-		.head_lut_offs = 0,
-		.tail_lut_offs = 0,
-		.seek_lut_offs = 0,
-		.reference_count = 0,
-		.flags = flags,
-	};
-	DataQ_LUT_Entry_t fifo_lut_entry;
-	FSAL_File_t fsal_handle = -1;
-	int fsal_flags = FSAL_FLAGS_CREATE | FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE;
-	int index;
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoSeekLocked( fifo_handle, seek_type, position );
+	DataQ_UnlockQueue( fifo_mutex );
+
+	return dataq_status;
+}
+
+
+/** @brief Copies an entry from a data queue with its lock held.
+ *
+ *  This function implements DataQ_FifoGetEntryEx (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoGetEntryLocked( DataQ_File_t * fifo_handle, void * data, size_t * size, uint32_t * sequence )
+{
+	DataQ_State_t * fifo_state;
+	DataQ_Hdr_t fifo_hdr;
+	uint32_t seek_lut_offs;
+	int dataq_status;
 
 	/* check mandatory arguments for NULL pointers */
-	if ( fifo_name == (char *) 0 ) {
+	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( data == (void *) 0 ) || ( size == (size_t *) 0 ) ) {
 		return CODE_ERROR_INVALID_ARG;
 	}
 
-	/* check mandatory arguments for invalid values:
-	 *  - at least max_entries or max_flash_size must
-	 *    indicate the maximum size of the data queue
-	 *  - max_entry_size must be set
-	 */
-	if ( ((max_entries == 0) && (max_flash_size == 0)) ||
-		 ( max_entry_size == 0 )  ) {
-		return CODE_ERROR_INVALID_ARG;
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
 	}
 
-	/* adjust maximum entries if not specified */
-	if ( fifo_hdr.max_entries == 0 ) {
-		fifo_hdr.max_entries = 0xFF;
+	/* at least read access is allowed */
+	if ( fifo_handle->access == ACCESS_TYPE_WRITE_ONLY ) {
+		return CODE_ERROR_QUEUE_WRITE_ONLY;
 	}
 
-	/* adjust maximum flash size if not specified */
-	if ( fifo_hdr.max_flash_size == 0 ) {
-		fifo_hdr.max_flash_size = fifo_hdr.max_entries * max_entry_size;
+	/* check if fifo is still opened (the lock taken when the fifo was
+	 * opened is trusted so no lock file is probed here) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
 	}
 
-	/* check if data queue already exists */
-	if ( FSAL_ChangeDirectory(fifo_name) == FSAL_STATUS_OK ) {
+	/* work on a copy of the cached header (or metadata) of the fifo */
+	PSL_memcpy( &fifo_hdr, &fifo_state->hdr, sizeof(DataQ_Hdr_t) );
 
-		/* data queue exists so return back and exit */
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_QUEUE_EXISTS;
-	}
+	/* determine if fifo is empty (the head offset is left one past the
+	 * tail offset once the last entry is dequeued, so only the entry
+	 * counter is reliable here) */
+	if ( fifo_hdr.num_of_entries == 0 ) {
 
-	/* create (and change to) the directory associated with the fifo */
-	if ( (FSAL_MakeDirectory(fifo_name) == FSAL_ERROR_DIR_ACCESS) ||
-		 (FSAL_ChangeDirectory(fifo_name) == FSAL_ERROR_DIR_ACCESS) ) {
+		/* nothing to return */
+		return CODE_ERROR_QUEUE_IS_EMPTY;
 
-		/* file system access error */
-		return CODE_ERROR_FS_ACCESS_FAIL;
 	}
 
-	/* create the header (or metadata) file associated with the fifo */
-	if ( (FSAL_OpenFile(".header", fsal_flags, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_WriteFile(fsal_handle, (uint8_t *)&fifo_hdr, sizeof(fifo_hdr)) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
-
-		/* delete the previously created directory */
-		FSAL_ChangeDirectory( "../" );
-		FSAL_RemoveDirectory( fifo_name );
-
-		/* file system access error */
-		return CODE_ERROR_FS_ACCESS_FAIL;
+	/* extract the data of the cached LUT entry indicated by the cursor */
+	seek_lut_offs = DataQ_GetCursor( fifo_state );
+	dataq_status = DataQ_ReadEntry( fifo_state, seek_lut_offs, data, size );
+	if ( dataq_status != CODE_STATUS_OK ) {
+		return dataq_status;
 	}
 
-	/* create the lut file associated with the fifo */
-	if ( FSAL_OpenFile(".lut", fsal_flags, &fsal_handle) == FSAL_STATUS_OK ) {
-
-		/* invalidate a generic LUT entry */
-		PSL_memset( &fifo_lut_entry, 0, sizeof(DataQ_LUT_Entry_t) );
-
-		/* pre-populate the lut with max number of entries */
-		for ( index = 0; index < max_entries; index++ ) {
-
-			/* write one lut entry at a time */
-			if ( FSAL_WriteFile(
-					fsal_handle,
-					(uint8_t *)&fifo_lut_entry,
-					sizeof(DataQ_LUT_Entry_t)) < 0 ) {
-
-				/* at least one write operation failed */
-				FSAL_CloseFile( fsal_handle );
-
-				/* delete the previously created directory */
-				FSAL_ChangeDirectory( "../" );
-				FSAL_RemoveDirectory( fifo_name );
-
-				/* file system access error */
-				return CODE_ERROR_FS_ACCESS_FAIL;
-			}
-		}
-
-		/* lut file fully initialized */
-		FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
+	/* the sequence number of the entry is its reference count */
+	if ( sequence != (uint32_t *) 0 ) {
+		*sequence = DataQ_GetEntryReference( &fifo_hdr, seek_lut_offs );
+	}
 
-		/* operation succeeded */
-		return CODE_STATUS_OK;
+	/* increment the seek offset if it have not yet reached the tail offset
+	 * (only in the cached state of the handle, so nothing is written here) */
+	if ( seek_lut_offs != fifo_hdr.tail_lut_offs ) {
+		seek_lut_offs = (seek_lut_offs + 1) % fifo_hdr.max_entries;
 	}
+	fifo_state->seek_lut_offs = seek_lut_offs;
+	fifo_state->cursor_dirty = 1;
 
-	/* delete the previously created file and directory */
-	FSAL_ChangeDirectory( "../" );
-	FSAL_RemoveDirectory( fifo_name );
+	/* operation succeeded */
+	return CODE_STATUS_OK;
+}
 
-	/* file system access error */
-	return CODE_ERROR_FS_ACCESS_FAIL;
+/** @brief Copies an entry from the specified first-in, first-out
+ *         (FIFO) data queue.
+ *
+ *  This function copies an entry from the specified data queue,
+ *  particularly where the 'seek' pointer is currently positioned.
+ *  After the contents and size of the entry are copied and set to
+ *  the corresponding output parameters, the position of the 'seek'
+ *  pointer is advanced to the next entry. If the old 'seek' pointer
+ *  position is the 'head' end of the queue, then the new position
+ *  would be the 'tail' end of the queue. The queue needs to have
+ *  at least one entry for the operation to succeed.
+ *
+ *  The size set is the true size of the entry as kept in its LUT
+ *  record. If the buffer is smaller than the entry, nothing is
+ *  copied, the 'seek' pointer is not advanced and the size is set
+ *  to the size of the entry so that the caller can retry.
+ *
+ *  Advancing the 'seek' pointer only changes the cached state of
+ *  the fifo handle (see DataQ_FifoSeek), so reading an entry never
+ *  writes to the storage media. If the entry the 'seek' pointer is
+ *  positioned at was evicted in the meantime, the entry at the
+ *  'head' end is copied instead.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the copy operation.
+ *
+ *  @param[out] data - the reference where the data is to be copied.
+ *
+ *  @param[in,out] size - the reference of the size of the buffer,
+ *                        which is then set to the size of the
+ *                        copied data.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_WRITE_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ *
+ */
+int DataQ_FifoGetEntry( DataQ_File_t * fifo_handle, void * data, size_t * size )
+{
+	/* copy the entry without its sequence number */
+	return DataQ_FifoGetEntryEx( fifo_handle, data, size, (uint32_t *) 0 );
 }
 
-/** @brief Destroys a first-in, first-out (FIFO) data queue.
+
+/** @brief Copies an entry along with its sequence number from the
+ *         specified first-in, first-out (FIFO) data queue.
  *
- *  This function destroys a specified data queue and frees up all
- *  allocated resources associated with it. If the data queue does
- *  not exist, it does not do anything and considers a successful
- *  operation. If the data queue is currently opened at least by
- *  one process, then operation will fail and the error code is set
- *  to busy to indicate a retry can be done.
+ *  This function copies the entry the 'seek' pointer is currently
+ *  positioned at the same way as DataQ_FifoGetEntry and sets the
+ *  sequence number of the entry: the reference count the entry was
+ *  enqueued with, which the entries of a data queue are numbered by
+ *  in the order they are enqueued, starting at 1 (a data queue
+ *  created with the first header version only keeps 16 bits of it).
+ *  A reader resuming later seeks right after the last entry it read
+ *  with SEEK_TYPE_SEQUENCE (see DataQ_FifoSeek).
  *
- *  @param[in] fifo_name - the reference of the data queue to be
- *                         destroyed
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the copy operation.
+ *
+ *  @param[out] data - the reference where the data is to be copied.
+ *
+ *  @param[in,out] size - the reference of the size of the buffer,
+ *                        which is then set to the size of the
+ *                        copied data.
+ *
+ *  @param[out] sequence - the reference where the sequence number of
+ *                         the copied entry is to be stored (may be
+ *                         null).
  *
  *  @return int - the status or error code of the operation after
  *                the call:
  *
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
- *                CODE_ERROR_QUEUE_IS_BUSY
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_WRITE_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
  *
  */
-int DataQ_FifoDestroy( char * fifo_name )
+int DataQ_FifoGetEntryEx( DataQ_File_t * fifo_handle, void * data, size_t * size, uint32_t * sequence )
 {
-	size_t file_size;
-	int index;
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoGetEntryLocked( fifo_handle, data, size, sequence );
+	DataQ_UnlockQueue( fifo_mutex );
+
+	return dataq_status;
+}
+
+
+/** @brief Sets a named cursor of a data queue with its lock held.
+ *
+ *  This function implements DataQ_FifoSetCursor (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoSetCursorLocked( DataQ_File_t * fifo_handle, char * cursor_name )
+{
+	DataQ_State_t * fifo_state;
+	size_t cursor_length = 0;
 
 	/* check mandatory arguments for NULL pointers */
-	if ( fifo_name == (char *) 0 ) {
+	if ( fifo_handle == (DataQ_File_t *) 0 ) {
 		return CODE_ERROR_INVALID_ARG;
 	}
 
-	/* check if folder associated with data queue is present by changing directory */
-	if ( FSAL_ChangeDirectory( fifo_name ) == FSAL_ERROR_DIR_ACCESS ) {
-		/* data queue does not exist so do nothing */
-		return CODE_STATUS_OK;
+	/* check optional arguments for invalid values */
+	if ( cursor_name != (char *) 0 ) {
+		cursor_length = strlen( cursor_name );
+		if ( ( cursor_length == 0 ) || ( cursor_length > CURSOR_NAME_MAX ) ) {
+			return CODE_ERROR_INVALID_ARG;
+		}
 	}
 
-	/* check if fifo is opened by this process */
-	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX; index++ ) {
-
-		/* locate the fifo name in the currently opened queue list */
-		if( (DataQ_FileHandleList[index].handle != DATA_QUEUE_FILE_HANDLE_INVALID) &&
-			(strcmp(fifo_name, DataQ_FileHandleList[index].name) == 0) ) {
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
+	}
 
-			/* fifo is still opened and maybe busy */
-			FSAL_ChangeDirectory( "../" );
-			return CODE_ERROR_QUEUE_IS_BUSY;
-		}
+	/* at least read access is allowed */
+	if ( fifo_handle->access == ACCESS_TYPE_WRITE_ONLY ) {
+		return CODE_ERROR_QUEUE_WRITE_ONLY;
 	}
 
-	/* check if fifo is opened by another process by listing lock files */
-	if ( (FSAL_ListFile( ".rolock", &file_size ) == FSAL_STATUS_OK) ||
-	     (FSAL_ListFile( ".wolock", &file_size ) == FSAL_STATUS_OK) ||
-		 (FSAL_ListFile( ".rwlock", &file_size ) == FSAL_STATUS_OK) ) {
+	/* check if fifo is still opened (the lock taken when the fifo was
+	 * opened is trusted so no lock file is probed here) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
 
-		/* fifo is still opened by another and maybe busy */
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_QUEUE_IS_BUSY;
+	/* store the cursor being replaced if it is named and moved */
+	if ( DataQ_StoreCursor( fifo_state ) != CODE_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
 
+	/* keep the current position in a cursor that is not named */
+	if ( cursor_name == (char *) 0 ) {
+		fifo_state->cursor[0] = '\0';
+		return CODE_STATUS_OK;
 	}
 
-	/* delete the folder (all files within) associated with data queue */
-	FSAL_ChangeDirectory( "../" );
-	FSAL_RemoveDirectory( fifo_name );
+	/* name the cursor file after the cursor and position the cursor
+	 * where it was last stored */
+	PSL_memcpy( fifo_state->cursor, DATAQ_CURSOR_FILE_PREFIX, sizeof(DATAQ_CURSOR_FILE_PREFIX) - 1 );
+	PSL_memcpy( &fifo_state->cursor[ sizeof(DATAQ_CURSOR_FILE_PREFIX) - 1 ], cursor_name, cursor_length + 1 );
+	if ( DataQ_LoadCursor( fifo_state ) != CODE_STATUS_OK ) {
+		fifo_state->cursor[0] = '\0';
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
 
 	/* operation succeeded */
 	return CODE_STATUS_OK;
 }
 
-/** @brief Opens a first-in, first-out (FIFO) data queue for
- *         access.
- *
- *  This function opens a specified data queue for access as
- *  specified by the type of access (read-only, write-only or
- *  read and write) and mode of access (normal or unpacked, or
- *  binary or packed). If the operation succeeded, the output
- *  parameter is updated with the fifo handle.
- *
- *  If the data queue is already opened by this process, it
- *  checks if the current access type and mode match the new
- *  one - if it does, the function updates the output parameter
- *  with the already opened fifo handle and considers a successful
- *  operation; otherwise, the function considers a failed operation.
- *
- *  If the data queue is already opened by another process, the
- *  function checks if the fifo is opened for read-only access.
- *  If it does, the passed access parameter should also be read
- *  only so the operation can proceed. In all other conditions,
- *  the function considers a failed operation and the error code
- *  is set to busy to indicate a retry can be done.
- *
- *  In nominal case, the function will create lock files so that
- *  concurrent access to the data queue by at least 2 separate
- *  processes are synchronized and would not result to data queue
- *  corruption. If the access type is read-only, the associated
- *  lock file is either 1) created (if no other process has opened
- *  the data queue) and write a byte value representing the number
- *  of users the data queue have (in this case, it will be 1); or
- *  2) opened (if there is at least another process that has the
- *  data queue opened) and had the current byte value incremented
- *  by one. For all other access type (write-only and read/write),
- *  the associated lock files are created empty because only one
- *  user is allowed for such access types.
- *
- *
- *  @param[in] fifo_name - the reference of the data queue to be
- *                         accessed
+/** @brief Sets a named cursor of the specified first-in, first-out
+ *         (FIFO) data queue.
  *
- *  @param[in] access - the access type to be performed on the data
- *                      data queue:
+ *  This function replaces the 'seek' pointer (the cursor) of the
+ *  fifo handle with the named cursor, which is positioned where it
+ *  was last stored (or at the 'head' end if it was never stored, or
+ *  if the entry it was positioned at has been evicted since). A named
+ *  cursor is kept in a small file of its own within the data queue
+ *  and stored lazily - only by DataQ_FifoFlush, DataQ_FifoClose or
+ *  when another cursor is set, and only if it moved - so separate
+ *  readers (each using a cursor of its own name) can resume reading
+ *  the data queue where they left off without sharing one position.
  *
- *						ACCESS_TYPE_READ_ONLY
- *						ACCESS_TYPE_WRITE_ONLY
- *						ACCESS_TYPE_READ_WRITE
+ *  The cursor being replaced is stored first, if it is named. If the
+ *  name is NULL, the cursor of the fifo handle stays positioned
+ *  where it is but is no longer named (and no longer stored).
  *
- *  @param[in] mode - the access mode to be considered on the data
- *                    data queue:
  *
- *					  ACCESS_MODE_UNPACKED
- *					  ACCESS_MODE_BINARY_PACKED
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the set cursor operation.
  *
- *  @param[out] fifo_handle - the reference where the pointer to the
- *                            fifo handle is copied.
+ *  @param[in] cursor_name - the name of the cursor (of at most
+ *                           CURSOR_NAME_MAX characters), or NULL.
  *
  *  @return int - the status or error code of the operation after
  *                the call:
  *
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
- *                CODE_ERROR_QUEUE_MISSING
- *                CODE_ERROR_QUEUE_OPENED
- *                CODE_ERROR_QUEUE_IS_BUSY
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_WRITE_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
  *                CODE_ERROR_FS_ACCESS_FAIL
- *                CODE_ERROR_HANDLE_NOT_AVAIL
  *
  */
-int DataQ_FifoOpen( char * fifo_name, int access, int mode, DataQ_File_t ** fifo_handle )
+int DataQ_FifoSetCursor( DataQ_File_t * fifo_handle, char * cursor_name )
 {
-	FSAL_File_t fsal_handle = -1;
-	size_t file_size;
-	int fsal_flags = FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE;
-	int fsal_status = FSAL_ERROR_FILE_ACCESS;
-	uint8_t users = 1;
-	int index;
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoSetCursorLocked( fifo_handle, cursor_name );
+	DataQ_UnlockQueue( fifo_mutex );
+
+	return dataq_status;
+}
+
+
+/** @brief Begins an iteration over a range of entries of a data queue
+ *         with its lock held.
+ *
+ *  This function implements DataQ_FifoIterBegin (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoIterBeginLocked( DataQ_File_t * fifo_handle, uint32_t start, uint32_t count, void * buffer, size_t buffer_size, DataQ_Iter_t * iter )
+{
+	DataQ_State_t * fifo_state;
+	DataQ_Hdr_t * fifo_hdr;
 
 	/* check mandatory arguments for NULL pointers */
-	if ( ( fifo_name == (char *) 0 ) || ( fifo_handle == (DataQ_File_t **) 0 ) ) {
+	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( iter == (DataQ_Iter_t *) 0 ) ) {
 		return CODE_ERROR_INVALID_ARG;
 	}
 
-	/* check mandatory arguments for invalid values */
-	if ( ( access >= ACCESS_TYPE_MAX ) || ( mode >= ACCESS_MODE_MAX ) ) {
+	/* check optional arguments for invalid values */
+	if ( ( buffer != (void *) 0 ) && ( buffer_size == 0 ) ) {
 		return CODE_ERROR_INVALID_ARG;
 	}
 
-	/* check if folder associated with data queue is present by changing directory */
-	if ( FSAL_ChangeDirectory( fifo_name ) == FSAL_ERROR_DIR_ACCESS ) {
-		return CODE_ERROR_QUEUE_MISSING;
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
 	}
 
-	/* check if fifo is already opened by this process */
-	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX; index++ ) {
-
-		/* locate the fifo name in the currently opened queue list */
-		if( (DataQ_FileHandleList[index].handle != DATA_QUEUE_FILE_HANDLE_INVALID) &&
-			(strcmp(fifo_name, DataQ_FileHandleList[index].name) == 0) ) {
+	/* at least read access is allowed */
+	if ( fifo_handle->access == ACCESS_TYPE_WRITE_ONLY ) {
+		return CODE_ERROR_QUEUE_WRITE_ONLY;
+	}
 
-			/* found an active fifo handle */
-			if ( (access == DataQ_FileHandleList[index].access) &&
-				 (mode == DataQ_FileHandleList[index].mode) ) {
+	/* check if fifo is still opened (the lock taken when the fifo was
+	 * opened is trusted so no lock file is probed here) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
 
-				/* fifo is already opened with the correct access parameters */
-				PSL_memcpy( *fifo_handle, &DataQ_FileHandleList[index], sizeof(DataQ_File_t) );
-				 FSAL_ChangeDirectory( "../" );
-				return CODE_STATUS_OK;
-			}
+	fifo_hdr = &fifo_state->hdr;
 
-			/* fifo is already opened but with different access parameters */
-			FSAL_ChangeDirectory( "../" );
-			return CODE_ERROR_QUEUE_OPENED;
-		}
+	/* determine if fifo is seekable (unless the range starts at the head end) */
+	if ( ( start != 0 ) && ( (fifo_hdr->flags & FLAGS_RANDOM_ACCESS) == 0 ) ) {
+		return CODE_ERROR_QUEUE_NOT_SEEKABLE;
 	}
 
-	/* check if fifo is already opened by another process by listing lock files */
-	if ( (FSAL_ListFile( ".wolock", &file_size ) == FSAL_STATUS_OK) ||
-		 (FSAL_ListFile( ".rwlock", &file_size ) == FSAL_STATUS_OK) ) {
-
-		/* fifo is already opened by another process with at least write access */
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_QUEUE_IS_BUSY;
+	/* determine if fifo is empty (the head offset is left one past the
+	 * tail offset once the last entry is dequeued, so only the entry
+	 * counter is reliable here) */
+	if ( fifo_hdr->num_of_entries == 0 ) {
 
-	} else if ( (FSAL_ListFile( ".rolock", &file_size ) == FSAL_STATUS_OK) &&
-			    (access != ACCESS_TYPE_READ_ONLY) ) {
+		/* nothing to return */
+		return CODE_ERROR_QUEUE_IS_EMPTY;
 
-		/**
-		 *  fifo is already opened by another process with read-only
-		 * access but write access is required
-		 */
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_QUEUE_IS_BUSY;
+	}
 
+	/* determine if start position is outside the range */
+	if ( start >= fifo_hdr->num_of_entries ) {
+		return CODE_ERROR_INVALID_SEEK;
 	}
 
-	/* create the appropriate lock file */
-	if ( access == ACCESS_TYPE_READ_ONLY ) {
+	/* resolve the range as the reference counts of its entries, which
+	 * stay valid however far the head end moves in the meantime */
+	if ( ( count == 0 ) || ( count > fifo_hdr->num_of_entries - start ) ) {
+		count = fifo_hdr->num_of_entries - start;
+	}
+	PSL_memset( iter, 0, sizeof(DataQ_Iter_t) );
+	iter->fifo_handle = fifo_handle;
+	iter->reference = DataQ_GetHeadReference( fifo_hdr ) + start;
+	iter->remaining = count;
+	iter->buffer = (uint8_t *) buffer;
+	iter->buffer_size = (buffer != (void *) 0) ? buffer_size : 0;
 
-		/* determine if another process is currently using the data queue */
-		if ( FSAL_ListFile( ".rolock", &file_size ) == FSAL_ERROR_FILE_ACCESS ) {
+	/* operation succeeded */
+	return CODE_STATUS_OK;
+}
 
-			/* this process is first user so create the lock file */
-			if ( FSAL_OpenFile(".rolock", fsal_flags | FSAL_FLAGS_CREATE, &fsal_handle) == FSAL_STATUS_OK ) {
+/** @brief Begins an iteration over a range of entries of the
+ *         specified first-in, first-out (FIFO) data queue.
+ *
+ *  This function sets up an iterator over the specified number of
+ *  entries of the data queue, starting at the specified position in
+ *  relative to the 'head' end, which are then copied in order by
+ *  DataQ_FifoIterNext. The range is resolved once from the cached
+ *  header: the entries enqueued afterwards are not part of it, and
+ *  the entries of it evicted before they are reached are skipped.
+ *  The iteration does not move the 'seek' pointer of the fifo
+ *  handle and never writes to the storage media. The data queue
+ *  should be seekable if the range does not start at the 'head' end.
+ *
+ *  If a read-ahead buffer is given and the data queue is created
+ *  with the segmented storage flag, the entries of the range that
+ *  follow each other within a segment are read into the buffer with
+ *  one read of the segment file (as many as fit into the buffer) and
+ *  then copied from it, instead of opening the segment file for each
+ *  entry (and so are the records that follow each other within the
+ *  ring file of a data queue created with the fixed record flag).
+ *  The buffer must stay valid until the iteration is over.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the iteration.
+ *
+ *  @param[in] start - the position of the first entry of the range
+ *                     in relative to the 'head' end.
+ *
+ *  @param[in] count - the number of entries of the range, which is
+ *                     cut down to the 'tail' end (if zero, all the
+ *                     entries up to the 'tail' end).
+ *
+ *  @param[in] buffer - if not null, the reference of the read-ahead
+ *                      buffer (otherwise, no entry is read ahead).
+ *
+ *  @param[in] buffer_size - the size of the read-ahead buffer.
+ *
+ *  @param[out] iter - the reference of the iterator to be set.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_INVALID_SEEK
+ *                CODE_ERROR_QUEUE_WRITE_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_QUEUE_NOT_SEEKABLE
+ *
+ */
+int DataQ_FifoIterBegin( DataQ_File_t * fifo_handle, uint32_t start, uint32_t count, void * buffer, size_t buffer_size, DataQ_Iter_t * iter )
+{
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
 
-				/* initialize lock file with default user count (set to 1) */
-				if ( FSAL_WriteFile(fsal_handle, (uint8_t *)&users, sizeof(users)) == sizeof(users) )
-					fsal_status = FSAL_STATUS_OK;
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoIterBeginLocked( fifo_handle, start, count, buffer, buffer_size, iter );
+	DataQ_UnlockQueue( fifo_mutex );
 
-				/* done creating the lock file */
-				FSAL_CloseFile( fsal_handle );
-			}
+	return dataq_status;
+}
 
-		} else {
 
-			/* another process is first user so modify the lock file instead */
-			if ( FSAL_OpenFile(".rolock", fsal_flags, &fsal_handle) == FSAL_STATUS_OK ) {
+/** @brief Copies the next entry of an iteration over a data queue
+ *         with its lock held.
+ *
+ *  This function implements DataQ_FifoIterNext (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoIterNextLocked( DataQ_Iter_t * iter, void * data, size_t * size )
+{
+	DataQ_State_t * fifo_state;
+	DataQ_Hdr_t * fifo_hdr;
+	uint32_t position;
+	uint32_t skipped;
+	uint32_t lut_offs;
+	int dataq_status;
 
-				/* read the current number of users from the lock file */
-				if ( FSAL_ReadFile(fsal_handle, (uint8_t *)&users, sizeof(users)) == sizeof(users) ) {
+	/* check mandatory arguments for NULL pointers */
+	if ( ( iter == (DataQ_Iter_t *) 0 ) || ( iter->fifo_handle == (DataQ_File_t *) 0 ) ||
+		 ( data == (void *) 0 ) || ( size == (size_t *) 0 ) ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
 
-					/* increment the number of users */
-					users++;
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( iter->fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
+	}
 
-					/* write the updated current number of users to the lock file */
-					if ( FSAL_WriteFile(fsal_handle, (uint8_t *)&users, sizeof(users)) == sizeof(users) )
-						fsal_status = FSAL_STATUS_OK;
-				}
+	/* check if fifo is still opened (the lock taken when the fifo was
+	 * opened is trusted so no lock file is probed here) */
+	if ( iter->fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
 
-				/* done modifying the lock file */
-				FSAL_CloseFile( fsal_handle );
-			}
-		}
+	/* determine if the whole range is copied */
+	if ( iter->remaining == 0 ) {
+		return CODE_ERROR_QUEUE_IS_EMPTY;
+	}
 
-	} else if ( access == ACCESS_TYPE_WRITE_ONLY ) {
+	fifo_hdr = &fifo_state->hdr;
 
-		/* create an empty write-only lock file (user count assumed only one) */
-		fsal_status = FSAL_OpenFile( ".wolock", fsal_flags | FSAL_FLAGS_CREATE, &fsal_handle );
-		if ( fsal_status == FSAL_STATUS_OK ) {
-			FSAL_CloseFile( fsal_handle );
+	/* locate the next entry in relative to the head end, skipping the
+	 * entries of the range evicted since the iteration began */
+	position = iter->reference - DataQ_GetHeadReference( fifo_hdr );
+	if ( position >= fifo_hdr->num_of_entries ) {
+		skipped = DataQ_GetHeadReference( fifo_hdr ) - iter->reference;
+		if ( skipped >= iter->remaining ) {
+			iter->remaining = 0;
+			return CODE_ERROR_QUEUE_IS_EMPTY;
 		}
+		iter->reference += skipped;
+		iter->remaining -= skipped;
+		position = 0;
+	}
+	lut_offs = (fifo_hdr->head_lut_offs + position) % fifo_hdr->max_entries;
 
+	/* copy the entry through the read-ahead buffer if there is one */
+	if ( ( iter->buffer != (uint8_t *) 0 ) && ( fifo_hdr->flags & DATAQ_SHARED_STORAGE ) ) {
+		dataq_status = DataQ_ReadAhead( fifo_state, iter, lut_offs, data, size );
 	} else {
-
-		/* create an empty read/write lock file (user count assumed only one) */
-		fsal_status = FSAL_OpenFile( ".rwlock", fsal_flags | FSAL_FLAGS_CREATE, &fsal_handle );
-		if ( fsal_status == FSAL_STATUS_OK ) {
-			FSAL_CloseFile( fsal_handle );
-		}
-
+		dataq_status = DataQ_ReadEntry( fifo_state, lut_offs, data, size );
 	}
 
-	/* check if appropriate lock file is added */
-	if ( fsal_status != FSAL_STATUS_OK ) {
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_FS_ACCESS_FAIL;
+	/* move on to the next entry (a corrupt entry is still passed so that
+	 * it does not stall the iteration) */
+	if ( ( dataq_status == CODE_STATUS_OK ) ||
+		 ( dataq_status == CODE_ERROR_QUEUE_ENTRY_CORRUPT ) ) {
+		iter->reference++;
+		iter->remaining--;
 	}
 
-	/* get a valid fifo handle */
-	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX; index++ ) {
-
-		/* locate an available fifo handle from the opened queue list */
-		if( DataQ_FileHandleList[index].handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
-
-			/* found an available fifo handle */
-			DataQ_FileHandleList[index].handle = index;
-			DataQ_FileHandleList[index].access = access;
-			DataQ_FileHandleList[index].mode = mode;
-			strncpy( DataQ_FileHandleList[index].name,
-					fifo_name,
-					sizeof(DataQ_FileHandleList[index].name) );
+	/* operation completed */
+	return dataq_status;
+}
 
-			/* store the fifo handle pointer to the output parameter */
-			*fifo_handle = &DataQ_FileHandleList[index];
+/** @brief Copies the next entry of an iteration over the specified
+ *         first-in, first-out (FIFO) data queue.
+ *
+ *  This function copies the next entry of the range of an iterator
+ *  set by DataQ_FifoIterBegin and moves the iterator on to the
+ *  following entry. Once all the entries of the range are copied,
+ *  the error code is set to empty to indicate the end of the
+ *  iteration.
+ *
+ *  If the buffer is smaller than the entry, nothing is copied, the
+ *  iterator is not moved and the size is set to the size of the
+ *  entry so that the caller can retry. If the entry fails its
+ *  integrity check, the iterator is still moved (so that it does
+ *  not stall the iteration) and the error code is returned.
+ *
+ *
+ *  @param[in,out] iter - the reference of the iterator.
+ *
+ *  @param[out] data - the reference where the data is to be copied.
+ *
+ *  @param[in,out] size - the reference of the size of the buffer,
+ *                        which is then set to the size of the
+ *                        copied data.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
+ *
+ */
+int DataQ_FifoIterNext( DataQ_Iter_t * iter, void * data, size_t * size )
+{
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
 
-			/* operation succeeded */
-			FSAL_ChangeDirectory( "../" );
-			return CODE_STATUS_OK;
-		}
-	}
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( (iter != (DataQ_Iter_t *) 0) ? iter->fifo_handle : (DataQ_File_t *) 0 );
+	dataq_status = DataQ_FifoIterNextLocked( iter, data, size );
+	DataQ_UnlockQueue( fifo_mutex );
 
-	/* no more available handles */
-	FSAL_ChangeDirectory( "../" );
-	return CODE_ERROR_HANDLE_NOT_AVAIL;
+	return dataq_status;
 }
 
 
-/** @brief Closes a first-in, first-out (FIFO) data queue for
- *         access.
- *
- *  This function closes a specified data queue previously opened
- *  for access. If the data queue is already closed, it does not
- *  do anything and considers a successful operation. If the data
- *  queue is missing, it returns an error code.
+/** @brief Retrieves the LUT record of the oldest entry of a data queue.
  *
- *  In nominal case, the function checks for the lock files as
- *  indications of data queues opened by other processes. If
- *  the lock file associated to a fifo that has been opened
- *  with read-only exists, this function will read a byte value
- *  (corresponds to the number of current user) and decrement
- *  it by one. If the result is a zero value, the lock file
- *  is deleted. For all other lock files (write-only or read
- *  write access types), the lock file is deleted immediately
- *  as such access types only allows one user at a time.
+ *  This function retrieves the LUT record of the entry at the 'head'
+ *  end of the data queue, as kept by a view of that entry. A fixed
+ *  record is located by its slot alone, which every entry reusing
+ *  that slot shares, so its LUT record is given the reference of the
+ *  entry as well to tell the entry apart.
  *
+ *  @param[in] fifo_state - the reference of the state of the data queue
  *
- *  @param[in] fifo_handle - the reference of the data queue to be
- *                           closed
+ *  @param[out] fifo_lut_record - the reference of the LUT record
  *
  *  @return int - the status or error code of the operation after
  *                the call:
  *
  *                CODE_STATUS_OK
- *                CODE_ERROR_INVALID_ARG
- *                CODE_ERROR_QUEUE_MISSING
  *                CODE_ERROR_FS_ACCESS_FAIL
+ */
+static int DataQ_GetHeadRecord( DataQ_State_t * fifo_state, DataQ_LUT_Record_t * fifo_lut_record )
+{
+	char fifo_lut_entry_reference[DATAQ_REFERENCE_SIZE_MAX + 1];
+
+	if ( DataQ_GetLUTRecord( fifo_state, fifo_state->hdr.head_lut_offs, fifo_lut_record ) != CODE_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+
+	if ( fifo_state->hdr.flags & FLAGS_FIXED_RECORD ) {
+		DataQ_MakeReference( &fifo_state->hdr, DataQ_GetHeadReference( &fifo_state->hdr ), fifo_lut_record, fifo_lut_entry_reference );
+	}
+
+	return CODE_STATUS_OK;
+}
+
+/** @brief Peeks at the oldest entry of a data queue with its lock held.
  *
+ *  This function implements DataQ_FifoPeek (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
  */
-int DataQ_FifoClose( DataQ_File_t * fifo_handle )
+static int DataQ_FifoPeekLocked( DataQ_File_t * fifo_handle, DataQ_View_t * view )
 {
 	FSAL_File_t fsal_handle = -1;
-	size_t file_size;
-	int fsal_flags = FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_WRITE;
-	int fsal_status = FSAL_STATUS_OK;
-	uint8_t users;
-	int index;
+	DataQ_State_t * fifo_state;
+	const uint8_t * fsal_data;
+	char fifo_lut_entry_reference[DATAQ_REFERENCE_SIZE_MAX + 1];
+	int fsal_status;
+	int dataq_status = CODE_STATUS_OK;
 
 	/* check mandatory arguments for NULL pointers */
-	if ( fifo_handle == (DataQ_File_t *) 0 ) {
+	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( view == (DataQ_View_t *) 0 ) ) {
 		return CODE_ERROR_INVALID_ARG;
 	}
 
-	/* check if folder associated with data queue is present by changing directory */
-	if ( FSAL_ChangeDirectory( fifo_handle->name ) == FSAL_ERROR_DIR_ACCESS ) {
-		return CODE_ERROR_QUEUE_MISSING;
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
 	}
 
-	/* check if fifo is actually opened by this process */
-	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX; index++ ) {
+	/* at least read access is allowed */
+	if ( fifo_handle->access == ACCESS_TYPE_WRITE_ONLY ) {
+		return CODE_ERROR_QUEUE_WRITE_ONLY;
+	}
 
-		/* locate the fifo handle in the currently opened queue list */
-		if( fifo_handle == &DataQ_FileHandleList[index] ) {
+	/* check if fifo is still opened (the lock taken when the fifo was
+	 * opened is trusted so no lock file is probed here) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
 
-			/* locate the read-only lock file associated with the data queue */
-			if ( FSAL_OpenFile(".rolock", fsal_flags, &fsal_handle) == FSAL_STATUS_OK ) {
+	/* determine if fifo is empty */
+	if ( fifo_state->hdr.num_of_entries == 0 ) {
 
-				/* read the current number of users from the lock file */
-				if ( FSAL_ReadFile(fsal_handle, (uint8_t *)&users, sizeof(users)) == sizeof(users) ) {
+		/* nothing to return */
+		return CODE_ERROR_QUEUE_IS_EMPTY;
 
-					/* decrement the number of users */
-					users--;
+	}
 
-					/* write the updated current number of users to the lock file */
-					if ( FSAL_WriteFile(fsal_handle, (uint8_t *)&users, sizeof(users)) == sizeof(users) )
-						fsal_status = FSAL_STATUS_OK;
-				}
+	/* describe the entry at the head end of the fifo */
+	PSL_memset( view, 0, sizeof(DataQ_View_t) );
+	view->buffer = -1;
+	if ( DataQ_GetHeadRecord( fifo_state, &view->record ) != CODE_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
+	view->size = view->record.length;
 
-				/* done modifying the lock file */
-				FSAL_CloseFile( fsal_handle );
+	if ( fifo_state->hdr.flags & DATAQ_SHARED_STORAGE ) {
 
-				/* determine if no other processes are using the data queue */
-				if ( users == 0 ) {
+		/* the entry is kept within its segment (or its slot of the ring file) */
+		DataQ_MakeStorageReference( &fifo_state->hdr, &view->record, fifo_lut_entry_reference );
+		view->offset = view->record.offset;
 
-					/* delete the lock file */
-					fsal_status = FSAL_DeleteFile( ".rolock" );
-				}
-			}
+	} else {
 
-			/* locate the write-only lock file associated with the data queue */
-			if ( FSAL_ListFile( ".wolock", &file_size ) == FSAL_STATUS_OK ) {
+		/* the entry is kept in a file of its own */
+		DataQ_GetReference( &fifo_state->hdr, &view->record, fifo_lut_entry_reference );
 
-				/* delete the lock file (only one user allowed) */
-				fsal_status = FSAL_DeleteFile( ".wolock" );
-			}
+		/* retrieve the size of the entry (a legacy LUT entry does not keep it) */
+		if ( (view->record.version == LUT_VERSION_LEGACY) &&
+			 (FSAL_ListDirFile( fifo_state->dir, fifo_lut_entry_reference, &view->size ) == FSAL_ERROR_FILE_ACCESS) ) {
+			return CODE_ERROR_FS_ACCESS_FAIL;
+		}
+	}
+
+	/* open the file holding the entry */
+	if ( FSAL_OpenDirFile(fifo_state->dir, fifo_lut_entry_reference, FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
 
-			/* locate the read/write lock file associated with the data queue */
-			if ( FSAL_ListFile( ".rwlock", &file_size ) == FSAL_STATUS_OK ) {
+	/* an entry rewritten in place by the enqueue reusing its room would
+	 * change under a view mapped from its file */
+	fsal_status = FSAL_ERROR_NOT_SUPPORTED;
+	if ( (view->record.encoding == ENCODING_TYPE_NONE) && ((fifo_state->hdr.flags & DATAQ_IN_PLACE_STORAGE) == 0) ) {
+		fsal_status = FSAL_MapFile( fsal_handle, view->offset, view->size, &fsal_data );
+	}
 
-				/* delete the lock file (only one user allowed) */
-				fsal_status = FSAL_DeleteFile( ".rwlock" );
-			}
+	if ( view->record.encoding != ENCODING_TYPE_NONE ) {
 
-			/* invalidate the handle for reuse */
-			memset( &DataQ_FileHandleList[index], DATA_QUEUE_FILE_HANDLE_INVALID, sizeof(DataQ_File_t) );
+		/* a packed entry is unpacked into a bounce buffer */
+		dataq_status = DataQ_UnpackView( fsal_handle, view );
 
-			/* found the handle so stop looking */
-			break;
+	} else if ( fsal_status == FSAL_STATUS_OK ) {
+
+		/* the entry is mapped straight from the file */
+		view->data = fsal_data;
+
+	} else if ( fsal_status == FSAL_ERROR_NOT_SUPPORTED ) {
+
+		/* otherwise claim an available bounce buffer large enough for the entry */
+		dataq_status = DataQ_ClaimView( view );
+
+		/* and copy the entry into it */
+		if ( dataq_status == CODE_STATUS_OK ) {
+			if ( FSAL_ReadFileAt(fsal_handle, view->offset, DataQ_PeekBufferPool[ view->buffer ], view->size) != (ssize_t) view->size ) {
+				DataQ_ReleaseView( view );
+				dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+			}
 		}
+
+	} else {
+
+		/* file system access error */
+		dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
 	}
 
-	FSAL_ChangeDirectory( "../" );
+	/* the view does not depend on the file being opened */
+	if ( (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) &&
+		 (dataq_status == CODE_STATUS_OK) ) {
+		DataQ_ReleaseView( view );
+		dataq_status = CODE_ERROR_FS_ACCESS_FAIL;
+	}
 
-	/* check if appropriate lock file is updated and/or deleted */
-	if ( fsal_status != FSAL_STATUS_OK ) {
-		return CODE_ERROR_FS_ACCESS_FAIL;
+	if ( dataq_status != CODE_STATUS_OK ) {
+		return dataq_status;
+	}
+
+	/* check the integrity of the entry if its LUT record allows it */
+	if ( (view->record.version != LUT_VERSION_LEGACY) &&
+		 (DataQ_ComputeCRC32( view->data, view->size ) != view->record.crc) ) {
+		DataQ_ReleaseView( view );
+		return CODE_ERROR_QUEUE_ENTRY_CORRUPT;
 	}
 
 	/* operation succeeded */
 	return CODE_STATUS_OK;
 }
 
-
-/** @brief Enqueues an entry into the specified first-in, first-out
- *         (FIFO) data queue.
+/** @brief Peeks at the oldest entry of the specified first-in,
+ *         first-out (FIFO) data queue.
  *
- *  This function enqueues or inserts a new entry into the specified
- *  data queue. For a FIFO type of queue, insertion happens on the
- *  'tail' end only (where the youngest entry can be found) and not
- *  anywhere else. If the data queue is full, then the oldest entry
- *  in the queue, located in the 'head' end, is removed from the queue
- *  before the new entry is inserted.
+ *  This function hands back a read-only view of the entry at the
+ *  'head' end of the specified data queue without copying it into
+ *  a caller buffer. The view is backed by a memory mapping of the
+ *  file holding the entry if the filesystem supports it, or else by
+ *  one of a pool of bounce buffers (in which case an entry larger
+ *  than a bounce buffer can not be peeked at), which a packed entry
+ *  is always unpacked into, and a fixed record or an entry of a
+ *  preallocated segment always copied into (an enqueue reusing its
+ *  room rewrites it in place, which would show through a mapping).
+ *  The view must be handed back with DataQ_FifoRelease once it is no
+ *  longer used.
+ *  The queue needs to have at least one entry for the operation to
+ *  succeed.
  *
  *
  *  @param[in] fifo_handle - the reference of the data queue to be
- *                           accessed for the enqueue operation.
- *
- *  @param[in] data - the reference of the data to be enqueued.
+ *                           accessed for the peek operation.
  *
- *  @param[in] size - the size of the data to be enqueued.
+ *  @param[out] view - the reference where the view of the entry
+ *                     is set.
  *
  *  @return int - the status or error code of the operation after
  *                the call:
@@ -624,52 +8126,61 @@ int DataQ_FifoClose( DataQ_File_t * fifo_handle )
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
  *                CODE_ERROR_INVALID_HANDLE
- *                CODE_ERROR_QUEUE_READ_ONLY
- *                CODE_ERROR_QUEUE_MISSING
+ *                CODE_ERROR_QUEUE_WRITE_ONLY
  *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_IS_EMPTY
  *                CODE_ERROR_FS_ACCESS_FAIL
- *                CODE_ERROR_QUEUE_ENTRY_NOT_LISTED
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_BUFFER_NOT_AVAIL
+ *                CODE_ERROR_QUEUE_ENTRY_CORRUPT
  *
  */
-int DataQ_FifoEnqueue( DataQ_File_t * fifo_handle, void * data, size_t size )
+int DataQ_FifoPeek( DataQ_File_t * fifo_handle, DataQ_View_t * view )
 {
-	FSAL_File_t fsal_handle = -1;
-	size_t file_size;
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoPeekLocked( fifo_handle, view );
+	DataQ_UnlockQueue( fifo_mutex );
+
+	return dataq_status;
+}
+
+
+/** @brief Releases a view of an entry of a data queue with its lock
+ *         held.
+ *
+ *  This function implements DataQ_FifoRelease (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoReleaseLocked( DataQ_File_t * fifo_handle, DataQ_View_t * view, int dequeue )
+{
+	DataQ_State_t * fifo_state;
 	DataQ_Hdr_t fifo_hdr;
-	DataQ_LUT_Entry_t fifo_lut_entry;
-	uint8_t fifo_lut_cache[ DATAQ_LUT_FILE_SIZE_MAX ] = { 0 };
-	char fifo_lut_entry_reference[DATA_QUEUE_LUT_ENTRY_SIZE + 1];
-	int index;
+	DataQ_LUT_Record_t fifo_lut_record;
 
 	/* check mandatory arguments for NULL pointers */
-	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( data == (void *) 0 ) ) {
-		return CODE_ERROR_INVALID_ARG;
-	}
-
-	/* check mandatory arguments for invalid values */
-	if ( size == 0 ) {
+	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( view == (DataQ_View_t *) 0 ) || ( view->data == (const void *) 0 ) ) {
 		return CODE_ERROR_INVALID_ARG;
 	}
 
 	/* check for a valid fifo handle */
-	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX + 1; index++ ) {
-
-		/* locate the fifo handle in the currently opened queue list */
-		if ( index < DATA_QUEUE_FILE_HANDLE_LIST_MAX ) {
-
-			/* a valid fifo handle references one data queue on the list */
-			if( fifo_handle == &DataQ_FileHandleList[index] ) {
-
-				/* found it */
-				break;
-			}
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
+	}
 
-			/* try next one */
-			continue;
-		}
+	/* hand back the memory backing the view */
+	if ( DataQ_ReleaseView( view ) != CODE_STATUS_OK ) {
+		return CODE_ERROR_FS_ACCESS_FAIL;
+	}
 
-		/* can not find the handle */
-		return CODE_ERROR_INVALID_HANDLE;
+	/* nothing else to do if the entry is kept */
+	if ( dequeue == 0 ) {
+		return CODE_STATUS_OK;
 	}
 
 	/* check if write access is allowed */
@@ -678,200 +8189,138 @@ int DataQ_FifoEnqueue( DataQ_File_t * fifo_handle, void * data, size_t size )
 		return CODE_ERROR_QUEUE_READ_ONLY;
 	}
 
-	/* check if folder associated with data queue is present by changing directory */
-	if ( FSAL_ChangeDirectory( fifo_handle->name ) == FSAL_ERROR_DIR_ACCESS ) {
-		return CODE_ERROR_QUEUE_MISSING;
-	}
-
-	/* check if fifo is already opened for writing */
-	if ( (FSAL_ListFile( ".wolock", &file_size ) == FSAL_ERROR_FILE_ACCESS) &&
-		 (FSAL_ListFile( ".rwlock", &file_size ) == FSAL_ERROR_FILE_ACCESS) ) {
-		FSAL_ChangeDirectory( "../" );
+	/* check if fifo is still opened (the lock taken when the fifo was
+	 * opened is trusted so no lock file is probed here) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
 		return CODE_ERROR_QUEUE_CLOSED;
 	}
 
-	/* open and read the header (or metadata) file associated with the fifo */
-	if ( (FSAL_OpenFile(".header", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_ReadFile(fsal_handle, (uint8_t *)&fifo_hdr, sizeof(fifo_hdr)) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+	/* work on a copy of the cached header (or metadata) of the fifo */
+	PSL_memcpy( &fifo_hdr, &fifo_state->hdr, sizeof(DataQ_Hdr_t) );
 
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
+	/* make sure the viewed entry is still the oldest one (it may have been
+	 * evicted by an enqueue since it was peeked at) */
+	if ( fifo_hdr.num_of_entries == 0 ) {
+		return CODE_ERROR_QUEUE_ENTRY_NOT_LISTED;
+	}
+	if ( DataQ_GetHeadRecord( fifo_state, &fifo_lut_record ) != CODE_STATUS_OK ) {
 		return CODE_ERROR_FS_ACCESS_FAIL;
 	}
-
-	/* validate the entry size of the data to be enqueued */
-	if ( size > fifo_hdr.max_entry_size ) {
-
-		/* data size is bigger that what is allowed */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_INVALID_ARG;
+	if ( memcmp( &fifo_lut_record, &view->record, sizeof(DataQ_LUT_Record_t) ) != 0 ) {
+		return CODE_ERROR_QUEUE_ENTRY_NOT_LISTED;
 	}
 
-	/* create a cache which directly mirrors the LUT file associated with the fifo */
-	if ( (FSAL_OpenFile(".lut", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_ReadFile(fsal_handle, (uint8_t *)fifo_lut_cache, DATAQ_LUT_FILE_SIZE_MAX) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+	/* remove the oldest entry (the file and the LUT entry) */
+	if ( DataQ_EvictHead( fifo_state, &fifo_hdr ) != CODE_STATUS_OK ) {
 
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
+		/* resynchronize the cached LUT with the LUT file */
+		DataQ_LoadState( fifo_state );
 		return CODE_ERROR_FS_ACCESS_FAIL;
 	}
 
-	/* increment reference count */
-	fifo_hdr.reference_count++;
-
-	/* initialize the LUT entry by converting reference count  as a revolving reference string */
-	for ( int base10 = 1, index = 0; index < sizeof(fifo_lut_entry.reference); base10 *= 10, index++ ) {
-		fifo_lut_entry.reference[ DATA_QUEUE_LUT_ENTRY_SIZE - index - 1] = '0' + ((fifo_hdr.reference_count % (base10 * 10)) / base10);
-	}
-
-	/* copy the LUT entry reference array and terminate to make it a string */
-	PSL_memcpy( fifo_lut_entry_reference, fifo_lut_entry.reference, DATA_QUEUE_LUT_ENTRY_SIZE);
-	fifo_lut_entry_reference[DATA_QUEUE_LUT_ENTRY_SIZE] = '\0';
-
-	/* create a new file to contain the enqueued data */
-	if ( (FSAL_OpenFile(fifo_lut_entry_reference, FSAL_FLAGS_BINARY | FSAL_FLAGS_WRITE_ONLY | FSAL_FLAGS_CREATE, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_WriteFile(fsal_handle, (uint8_t *)data, size) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+	/* commit the LUT and the header (or metadata) under the durability policy */
+	if ( DataQ_CommitState( fifo_state, &fifo_hdr ) != CODE_STATUS_OK ) {
 
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
+		/* resynchronize the cached state with the files */
+		DataQ_LoadState( fifo_state );
 		return CODE_ERROR_FS_ACCESS_FAIL;
 	}
+	DATAQ_STATS_COUNT( dequeues );
 
-	/* determine if fifo is already maxed out in terms either of
-	 * the number of entries allowed or the flash size allowed
-	 */
-	while ( (fifo_hdr.num_of_entries == fifo_hdr.max_entries) ||
-			((fifo_hdr.flash_size + size) > fifo_hdr.max_flash_size) ) {
-
-		/* adjust seek offset if seek is set to the head end of the data queue
-		 * (wrapping around if the seek reach the end of the queue) */
-		if ( fifo_hdr.seek_lut_offs == fifo_hdr.head_lut_offs ) {
-			fifo_hdr.seek_lut_offs = (fifo_hdr.seek_lut_offs + 1) % fifo_hdr.max_entries;
-		}
-
-		/* copy the LUT entry reference array and terminate to make it a string */
-		PSL_memcpy( fifo_lut_entry_reference, fifo_lut_cache + (fifo_hdr.head_lut_offs * sizeof(DataQ_LUT_Entry_t)), DATA_QUEUE_LUT_ENTRY_SIZE);
-		fifo_lut_entry_reference[DATA_QUEUE_LUT_ENTRY_SIZE] = '\0';
+	/* operation succeeded */
+	return CODE_STATUS_OK;
+}
 
-    	/* retrieve the flash size of the current head */
-    	if ( FSAL_ListFile( fifo_lut_entry_reference, &file_size ) == FSAL_ERROR_FILE_ACCESS ) {
+/** @brief Releases a view of an entry of the specified first-in,
+ *         first-out (FIFO) data queue.
+ *
+ *  This function hands back a view previously set by DataQ_FifoPeek
+ *  and, if requested, dequeues the viewed entry right away (as long
+ *  as it is still at the 'head' end of the queue). The view is
+ *  released in any case and must not be used anymore.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the release operation.
+ *
+ *  @param[in] view - the reference of the view to be released.
+ *
+ *  @param[in] dequeue - non-zero if the viewed entry is to be
+ *                       dequeued as well.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_READ_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_ENTRY_NOT_LISTED
+ *                CODE_ERROR_FS_ACCESS_FAIL
+ *
+ */
+int DataQ_FifoRelease( DataQ_File_t * fifo_handle, DataQ_View_t * view, int dequeue )
+{
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
 
-    		/* file system access error */
-    		if ( fsal_handle != -1 )
-    			FSAL_CloseFile( fsal_handle );
-    		FSAL_ChangeDirectory( "../" );
-    		return CODE_ERROR_QUEUE_ENTRY_NOT_LISTED;
-    	}
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoReleaseLocked( fifo_handle, view, dequeue );
+	DataQ_UnlockQueue( fifo_mutex );
 
-		/* delete the file */
-		FSAL_DeleteFile( fifo_lut_entry_reference );
+	return dataq_status;
+}
 
-		/* remove the oldest entry by invalidating the LUT entry indicated by the
-		 * head offset and then incrementing the head offset (wrapping around if the
-		 * the head reach the end of the queue)
-		 */
-		PSL_memset( fifo_lut_cache + (fifo_hdr.head_lut_offs * sizeof(DataQ_LUT_Entry_t)), 0, sizeof(DataQ_LUT_Entry_t) );
-		fifo_hdr.head_lut_offs = (fifo_hdr.head_lut_offs + 1) % fifo_hdr.max_entries;
 
-		/* decrement entry counter */
-		fifo_hdr.num_of_entries--;
+/** @brief Retrieves the current number of entries of a data queue
+ *         with its lock held.
+ *
+ *  This function implements DataQ_FifoGetLength (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoGetLengthLocked( DataQ_File_t * fifo_handle, size_t * length )
+{
+	DataQ_State_t * fifo_state;
 
-		/* decrement flash size */
-		fifo_hdr.flash_size -= file_size;
+	/* check mandatory arguments for NULL pointers */
+	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( length == (size_t *) 0 ) ) {
+		return CODE_ERROR_INVALID_ARG;
 	}
 
-	/* determine if fifo is empty */
-	if ( (fifo_hdr.num_of_entries == 0) &&
-		 (fifo_hdr.head_lut_offs == fifo_hdr.tail_lut_offs)  ) {
-
-		/* add the new entry by copying the LUT entry indicated either by the head or tail offset */
-		PSL_memcpy( fifo_lut_cache + (fifo_hdr.tail_lut_offs * sizeof(DataQ_LUT_Entry_t)), &fifo_lut_entry, sizeof(DataQ_LUT_Entry_t) );
-
-		/* increment entry counter */
-		fifo_hdr.num_of_entries++;
-
-		/* increment flash size */
-		fifo_hdr.flash_size += size;
-
-	} else {
-
-		/* add the new entry by incrementing the tail offset (wrapping around if the
-		 * tail reach the end of the queue) and copying the LUT entry indicated by
-		 * the new tail offset
-		 */
-		fifo_hdr.tail_lut_offs = (fifo_hdr.tail_lut_offs + 1) % fifo_hdr.max_entries;
-		PSL_memcpy( fifo_lut_cache + (fifo_hdr.tail_lut_offs * sizeof(DataQ_LUT_Entry_t)), &fifo_lut_entry, sizeof(DataQ_LUT_Entry_t) );
-
-		/* increment entry counter */
-		fifo_hdr.num_of_entries++;
-
-		/* increment flash size */
-		fifo_hdr.flash_size += size;
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
 	}
 
-	/* update the LUT file associated with the fifo */
-	if ( (FSAL_OpenFile(".lut", FSAL_FLAGS_BINARY | FSAL_FLAGS_WRITE_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_WriteFile(fsal_handle, (uint8_t *)fifo_lut_cache, DATAQ_LUT_FILE_SIZE_MAX) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
-
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_FS_ACCESS_FAIL;
+	/* check if fifo is still opened (the cached state is only valid while it is) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
 	}
 
-	/* update the header (or metadata) file associated with the fifo */
-	if ( (FSAL_OpenFile(".header", FSAL_FLAGS_BINARY | FSAL_FLAGS_WRITE_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_WriteFile(fsal_handle, (uint8_t *)&fifo_hdr, sizeof(fifo_hdr)) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
-
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_FS_ACCESS_FAIL;
-	}
+	/* copy the current number of fifo entries from the cached header */
+	*length = fifo_state->hdr.num_of_entries;
 
 	/* operation succeeded */
-	FSAL_ChangeDirectory( "../" );
 	return CODE_STATUS_OK;
 }
 
-
-/** @brief Dequeues an entry from the specified first-in, first-out
- *         (FIFO) data queue.
+/** @brief Retrieves the current number of entries of the specified
+ *         first-in, first-out (FIFO) data queue.
  *
- *  This function dequeues or removes a new entry on the specified
- *  data queue. For a FIFO type of queue, deletion happens on the
- *  'head' end only (where the oldest entry can be found) and not
- *  anywhere else. On successful operation, the contents and size
- *  of the data removed from the queue is copied into the non-null
- *  output parameters. The queue needs to have at least one entry
- *  for the operation to succeed.
+ *  This function gets the number of entries the specified data queue
+ *  currently has. If the operation succeeds, the number of entries
+ *  is stored in the output parameter.
  *
  *
  *  @param[in] fifo_handle - the reference of the data queue to be
- *                           access for the dequeue operation.
- *
- *  @param[out] data - if not null, the reference where the data to be
- *                     dequeued is to be copied (otherwise, it is not
- *                     copied).
+ *                           accessed for the get length operation.
  *
- *  @param[out] size - if not null, the reference where the data size
- *                     of the data to be dequeued is set (otherwise,
- *                     it is not set).
+ *  @param[out] length - the reference where the number of entries
+ *                       is to be stored.
  *
  *  @return int - the status or error code of the operation after
  *                the call:
@@ -879,194 +8328,127 @@ int DataQ_FifoEnqueue( DataQ_File_t * fifo_handle, void * data, size_t size )
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
  *                CODE_ERROR_INVALID_HANDLE
- *                CODE_ERROR_QUEUE_READ_ONLY
- *                CODE_ERROR_QUEUE_MISSING
  *                CODE_ERROR_QUEUE_CLOSED
- *                CODE_ERROR_FS_ACCESS_FAIL
- *                CODE_ERROR_QUEUE_IS_EMPTY
  *
  */
-int DataQ_FifoDequeue( DataQ_File_t * fifo_handle, void * data, size_t * size )
+int DataQ_FifoGetLength( DataQ_File_t * fifo_handle, size_t * length )
 {
-	FSAL_File_t fsal_handle = -1;
-	size_t file_size;
-	DataQ_Hdr_t fifo_hdr;
-	uint8_t fifo_lut_cache[ DATAQ_LUT_FILE_SIZE_MAX ] = { 0 };
-	char fifo_lut_entry_reference[DATA_QUEUE_LUT_ENTRY_SIZE + 1];
-	int index;
-
-	/* check mandatory arguments for NULL pointers */
-	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( data == (void *) 0 ) || ( size == (size_t *) 0 ) ) {
-		return CODE_ERROR_INVALID_ARG;
-	}
-
-	/* check for a valid fifo handle */
-	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX + 1; index++ ) {
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
 
-		/* locate the fifo handle in the currently opened queue list */
-		if ( index < DATA_QUEUE_FILE_HANDLE_LIST_MAX ) {
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoGetLengthLocked( fifo_handle, length );
+	DataQ_UnlockQueue( fifo_mutex );
 
-			/* a valid fifo handle references one data queue on the list */
-			if( fifo_handle == &DataQ_FileHandleList[index] ) {
+	return dataq_status;
+}
 
-				/* found it */
-				break;
-			}
 
-			/* try next one */
-			continue;
-		}
+/** @brief Waits for entries of a data queue with its lock held.
+ *
+ *  This function implements DataQ_FifoWait (see it for the parameters
+ *  and the status or error codes) once the caller serialized it with
+ *  any other operation on the data queue, releasing the lock while it
+ *  waits.
+ */
+static int DataQ_FifoWaitLocked( DataQ_File_t * fifo_handle, uint32_t min_entries, uint32_t timeout_ms )
+{
+	DataQ_State_t * fifo_state;
+	uint64_t remaining = (uint64_t) timeout_ms * 1000u;
+	uint32_t slice;
+	uint32_t started;
+	uint32_t spent;
+	int index;
 
-		/* can not find the handle */
-		return CODE_ERROR_INVALID_HANDLE;
+	/* check mandatory arguments for NULL pointers */
+	if ( fifo_handle == (DataQ_File_t *) 0 ) {
+		return CODE_ERROR_INVALID_ARG;
 	}
 
-	/* check if write access is allowed */
-	if ( ( fifo_handle->access != ACCESS_TYPE_WRITE_ONLY ) &&
-		 ( fifo_handle->access != ACCESS_TYPE_READ_WRITE ) ) {
-		return CODE_ERROR_QUEUE_READ_ONLY;
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
 	}
 
-	/* check if folder associated with data queue is present by changing directory */
-	if ( FSAL_ChangeDirectory( fifo_handle->name ) == FSAL_ERROR_DIR_ACCESS ) {
-		return CODE_ERROR_QUEUE_MISSING;
+	/* check if read access is allowed */
+	if ( fifo_handle->access == ACCESS_TYPE_WRITE_ONLY ) {
+		return CODE_ERROR_QUEUE_WRITE_ONLY;
 	}
 
-	/* check if fifo is already opened for writing */
-	if ( (FSAL_ListFile( ".wolock", &file_size ) == FSAL_ERROR_FILE_ACCESS) &&
-		 (FSAL_ListFile( ".rwlock", &file_size ) == FSAL_ERROR_FILE_ACCESS) ) {
-		FSAL_ChangeDirectory( "../" );
+	/* check if fifo is still opened (the cached state is only valid while it is) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
 		return CODE_ERROR_QUEUE_CLOSED;
 	}
 
-	/* open and read the header (or metadata) file associated with the fifo */
-	if ( (FSAL_OpenFile(".header", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_ReadFile(fsal_handle, (uint8_t *)&fifo_hdr, sizeof(fifo_hdr)) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
-
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_FS_ACCESS_FAIL;
-	}
-
-	/* create a cache which directly mirrors the LUT file associated with the fifo */
-	if ( (FSAL_OpenFile(".lut", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_ReadFile(fsal_handle, (uint8_t *)fifo_lut_cache, DATAQ_LUT_FILE_SIZE_MAX) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
-
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_FS_ACCESS_FAIL;
+	/* check mandatory arguments for invalid values (the fifo never holds
+	 * more than its maximum number of entries) */
+	if ( (min_entries == 0) || (min_entries > fifo_state->hdr.max_entries) ) {
+		return CODE_ERROR_INVALID_ARG;
 	}
 
-	/* determine if fifo is empty */
-	if ( (fifo_hdr.num_of_entries == 0) &&
-		 (fifo_hdr.head_lut_offs == fifo_hdr.tail_lut_offs)  ) {
-
-		/* nothing to return */
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_QUEUE_IS_EMPTY;
+	/* the event and the mutex are those of the opened data queue */
+	index = (int) (fifo_state - DataQ_FileStateList);
 
-	} else {
+	/* wait for the fifo to be signaled until it has enough entries */
+	while ( fifo_state->hdr.num_of_entries < min_entries ) {
 
-		/* adjust seek offset if seek is set to the head end of the data queue
-		 * (wrapping around if the seek reach the end of the queue) */
-		if ( fifo_hdr.seek_lut_offs == fifo_hdr.head_lut_offs ) {
-			fifo_hdr.seek_lut_offs = (fifo_hdr.seek_lut_offs + 1) % fifo_hdr.max_entries;
+		/* check if the timeout elapsed */
+		if ( remaining == 0 ) {
+			return CODE_ERROR_WAIT_TIMEOUT;
 		}
 
-		/* copy the LUT entry reference array and terminate to make it a string */
-		PSL_memcpy( fifo_lut_entry_reference, fifo_lut_cache + (fifo_hdr.head_lut_offs * sizeof(DataQ_LUT_Entry_t)), DATA_QUEUE_LUT_ENTRY_SIZE);
-		fifo_lut_entry_reference[DATA_QUEUE_LUT_ENTRY_SIZE] = '\0';
-
-		/* copy the dequeued data and store it if possible */
-		if ( (FSAL_ListFile( fifo_lut_entry_reference, &file_size ) == FSAL_ERROR_FILE_ACCESS) ||
-			 (FSAL_OpenFile(fifo_lut_entry_reference, FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-			 (*size = FSAL_ReadFile(fsal_handle, (uint8_t *)data, *size) < 0) ||
-			 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
-
-			/* file system access error */
-			if ( fsal_handle != -1 )
-				FSAL_CloseFile( fsal_handle );
-			FSAL_ChangeDirectory( "../" );
-			return CODE_ERROR_FS_ACCESS_FAIL;
+		/* wait for at most the rest of the timeout, one slice at a time */
+		slice = DATAQ_WAIT_SLICE_MAX;
+		if ( remaining < ((uint64_t) DATAQ_WAIT_SLICE_MAX * 1000u) ) {
+			slice = (uint32_t) ((remaining + 999u) / 1000u);
 		}
+		started = PSL_GetTimestamp();
+		PSL_EventWait( &DataQ_QueueEvent[index], &DataQ_QueueMutex[index], slice );
+		spent = PSL_GetTimestamp() - started;
 
-		/* delete the file */
-		FSAL_DeleteFile( fifo_lut_entry_reference );
-
-		/* remove the oldest entry by invalidating the LUT entry indicated by the
-		 * head offset and then incrementing the head offset (wrapping around if
-		 * the head reach the end of the queue)
-		 */
-		PSL_memset( fifo_lut_cache + (fifo_hdr.head_lut_offs * sizeof(DataQ_LUT_Entry_t)), 0, sizeof(DataQ_LUT_Entry_t) );
-		fifo_hdr.head_lut_offs = (fifo_hdr.head_lut_offs + 1) % fifo_hdr.max_entries;
-
-		/* decrement entry counter */
-		fifo_hdr.num_of_entries--;
-
-		/* decrement flash size */
-		fifo_hdr.flash_size -= file_size;
-	}
-
-	/* update the LUT file associated with the fifo */
-	if ( (FSAL_OpenFile(".lut", FSAL_FLAGS_BINARY | FSAL_FLAGS_WRITE_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_WriteFile(fsal_handle, (uint8_t *)fifo_lut_cache, DATAQ_LUT_FILE_SIZE_MAX) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
-
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_FS_ACCESS_FAIL;
-	}
-
-	/* update the header (or metadata) file associated with the fifo */
-	if ( (FSAL_OpenFile(".header", FSAL_FLAGS_BINARY | FSAL_FLAGS_WRITE_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_WriteFile(fsal_handle, (uint8_t *)&fifo_hdr, sizeof(fifo_hdr)) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+		/* account for the time spent waiting (unless there is no limit) */
+		if ( timeout_ms != WAIT_TIMEOUT_FOREVER ) {
+			remaining = (spent < remaining) ? (remaining - spent) : 0;
+		}
 
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_FS_ACCESS_FAIL;
+		/* check if fifo was closed while waiting */
+		if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+			return CODE_ERROR_QUEUE_CLOSED;
+		}
 	}
 
 	/* operation succeeded */
-	FSAL_ChangeDirectory( "../" );
 	return CODE_STATUS_OK;
 }
 
-
-/** @brief Seeks to an entry from the specified first-in, first-out
+/** @brief Waits for entries of the specified first-in, first-out
  *         (FIFO) data queue.
  *
- *  This function sets the current position of the 'seek' pointer
- *  to a particular entry from the specified data queue. The seek
- *  operation can be either seek to the 'head' end, seek to the
- *  'tail' end, or seek to a specific position between 'head' and
- *  'tail' ends. The data queue should be seekable and should have
- *  at least one entry for the operation to succeed.
+ *  This function blocks the calling task (or thread) until the
+ *  specified data queue has at least the specified number of entries
+ *  (as enqueued through the same fifo handle by another task or
+ *  thread) or until the timeout elapses, whichever happens first. It
+ *  returns right away, without any access to the file system, if the
+ *  data queue already has enough entries, so a consumer waiting for
+ *  more than one entry wakes once for the whole batch. The data queue
+ *  is not locked while the function waits, so any other operation may
+ *  be made on it meanwhile. If the data queue is closed while waiting,
+ *  the function returns CODE_ERROR_QUEUE_CLOSED.
  *
+ *  A zero timeout only checks the number of entries, while a timeout
+ *  of WAIT_TIMEOUT_FOREVER waits with no time limit.
  *
- *  @param[in] fifo_handle - the reference of the data queue to be
- *                           accessed for the seek operation.
  *
- *  @param[in] seek_type - the type of seek to be performed:
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the wait operation.
  *
- *                         SEEK_TYPE_HEAD
- *                         SEEK_TYPE_TAIL
- *                         SEEK_TYPE_POSITION
+ *  @param[in] min_entries - the number of entries to wait for (at
+ *                           least one and at most the maximum number
+ *                           of entries of the data queue).
  *
- *  @param[in] position - if SEEK_TYPE_POSITION is specified as the
- *                        seek type, the position where the 'seek'
- *                        pointer would be set (otherwise, this
- *                        parameter is ignored).
+ *  @param[in] timeout_ms - the longest time to wait (in milliseconds).
  *
  *  @return int - the status or error code of the operation after
  *                the call:
@@ -1074,161 +8456,338 @@ int DataQ_FifoDequeue( DataQ_File_t * fifo_handle, void * data, size_t * size )
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
  *                CODE_ERROR_INVALID_HANDLE
- *                CODE_ERROR_INVALID_SEEK
  *                CODE_ERROR_QUEUE_WRITE_ONLY
- *                CODE_ERROR_QUEUE_MISSING
  *                CODE_ERROR_QUEUE_CLOSED
- *                CODE_ERROR_QUEUE_IS_EMPTY
- *                CODE_ERROR_QUEUE_NOT_SEEKABLE
- *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_WAIT_TIMEOUT
  *
  */
-int DataQ_FifoSeek( DataQ_File_t * fifo_handle, int seek_type, int position )
+int DataQ_FifoWait( DataQ_File_t * fifo_handle, uint32_t min_entries, uint32_t timeout_ms )
 {
-	FSAL_File_t fsal_handle = -1;
-	size_t file_size;
-	DataQ_Hdr_t fifo_hdr;
-	int index;
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoWaitLocked( fifo_handle, min_entries, timeout_ms );
+	DataQ_UnlockQueue( fifo_mutex );
+
+	return dataq_status;
+}
+
+
+/** @brief Retrieves the current flash size usage of a data queue with
+ *         its lock held.
+ *
+ *  This function implements DataQ_FifoGetSize (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoGetSizeLocked( DataQ_File_t * fifo_handle, size_t * flash_size )
+{
+	DataQ_State_t * fifo_state;
 
 	/* check mandatory arguments for NULL pointers */
-	if ( fifo_handle == (DataQ_File_t *) 0 )  {
+	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( flash_size == (size_t *) 0 ) ) {
 		return CODE_ERROR_INVALID_ARG;
 	}
 
-	/* check mandatory arguments for invalid values */
-	if ( seek_type >= SEEK_TYPE_MAX ) {
-		return CODE_ERROR_INVALID_ARG;
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
 	}
 
-	/* check for a valid fifo handle */
-	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX + 1; index++ ) {
+	/* check if fifo is still opened (the cached state is only valid while it is) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
 
-		/* locate the fifo handle in the currently opened queue list */
-		if ( index < DATA_QUEUE_FILE_HANDLE_LIST_MAX ) {
+	/* copy the current flash size from the cached header */
+	*flash_size = fifo_state->hdr.flash_size;
 
-			/* a valid fifo handle references one data queue on the list */
-			if( fifo_handle == &DataQ_FileHandleList[index] ) {
+	/* operation succeeded */
+	return CODE_STATUS_OK;
+}
 
-				/* found it */
-				break;
-			}
+/** @brief Retrieves the current flash size usage of the specified
+ *         first-in, first-out (FIFO) data queue.
+ *
+ *  This function gets the current size in flash storage of the
+ *  specified data queue. If the operation succeeds, the flash size
+ *  in bytes is stored in the output parameter.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the get length operation.
+ *
+ *  @param[out] flash_size - the reference where the flash size used
+ *                           is to be stored.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_CLOSED
+ *
+ */
+int DataQ_FifoGetSize( DataQ_File_t * fifo_handle, size_t * flash_size )
+{
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
 
-			/* try next one */
-			continue;
-		}
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoGetSizeLocked( fifo_handle, flash_size );
+	DataQ_UnlockQueue( fifo_mutex );
 
-		/* can not find the handle */
-		return CODE_ERROR_INVALID_HANDLE;
-	}
+	return dataq_status;
+}
 
-	/* at least read access is allowed */
-	if ( fifo_handle->access == ACCESS_TYPE_WRITE_ONLY ) {
-		return CODE_ERROR_QUEUE_WRITE_ONLY;
-	}
 
-	/* check if folder associated with data queue is present by changing directory */
-	if ( FSAL_ChangeDirectory( fifo_handle->name ) == FSAL_ERROR_DIR_ACCESS ) {
-		return CODE_ERROR_QUEUE_MISSING;
+/** @brief Takes a staging ring from the staging arena.
+ *
+ *  This function looks for the first part of the staging arena
+ *  large enough for a ring of the specified size that none of the
+ *  staging rings of the other opened data queues takes.
+ *
+ *  @param[in] index - the index of the data queue in the list of
+ *                     opened data queues
+ *
+ *  @param[in] ring_size - the size of the ring in bytes
+ *
+ *  @return uint8_t* - the reference of the ring or null if the arena
+ *                     has no room for it
+ */
+static uint8_t * DataQ_AllocStaging( int index, uint32_t ring_size )
+{
+	uint8_t * arena = (uint8_t *) DataQ_StagingArena;
+	uint32_t offset = 0;
+	uint32_t other_offset;
+	int other;
+
+	/* move past any ring overlapping the candidate part, and check again */
+	for ( other = 0; other < DATA_QUEUE_FILE_HANDLE_LIST_MAX; other++ ) {
+		if ( (other != index) && (DataQ_StagingList[other].ring != (uint8_t *) 0) ) {
+			other_offset = (uint32_t) (DataQ_StagingList[other].ring - arena);
+			if ( (offset < (other_offset + DataQ_StagingList[other].ring_size)) &&
+				 (other_offset < (offset + ring_size)) ) {
+				offset = other_offset + DataQ_StagingList[other].ring_size;
+				other = -1;
+			}
+		}
 	}
 
-	/* check if fifo is already opened for reading */
-	if ( (FSAL_ListFile( ".rolock", &file_size ) == FSAL_ERROR_FILE_ACCESS) &&
-		 (FSAL_ListFile( ".rwlock", &file_size ) == FSAL_ERROR_FILE_ACCESS) ) {
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_QUEUE_CLOSED;
+	/* check if the part found is still within the arena */
+	if ( (offset + ring_size) > DATA_QUEUE_STAGING_ARENA_SIZE ) {
+		return (uint8_t *) 0;
 	}
 
-	/* open and read the header (or metadata) file associated with the fifo */
-	if ( (FSAL_OpenFile(".header", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_ReadFile(fsal_handle, (uint8_t *)&fifo_hdr, sizeof(fifo_hdr)) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+	return arena + offset;
+}
 
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_FS_ACCESS_FAIL;
-	}
+/** @brief Copies data into a staging ring.
+ *
+ *  This function copies data into the staging ring at the specified
+ *  free running byte count, wrapping to the start of the ring.
+ *
+ *  @param[in] staging - the reference of the staging ring
+ *
+ *  @param[in] position - the free running byte count to copy at
+ *
+ *  @param[in] data - the reference of the data to be copied
+ *
+ *  @param[in] size - the size of the data to be copied
+ *
+ *  @return none
+ */
+static void DataQ_WriteStaging( DataQ_Staging_t * staging, uint32_t position, const void * data, uint32_t size )
+{
+	uint32_t offset = position & (staging->ring_size - 1);
+	uint32_t size_to_end = staging->ring_size - offset;
 
-	/* determine if fifo is seekable */
-	if ( (fifo_hdr.flags & FLAGS_RANDOM_ACCESS) == 0 ) {
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_QUEUE_NOT_SEEKABLE;
+	if ( size <= size_to_end ) {
+		PSL_memcpy( staging->ring + offset, data, size );
+	} else {
+		PSL_memcpy( staging->ring + offset, data, size_to_end );
+		PSL_memcpy( staging->ring, (const uint8_t *) data + size_to_end, size - size_to_end );
 	}
+}
 
-	/* determine if fifo is empty */
-	if ( (fifo_hdr.num_of_entries == 0) &&
-		 (fifo_hdr.head_lut_offs == fifo_hdr.tail_lut_offs)  ) {
-
-		/* nothing to return */
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_QUEUE_IS_EMPTY;
+/** @brief Copies data out of a staging ring.
+ *
+ *  This function copies data out of the staging ring at the specified
+ *  free running byte count, wrapping to the start of the ring.
+ *
+ *  @param[in] staging - the reference of the staging ring
+ *
+ *  @param[in] position - the free running byte count to copy at
+ *
+ *  @param[out] data - the reference of the buffer to copy into
+ *
+ *  @param[in] size - the size of the data to be copied
+ *
+ *  @return none
+ */
+static void DataQ_ReadStaging( DataQ_Staging_t * staging, uint32_t position, void * data, uint32_t size )
+{
+	uint32_t offset = position & (staging->ring_size - 1);
+	uint32_t size_to_end = staging->ring_size - offset;
 
+	if ( size <= size_to_end ) {
+		PSL_memcpy( data, staging->ring + offset, size );
+	} else {
+		PSL_memcpy( data, staging->ring + offset, size_to_end );
+		PSL_memcpy( (uint8_t *) data + size_to_end, staging->ring, size - size_to_end );
 	}
+}
 
-	/* determine if seek position is outside the range */
-	if ( position >= fifo_hdr.num_of_entries ) {
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_INVALID_SEEK;
-	}
+/** @brief Opens a staging ring in front of a data queue with its lock
+ *         held.
+ *
+ *  This function implements DataQ_FifoOpenStaging (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoOpenStagingLocked( DataQ_File_t * fifo_handle, size_t ring_size, int overflow )
+{
+	DataQ_State_t * fifo_state;
+	DataQ_Staging_t * staging;
+	uint8_t * ring;
+	int index;
 
-	/* perform seek operation */
-	if ( seek_type == SEEK_TYPE_HEAD ) {
+	/* check mandatory arguments for NULL pointers */
+	if ( fifo_handle == (DataQ_File_t *) 0 ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
 
-		/* set seek offset to current head offset in the LUT entry */
-		fifo_hdr.seek_lut_offs = fifo_hdr.head_lut_offs;
+	/* check mandatory arguments for invalid values (the free running byte
+	 * counts only wrap consistently within a ring sized a power of two) */
+	if ( (ring_size < (2 * DATAQ_STAGING_HDR_SIZE)) || (ring_size > DATA_QUEUE_STAGING_ARENA_SIZE) ||
+		 ((ring_size & (ring_size - 1)) != 0) ||
+		 (overflow < OVERFLOW_TYPE_FAIL) || (overflow >= OVERFLOW_TYPE_MAX) ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
 
-	} else if ( seek_type == SEEK_TYPE_TAIL ) {
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
+	}
 
-		/* set seek offset to current tail offset in the LUT entry */
-		fifo_hdr.seek_lut_offs = fifo_hdr.tail_lut_offs;
+	/* check if write access is allowed */
+	if ( ( fifo_handle->access != ACCESS_TYPE_WRITE_ONLY ) &&
+		 ( fifo_handle->access != ACCESS_TYPE_READ_WRITE ) ) {
+		return CODE_ERROR_QUEUE_READ_ONLY;
+	}
 
-	} else {
+	/* check if fifo is still opened */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
 
-		/* set seek offset to anywhere between head and tail offsets
-		 * in relative to the head offset in the LUT entry
-		 */
-		fifo_hdr.seek_lut_offs = (fifo_hdr.head_lut_offs + position) % fifo_hdr.max_entries;
+	/* only one staging ring is kept for each opened data queue */
+	index = (int) (fifo_state - DataQ_FileStateList);
+	staging = &DataQ_StagingList[index];
+	if ( staging->ring != (uint8_t *) 0 ) {
+		return CODE_ERROR_QUEUE_OPENED;
 	}
 
-	/* update the header (or metadata) file associated with the fifo */
-	if ( (FSAL_OpenFile(".header", FSAL_FLAGS_BINARY | FSAL_FLAGS_WRITE_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_WriteFile(fsal_handle, (uint8_t *)&fifo_hdr, sizeof(fifo_hdr)) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+	/* take the ring from the staging arena */
+	ring = DataQ_AllocStaging( index, (uint32_t) ring_size );
+	if ( ring == (uint8_t *) 0 ) {
+		return CODE_ERROR_BUFFER_NOT_AVAIL;
+	}
 
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_FS_ACCESS_FAIL;
+	/* an entry takes at most the whole ring and what the fifo allows */
+	PSL_memset( staging, 0, sizeof(DataQ_Staging_t) );
+	staging->ring_size = (uint32_t) ring_size;
+	staging->max_entry_size = (uint32_t) ring_size - DATAQ_STAGING_HDR_SIZE;
+	if ( staging->max_entry_size > fifo_state->hdr.max_entry_size ) {
+		staging->max_entry_size = fifo_state->hdr.max_entry_size;
+	}
+	if ( staging->max_entry_size > fifo_state->hdr.max_flash_size ) {
+		staging->max_entry_size = fifo_state->hdr.max_flash_size;
 	}
+	staging->overflow = overflow;
+	staging->ring = ring;
 
 	/* operation succeeded */
-	FSAL_ChangeDirectory( "../" );
 	return CODE_STATUS_OK;
 }
 
-
-/** @brief Copies an entry from the specified first-in, first-out
+/** @brief Opens a staging ring in front of the specified first-in,
+ *         first-out (FIFO) data queue.
+ *
+ *  This function sets up a fixed-capacity ring buffer in memory,
+ *  taken from a static arena, where entries are staged without
+ *  accessing the filesystem (see DataQ_FifoStage) until a task
+ *  drains them into the data queue (see DataQ_FifoDrain). The ring
+ *  is released when the data queue is closed, discarding whatever
+ *  was not drained.
+ *
+ *  The overflow policy determines what happens to an entry staged
+ *  while the ring is full: OVERFLOW_TYPE_FAIL rejects it,
+ *  OVERFLOW_TYPE_DROP_NEWEST silently drops it and
+ *  OVERFLOW_TYPE_DROP_OLDEST drops the oldest staged entries to
+ *  make room for it (the dropped entries are counted).
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the open staging operation.
+ *
+ *  @param[in] ring_size - the size of the ring in bytes (a power of
+ *                         two of at least 8)
+ *
+ *  @param[in] overflow - the overflow policy of the ring
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_READ_ONLY
+ *                CODE_ERROR_QUEUE_CLOSED
+ *                CODE_ERROR_QUEUE_OPENED
+ *                CODE_ERROR_BUFFER_NOT_AVAIL
+ *
+ */
+int DataQ_FifoOpenStaging( DataQ_File_t * fifo_handle, size_t ring_size, int overflow )
+{
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the list of opened data
+	 * queues (which the staging arena is shared by) and on the same data
+	 * queue (always locked in this order) */
+	PSL_MutexLock( &DataQ_ListMutex );
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoOpenStagingLocked( fifo_handle, ring_size, overflow );
+	DataQ_UnlockQueue( fifo_mutex );
+	PSL_MutexUnlock( &DataQ_ListMutex );
+
+	return dataq_status;
+}
+
+/** @brief Stages an entry for the specified first-in, first-out
  *         (FIFO) data queue.
  *
- *  This function copies an entry from the specified data queue,
- *  particularly where the 'seek' pointer is currently positioned.
- *  After the contents and size of the entry are copied and set to
- *  the corresponding output parameters, the position of the 'seek'
- *  pointer is advanced to the next entry. If the old 'seek' pointer
- *  position is the 'head' end of the queue, then the new position
- *  would be the 'tail' end of the queue. The queue needs to have
- *  at least one entry for the operation to succeed.
+ *  This function copies a new entry into the staging ring of the
+ *  data queue, to be enqueued when the ring is next drained. It
+ *  neither blocks nor accesses the filesystem, so it can be called
+ *  from an interrupt service routine, as long as a single task (or
+ *  interrupt) stages entries for a data queue at a time. What
+ *  happens when the ring is full depends on its overflow policy.
  *
  *
  *  @param[in] fifo_handle - the reference of the data queue to be
- *                           accessed for the copy operation.
+ *                           accessed for the stage operation.
  *
- *  @param[out] data - the reference where the data is to be copied.
+ *  @param[in] data - the reference of the data to be staged.
  *
- *  @param[out] size - the reference where the size of the copied
- *                     data is to be set.
+ *  @param[in] size - the size of the data to be staged.
  *
  *  @return int - the status or error code of the operation after
  *                the call:
@@ -1236,157 +8795,221 @@ int DataQ_FifoSeek( DataQ_File_t * fifo_handle, int seek_type, int position )
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
  *                CODE_ERROR_INVALID_HANDLE
- *                CODE_ERROR_QUEUE_WRITE_ONLY
- *                CODE_ERROR_QUEUE_MISSING
- *                CODE_ERROR_QUEUE_CLOSED
- *                CODE_ERROR_QUEUE_IS_EMPTY
- *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_IS_FULL
+ *                CODE_ERROR_BUFFER_NOT_AVAIL
  *
  */
-int DataQ_FifoGetEntry( DataQ_File_t * fifo_handle, void * data, size_t * size )
+int DataQ_FifoStage( DataQ_File_t * fifo_handle, const void * data, size_t size )
 {
-	FSAL_File_t fsal_handle = -1;
-	size_t file_size;
-	DataQ_Hdr_t fifo_hdr;
-	DataQ_LUT_Entry_t fifo_lut_entry;
-	uint8_t fifo_lut_cache[ DATAQ_LUT_FILE_SIZE_MAX ] = { 0 };
-	char fifo_lut_entry_reference[DATA_QUEUE_LUT_ENTRY_SIZE + 1];
+	DataQ_Staging_t * staging = (DataQ_Staging_t *) 0;
+	uint32_t record_size;
+	uint32_t entry_size;
+	uint32_t head;
+	uint32_t tail;
 	int index;
 
 	/* check mandatory arguments for NULL pointers */
-	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( data == (void *) 0 ) || ( size == (size_t *) 0 ) ) {
+	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( data == (const void *) 0 ) ) {
 		return CODE_ERROR_INVALID_ARG;
 	}
 
-	/* check for a valid fifo handle */
-	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX + 1; index++ ) {
+	/* check for a valid fifo handle (without taking any lock) */
+	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX; index++ ) {
+		if( fifo_handle == &DataQ_FileHandleList[index] ) {
+			staging = &DataQ_StagingList[index];
+			break;
+		}
+	}
+	if ( staging == (DataQ_Staging_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
+	}
 
-		/* locate the fifo handle in the currently opened queue list */
-		if ( index < DATA_QUEUE_FILE_HANDLE_LIST_MAX ) {
+	/* check if a staging ring is opened for the fifo */
+	if ( staging->ring == (uint8_t *) 0 ) {
+		return CODE_ERROR_BUFFER_NOT_AVAIL;
+	}
+
+	/* validate the entry size of the data to be staged */
+	if ( (size == 0) || (size > staging->max_entry_size) ) {
+		return CODE_ERROR_INVALID_ARG;
+	}
 
-			/* a valid fifo handle references one data queue on the list */
-			if( fifo_handle == &DataQ_FileHandleList[index] ) {
+	/* only this side writes the head, the tail is written by the draining
+	 * task and by this side when dropping the oldest entries */
+	record_size = DATAQ_STAGING_RECORD_SIZE( size );
+	head = staging->head;
+	tail = PSL_AtomicLoad( &staging->tail );
 
-				/* found it */
-				break;
-			}
+	/* apply the overflow policy while the ring has no room for the entry */
+	while ( (head - tail + record_size) > staging->ring_size ) {
 
-			/* try next one */
-			continue;
+		if ( staging->overflow == OVERFLOW_TYPE_FAIL ) {
+			return CODE_ERROR_QUEUE_IS_FULL;
 		}
 
-		/* can not find the handle */
-		return CODE_ERROR_INVALID_HANDLE;
-	}
+		if ( staging->overflow == OVERFLOW_TYPE_DROP_NEWEST ) {
+			PSL_AtomicStore( &staging->dropped, staging->dropped + 1 );
+			return CODE_STATUS_OK;
+		}
 
-	/* at least read access is allowed */
-	if ( fifo_handle->access == ACCESS_TYPE_WRITE_ONLY ) {
-		return CODE_ERROR_QUEUE_WRITE_ONLY;
+		/* drop the oldest entry unless it was just drained */
+		DataQ_ReadStaging( staging, tail, &entry_size, DATAQ_STAGING_HDR_SIZE );
+		if ( PSL_AtomicCompareExchange( &staging->tail, tail, tail + DATAQ_STAGING_RECORD_SIZE( entry_size ) ) ) {
+			PSL_AtomicStore( &staging->dropped, staging->dropped + 1 );
+		}
+		tail = PSL_AtomicLoad( &staging->tail );
 	}
 
-	/* check if folder associated with data queue is present by changing directory */
-	if ( FSAL_ChangeDirectory( fifo_handle->name ) == FSAL_ERROR_DIR_ACCESS ) {
-		return CODE_ERROR_QUEUE_MISSING;
+	/* copy the entry after its size and then publish both at once */
+	entry_size = (uint32_t) size;
+	DataQ_WriteStaging( staging, head, &entry_size, DATAQ_STAGING_HDR_SIZE );
+	DataQ_WriteStaging( staging, head + DATAQ_STAGING_HDR_SIZE, data, entry_size );
+	if ( (head - tail + record_size) > staging->high_water ) {
+		PSL_AtomicStore( &staging->high_water, head - tail + record_size );
 	}
+	PSL_AtomicStore( &staging->head, head + record_size );
 
-	/* check if fifo is already opened for reading */
-	if ( (FSAL_ListFile( ".rolock", &file_size ) == FSAL_ERROR_FILE_ACCESS) &&
-		 (FSAL_ListFile( ".rwlock", &file_size ) == FSAL_ERROR_FILE_ACCESS) ) {
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_QUEUE_CLOSED;
+	/* operation succeeded */
+	return CODE_STATUS_OK;
+}
+
+/** @brief Drains the staging ring of a data queue with its lock held.
+ *
+ *  This function implements DataQ_FifoDrain (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoDrainLocked( DataQ_File_t * fifo_handle, void * buffer, size_t buffer_size, size_t * count )
+{
+	size_t batch_count;
+	size_t batch_length;
+	DataQ_State_t * fifo_state;
+	DataQ_Staging_t * staging;
+	uint32_t entry_size;
+	uint32_t used;
+	uint32_t head;
+	uint32_t tail;
+	int dataq_status;
+	int torn;
+
+	/* check mandatory arguments for NULL pointers */
+	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( buffer == (void *) 0 ) ) {
+		return CODE_ERROR_INVALID_ARG;
 	}
 
-	/* open and read the header (or metadata) file associated with the fifo */
-	if ( (FSAL_OpenFile(".header", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_ReadFile(fsal_handle, (uint8_t *)&fifo_hdr, sizeof(fifo_hdr)) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+	if ( count != (size_t *) 0 ) {
+		*count = 0;
+	}
 
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_FS_ACCESS_FAIL;
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
 	}
 
-	/* create a cache which directly mirrors the LUT file associated with the fifo */
-	if ( (FSAL_OpenFile(".lut", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_ReadFile(fsal_handle, (uint8_t *)fifo_lut_cache, DATAQ_LUT_FILE_SIZE_MAX) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+	/* check if fifo is still opened */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
 
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_FS_ACCESS_FAIL;
+	/* check if a staging ring is opened for the fifo */
+	staging = &DataQ_StagingList[ fifo_state - DataQ_FileStateList ];
+	if ( staging->ring == (uint8_t *) 0 ) {
+		return CODE_ERROR_BUFFER_NOT_AVAIL;
 	}
 
-	/* determine if fifo is empty */
-	if ( (fifo_hdr.num_of_entries == 0) &&
-		 (fifo_hdr.head_lut_offs == fifo_hdr.tail_lut_offs)  ) {
+	for ( ;; ) {
 
-		/* nothing to return */
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_QUEUE_IS_EMPTY;
+		/* the tail is read first so that it never gets past the head */
+		tail = PSL_AtomicLoad( &staging->tail );
+		head = PSL_AtomicLoad( &staging->head );
 
-	}
+		/* copy as many staged entries as the buffer and a batch hold */
+		batch_count = 0;
+		batch_length = 0;
+		used = 0;
+		torn = 0;
+		while ( (batch_count < DATA_QUEUE_STAGING_BATCH_MAX) && ((tail + used) != head) ) {
+			DataQ_ReadStaging( staging, tail + used, &entry_size, DATAQ_STAGING_HDR_SIZE );
 
-	/* retrieve the entry by copying the LUT entry indicated by the seek offset */
-	PSL_memcpy( &fifo_lut_entry,
-			    fifo_lut_cache + (fifo_hdr.seek_lut_offs * sizeof(DataQ_LUT_Entry_t)),
-			    sizeof(DataQ_LUT_Entry_t) );
+			/* an entry overwritten while dropping the oldest ones is retried */
+			if ( (entry_size == 0) || (entry_size > staging->max_entry_size) ||
+				 (DATAQ_STAGING_RECORD_SIZE( entry_size ) > (head - tail - used)) ) {
+				torn = 1;
+				break;
+			}
 
-	/* copy the LUT entry reference array and terminate to make it a string */
-	PSL_memcpy( fifo_lut_entry_reference, fifo_lut_entry.reference, DATA_QUEUE_LUT_ENTRY_SIZE);
-	fifo_lut_entry_reference[DATA_QUEUE_LUT_ENTRY_SIZE] = '\0';
+			if ( (batch_length + entry_size) > buffer_size ) {
+				break;
+			}
 
-	/* extract the data from the LUT entry as indicated by the reference */
-	if ( (FSAL_OpenFile(fifo_lut_entry_reference, FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_ReadFile(fsal_handle, (uint8_t *)data, *size) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+			DataQ_ReadStaging( staging, tail + used + DATAQ_STAGING_HDR_SIZE, (uint8_t *) buffer + batch_length, entry_size );
+			staging->batch_data[ batch_count ] = (uint8_t *) buffer + batch_length;
+			staging->batch_sizes[ batch_count ] = entry_size;
+			batch_length += entry_size;
+			used += DATAQ_STAGING_RECORD_SIZE( entry_size );
+			batch_count++;
+		}
 
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_FS_ACCESS_FAIL;
-	}
+		/* a copy is only trusted if those entries were not dropped meanwhile,
+		 * in which case they are removed from the ring before the enqueue */
+		if ( staging->overflow == OVERFLOW_TYPE_DROP_OLDEST ) {
+			if ( torn || ((batch_count != 0) && !PSL_AtomicCompareExchange( &staging->tail, tail, tail + used )) ) {
+				continue;
+			}
+		}
 
-	/* increment the seek offset if it have not yet reached the tail offset */
-	if ( fifo_hdr.seek_lut_offs != fifo_hdr.tail_lut_offs ) {
-		fifo_hdr.seek_lut_offs = (fifo_hdr.seek_lut_offs + 1) % fifo_hdr.max_entries;
-	}
+		/* check if the ring is drained (or its oldest entry does not fit) */
+		if ( batch_count == 0 ) {
+			if ( tail != head ) {
+				return CODE_ERROR_BUFFER_TOO_SMALL;
+			}
+			break;
+		}
 
-	/* update the header (or metadata) file associated with the fifo */
-	if ( (FSAL_OpenFile(".header", FSAL_FLAGS_BINARY | FSAL_FLAGS_WRITE_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_WriteFile(fsal_handle, (uint8_t *)&fifo_hdr, sizeof(fifo_hdr)) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+		/* enqueue the whole batch at once */
+		dataq_status = DataQ_FifoEnqueueBatchLocked( fifo_handle, staging->batch_data, staging->batch_sizes, batch_count );
+		if ( dataq_status != CODE_STATUS_OK ) {
+			return dataq_status;
+		}
 
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_FS_ACCESS_FAIL;
+		/* otherwise the entries are only removed from the ring once enqueued */
+		if ( staging->overflow != OVERFLOW_TYPE_DROP_OLDEST ) {
+			PSL_AtomicStore( &staging->tail, tail + used );
+		}
+
+		if ( count != (size_t *) 0 ) {
+			*count += batch_count;
+		}
 	}
 
 	/* operation succeeded */
-	FSAL_ChangeDirectory( "../" );
 	return CODE_STATUS_OK;
 }
 
-
-/** @brief Retrieves the current number of entries of the specified
- *         first-in, first-out (FIFO) data queue.
+/** @brief Drains the staging ring of the specified first-in,
+ *         first-out (FIFO) data queue.
  *
- *  This function gets the number of entries the specified data queue
- *  currently has. If the operation succeeds, the number of entries
- *  is stored in the output parameter.
+ *  This function moves the entries staged so far into the data
+ *  queue, in the order they were staged, copying them into the
+ *  specified buffer and enqueuing each buffer full of them as one
+ *  batch (see DataQ_FifoEnqueueBatch). It is meant to be called by
+ *  a background task, and entries staged while it runs are drained
+ *  too. If enqueuing a batch fails, its entries stay staged (except
+ *  under the drop-oldest overflow policy, where the ring no longer
+ *  holds them) and the error code is returned.
  *
  *
  *  @param[in] fifo_handle - the reference of the data queue to be
- *                           accessed for the get length operation.
+ *                           accessed for the drain operation.
  *
- *  @param[out] length - the reference where the number of entries
- *                       is to be stored.
+ *  @param[in] buffer - the reference of the buffer the staged entries
+ *                      are copied into
+ *
+ *  @param[in] buffer_size - the size of the buffer (at least the size
+ *                           of the largest staged entry)
+ *
+ *  @param[out] count - the number of entries drained (may be null)
  *
  *  @return int - the status or error code of the operation after
  *                the call:
@@ -1394,91 +9017,89 @@ int DataQ_FifoGetEntry( DataQ_File_t * fifo_handle, void * data, size_t * size )
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
  *                CODE_ERROR_INVALID_HANDLE
- *                CODE_ERROR_QUEUE_MISSING
  *                CODE_ERROR_QUEUE_CLOSED
  *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_QUEUE_ENTRY_NOT_LISTED
+ *                CODE_ERROR_BUFFER_TOO_SMALL
+ *                CODE_ERROR_BUFFER_NOT_AVAIL
  *
  */
-int DataQ_FifoGetLength( DataQ_File_t * fifo_handle, size_t * length )
+int DataQ_FifoDrain( DataQ_File_t * fifo_handle, void * buffer, size_t buffer_size, size_t * count )
 {
-	FSAL_File_t fsal_handle = -1;
-	size_t file_size;
-	DataQ_Hdr_t fifo_hdr;
-	int index;
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the same data queue (which
+	 * also keeps a single task draining the staging ring at a time) */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoDrainLocked( fifo_handle, buffer, buffer_size, count );
+	DataQ_UnlockQueue( fifo_mutex );
+
+	return dataq_status;
+}
+
+/** @brief Retrieves the state of the staging ring of a data queue with
+ *         its lock held.
+ *
+ *  This function implements DataQ_FifoGetStagingInfo (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_FifoGetStagingInfoLocked( DataQ_File_t * fifo_handle, DataQ_Staging_Info_t * info )
+{
+	DataQ_State_t * fifo_state;
+	DataQ_Staging_t * staging;
+	uint32_t tail;
 
 	/* check mandatory arguments for NULL pointers */
-	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( length == (size_t *) 0 ) ) {
+	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( info == (DataQ_Staging_Info_t *) 0 ) ) {
 		return CODE_ERROR_INVALID_ARG;
 	}
 
 	/* check for a valid fifo handle */
-	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX + 1; index++ ) {
-
-		/* locate the fifo handle in the currently opened queue list */
-		if ( index < DATA_QUEUE_FILE_HANDLE_LIST_MAX ) {
-
-			/* a valid fifo handle references one data queue on the list */
-			if( fifo_handle == &DataQ_FileHandleList[index] ) {
-
-				/* found it */
-				break;
-			}
-
-			/* try next one */
-			continue;
-		}
-
-		/* can not find the handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
 		return CODE_ERROR_INVALID_HANDLE;
 	}
 
-	/* check if folder associated with data queue is present by changing directory */
-	if ( FSAL_ChangeDirectory( fifo_handle->name ) == FSAL_ERROR_DIR_ACCESS ) {
-		return CODE_ERROR_QUEUE_MISSING;
-	}
-
-	/* check if fifo is already opened */
-	if ( (FSAL_ListFile( ".rolock", &file_size ) == FSAL_ERROR_FILE_ACCESS) &&
-	     (FSAL_ListFile( ".wolock", &file_size ) == FSAL_ERROR_FILE_ACCESS) &&
-		 (FSAL_ListFile( ".rwlock", &file_size ) == FSAL_ERROR_FILE_ACCESS) ) {
-		FSAL_ChangeDirectory( "../" );
+	/* check if fifo is still opened */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
 		return CODE_ERROR_QUEUE_CLOSED;
 	}
 
-	/* open and read the header (or metadata) file associated with the fifo */
-	if ( (FSAL_OpenFile(".header", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_ReadFile(fsal_handle, (uint8_t *)&fifo_hdr, sizeof(fifo_hdr)) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
-
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_FS_ACCESS_FAIL;
+	/* check if a staging ring is opened for the fifo */
+	staging = &DataQ_StagingList[ fifo_state - DataQ_FileStateList ];
+	if ( staging->ring == (uint8_t *) 0 ) {
+		return CODE_ERROR_BUFFER_NOT_AVAIL;
 	}
 
-	/* copy the current number of fifo entries */
-	*length = fifo_hdr.num_of_entries;
+	/* the tail is read first so that it never gets past the head */
+	tail = PSL_AtomicLoad( &staging->tail );
+	info->length = PSL_AtomicLoad( &staging->head ) - tail;
+	info->ring_size = staging->ring_size;
+
+	/* the statistics are updated by whoever stages the entries without
+	 * taking the lock of the fifo */
+	info->high_water = PSL_AtomicLoad( &staging->high_water );
+	info->dropped = PSL_AtomicLoad( &staging->dropped );
 
 	/* operation succeeded */
-	FSAL_ChangeDirectory( "../" );
 	return CODE_STATUS_OK;
 }
 
-
-/** @brief Retrieves the current flash size usage of the specified
+/** @brief Retrieves the state of the staging ring of the specified
  *         first-in, first-out (FIFO) data queue.
  *
- *  This function gets the current size in flash storage of the
- *  specified data queue. If the operation succeeds, the flash size
- *  in bytes is stored in the output parameter.
+ *  This function reports the size of the staging ring of the data
+ *  queue, how much of it is currently used by staged entries, the
+ *  most of it ever used (the high-water mark) and the number of
+ *  entries dropped under its overflow policy.
  *
  *
  *  @param[in] fifo_handle - the reference of the data queue to be
- *                           accessed for the get length operation.
+ *                           accessed for the staging info operation.
  *
- *  @param[out] flash_size - the reference where the flash size used
- *                           is to be stored.
+ *  @param[out] info - the reference of the state of the ring
  *
  *  @return int - the status or error code of the operation after
  *                the call:
@@ -1486,73 +9107,164 @@ int DataQ_FifoGetLength( DataQ_File_t * fifo_handle, size_t * length )
  *                CODE_STATUS_OK
  *                CODE_ERROR_INVALID_ARG
  *                CODE_ERROR_INVALID_HANDLE
- *                CODE_ERROR_QUEUE_MISSING
  *                CODE_ERROR_QUEUE_CLOSED
- *                CODE_ERROR_FS_ACCESS_FAIL
+ *                CODE_ERROR_BUFFER_NOT_AVAIL
  *
  */
-int DataQ_FifoGetSize( DataQ_File_t * fifo_handle, size_t * flash_size )
+int DataQ_FifoGetStagingInfo( DataQ_File_t * fifo_handle, DataQ_Staging_Info_t * info )
 {
-	FSAL_File_t fsal_handle = -1;
-	size_t file_size;
-	DataQ_Hdr_t fifo_hdr;
-	int index;
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_FifoGetStagingInfoLocked( fifo_handle, info );
+	DataQ_UnlockQueue( fifo_mutex );
+
+	return dataq_status;
+}
+
+#if defined( DATA_QUEUE_STATS )
+
+/** @brief Retrieves the statistics of a data queue with its lock held.
+ *
+ *  This function implements DataQ_GetStats (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_GetStatsLocked( DataQ_File_t * fifo_handle, DataQ_Stats_t * stats )
+{
+	DataQ_State_t * fifo_state;
 
 	/* check mandatory arguments for NULL pointers */
-	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( flash_size == (size_t *) 0 ) ) {
+	if ( ( fifo_handle == (DataQ_File_t *) 0 ) || ( stats == (DataQ_Stats_t *) 0 ) ) {
 		return CODE_ERROR_INVALID_ARG;
 	}
 
 	/* check for a valid fifo handle */
-	for ( index = 0; index < DATA_QUEUE_FILE_HANDLE_LIST_MAX + 1; index++ ) {
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
+	}
 
-		/* locate the fifo handle in the currently opened queue list */
-		if ( index < DATA_QUEUE_FILE_HANDLE_LIST_MAX ) {
+	/* check if fifo is still opened (the statistics are only kept while it is) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
+	}
 
-			/* a valid fifo handle references one data queue on the list */
-			if( fifo_handle == &DataQ_FileHandleList[index] ) {
+	/* copy the statistics kept alongside the cached state of the handle */
+	PSL_memcpy( stats, &DataQ_FileStatsList[ fifo_state - DataQ_FileStateList ], sizeof(DataQ_Stats_t) );
 
-				/* found it */
-				break;
-			}
+	/* operation succeeded */
+	return CODE_STATUS_OK;
+}
 
-			/* try next one */
-			continue;
-		}
+/** @brief Retrieves the statistics of the specified first-in,
+ *         first-out (FIFO) data queue.
+ *
+ *  This function copies the statistics gathered since the data
+ *  queue was opened (or since they were last reset) into the output
+ *  parameter: the count, errors, bytes transferred and cumulative
+ *  and maximum latency of each type of FSAL call made on behalf of
+ *  the data queue, and the counters of the engine (enqueues,
+ *  evictions, dequeues, discards, trims, LUT cache hits and misses, LUT page and
+ *  header stores and lock operations). Only available when the
+ *  library is built with DATA_QUEUE_STATS.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the get stats operation.
+ *
+ *  @param[out] stats - the reference where the statistics are to
+ *                      be stored.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_CLOSED
+ *
+ */
+int DataQ_GetStats( DataQ_File_t * fifo_handle, DataQ_Stats_t * stats )
+{
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
 
-		/* can not find the handle */
-		return CODE_ERROR_INVALID_HANDLE;
-	}
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_GetStatsLocked( fifo_handle, stats );
+	DataQ_UnlockQueue( fifo_mutex );
 
-	/* check if folder associated with data queue is present by changing directory */
-	if ( FSAL_ChangeDirectory( fifo_handle->name ) == FSAL_ERROR_DIR_ACCESS ) {
-		return CODE_ERROR_QUEUE_MISSING;
-	}
+	return dataq_status;
+}
 
-	/* check if fifo is already opened */
-	if ( (FSAL_ListFile( ".rolock", &file_size ) == FSAL_ERROR_FILE_ACCESS) &&
-	     (FSAL_ListFile( ".wolock", &file_size ) == FSAL_ERROR_FILE_ACCESS) &&
-		 (FSAL_ListFile( ".rwlock", &file_size ) == FSAL_ERROR_FILE_ACCESS) ) {
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_QUEUE_CLOSED;
+
+/** @brief Resets the statistics of a data queue with its lock held.
+ *
+ *  This function implements DataQ_ResetStats (see it for the
+ *  parameters and the status or error codes) once the caller
+ *  serialized it with any other operation on the data queue.
+ */
+static int DataQ_ResetStatsLocked( DataQ_File_t * fifo_handle )
+{
+	DataQ_State_t * fifo_state;
+
+	/* check mandatory arguments for NULL pointers */
+	if ( fifo_handle == (DataQ_File_t *) 0 ) {
+		return CODE_ERROR_INVALID_ARG;
 	}
 
-	/* open and read the header (or metadata) file associated with the fifo */
-	if ( (FSAL_OpenFile(".header", FSAL_FLAGS_BINARY | FSAL_FLAGS_READ_ONLY, &fsal_handle) == FSAL_ERROR_FILE_ACCESS) ||
-		 (FSAL_ReadFile(fsal_handle, (uint8_t *)&fifo_hdr, sizeof(fifo_hdr)) < 0) ||
-		 (FSAL_CloseFile(fsal_handle) == FSAL_ERROR_FILE_ACCESS) ) {
+	/* check for a valid fifo handle */
+	fifo_state = DataQ_GetState( fifo_handle );
+	if ( fifo_state == (DataQ_State_t *) 0 ) {
+		return CODE_ERROR_INVALID_HANDLE;
+	}
 
-		/* file system access error */
-		if ( fsal_handle != -1 )
-			FSAL_CloseFile( fsal_handle );
-		FSAL_ChangeDirectory( "../" );
-		return CODE_ERROR_FS_ACCESS_FAIL;
+	/* check if fifo is still opened (the statistics are only kept while it is) */
+	if ( fifo_handle->handle == DATA_QUEUE_FILE_HANDLE_INVALID ) {
+		return CODE_ERROR_QUEUE_CLOSED;
 	}
 
-	/* copy the current number of fifo entries */
-	*flash_size = fifo_hdr.flash_size;
+	/* clear the statistics kept alongside the cached state of the handle */
+	PSL_memset( &DataQ_FileStatsList[ fifo_state - DataQ_FileStateList ], 0, sizeof(DataQ_Stats_t) );
 
 	/* operation succeeded */
-	FSAL_ChangeDirectory( "../" );
 	return CODE_STATUS_OK;
 }
+
+/** @brief Resets the statistics of the specified first-in,
+ *         first-out (FIFO) data queue.
+ *
+ *  This function clears all statistics gathered for the data queue
+ *  so far. Only available when the library is built with
+ *  DATA_QUEUE_STATS.
+ *
+ *
+ *  @param[in] fifo_handle - the reference of the data queue to be
+ *                           accessed for the reset stats operation.
+ *
+ *  @return int - the status or error code of the operation after
+ *                the call:
+ *
+ *                CODE_STATUS_OK
+ *                CODE_ERROR_INVALID_ARG
+ *                CODE_ERROR_INVALID_HANDLE
+ *                CODE_ERROR_QUEUE_CLOSED
+ *
+ */
+int DataQ_ResetStats( DataQ_File_t * fifo_handle )
+{
+	PSL_Mutex_t * fifo_mutex;
+	int dataq_status;
+
+	/* serialize the operation with any other on the same data queue */
+	fifo_mutex = DataQ_LockQueue( fifo_handle );
+	dataq_status = DataQ_ResetStatsLocked( fifo_handle );
+	DataQ_UnlockQueue( fifo_mutex );
+
+	return dataq_status;
+}
+
+#endif /* DATA_QUEUE_STATS */